@@ -0,0 +1,122 @@
+#include <filesystem>
+
+#include <core/config_manager.hpp>
+#include <core/files.hpp>
+#include <core/fiber_pool.hpp>
+#include <util/codec.hpp>
+#include <util/seekable_compression.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace core;
+using namespace util;
+
+/* All files of models_dir and shaders_dir concatenated */
+static const vector<byte>& corpus() {
+    static const vector<byte> data = [] {
+        vector<byte> result;
+        for (auto dir : {"models_dir", "shaders_dir"}) {
+            for (auto& entry : std::filesystem::recursive_directory_iterator(path_eval(cfg_read_path(dir)))) {
+                if (!entry.is_regular_file())
+                    continue;
+                auto file = read_binary_file(entry.path().string());
+                result.insert(result.end(), file.begin(), file.end());
+            }
+        }
+        return result;
+    }();
+
+    return data;
+}
+
+static codec_settings settings_from(const benchmark::State& state) {
+    return codec_settings{static_cast<codec_id>(state.range(0)), static_cast<int>(state.range(1))};
+}
+
+static void codec_compress(benchmark::State& state) {
+    auto& data     = corpus();
+    auto  settings = settings_from(state);
+
+    size_t compressed_size = 0;
+    for (auto _ : state) {
+        auto compressed = compress_frame(data, settings);
+        compressed_size = compressed.size();
+        benchmark::DoNotOptimize(compressed.data());
+    }
+
+    state.SetLabel(string(get_codec(settings.codec).name()));
+    state.counters["ratio"] = static_cast<double>(data.size()) / static_cast<double>(compressed_size);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(data.size()));
+}
+
+static void codec_decompress(benchmark::State& state) {
+    auto& data       = corpus();
+    auto  settings   = settings_from(state);
+    auto  compressed = compress_frame(data, settings);
+
+    vector<byte> output(data.size());
+    for (auto _ : state) {
+        decompress_frame(compressed, output);
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.SetLabel(string(get_codec(settings.codec).name()));
+    state.counters["ratio"] = static_cast<double>(data.size()) / static_cast<double>(compressed.size());
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(data.size()));
+}
+
+/* {codec id, level} */
+#define CODEC_ARGS                                                                                                     \
+    Args({static_cast<int64_t>(codec_id::lz), COMPRESS_DEFAULT})                                                       \
+        ->Args({static_cast<int64_t>(codec_id::zlib), COMPRESS_FAST})                                                  \
+        ->Args({static_cast<int64_t>(codec_id::zlib), COMPRESS_DEFAULT})                                               \
+        ->Args({static_cast<int64_t>(codec_id::zlib), COMPRESS_BEST})                                                  \
+        ->Unit(benchmark::kMillisecond)
+
+BENCHMARK(codec_compress)->CODEC_ARGS;
+BENCHMARK(codec_decompress)->CODEC_ARGS;
+
+/* Reads 64 KiB from the middle of the corpus, range(0) - the codec id */
+static void seekable_read_range(benchmark::State& state) {
+    auto& data       = corpus();
+    auto  compressed = compress_seekable(data, {static_cast<codec_id>(state.range(0)), COMPRESS_DEFAULT});
+    auto  reader     = seekable_reader(compressed);
+
+    vector<byte> output(std::min<size_t>(SEEKABLE_BLOCK_SIZE, data.size()));
+    for (auto _ : state) {
+        reader.read(data.size() / 2 - output.size() / 2, output);
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.SetLabel(string(get_codec(reader.codec()).name()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(output.size()));
+}
+
+static void seekable_read_all(benchmark::State& state) {
+    auto& data       = corpus();
+    auto  compressed = compress_seekable(data, {static_cast<codec_id>(state.range(0)), COMPRESS_DEFAULT});
+    auto  reader     = seekable_reader(compressed);
+
+    vector<byte> output(data.size());
+    for (auto _ : state) {
+        reader.read_parallel(0, output);
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.SetLabel(string(get_codec(reader.codec()).name()));
+    state.counters["ratio"] = static_cast<double>(data.size()) / static_cast<double>(compressed.size());
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(data.size()));
+}
+
+BENCHMARK(seekable_read_range)->Arg(static_cast<int64_t>(codec_id::lz))->Arg(static_cast<int64_t>(codec_id::zlib));
+BENCHMARK(seekable_read_all)
+    ->Arg(static_cast<int64_t>(codec_id::lz))
+    ->Arg(static_cast<int64_t>(codec_id::zlib))
+    ->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+
+    /* Parallel reads run on the global pool */
+    global_fiber_pool().close();
+}
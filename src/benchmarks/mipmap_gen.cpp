@@ -0,0 +1,104 @@
+#include <random>
+
+extern "C" {
+#include <stb/stb_image_resize.h>
+}
+
+#include <core/fiber_pool.hpp>
+#include <util/mipmap_gen.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace core;
+using namespace util;
+
+/* grx_color_map generates 8 mipmaps */
+static constexpr u32 mipmaps_count = 8;
+
+static vector<u8> random_image(u32 side) {
+    vector<u8> result(size_t(side) * side * 4);
+    auto       gen = std::mt19937(1337); // NOLINT
+    for (auto& v : result)
+        v = static_cast<u8>(gen());
+    return result;
+}
+
+static vector<vec2u> mipmap_sizes(u32 side) {
+    auto sizes = mip_chain_sizes({side, side});
+    sizes.resize(mipmaps_count);
+    return sizes;
+}
+
+/* The previous path of grx_color_map::gen_mipmaps: every level is resized from the previous one on one thread */
+static void stbir_mipmaps(benchmark::State& state) {
+    auto side  = static_cast<u32>(state.range(0));
+    auto image = random_image(side);
+    auto sizes = mipmap_sizes(side);
+
+    size_t values = 0;
+    for (auto& size : sizes)
+        values += size_t(size.x()) * size.y() * 4;
+    vector<u8> output(values);
+
+    for (auto _ : state) {
+        auto src      = image.data();
+        auto src_size = vec2u{side, side};
+        auto dst      = output.data();
+        for (auto& size : sizes) {
+            stbir_resize_uint8(src,
+                               static_cast<int>(src_size.x()),
+                               static_cast<int>(src_size.y()),
+                               0,
+                               dst,
+                               static_cast<int>(size.x()),
+                               static_cast<int>(size.y()),
+                               0,
+                               4);
+            src      = dst;
+            src_size = size;
+            dst += size_t(size.x()) * size.y() * 4;
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(image.size()));
+}
+
+/* {side, filter, srgb} */
+static void generate_mipmaps_rgba(benchmark::State& state) {
+    auto side     = static_cast<u32>(state.range(0));
+    auto settings = mip_settings{static_cast<mip_filter>(state.range(1)), state.range(2) != 0};
+    auto image    = random_image(side);
+    auto sizes    = mipmap_sizes(side);
+
+    size_t values = 0;
+    for (auto& size : sizes)
+        values += size_t(size.x()) * size.y() * 4;
+    vector<u8> output(values);
+
+    for (auto _ : state) {
+        generate_mipmaps(image.data(), {side, side}, 4, sizes, output.data(), settings);
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(image.size()));
+}
+
+BENCHMARK(stbir_mipmaps)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(generate_mipmaps_rgba)
+    ->Args({1024, static_cast<int64_t>(mip_filter::box), 0})
+    ->Args({4096, static_cast<int64_t>(mip_filter::box), 0})
+    ->Args({4096, static_cast<int64_t>(mip_filter::box), 1})
+    ->Args({4096, static_cast<int64_t>(mip_filter::kaiser), 0})
+    ->Args({4096, static_cast<int64_t>(mip_filter::lanczos), 0})
+    ->Args({4096, static_cast<int64_t>(mip_filter::lanczos), 1})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+
+    /* Mipmaps are generated on the global pool */
+    global_fiber_pool().close();
+}
@@ -0,0 +1,143 @@
+#include <cmath>
+#include <cstdlib>
+#include <random>
+
+#include <core/fiber_pool.hpp>
+#include <util/patch_match.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace core;
+using namespace util;
+
+static constexpr u32    block_size = 16;
+static constexpr size_t channels   = 3;
+
+/* Smooth gradients with noise, neighbouring blocks are similar as in photos */
+static vector<u8> test_image(vec2u size, u32 seed) {
+    vector<u8> result(size_t(size.x()) * size.y() * channels);
+    auto       gen   = std::mt19937(seed);
+    auto       noise = std::uniform_int_distribution<int>(-12, 12); // NOLINT
+    auto       phase = static_cast<float>(seed);
+
+    for (u32 y = 0; y < size.y(); ++y) {
+        for (u32 x = 0; x < size.x(); ++x) {
+            for (size_t c = 0; c < channels; ++c) {
+                auto v = 128.f + 100.f * std::sin(float(x) * 0.013f + float(c) + phase) * // NOLINT
+                                     std::cos(float(y) * 0.021f - phase);                 // NOLINT
+                result[(size_t(y) * size.x() + x) * channels + c] =
+                    static_cast<u8>(std::clamp(int(v) + noise(gen), 0, 255)); // NOLINT
+            }
+        }
+    }
+    return result;
+}
+
+static void set_items(benchmark::State& state, vec2u size) {
+    /* Block comparisons */
+    auto blocks = u64(size.x() / block_size) * (size.y() / block_size);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(blocks * blocks));
+}
+
+/* Previous samples/genshit loop */
+static void patch_match_plain(benchmark::State& state) {
+    auto size = vec2u::filled_with(static_cast<u32>(state.range(0)));
+    auto src  = test_image(size, 1);
+    auto smp  = test_image(size, 2);
+
+    auto blocks = size / block_size;
+    auto pitch  = size_t(size.x()) * channels;
+
+    for (auto _ : state) {
+        for (u32 sy = 0; sy < blocks.y(); ++sy) {
+            for (u32 sx = 0; sx < blocks.x(); ++sx) {
+                auto best = numlim<int>::max();
+                for (u32 cy = 0; cy < blocks.y(); ++cy) {
+                    for (u32 cx = 0; cx < blocks.x(); ++cx) {
+                        int error = 0;
+                        for (u32 y = 0; y < block_size; ++y) {
+                            auto a = src.data() + (sy * block_size + y) * pitch + sx * block_size * channels;
+                            auto b = smp.data() + (cy * block_size + y) * pitch + cx * block_size * channels;
+                            for (size_t i = 0; i < block_size * channels; ++i)
+                                error += std::abs(int(a[i]) - int(b[i]));
+                        }
+                        best = std::min(best, error);
+                    }
+                }
+                benchmark::DoNotOptimize(best);
+            }
+        }
+    }
+    set_items(state, size);
+}
+
+/* state.range(1): 0 - exhaustive SAD, 1 - early termination; state.range(2): threads (0 - global pool) */
+static void patch_match_engine(benchmark::State& state) {
+    auto size = vec2u::filled_with(static_cast<u32>(state.range(0)));
+    auto src  = test_image(size, 1);
+    auto smp  = test_image(size, 2);
+
+    auto settings              = patch_match_settings{};
+    settings.block_size        = block_size;
+    settings.early_termination = state.range(1) != 0;
+
+    auto pool = state.range(2) ? make_unique<fiber_pool>(static_cast<size_t>(state.range(2))) : nullptr;
+
+    for (auto _ : state) {
+        auto result = patch_match_exact(src.data(), size, smp.data(), size, channels, settings, pool.get());
+        benchmark::DoNotOptimize(result.errors.data());
+    }
+    set_items(state, size);
+
+    if (pool)
+        pool->close();
+}
+
+/* state.range(1): quality in percents; the relative_error counter is the error relative to the exhaustive search */
+static void patch_match_approximate(benchmark::State& state) {
+    auto size = vec2u::filled_with(static_cast<u32>(state.range(0)));
+    auto src  = test_image(size, 1);
+    auto smp  = test_image(size, 2);
+
+    auto settings       = patch_match_settings{};
+    settings.block_size = block_size;
+
+    auto approx    = patch_match_approx_settings{};
+    approx.quality = static_cast<float>(state.range(1)) / 100.f; // NOLINT
+
+    patch_match_result result;
+    for (auto _ : state) {
+        result = patch_match_approx(src.data(), size, smp.data(), size, channels, settings, approx);
+        benchmark::DoNotOptimize(result.errors.data());
+    }
+    set_items(state, size);
+
+    auto exact = patch_match_exact(src.data(), size, smp.data(), size, channels, settings);
+    state.counters["relative_error"] = patch_match_relative_error(result, exact);
+}
+
+BENCHMARK(patch_match_plain)->Arg(256)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(patch_match_engine)
+    ->Args({256, 0, 1})
+    ->Args({256, 1, 1})
+    ->Args({256, 1, 0})
+    ->Args({1024, 1, 0})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(patch_match_approximate)
+    ->Args({256, 0})
+    ->Args({256, 50})
+    ->Args({256, 100})
+    ->Args({1024, 50})
+    ->Args({2048, 50})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+
+    /* Blocks are matched on the global pool */
+    global_fiber_pool().close();
+}
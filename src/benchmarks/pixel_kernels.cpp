@@ -0,0 +1,184 @@
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#include <core/fiber_pool.hpp>
+#include <util/pixel_kernels.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace core;
+using namespace util;
+
+/* 4K equirectangular environment map */
+static constexpr u32    map_width  = 4096;
+static constexpr u32    map_height = 2048;
+static constexpr size_t values     = size_t(map_width) * map_height * 4;
+static const auto       map_size   = vec2u{map_width, map_height};
+
+static vector<float> random_hdr() {
+    vector<float> result(values);
+    auto          gen  = std::mt19937(1337); // NOLINT
+    auto          dist = std::exponential_distribution<float>(1.f);
+    for (auto& v : result)
+        v = dist(gen);
+    return result;
+}
+
+static vector<u8> random_ldr() {
+    vector<u8> result(values);
+    auto       gen = std::mt19937(1337); // NOLINT
+    for (auto& v : result)
+        v = static_cast<u8>(gen());
+    return result;
+}
+
+static void set_bytes(benchmark::State& state, size_t bytes) {
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(bytes));
+}
+
+/* Previous grx_color_map::to_ldr loop */
+static void tone_map_std(benchmark::State& state) {
+    auto       hdr = random_hdr();
+    vector<u8> ldr(values);
+    for (auto _ : state) {
+        for (size_t i = 0; i < values; ++i) {
+            auto mapped = 1.f - std::exp(-hdr[i] * 1.f);
+            ldr[i]      = static_cast<u8>(255.f * std::pow(mapped, 1.f / 2.2f)); // NOLINT
+        }
+        benchmark::DoNotOptimize(ldr.data());
+    }
+    set_bytes(state, values * sizeof(float));
+}
+
+static void tone_map_kernel(benchmark::State& state) {
+    auto       hdr = random_hdr();
+    vector<u8> ldr(values);
+    for (auto _ : state) {
+        tone_map(hdr.data(), ldr.data(), values, 2.2f, 1.f); // NOLINT
+        benchmark::DoNotOptimize(ldr.data());
+    }
+    set_bytes(state, values * sizeof(float));
+}
+
+/* Previous grx_color_map::to_hdr loop */
+static void u8_to_float_loop(benchmark::State& state) {
+    auto          ldr = random_ldr();
+    vector<float> hdr(values);
+    for (auto _ : state) {
+        for (size_t i = 0; i < values; ++i)
+            hdr[i] = static_cast<float>(ldr[i]) / 255.f; // NOLINT
+        benchmark::DoNotOptimize(hdr.data());
+    }
+    set_bytes(state, values);
+}
+
+static void u8_to_float_kernel(benchmark::State& state) {
+    auto          ldr = random_ldr();
+    vector<float> hdr(values);
+    for (auto _ : state) {
+        u8_to_float(ldr.data(), hdr.data(), values);
+        benchmark::DoNotOptimize(hdr.data());
+    }
+    set_bytes(state, values);
+}
+
+/* Previous grx_color_map::rotated_left loop: row order reads and column order per pixel writes, RGBA8 pixels */
+static void rotate_left_loop(benchmark::State& state) {
+    auto       src = random_ldr();
+    vector<u8> dst(values);
+    auto       w = map_size.x();
+    auto       h = map_size.y();
+    for (auto _ : state) {
+        for (u32 y = 0; y < h; ++y)
+            for (u32 x = 0; x < w; ++x)
+                std::memcpy(&dst[(size_t(w - x - 1) * h + y) * 4], &src[(size_t(y) * w + x) * 4], 4);
+        benchmark::DoNotOptimize(dst.data());
+    }
+    set_bytes(state, values);
+}
+
+static void rotate_left_kernel(benchmark::State& state) {
+    auto       src = random_ldr();
+    vector<u8> dst(values);
+    for (auto _ : state) {
+        rotate_pixels(reinterpret_cast<const byte*>(src.data()), // NOLINT
+                      map_size,
+                      4,
+                      reinterpret_cast<byte*>(dst.data()), // NOLINT
+                      pixel_rotation::left);
+        benchmark::DoNotOptimize(dst.data());
+    }
+    set_bytes(state, values);
+}
+
+/* Same as rotate_left_kernel with float RGBA pixels */
+static void rotate_left_kernel_float(benchmark::State& state) {
+    auto          src = random_hdr();
+    vector<float> dst(values);
+    for (auto _ : state) {
+        rotate_pixels(reinterpret_cast<const byte*>(src.data()), // NOLINT
+                      map_size,
+                      sizeof(float) * 4,
+                      reinterpret_cast<byte*>(dst.data()), // NOLINT
+                      pixel_rotation::left);
+        benchmark::DoNotOptimize(dst.data());
+    }
+    set_bytes(state, values * sizeof(float));
+}
+
+/* Previous grx_color_map_view::flip_horizontal loop */
+static void flip_horizontal_loop(benchmark::State& state) {
+    auto data = random_ldr();
+    auto w    = map_size.x();
+    for (auto _ : state) {
+        for (u32 y = 0; y < map_size.y(); ++y) {
+            for (u32 x = 0; x < w / 2; ++x) {
+                u8 tmp[4]; // NOLINT
+                auto a = &data[(size_t(y) * w + x) * 4];
+                auto b = &data[(size_t(y) * w + w - x - 1) * 4];
+                std::memcpy(tmp, a, 4);
+                std::memcpy(a, b, 4);
+                std::memcpy(b, tmp, 4);
+            }
+        }
+        benchmark::DoNotOptimize(data.data());
+    }
+    set_bytes(state, values);
+}
+
+static void flip_horizontal_kernel(benchmark::State& state) {
+    auto data = random_ldr();
+    for (auto _ : state) {
+        flip_pixels_horizontal(reinterpret_cast<byte*>(data.data()), map_size, 4); // NOLINT
+        benchmark::DoNotOptimize(data.data());
+    }
+    set_bytes(state, values);
+}
+
+static void flip_vertical_kernel(benchmark::State& state) {
+    auto data = random_ldr();
+    for (auto _ : state) {
+        flip_pixels_vertical(reinterpret_cast<byte*>(data.data()), map_size, 4); // NOLINT
+        benchmark::DoNotOptimize(data.data());
+    }
+    set_bytes(state, values);
+}
+
+BENCHMARK(tone_map_std)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(tone_map_kernel)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(u8_to_float_loop)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(u8_to_float_kernel)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(rotate_left_loop)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(rotate_left_kernel)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(rotate_left_kernel_float)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(flip_horizontal_loop)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(flip_horizontal_kernel)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(flip_vertical_kernel)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+
+    /* Kernels run on the global pool */
+    global_fiber_pool().close();
+}
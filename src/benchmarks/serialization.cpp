@@ -0,0 +1,168 @@
+#include <core/compact_serialization.hpp>
+#include <core/serialization.hpp>
+#include <core/vec.hpp>
+#include <graphics/grx_vbo_types.hpp>
+#include <benchmark/benchmark.h>
+#include <random>
+
+using namespace core;
+
+template <typename T>
+static vector<T> make_data(size_t count) {
+    auto gen  = std::mt19937(228); // NOLINT
+    auto dist = std::uniform_real_distribution<float>(-100.f, 100.f); // NOLINT
+
+    vector<T> result(count);
+    for (auto& v : result) {
+        if constexpr (std::is_same_v<T, vec3f>)
+            v = vec3f{dist(gen), dist(gen), dist(gen)};
+        else if constexpr (std::is_same_v<T, glm::mat4>)
+            for (int i = 0; i < 4; ++i)
+                v[i] = glm::vec4(dist(gen), dist(gen), dist(gen), dist(gen));
+        else if constexpr (std::is_same_v<T, grx::grx_bone_vertex_data>)
+            v.append(static_cast<uint>(gen() % 64), dist(gen)); // NOLINT
+        else
+            v = static_cast<T>(gen());
+    }
+    return result;
+}
+
+/* The element by element serialization as it was before the memcpy fast path */
+template <typename T>
+static void serialize_per_element(const vector<T>& data, byte_vector& out) {
+    serialize(static_cast<u64>(data.size()), out);
+    for (auto& v : data) {
+        if constexpr (std::is_same_v<T, vec3f>)
+            serialize_all(out, v.x(), v.y(), v.z());
+        else
+            serialize(v, out);
+    }
+}
+
+template <typename T>
+static void serialize_fast(benchmark::State& state) {
+    auto data = make_data<T>(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        serializer s;
+        s.write(data);
+        benchmark::DoNotOptimize(s.data().data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0) *
+                            static_cast<int64_t>(sizeof(T)));
+}
+
+template <typename T>
+static void serialize_slow(benchmark::State& state) {
+    auto data = make_data<T>(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        byte_vector out;
+        serialize_per_element(data, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0) *
+                            static_cast<int64_t>(sizeof(T)));
+}
+
+template <typename T>
+static void deserialize_fast(benchmark::State& state) {
+    serializer s;
+    s.write(make_data<T>(static_cast<size_t>(state.range(0))));
+
+    for (auto _ : state) {
+        vector<T> result;
+        deserializer_view ds{s.data()};
+        ds.read(result);
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0) *
+                            static_cast<int64_t>(sizeof(T)));
+}
+
+static void deserialize_vec3f_slow(benchmark::State& state) {
+    serializer s;
+    s.write(make_data<vec3f>(static_cast<size_t>(state.range(0))));
+
+    for (auto _ : state) {
+        vector<vec3f> result;
+        span<const byte> in = s.data();
+
+        u64 size;
+        deserialize(size, in);
+        for (u64 i = 0; i < size; ++i) {
+            vec3f v;
+            deserialize_all(in, v.x(), v.y(), v.z());
+            result.push_back(v);
+        }
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0) *
+                            static_cast<int64_t>(sizeof(vec3f)));
+}
+
+/* Triangle list indices of a regular grid, neighbour indices are close */
+static vector<u32> make_indices(size_t count) {
+    constexpr u32 width = 256;
+
+    vector<u32> result;
+    result.reserve(count);
+    for (u32 quad = 0; result.size() < count; ++quad) {
+        auto i = quad / (width - 1) * width + quad % (width - 1);
+        for (auto v : {i, i + width, i + 1, i + 1, i + width, i + width + 1})
+            result.push_back(v);
+    }
+    result.resize(count);
+    return result;
+}
+
+static void serialize_indices_delta(benchmark::State& state) {
+    auto indices = make_indices(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        byte_vector out;
+        serialize_delta_encoded(indices, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0) *
+                            static_cast<int64_t>(sizeof(u32)));
+}
+
+static void deserialize_indices_delta(benchmark::State& state) {
+    byte_vector data;
+    serialize_delta_encoded(make_indices(static_cast<size_t>(state.range(0))), data);
+    state.counters["ratio"] =
+        static_cast<double>(data.size()) / static_cast<double>(static_cast<size_t>(state.range(0)) * sizeof(u32));
+
+    for (auto _ : state) {
+        vector<u32> result;
+        span<const byte> in = data;
+        deserialize_delta_encoded(result, in);
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0) *
+                            static_cast<int64_t>(sizeof(u32)));
+}
+
+constexpr int64_t elements_count = 1 << 20;
+
+BENCHMARK_TEMPLATE(serialize_slow, vec3f)->Arg(elements_count);
+BENCHMARK_TEMPLATE(serialize_fast, vec3f)->Arg(elements_count);
+BENCHMARK(deserialize_vec3f_slow)->Arg(elements_count);
+BENCHMARK_TEMPLATE(deserialize_fast, vec3f)->Arg(elements_count);
+
+BENCHMARK_TEMPLATE(serialize_slow, u32)->Arg(elements_count);
+BENCHMARK_TEMPLATE(serialize_fast, u32)->Arg(elements_count);
+BENCHMARK_TEMPLATE(deserialize_fast, u32)->Arg(elements_count);
+BENCHMARK(serialize_indices_delta)->Arg(elements_count);
+BENCHMARK(deserialize_indices_delta)->Arg(elements_count);
+
+BENCHMARK_TEMPLATE(serialize_slow, glm::mat4)->Arg(elements_count / 16);
+BENCHMARK_TEMPLATE(serialize_fast, glm::mat4)->Arg(elements_count / 16);
+BENCHMARK_TEMPLATE(deserialize_fast, glm::mat4)->Arg(elements_count / 16);
+
+BENCHMARK_TEMPLATE(serialize_slow, grx::grx_bone_vertex_data)->Arg(elements_count);
+BENCHMARK_TEMPLATE(serialize_fast, grx::grx_bone_vertex_data)->Arg(elements_count);
+BENCHMARK_TEMPLATE(deserialize_fast, grx::grx_bone_vertex_data)->Arg(elements_count);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,124 @@
+#include <random>
+
+#include <core/fiber_pool.hpp>
+#include <processing/terrain_generation.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace core;
+using namespace prc;
+
+static constexpr auto terrain_size = vec2f{1000.f, 1000.f};
+static constexpr auto max_height   = 100.f;
+
+static grx_float_color_map_r test_height_map() {
+    auto hmap = grx_float_color_map_r({1024, 1024}); // NOLINT
+    auto gen  = std::mt19937(1337);                 // NOLINT
+    for (auto [x, y] : dimensional_seq(hmap.size()))
+        hmap[y][x] = vec{std::sin(float(x) * 0.01f) * std::cos(float(y) * 0.013f) * 0.4f + 0.5f + // NOLINT
+                         float(gen() % 100) * 0.0005f};                                            // NOLINT
+    return hmap;
+}
+
+/* The previous terrain_editor::generate: every vertex samples the height map and faces are added one by one */
+static void terrain_generate_serial(benchmark::State& state) {
+    auto hmap       = test_height_map();
+    auto vert_count = vec2u::filled_with(static_cast<u32>(state.range(0))) + vec2u{2, 2};
+    auto size_f     = vec2f(hmap.size() - vec2u{1, 1}) / terrain_size;
+    auto uv_max     = vec2f(vert_count - vec2u{1, 1});
+
+    auto take_color = [&](vec2f pos) {
+        auto p  = pos * size_f;
+        auto p1 = vec{std::floor(p.x()), std::floor(p.y())};
+        auto p2 = vec{std::ceil(p.x()), std::ceil(p.y())};
+        auto p3 = vec{p2.x(), p1.y()};
+        auto p4 = vec{p1.x(), p2.y()};
+
+        float colors[] = {hmap[size_t(p1.y())][size_t(p1.x())].get().x(),
+                          hmap[size_t(p2.y())][size_t(p2.x())].get().x(),
+                          hmap[size_t(p3.y())][size_t(p3.x())].get().x(),
+                          hmap[size_t(p4.y())][size_t(p4.x())].get().x()};
+        float dsts[]   = {(p - p1).magnitude(), (p - p2).magnitude(), (p - p3).magnitude(), (p - p4).magnitude()};
+
+        float inf_max = 0.f;
+        for (size_t i = 0; i < 4; ++i) {
+            if (dsts[i] < 0.00001f) // NOLINT
+                return colors[i];
+            dsts[i] = 1.f / dsts[i];
+            inf_max += dsts[i];
+        }
+
+        float result = 0.f;
+        for (size_t i = 0; i < 4; ++i)
+            result += colors[i] * (dsts[i] / inf_max);
+        return result;
+    };
+
+    for (auto _ : state) {
+        vector<terrain_editor::vertex_data> vertices;
+        vector<terrain_editor::face_data>   faces;
+
+        for (auto [x, y] : dimensional_seq(vert_count)) {
+            auto f = terrain_size * vec2f{float(x), float(y)} / vec2f(vert_count);
+            vertices.push_back({vec{f.x(), max_height * take_color(f), f.y()}, vec{float(x), float(y)} / uv_max});
+        }
+
+        for (auto [x, y] : dimensional_seq(vert_count - vec2u{1, 1})) {
+            faces.push_back({y * vert_count.x() + x, (y + 1) * vert_count.x() + x, y * vert_count.x() + x + 1});
+            faces.back().recalc_normal(vertices);
+            faces.push_back(
+                {y * vert_count.x() + x + 1, (y + 1) * vert_count.x() + x, (y + 1) * vert_count.x() + x + 1});
+            faces.back().recalc_normal(vertices);
+        }
+
+        for (auto& v : vertices)
+            v.normal.make_normalize();
+
+        benchmark::DoNotOptimize(vertices.data());
+        benchmark::DoNotOptimize(faces.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * vert_count.x() * vert_count.y());
+}
+
+/* state.range(1): 0 - inverse distance weights, 1 - bilinear; state.range(2): threads (0 - global pool) */
+static void terrain_generate(benchmark::State& state) {
+    auto hmap       = test_height_map();
+    auto split      = vec2u::filled_with(static_cast<u32>(state.range(0)));
+    auto vert_count = split + vec2u{2, 2};
+    auto pool       = state.range(2) ? make_unique<fiber_pool>(static_cast<size_t>(state.range(2))) : nullptr;
+
+    for (auto _ : state) {
+        auto terrain = state.range(1)
+                           ? terrain_editor::generate_bilinear(hmap, terrain_size, max_height, split, pool.get())
+                           : terrain_editor::generate(hmap,
+                                                      terrain_size,
+                                                      max_height,
+                                                      split,
+                                                      terrain_editor::terrain_gen_identity_curve,
+                                                      pool.get());
+        benchmark::DoNotOptimize(terrain.get_vertices().data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * vert_count.x() * vert_count.y());
+
+    if (pool)
+        pool->close();
+}
+
+BENCHMARK(terrain_generate_serial)->Arg(1024)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(terrain_generate)
+    ->Args({1024, 0, 1})
+    ->Args({1024, 1, 1})
+    ->Args({1024, 0, 0})
+    ->Args({1024, 1, 0})
+    ->Args({4096, 0, 0})
+    ->Args({4096, 1, 0})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+
+    /* Terrains are generated on the global pool */
+    global_fiber_pool().close();
+}
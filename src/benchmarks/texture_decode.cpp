@@ -0,0 +1,77 @@
+#include <random>
+
+#include <core/fiber_pool.hpp>
+#include <util/texture_decode.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace core;
+using namespace util;
+
+/* Random blocks decode as well as real ones, the decoder has no data-dependent branches */
+static vector<byte> random_bytes(size_t size) {
+    vector<byte> result(size);
+    auto         gen = std::mt19937(1337); // NOLINT
+    for (auto& b : result)
+        b = static_cast<byte>(gen());
+    return result;
+}
+
+/* {format, image side, channels} */
+static void dxt_decode_image(benchmark::State& state) {
+    auto format   = static_cast<dxt_format>(state.range(0));
+    auto side     = static_cast<u32>(state.range(1));
+    auto channels = static_cast<size_t>(state.range(2));
+    auto size     = vec2u{side, side};
+    auto data     = random_bytes(dxt_data_size(format, size));
+
+    vector<u8> output(size_t(side) * side * channels);
+    for (auto _ : state) {
+        dxt_decode(format, data, size, output.data(), channels);
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.counters["pixels"] = benchmark::Counter(static_cast<double>(state.iterations()) * side * side,
+                                                  benchmark::Counter::kIsRate);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(output.size()));
+}
+
+/* {format, image side} */
+static void packed_pixels_decode(benchmark::State& state) {
+    auto format = static_cast<packed_pixel_format>(state.range(0));
+    auto count  = static_cast<size_t>(state.range(1) * state.range(1));
+    auto data   = random_bytes(count * packed_pixel_size(format));
+
+    vector<u8> output(count * 4);
+    for (auto _ : state) {
+        decode_packed_pixels(format, data, count, output.data());
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(output.size()));
+}
+
+BENCHMARK(dxt_decode_image)
+    ->Args({static_cast<int64_t>(dxt_format::dxt1), 2048, 3})
+    ->Args({static_cast<int64_t>(dxt_format::dxt1), 2048, 4})
+    ->Args({static_cast<int64_t>(dxt_format::dxt1_onebitalpha), 2048, 4})
+    ->Args({static_cast<int64_t>(dxt_format::dxt3), 2048, 4})
+    ->Args({static_cast<int64_t>(dxt_format::dxt5), 2048, 4})
+    ->Args({static_cast<int64_t>(dxt_format::dxt5), 256, 4})
+    ->Args({static_cast<int64_t>(dxt_format::bc7), 2048, 4})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+BENCHMARK(packed_pixels_decode)
+    ->Args({static_cast<int64_t>(packed_pixel_format::bgra4444), 2048})
+    ->Args({static_cast<int64_t>(packed_pixel_format::bgra5551), 2048})
+    ->Args({static_cast<int64_t>(packed_pixel_format::bgrx8888), 2048})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+
+    /* Decoding runs on the global pool */
+    global_fiber_pool().close();
+}
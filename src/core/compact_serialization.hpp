@@ -0,0 +1,429 @@
+#pragma once
+
+#include "serialization.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define PE_STREAM_VBYTE_X86
+#endif
+
+/*
+ * Opt-in compact integer encodings
+ *
+ * varint<T>            - LEB128 (7 bits per byte), signed values are zigzag encoded
+ * delta_encoded<T>     - u32 sequence as zigzag deltas packed with stream-vbyte
+ *
+ * Stream-vbyte stores 2-bit length codes of four values in one control byte, followed by
+ * the 1-4 significant bytes of every value. The control stream goes first, so the decoder
+ * expands four values per control byte with one shuffle (SSSE3 if supported by the CPU)
+ */
+
+namespace core
+{
+    constexpr u32 zigzag_encode(i32 value) {
+        return (static_cast<u32>(value) << 1U) ^ static_cast<u32>(value >> 31); // NOLINT
+    }
+
+    constexpr u64 zigzag_encode(i64 value) {
+        return (static_cast<u64>(value) << 1U) ^ static_cast<u64>(value >> 63); // NOLINT
+    }
+
+    constexpr i32 zigzag_decode(u32 value) {
+        return static_cast<i32>(value >> 1U) ^ -static_cast<i32>(value & 1U);
+    }
+
+    constexpr i64 zigzag_decode(u64 value) {
+        return static_cast<i64>(value >> 1U) ^ -static_cast<i64>(value & 1U);
+    }
+
+    //===================== Varint
+
+    constexpr size_t varint_size(u64 value) {
+        size_t size = 1;
+        while (value >= 0x80) { // NOLINT
+            value >>= 7U;       // NOLINT
+            ++size;
+        }
+        return size;
+    }
+
+    inline void serialize_varint(u64 value, byte_vector& out) {
+        while (value >= 0x80) { // NOLINT
+            out.push_back(static_cast<byte>((value & 0x7f) | 0x80)); // NOLINT
+            value >>= 7U; // NOLINT
+        }
+        out.push_back(static_cast<byte>(value));
+    }
+
+    inline u64 deserialize_varint(span<const byte>& in) {
+        u64      value = 0;
+        unsigned shift = 0;
+
+        while (true) {
+            Expects(!in.empty() && shift < 64); // NOLINT
+
+            auto b = static_cast<u64>(in[0]);
+            in     = in.subspan(1);
+
+            value |= (b & 0x7f) << shift; // NOLINT
+            if (!(b & 0x80))              // NOLINT
+                return value;
+
+            shift += 7; // NOLINT
+        }
+    }
+
+    /**
+     * @brief Integer which is serialized as LEB128 varint
+     *
+     * Signed values are zigzag encoded, so small negative numbers stay small
+     */
+    template <typename T> requires Integral<T>
+    struct varint {
+        void serialize(byte_vector& out) const {
+            serialize_varint(encoded(), out);
+        }
+
+        void deserialize(span<const byte>& in) {
+            auto v = deserialize_varint(in);
+            if constexpr (std::is_signed_v<T>)
+                value = static_cast<T>(zigzag_decode(v));
+            else
+                value = static_cast<T>(v);
+        }
+
+        [[nodiscard]]
+        size_t serialized_size() const {
+            return varint_size(encoded());
+        }
+
+        [[nodiscard]]
+        u64 encoded() const {
+            if constexpr (std::is_signed_v<T>)
+                return zigzag_encode(static_cast<i64>(value));
+            else
+                return static_cast<u64>(value);
+        }
+
+        T value = 0;
+    };
+
+    //===================== Stream-vbyte
+
+    namespace stream_vbyte_details
+    {
+        struct tables_t {
+            array<u8, 256>                lengths; /* Data bytes of four values */
+            array<array<u8, 16>, 256>     decode;  /* Data bytes -> four u32 */
+            array<array<u8, 16>, 256>     encode;  /* Four u32 -> data bytes */
+        };
+
+        constexpr tables_t make_tables() {
+            tables_t t{};
+
+            for (unsigned c = 0; c < 256; ++c) { // NOLINT
+                t.decode[c].fill(0x80); // NOLINT
+                t.encode[c].fill(0x80); // NOLINT
+
+                unsigned pos = 0;
+                for (unsigned lane = 0; lane < 4; ++lane) {
+                    auto len = ((c >> (2 * lane)) & 3U) + 1;
+                    for (unsigned b = 0; b < len; ++b) {
+                        t.decode[c][lane * 4 + b] = static_cast<u8>(pos + b);
+                        t.encode[c][pos + b]      = static_cast<u8>(lane * 4 + b);
+                    }
+                    pos += len;
+                }
+                t.lengths[c] = static_cast<u8>(pos);
+            }
+
+            return t;
+        }
+
+        inline constexpr tables_t tables = make_tables();
+
+        constexpr u32 value_code(u32 value) {
+            return value < (1U << 8U) ? 0 : value < (1U << 16U) ? 1 : value < (1U << 24U) ? 2 : 3; // NOLINT
+        }
+
+        inline bool simd_supported() {
+#ifdef PE_STREAM_VBYTE_X86
+            static const bool supported = __builtin_cpu_supports("ssse3");
+            return supported;
+#else
+            return false;
+#endif
+        }
+
+        /* Returns the count of data bytes */
+        template <bool Delta>
+        size_t encode_scalar(const u32* values, size_t count, byte* control, byte* data, u32 prev) {
+            auto start = data;
+
+            for (size_t i = 0; i < count; ++i) {
+                auto value = values[i];
+                if constexpr (Delta) {
+                    value = zigzag_encode(static_cast<i32>(values[i] - prev));
+                    prev  = values[i];
+                }
+
+                auto code = value_code(value);
+                if (i % 4 == 0)
+                    control[i / 4] = byte(0);
+                control[i / 4] |= static_cast<byte>(code << (2 * (i % 4)));
+
+                for (u32 b = 0; b <= code; ++b)
+                    *data++ = static_cast<byte>(value >> (8 * b)); // NOLINT
+            }
+
+            return static_cast<size_t>(data - start);
+        }
+
+        /* Returns the count of data bytes */
+        template <bool Delta>
+        size_t decode_scalar(const byte* control, const byte* data, size_t count, u32* out, u32 prev) {
+            auto start = data;
+
+            for (size_t i = 0; i < count; ++i) {
+                auto code  = (static_cast<u32>(control[i / 4]) >> (2 * (i % 4))) & 3U;
+                u32  value = 0;
+                for (u32 b = 0; b <= code; ++b)
+                    value |= static_cast<u32>(*data++) << (8 * b); // NOLINT
+
+                if constexpr (Delta) {
+                    prev += static_cast<u32>(zigzag_decode(value));
+                    value = prev;
+                }
+                out[i] = value;
+            }
+
+            return static_cast<size_t>(data - start);
+        }
+
+#ifdef PE_STREAM_VBYTE_X86
+        /* Encodes groups of four values, the data must have 16 bytes of slack */
+        template <bool Delta>
+        __attribute__((target("ssse3")))
+        size_t encode_ssse3(const u32* values, size_t groups, byte* control, byte* data) {
+            auto start = data;
+            auto prev  = _mm_setzero_si128();
+
+            for (size_t g = 0; g < groups; ++g) {
+                auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + g * 4)); // NOLINT
+
+                if constexpr (Delta) {
+                    auto shifted = _mm_alignr_epi8(v, prev, 12); // NOLINT
+                    prev         = v;
+                    auto delta   = _mm_sub_epi32(v, shifted);
+                    v            = _mm_xor_si128(_mm_slli_epi32(delta, 1), _mm_srai_epi32(delta, 31)); // NOLINT
+                }
+
+                alignas(16) u32 lanes[4]; // NOLINT
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes), v); // NOLINT
+
+                auto code = value_code(lanes[0]) | (value_code(lanes[1]) << 2U) | (value_code(lanes[2]) << 4U) |
+                            (value_code(lanes[3]) << 6U); // NOLINT
+                control[g] = static_cast<byte>(code);
+
+                auto shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.encode[code].data())); // NOLINT
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(data), _mm_shuffle_epi8(v, shuffle)); // NOLINT
+                data += tables.lengths[code];
+            }
+
+            return static_cast<size_t>(data - start);
+        }
+
+        /* Decodes groups of four values while 16 bytes can be loaded from the data */
+        template <bool Delta>
+        __attribute__((target("ssse3")))
+        size_t decode_ssse3(const byte* control, const byte* data, size_t data_size, size_t groups, u32* out,
+                            size_t& decoded_groups) {
+            auto start = data;
+            auto end   = data + data_size;
+            auto prev  = _mm_setzero_si128();
+            auto one   = _mm_set1_epi32(1);
+
+            size_t g = 0;
+            for (; g < groups && end - data >= 16; ++g) {
+                auto code    = static_cast<u8>(control[g]);
+                auto shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.decode[code].data())); // NOLINT
+                auto packed  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)); // NOLINT
+                auto v       = _mm_shuffle_epi8(packed, shuffle);
+
+                if constexpr (Delta) {
+                    v = _mm_xor_si128(_mm_srli_epi32(v, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(v, one)));
+                    v = _mm_add_epi32(v, _mm_slli_si128(v, 4)); // NOLINT
+                    v = _mm_add_epi32(v, _mm_slli_si128(v, 8)); // NOLINT
+                    v = _mm_add_epi32(v, prev);
+                    prev = _mm_shuffle_epi32(v, 0xff); // NOLINT
+                }
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + g * 4), v); // NOLINT
+                data += tables.lengths[code];
+            }
+
+            decoded_groups = g;
+            return static_cast<size_t>(data - start);
+        }
+#endif
+    } // namespace stream_vbyte_details
+
+    constexpr size_t stream_vbyte_control_size(size_t count) {
+        return (count + 3) / 4;
+    }
+
+    /**
+     * @brief Gets the maximum size of stream-vbyte encoded values
+     */
+    constexpr size_t stream_vbyte_max_size(size_t count) {
+        return stream_vbyte_control_size(count) + count * sizeof(u32);
+    }
+
+    /**
+     * @brief Encodes values with stream-vbyte
+     *
+     * @tparam Delta - encode zigzag deltas of consecutive values (the first value is the delta from zero)
+     * @param values - values to encode
+     * @param out - the output, must have stream_vbyte_max_size(count) + 16 bytes
+     *
+     * @return the size of encoded data
+     */
+    template <bool Delta = false>
+    size_t stream_vbyte_encode(span<const u32> values, byte* out) {
+        using namespace stream_vbyte_details;
+
+        auto count   = static_cast<size_t>(values.size());
+        auto control = out;
+        auto data    = out + stream_vbyte_control_size(count);
+        auto groups  = count / 4;
+
+        size_t data_size = 0;
+#ifdef PE_STREAM_VBYTE_X86
+        if (simd_supported()) {
+            data_size = encode_ssse3<Delta>(values.data(), groups, control, data);
+        }
+        else
+#endif
+        {
+            data_size = encode_scalar<Delta>(values.data(), groups * 4, control, data, 0);
+        }
+
+        if (groups * 4 < count)
+            data_size += encode_scalar<Delta>(values.data() + groups * 4,
+                                              count - groups * 4,
+                                              control + groups,
+                                              data + data_size,
+                                              groups ? values[static_cast<ptrdiff_t>(groups * 4 - 1)] : 0);
+
+        return stream_vbyte_control_size(count) + data_size;
+    }
+
+    /**
+     * @brief Decodes values encoded with stream_vbyte_encode
+     *
+     * @tparam Delta - must be same as for the encoding
+     * @param in - encoded data
+     * @param out - the output for count values
+     * @param count - the count of encoded values
+     *
+     * @return the size of consumed data
+     */
+    template <bool Delta = false>
+    size_t stream_vbyte_decode(span<const byte> in, u32* out, size_t count) {
+        using namespace stream_vbyte_details;
+
+        auto control_size = stream_vbyte_control_size(count);
+        Expects(control_size <= static_cast<size_t>(in.size()));
+
+        /* Validate the data size before the decoding */
+        auto   control   = in.data();
+        size_t data_size = 0;
+        for (size_t i = 0; i < count / 4; ++i)
+            data_size += tables.lengths[static_cast<u8>(control[i])];
+        for (size_t i = count / 4 * 4; i < count; ++i)
+            data_size += ((static_cast<u32>(control[i / 4]) >> (2 * (i % 4))) & 3U) + 1;
+
+        Expects(data_size <= static_cast<size_t>(in.size()) - control_size);
+
+        auto   data   = control + control_size;
+        size_t groups = 0;
+        size_t used   = 0;
+#ifdef PE_STREAM_VBYTE_X86
+        if (simd_supported())
+            used = decode_ssse3<Delta>(control, data, data_size, count / 4, out, groups);
+#endif
+
+        used += decode_scalar<Delta>(
+            control + groups, data + used, count - groups * 4, out + groups * 4, groups ? out[groups * 4 - 1] : 0);
+
+        return control_size + used;
+    }
+
+    //===================== Delta encoding
+
+    /**
+     * @brief Serializes the u32 sequence as stream-vbyte packed zigzag deltas
+     *
+     * Suits sequences where neighbour values are close (e.g. mesh indices)
+     */
+    inline void serialize_delta_encoded(span<const u32> values, byte_vector& out) {
+        auto count = static_cast<size_t>(values.size());
+        serialize_varint(count, out);
+
+        auto pos = out.size();
+        out.resize(pos + stream_vbyte_max_size(count) + 16); // NOLINT
+        out.resize(pos + stream_vbyte_encode<true>(values, out.data() + pos));
+    }
+
+    /**
+     * @brief Deserializes the sequence written by serialize_delta_encoded
+     *
+     * Replaces content of the vector
+     */
+    inline void deserialize_delta_encoded(vector<u32>& values, span<const byte>& in) {
+        auto count = deserialize_varint(in);
+
+        /* At least one data byte per value */
+        Expects(count <= static_cast<u64>(in.size()));
+
+        values.resize(static_cast<size_t>(count));
+        auto used = stream_vbyte_decode<true>(in, values.data(), values.size());
+        in        = in.subspan(static_cast<ptrdiff_t>(used));
+    }
+
+    inline size_t delta_encoded_size(span<const u32> values) {
+        auto count = static_cast<size_t>(values.size());
+        auto size  = varint_size(count) + stream_vbyte_control_size(count);
+
+        u32 prev = 0;
+        for (auto v : values) {
+            size += stream_vbyte_details::value_code(zigzag_encode(static_cast<i32>(v - prev))) + 1;
+            prev = v;
+        }
+        return size;
+    }
+
+    /**
+     * @brief Sequence which is serialized with serialize_delta_encoded
+     */
+    template <typename T>
+    struct delta_encoded;
+
+    template <>
+    struct delta_encoded<vector<u32>> {
+        void serialize(byte_vector& out) const {
+            serialize_delta_encoded(data, out);
+        }
+
+        void deserialize(span<const byte>& in) {
+            deserialize_delta_encoded(data, in);
+        }
+
+        [[nodiscard]]
+        size_t serialized_size() const {
+            return delta_encoded_size(data);
+        }
+
+        vector<u32> data;
+    };
+} // namespace core
@@ -3,6 +3,7 @@
 #include "print.hpp"
 #include "ston.hpp"
 #include "vec.hpp"
+#include <algorithm>
 #include <fstream>
 #include <utility>
 
@@ -75,8 +76,13 @@ private:
 template <typename T, size_t S>
 class dimensional_index_iterator : public std::iterator<std::forward_iterator_tag, T> {
 public:
-    dimensional_index_iterator(array<T, S> end) noexcept: ends(end) {}
-    dimensional_index_iterator(array<T, S> start, array<T, S> end) noexcept: idxs(start), ends(end) {}
+    dimensional_index_iterator(array<T, S> end) noexcept: ends(end) {
+        wrapped = std::find(ends.begin(), ends.end(), T(0)) != ends.end();
+    }
+    dimensional_index_iterator(array<T, S> start, array<T, S> end) noexcept: idxs(start), starts(start), ends(end) {
+        for (size_t i = 0; i < S; ++i)
+            wrapped = wrapped || starts[i] >= ends[i];
+    }
     dimensional_index_iterator() noexcept: wrapped(true) {}
 
     inline dimensional_index_iterator& operator++() noexcept {
@@ -91,7 +97,7 @@ public:
     }
 
     inline bool operator==(const dimensional_index_iterator& i) const noexcept {
-        return idxs == i.idxs && wrapped == i.wrapped;
+        return wrapped == i.wrapped && (wrapped || idxs == i.idxs);
     }
 
     inline bool operator!=(const dimensional_index_iterator& i) const noexcept {
@@ -107,7 +113,7 @@ private:
         if (idx != S) {
             ++idxs[idx];
             if (idxs[idx] == ends[idx]) {
-                idxs[idx] = 0;
+                idxs[idx] = starts[idx];
                 increment(idx + 1);
             }
         } else
@@ -115,7 +121,8 @@ private:
     }
 
 private:
-    array<T, S> idxs = {0};
+    array<T, S> idxs   = {0};
+    array<T, S> starts = {0};
     array<T, S> ends;
     bool wrapped = false;
 };
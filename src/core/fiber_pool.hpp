@@ -6,7 +6,9 @@
 #include <boost/fiber/future/packaged_task.hpp>
 #include <boost/fiber/operations.hpp>
 
+#include <atomic>
 #include "types.hpp"
+#include "pe_throw.hpp"
 
 namespace core
 {
@@ -72,13 +74,34 @@ public:
         return count < 2 ? 1 : count - 1;
     }
 
+    /**
+     * @brief Starts worker threads of the pool
+     *
+     * Pools of several threads schedule fibers with work_stealing, its schedulers are registered in static tables
+     * of Boost.Fiber. So only one such pool may exist at a time, it is global_fiber_pool() in the engine. Pools of
+     * one thread use the default scheduler and may be created at any time, e.g. to run jobs serially
+     *
+     * @throw runtime_error if another pool of several threads exists
+     *
+     * @param threads_count - the count of worker threads
+     * @param iwork_queue_size - the capacity of the task queue
+     */
     fiber_pool(size_t threads_count = default_threads_count(), size_t iwork_queue_size = default_work_queue_size):
         threads_count_(threads_count), work_queue_size_(iwork_queue_size), channel_(iwork_queue_size) {
+        if (threads_count_ > 1 && work_stealing_pools_.fetch_add(1) != 0) {
+            --work_stealing_pools_;
+            pe_throw std::runtime_error("Only one fiber pool with several threads may exist at a time");
+        }
+
         try {
             for (uint32_t i = 0; i < threads_count_; ++i) threads_.emplace_back(&fiber_pool::worker, this);
         }
         catch (...) {
             close();
+            for (auto& t : threads_)
+                t.join();
+            if (threads_count_ > 1)
+                --work_stealing_pools_;
             std::rethrow_exception(std::current_exception());
         }
     }
@@ -91,6 +114,8 @@ public:
     ~fiber_pool() {
         for (auto& t : threads_)
             t.join();
+        if (threads_count_ > 1)
+            --work_stealing_pools_;
     }
 
     void close() {
@@ -131,7 +156,9 @@ public:
 
 private:
     void worker() {
-        fibers::use_scheduling_algorithm<fibers::algo::work_stealing>(threads_count_, true);
+        /* work_stealing looks for a victim other than itself, so it spins forever with the only thread */
+        if (threads_count_ > 1)
+            fibers::use_scheduling_algorithm<fibers::algo::work_stealing>(threads_count_, true);
 
         task_tuple_t task_tuple;
         while (channel_.pop(task_tuple) == fibers::channel_op_status::success) {
@@ -141,6 +168,8 @@ private:
     }
 
 private:
+    static inline std::atomic<size_t> work_stealing_pools_ = 0;
+
     size_t                                 threads_count_ = 1;
     size_t                                 work_queue_size_;
     fibers::buffered_channel<task_tuple_t> channel_;
@@ -161,4 +190,87 @@ template <typename F, typename... ArgsT>
 auto submit_job(F&& function, ArgsT&&... args) {
     return global_fiber_pool().submit(forward<F>(function), forward<ArgsT>(args)...);
 }
+
+/**
+ * @brief Waits for all jobs and rethrows the first exception after that
+ *
+ * Jobs usually reference the caller's input or output, so none of them may outlive an exception
+ *
+ * @param jobs - futures of the jobs
+ * @param on_result - function called in the jobs order as void(size_t index, T&& result) (or void(size_t index)
+ * for void jobs) for each job that has finished without exception
+ */
+template <typename T, typename F>
+void wait_all_rethrow(vector<job_future<T>>& jobs, F&& on_result) {
+    std::exception_ptr error;
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                jobs[i].get();
+                on_result(i);
+            }
+            else {
+                on_result(i, jobs[i].get());
+            }
+        }
+        catch (...) {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+/**
+ * @brief Waits for all jobs and rethrows the first exception after that
+ *
+ * @param jobs - futures of the jobs
+ */
+template <typename T>
+void wait_all_rethrow(vector<job_future<T>>& jobs) {
+    if constexpr (std::is_void_v<T>)
+        wait_all_rethrow(jobs, [](size_t) {});
+    else
+        wait_all_rethrow(jobs, [](size_t, T&&) {});
+}
+
+/**
+ * @brief Calls function(begin, end) for subranges of [0, count) on the fiber pool and waits for all of them
+ *
+ * Subranges are not shorter than min_range (except the last one), so small inputs are processed
+ * in the calling thread. The first exception is rethrown after all subranges are finished
+ *
+ * @param count - the count of items
+ * @param min_range - the minimal count of items per job
+ * @param function - void(size_t begin, size_t end)
+ * @param pool - the fiber pool which runs jobs, nullptr - the global fiber pool
+ */
+template <typename F>
+void parallel_for(size_t count, size_t min_range, F&& function, fiber_pool* pool = nullptr) {
+    min_range = std::max<size_t>(min_range, 1);
+
+    if (count <= min_range) {
+        if (count)
+            function(size_t(0), count);
+        return;
+    }
+
+    if (!pool)
+        pool = &global_fiber_pool();
+
+    /* A few jobs per thread balance uneven subranges */
+    auto jobs_count = std::min(count / min_range, pool->threads_count() * 4);
+    auto step       = (count + jobs_count - 1) / jobs_count;
+
+    vector<job_future<void>> jobs;
+    jobs.reserve(jobs_count);
+
+    for (size_t begin = 0; begin < count; begin += step)
+        jobs.push_back(pool->submit([&function, begin, end = std::min(begin + step, count)] { function(begin, end); }));
+
+    wait_all_rethrow(jobs);
+}
 } // namespace core
@@ -51,6 +51,11 @@ public:
         core::deserialize(_data, in);
     }
 
+    [[nodiscard]]
+    static constexpr size_t serialized_size() {
+        return sizeof(Type);
+    }
+
     template <Type flag>
     struct _define_helper {
         static_assert(flag < sizeof(Type) * 8, "Can't define that bit!"); // NOLINT
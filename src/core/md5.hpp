@@ -289,7 +289,7 @@ inline md5_hash md5(string_view str) {
     return md5(str.data(), str.size());
 }
 
-inline md5_hash md5(span<byte> bytes) {
+inline md5_hash md5(span<const byte> bytes) {
     return md5(safe_u8_cast(bytes.data()), static_cast<size_t>(bytes.size()));
 }
 
@@ -14,6 +14,7 @@
 
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -144,6 +145,90 @@ namespace platform_dependent
         return result;
     }
 
+    /**
+     * @brief Read-only memory mapping of the whole file
+     */
+    class mapped_file {
+    public:
+        mapped_file() = default;
+
+        /**
+         * @brief Maps the file into memory
+         *
+         * @throw std::runtime_error if the file can't be opened or mapped
+         *
+         * @param path - the path to the file
+         */
+        explicit mapped_file(const string& path) {
+            int fd = ::open(path.data(), O_RDONLY | O_CLOEXEC); // NOLINT
+            if (fd == -1)
+                throw std::runtime_error("Can't open file \'" + path + "\'");
+
+            auto fd_guard = core::scope_guard{[fd]() { ::close(fd); }};
+
+            struct stat st; // NOLINT
+            if (fstat(fd, &st) == -1)
+                throw std::runtime_error("Can't stat file \'" + path + "\'");
+
+            _size = static_cast<size_t>(st.st_size);
+            if (_size == 0)
+                return;
+
+            auto addr = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) { // NOLINT
+                _size = 0;
+                throw std::runtime_error("Can't map file \'" + path + "\'");
+            }
+
+            _data = static_cast<const core::byte*>(addr);
+        }
+
+        ~mapped_file() {
+            unmap();
+        }
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        mapped_file(mapped_file&& f) noexcept: _data(f._data), _size(f._size) {
+            f._data = nullptr;
+            f._size = 0;
+        }
+
+        mapped_file& operator=(mapped_file&& f) noexcept {
+            if (this != &f) {
+                unmap();
+                _data   = f._data;
+                _size   = f._size;
+                f._data = nullptr;
+                f._size = 0;
+            }
+            return *this;
+        }
+
+        [[nodiscard]]
+        core::span<const core::byte> data() const {
+            return {_data, static_cast<ssize_t>(_size)};
+        }
+
+        [[nodiscard]]
+        size_t size() const {
+            return _size;
+        }
+
+    private:
+        void unmap() {
+            if (_data)
+                ::munmap(const_cast<core::byte*>(_data), _size); // NOLINT
+            _data = nullptr;
+            _size = 0;
+        }
+
+    private:
+        const core::byte* _data = nullptr;
+        size_t            _size = 0;
+    };
+
     inline bool recursive_create_directory(const core::string& path) {
         if (path.empty() || path == "." || path == "/")
             return true;
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <mutex>
+#include "types.hpp"
+#include "md5.hpp"
+#include "string_hash.hpp"
+#include "helper_macros.hpp"
+
+namespace core
+{
+/**
+ * @brief Process-wide index of source contents of resources loaded by managers of the same type
+ *
+ * Resources are looked up by the fast hash and the size of their source bytes. Candidates with the same
+ * fast hash are verified by md5, so md5 is computed only when the fast hash collides. Entries of destroyed
+ * managers are dropped on lookup
+ *
+ * @tparam MgrT - the type of the resource manager
+ */
+template <typename MgrT>
+class resource_content_index {
+    SINGLETON_IMPL(resource_content_index);
+
+public:
+    using resource_id_t = u64;
+
+    struct found_t {
+        shared_ptr<MgrT> mgr;
+        resource_id_t    id;
+    };
+
+    resource_content_index() = default;
+    ~resource_content_index() = default;
+
+    /**
+     * @brief Finds the resource loaded from the same content
+     *
+     * @param hash - the fast hash of bytes
+     * @param bytes - source bytes of the resource
+     * @param map_content - callable (const string& path) -> optional<T> where T has bytes() returning
+     * span<const byte>, used to read sources of candidates to compute their md5
+     *
+     * @return the manager and the id of the resource or nullopt
+     */
+    template <typename F>
+    optional<found_t> find(u64 hash, span<const byte> bytes, F&& map_content) {
+        /* Sources are mapped and hashed without the lock, it is taken only to read and store digests */
+        auto candidates = candidates_of(hash, static_cast<u64>(bytes.size()));
+
+        optional<md5_hash> md5_of_bytes;
+        for (auto& entry : candidates) {
+            if (!entry.md5) {
+                auto content = map_content(entry.path);
+                if (!content)
+                    continue;
+                entry.md5 = md5(content->bytes());
+                store_md5(hash, entry.path, *entry.md5);
+            }
+
+            if (!md5_of_bytes)
+                md5_of_bytes = md5(bytes);
+
+            if (*entry.md5 != *md5_of_bytes)
+                continue;
+
+            if (auto mgr = entry.mgr.lock())
+                return found_t{move(mgr), entry.id};
+        }
+
+        return nullopt;
+    }
+
+    /**
+     * @brief Inserts the resource
+     *
+     * @param hash - the fast hash of source bytes
+     * @param size - the size of source bytes
+     * @param mgr - the manager of the resource
+     * @param id - the id of the resource
+     * @param path - the absolute path to the source of the resource
+     */
+    void insert(u64 hash, u64 size, weak_ptr<MgrT> mgr, resource_id_t id, string path) {
+        std::lock_guard lock{_mutex};
+        _entries[hash].push_back(entry_t{move(mgr), id, move(path), size, nullopt});
+    }
+
+    [[nodiscard]]
+    size_t size() const {
+        std::lock_guard lock{_mutex};
+        size_t result = 0;
+        for (auto& [_, entries] : _entries)
+            result += entries.size();
+        return result;
+    }
+
+private:
+    struct entry_t {
+        weak_ptr<MgrT>     mgr;
+        resource_id_t      id;
+        string             path;
+        u64                size;
+        optional<md5_hash> md5;
+    };
+
+    /* Copies of live entries with the size, entries of destroyed managers are dropped */
+    vector<entry_t> candidates_of(u64 hash, u64 size) {
+        std::lock_guard lock{_mutex};
+
+        auto bucket = _entries.find(hash);
+        if (bucket == _entries.end())
+            return {};
+
+        auto& entries = bucket->second;
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [](auto& e) { return e.mgr.expired(); }),
+                      entries.end());
+
+        vector<entry_t> result;
+        for (auto& entry : entries)
+            if (entry.size == size)
+                result.push_back(entry);
+
+        return result;
+    }
+
+    void store_md5(u64 hash, const string& path, const md5_hash& digest) {
+        std::lock_guard lock{_mutex};
+
+        auto bucket = _entries.find(hash);
+        if (bucket == _entries.end())
+            return;
+
+        for (auto& entry : bucket->second)
+            if (!entry.md5 && entry.path == path)
+                entry.md5 = digest;
+    }
+
+    mutable std::mutex             _mutex;
+    hash_map<u64, vector<entry_t>> _entries;
+};
+} // namespace core
@@ -5,6 +5,8 @@
 #include "global_storage.hpp"
 #include "async.hpp"
 #include "assert.hpp"
+#include "resource_mgr_stats.hpp"
+#include "resource_content_index.hpp"
 
 namespace core {
 
@@ -44,6 +46,11 @@ public:
         *this = resource_provider_t(mgr_lookup<MgrT>(mgr_tag), filepath, load_sign);
     }
 
+    [[nodiscard]]
+    size_t serialized_size() const {
+        return serialized_size_all(_storage->mgr_tag(), path(), load_significance());
+    }
+
     resource_provider_t() = default;
     resource_provider_t(shared_ptr<MgrT>    mgr,
                         const cfg_path&     file_path,
@@ -129,7 +136,7 @@ public:
         return _storage->try_access(_resource_id);
     }
 
-private:
+protected:
     shared_ptr<MgrT> _storage;
     u64              _resource_id = numlim<u64>::max();
 };
@@ -158,13 +165,22 @@ public:
     static shared_ptr<DerivedT> create_shared(const string& mgr_tag) {
         auto ptr = make_shared<DerivedT>(constructor_accessor<resource_mgr_base>{}, mgr_tag);
         mgr_lookup_t::instance().insert(mgr_tag, ptr);
+        resource_mgr_stats_reg().insert(mgr_tag, [weak = weak_ptr<DerivedT>(ptr), mgr_tag]() {
+            if (auto mgr = weak.lock())
+                return mgr->stats();
+
+            resource_mgr_stats stats;
+            stats.mgr_tag = mgr_tag;
+            return stats;
+        });
         return ptr;
     }
 
     resource_id_t load_id(const cfg_path& path, load_significance_t load_significance = load_significance_t::medium) {
         using namespace core;
 
-        auto [position, was_inserted] = _path_to_id.emplace(path.absolute(), 0);
+        auto absolute = path.absolute();
+        auto [position, was_inserted] = _path_to_id.emplace(absolute, 0);
         if (!was_inserted) {
             auto id = position->second;
             increment_usages(id);
@@ -174,17 +190,31 @@ public:
             return position->second;
         }
 
-        auto id = new_id();
-        position->second = id;
-        _specs[position->second] = resource_spec_t{path, 1, load_significance};
-        _futures.emplace(id, static_cast<DerivedT*>(this)->load_async_cached(path));
-        DLOG("resource_mgr[{}]: create resource: path = {} id = {} usages = {}",
-             _mgr_tag,
-             path,
-             id,
-             1);
+        /* Resources with the same content are shared, the index is registered after the load starts. The source is
+         * mapped and hashed on the calling thread, the loader reads the same mapping instead of the file */
+        if constexpr (has_content_dedup()) {
+            if (_content_dedup) {
+                if (auto content = DerivedT::map_content(absolute)) {
+                    auto bytes = content->bytes();
+                    auto hash  = hash_fast64(bytes);
+                    auto size  = static_cast<u64>(bytes.size());
+                    auto map   = [](const string& source) { return DerivedT::map_content(source); };
+
+                    if (auto found = content_index().find(hash, bytes, map)) {
+                        auto id = share_content(path, load_significance, move(*found));
+                        _path_to_id[absolute] = id;
+                        _stats.dedup_file_bytes += size;
+                        return id;
+                    }
+
+                    auto id = create_resource(absolute, path, load_significance, move(*content));
+                    content_index().insert(hash, size, this->weak_from_this(), id, move(absolute));
+                    return id;
+                }
+            }
+        }
 
-        return id;
+        return create_resource(absolute, path, load_significance);
     }
 
     ProviderT load(const cfg_path& path, load_significance_t load_significance = load_significance_t::medium) {
@@ -205,6 +235,12 @@ public:
              spec.usages - 1,
              spec.usages);
 
+        if (auto alias = _aliases.find(id); alias != _aliases.end()) {
+            if (spec.usages == 1)
+                acquire_alias(id, alias->second);
+            return;
+        }
+
         if (spec.usages == 1) {
             auto& resource = _resources.at(id);
             if (!resource.value) {
@@ -212,8 +248,9 @@ public:
                     DLOG("resource_mgr[{}]: resource {} will be load from cache",
                          _mgr_tag,
                          spec.path);
-                    resource.value = DerivedT::from_cache(move(*resource.cached));
+                    resource.value = derived().make_resource(id, move(*resource.cached));
                     resource.cached.reset();
+                    ++_stats.cache_hits;
                 }
                 else {
                     DLOG("resource_mgr[{}]: resource {} will be load from file",
@@ -221,9 +258,8 @@ public:
                          spec.path);
                     auto found_spec = _specs.find(id);
                     PeAssert(found_spec != _specs.end());
-                    _futures.emplace(
-                        id,
-                        static_cast<DerivedT*>(this)->load_async_cached(found_spec->second.path));
+                    ++_stats.disk_reloads;
+                    start_load(id, found_spec->second.path);
                 }
             }
         }
@@ -244,6 +280,19 @@ public:
              spec.path,
              spec.usages,
              spec.usages - 1);
+
+        if (auto alias = _aliases.find(id); alias != _aliases.end()) {
+            if (spec.usages == 1) {
+                auto owner = move(alias->second.owner);
+                --spec.usages;
+                owner->decrement_usages(alias->second.id);
+            }
+            else {
+                --spec.usages;
+            }
+            return;
+        }
+
         if (spec.usages == 1) {
             auto found_resource = _resources.find(id);
 
@@ -255,6 +304,7 @@ public:
                 }};
                 resource_val_t resource;
                 resource.cached = move(future_pos->second.get());
+                complete_load(id);
 
                 auto [position, _] = _resources.insert_or_assign(id, move(resource));
                 found_resource = position;
@@ -270,7 +320,7 @@ public:
             if (spec.load_significance == load_significance_t::medium) {
                 DLOG("resource_mgr[{}]: resource {} will be cached", _mgr_tag, spec.path);
                 if (resource.value) {
-                    resource.cached = DerivedT::to_cache(move(resource.value.value()));
+                    resource.cached = derived().make_cache(id, move(resource.value.value()));
                     resource.value.reset();
                 }
                 else {
@@ -280,6 +330,8 @@ public:
             }
             else if (spec.load_significance == load_significance_t::low) {
                 DLOG("resource_mgr[{}]: resource {} will be unloaded", _mgr_tag, spec.path);
+                if (resource.value)
+                    derived().release_resource(id);
                 resource.value.reset();
             }
         }
@@ -288,6 +340,11 @@ public:
     }
 
     T* try_access(resource_id_t id, bool wait = false) {
+        if (auto alias = _aliases.find(id); alias != _aliases.end()) {
+            auto& owner = alias->second.owner;
+            return owner ? owner->try_access(alias->second.id, wait) : nullptr;
+        }
+
         auto found_resource = _resources.find(id);
         if (found_resource != _resources.end() && found_resource->second.value)
             return &found_resource->second.value.value();
@@ -318,7 +375,8 @@ public:
             }};
 
             resource_val_t resource;
-            resource.value = DerivedT::from_cache(move(future.get()));
+            resource.value = derived().make_resource(id, move(future.get()));
+            complete_load(id);
 
             auto [position, _] = _resources.insert_or_assign(id, move(resource));
             if (position->second.value)
@@ -363,6 +421,7 @@ public:
 
     ~resource_mgr_base() noexcept {
         mgr_lookup_t::instance().remove(_mgr_tag);
+        resource_mgr_stats_reg().remove(_mgr_tag);
     }
 
     resource_mgr_base(resource_mgr_base&&) noexcept = default;
@@ -375,17 +434,253 @@ public:
         return _mgr_tag;
     }
 
+    /**
+     * @brief Enables deduplication of resources by the content of their sources
+     *
+     * Requires static DerivedT::map_content(const string& path) which returns optional<U> with
+     * U::bytes() -> span<const byte>. Paths loaded after this call are hashed, paths with the same content as
+     * a resource already loaded by this manager or by another manager of DerivedT type get the id of
+     * the existing resource or an alias to the resource of another manager.
+     *
+     * Sources are mapped and hashed on the thread which calls load(). DerivedT may provide
+     * load_async_cached(const cfg_path& path, U content) to decode new resources from that mapping
+     *
+     * @param value - true to enable
+     */
+    void content_dedup(bool value) {
+        static_assert(has_content_dedup(), "DerivedT must provide static map_content(const string&)");
+        _content_dedup = value;
+    }
+
+    [[nodiscard]]
+    bool content_dedup() const {
+        return _content_dedup;
+    }
+
+    /**
+     * @brief Gets the manager and the id of the resource which is actually loaded for the id
+     *
+     * Ids of resources shared with another manager are resolved to that manager while they are used
+     *
+     * @param id - the resource id
+     *
+     * @return the manager and the resource id
+     */
+    [[nodiscard]]
+    pair<DerivedT*, resource_id_t> content_owner(resource_id_t id) {
+        if (auto alias = _aliases.find(id); alias != _aliases.end() && alias->second.owner)
+            return {alias->second.owner.get(), alias->second.id};
+        return {&derived(), id};
+    }
+
+    /**
+     * @brief Makes the resource from its cached form
+     *
+     * DerivedT may hide this function (and make_cache() with release_resource()) to keep a state of loaded resources.
+     * The default one calls static DerivedT::from_cache(CachedT&&)
+     */
+    T make_resource([[maybe_unused]] resource_id_t id, CachedT&& cache) {
+        return DerivedT::from_cache(move(cache));
+    }
+
+    /**
+     * @brief Makes the cached form of the resource which is not used anymore
+     *
+     * The default one calls static DerivedT::to_cache(T&&)
+     */
+    CachedT make_cache([[maybe_unused]] resource_id_t id, T&& value) {
+        return DerivedT::to_cache(move(value));
+    }
+
+    /**
+     * @brief Called before the resource which is not used anymore is unloaded without caching
+     */
+    void release_resource([[maybe_unused]] resource_id_t id) {}
+
+    /**
+     * @brief Gets telemetry of the manager
+     *
+     * Resource sizes are reported if DerivedT provides static resource_size(const T&)
+     * and cached_size(const CachedT&) functions
+     *
+     * @return the stats
+     */
+    [[nodiscard]]
+    resource_mgr_stats stats() const {
+        auto result    = _stats;
+        result.mgr_tag = _mgr_tag;
+
+        for (auto& [_, resource] : _resources) {
+            if (resource.value) {
+                ++result.resident_count;
+                if constexpr (requires { DerivedT::resource_size(*resource.value); })
+                    result.resident_bytes += DerivedT::resource_size(*resource.value);
+            }
+            if (resource.cached) {
+                ++result.cached_count;
+                if constexpr (requires { DerivedT::cached_size(*resource.cached); })
+                    result.cached_bytes += DerivedT::cached_size(*resource.cached);
+            }
+        }
+
+        for (auto& [_, future] : _futures) {
+            if (future / is_ready())
+                ++result.finalize_backlog;
+            else
+                ++result.pending_loads;
+        }
+
+        for (auto& [id, paths] : _shared_paths) {
+            if (auto alias = _aliases.find(id); alias != _aliases.end()) {
+                if (auto owner = alias->second.owner_weak.lock())
+                    result.dedup_bytes_saved += paths * owner->resource_bytes(alias->second.id);
+            }
+            else {
+                result.dedup_bytes_saved += paths * resource_bytes(id);
+            }
+        }
+
+        return result;
+    }
+
 private:
+    /* DerivedT is incomplete while the base is instantiated, so it is checked in function bodies only */
+    static constexpr bool has_content_dedup() {
+        return requires(const string& path) { DerivedT::map_content(path)->bytes(); };
+    }
+
+    /* The resource of another manager with the same content, the owner is held while the alias is used */
+    struct alias_t {
+        weak_ptr<DerivedT>   owner_weak;
+        shared_ptr<DerivedT> owner;
+        resource_id_t        id;
+    };
+
+    static resource_content_index<DerivedT>& content_index() {
+        return resource_content_index<DerivedT>::instance();
+    }
+
+    DerivedT& derived() {
+        return *static_cast<DerivedT*>(this);
+    }
+
+    template <typename... ContentT>
+    resource_id_t create_resource(const string&       absolute,
+                                  const cfg_path&     path,
+                                  load_significance_t load_significance,
+                                  ContentT&&... content) {
+        auto id = new_id();
+        _path_to_id[absolute] = id;
+        _specs[id] = resource_spec_t{path, 1, load_significance};
+        start_load(id, path, forward<ContentT>(content)...);
+        DLOG("resource_mgr[{}]: create resource: path = {} id = {} usages = {}",
+             _mgr_tag,
+             path,
+             id,
+             1);
+
+        return id;
+    }
+
+    resource_id_t share_content(const cfg_path&                                     path,
+                                load_significance_t                                 load_significance,
+                                typename resource_content_index<DerivedT>::found_t found) {
+        ++_stats.dedup_hits;
+
+        if (found.mgr.get() == this) {
+            DLOG("resource_mgr[{}]: resource {} has the same content as {}",
+                 _mgr_tag,
+                 path,
+                 _specs.at(found.id).path);
+            increment_usages(found.id);
+
+            /* Another path must not unload the resource earlier than its first path asks */
+            auto& spec             = _specs.at(found.id);
+            spec.load_significance = std::max(spec.load_significance, load_significance);
+            ++_shared_paths[found.id];
+            return found.id;
+        }
+
+        auto id = new_id();
+        DLOG("resource_mgr[{}]: resource {} has the same content as resource {} of manager {}",
+             _mgr_tag,
+             path,
+             found.id,
+             found.mgr->mgr_tag());
+
+        _specs[id] = resource_spec_t{path, 0, load_significance};
+        _aliases.emplace(id, alias_t{found.mgr, nullptr, found.id});
+        _shared_paths[id] = 1;
+        increment_usages(id);
+        return id;
+    }
+
+    void acquire_alias(resource_id_t id, alias_t& alias) {
+        alias.owner = alias.owner_weak.lock();
+        if (alias.owner) {
+            alias.owner->increment_usages(alias.id);
+            return;
+        }
+
+        /* The owner was destroyed, the resource is loaded by this manager from now */
+        DLOG("resource_mgr[{}]: owner of the shared resource {} was destroyed", _mgr_tag, id);
+        _aliases.erase(id);
+        _shared_paths.erase(id);
+        ++_stats.disk_reloads;
+        start_load(id, _specs.at(id).path);
+    }
+
+    [[nodiscard]]
+    u64 resource_bytes(resource_id_t id) const {
+        auto found = _resources.find(id);
+        if (found == _resources.end())
+            return 0;
+
+        auto& resource = found->second;
+        if constexpr (requires { DerivedT::resource_size(*resource.value); })
+            if (resource.value)
+                return DerivedT::resource_size(*resource.value);
+        if constexpr (requires { DerivedT::cached_size(*resource.cached); })
+            if (resource.cached)
+                return DerivedT::cached_size(*resource.cached);
+        return 0;
+    }
+
     resource_id_t new_id() {
         return _last_id++;
     }
 
+    /* The mapped content is passed to DerivedT::load_async_cached(path, content) if the manager can load from it */
+    template <typename... ContentT>
+    void start_load(resource_id_t id, const cfg_path& path, ContentT&&... content) {
+        _load_starts.insert_or_assign(id, steady_clock::now());
+        if constexpr (requires { derived().load_async_cached(path, forward<ContentT>(content)...); })
+            _futures.emplace(id, derived().load_async_cached(path, forward<ContentT>(content)...));
+        else
+            _futures.emplace(id, derived().load_async_cached(path));
+        ++_stats.loads_started;
+    }
+
+    void complete_load(resource_id_t id) {
+        auto found = _load_starts.find(id);
+        if (found != _load_starts.end()) {
+            _stats.load_latency.record(duration_cast<microseconds>(steady_clock::now() - found->second));
+            _load_starts.erase(found);
+        }
+        ++_stats.loads_completed;
+    }
+
 private:
-    hash_map<resource_id_t, job_future<CachedT>> _futures;
-    hash_map<resource_id_t, resource_val_t>      _resources;
-    hash_map<resource_id_t, resource_spec_t>     _specs;
-    hash_map<string, resource_id_t>              _path_to_id;
-    string                                       _mgr_tag;
-    resource_id_t                                _last_id = 0;
+    hash_map<resource_id_t, job_future<CachedT>>      _futures;
+    hash_map<resource_id_t, resource_val_t>           _resources;
+    hash_map<resource_id_t, resource_spec_t>          _specs;
+    hash_map<string, resource_id_t>                   _path_to_id;
+    hash_map<resource_id_t, steady_clock::time_point> _load_starts;
+    hash_map<resource_id_t, alias_t>                  _aliases;
+    hash_map<resource_id_t, u64>                      _shared_paths;
+    resource_mgr_stats                                _stats;
+    string                                            _mgr_tag;
+    resource_id_t                                     _last_id       = 0;
+    bool                                              _content_dedup = false;
 };
 }
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <mutex>
+#include <sstream>
+#include "types.hpp"
+#include "time.hpp"
+#include "helper_macros.hpp"
+
+namespace core
+{
+/**
+ * @brief Latency histogram with power of two buckets
+ *
+ * The bucket i holds latencies in [2^i, 2^(i+1)) microseconds (the first one also holds zero).
+ * Percentiles are interpolated linearly inside the bucket, so the error is below the bucket width
+ */
+class latency_histogram {
+public:
+    static constexpr size_t buckets_count = 40;
+
+    void record(microseconds latency) {
+        auto us = static_cast<u64>(std::max<microseconds::rep>(latency.count(), 0));
+        ++_buckets[bucket_index(us)];
+        ++_count;
+        _sum_us += us;
+        _max_us = std::max(_max_us, us);
+    }
+
+    /**
+     * @brief Estimates the percentile
+     *
+     * @param p - the percentile in range [0, 100]
+     *
+     * @return the latency or zero if there are no samples
+     */
+    [[nodiscard]]
+    microseconds percentile(double p) const {
+        if (_count == 0)
+            return microseconds(0);
+
+        auto rank = std::clamp(p, 0.0, 100.0) / 100.0 * static_cast<double>(_count);
+        u64  seen = 0;
+
+        for (size_t i = 0; i < buckets_count; ++i) {
+            if (_buckets[i] == 0)
+                continue;
+
+            if (static_cast<double>(seen + _buckets[i]) >= rank) {
+                auto low   = i == 0 ? 0.0 : static_cast<double>(1ULL << i);
+                auto high  = std::min(static_cast<double>(1ULL << (i + 1)), static_cast<double>(_max_us));
+                auto ratio = (rank - static_cast<double>(seen)) / static_cast<double>(_buckets[i]);
+                return microseconds(static_cast<microseconds::rep>(low + (std::max(high, low) - low) * ratio));
+            }
+            seen += _buckets[i];
+        }
+
+        return max();
+    }
+
+    [[nodiscard]]
+    microseconds max() const {
+        return microseconds(static_cast<microseconds::rep>(_max_us));
+    }
+
+    [[nodiscard]]
+    microseconds mean() const {
+        return microseconds(static_cast<microseconds::rep>(_count ? _sum_us / _count : 0));
+    }
+
+    [[nodiscard]]
+    u64 count() const {
+        return _count;
+    }
+
+    [[nodiscard]]
+    const array<u64, buckets_count>& buckets() const {
+        return _buckets;
+    }
+
+private:
+    static size_t bucket_index(u64 us) {
+        size_t idx = 0;
+        while (us > 1 && idx + 1 < buckets_count) {
+            us >>= 1U;
+            ++idx;
+        }
+        return idx;
+    }
+
+private:
+    array<u64, buckets_count> _buckets = {};
+    u64                       _count   = 0;
+    u64                       _sum_us  = 0;
+    u64                       _max_us  = 0;
+};
+
+/**
+ * @brief Telemetry of the resource manager
+ */
+struct resource_mgr_stats {
+    string mgr_tag;
+
+    u64 loads_started   = 0; /* Loads from file, including reloads */
+    u64 loads_completed = 0; /* Loaded resources taken by the manager */
+    u64 cache_hits      = 0; /* Resources restored from the cached form */
+    u64 disk_reloads    = 0; /* Loads from file of resources that were unloaded before */
+
+    u64 resident_count = 0; /* Resources in the usable form */
+    u64 resident_bytes = 0;
+    u64 cached_count   = 0; /* Resources in the cached form */
+    u64 cached_bytes   = 0;
+
+    u64 pending_loads    = 0; /* Loads in progress */
+    u64 finalize_backlog = 0; /* Loaded resources waiting for the finalization on access */
+
+    u64 dedup_hits        = 0; /* Paths served by resources loaded from other paths with the same content */
+    u64 dedup_file_bytes  = 0; /* Source bytes which were not loaded because of deduplication */
+    u64 dedup_bytes_saved = 0; /* Resident and cached bytes of shared resources per additional path */
+
+    /* Time between the load start and the moment the manager takes the loaded resource */
+    latency_histogram load_latency;
+
+    [[nodiscard]]
+    double cache_hit_rate() const {
+        auto total = cache_hits + loads_started;
+        return total ? static_cast<double>(cache_hits) / static_cast<double>(total) : 0.0;
+    }
+};
+
+/**
+ * @brief Converts the stats to JSON object
+ *
+ * Latencies are in microseconds
+ *
+ * @param stats - the stats of the resource manager
+ *
+ * @return the JSON string
+ */
+inline string to_json(const resource_mgr_stats& stats) {
+    std::stringstream ss;
+    ss << "{\"mgr_tag\":\"";
+    for (auto c : stats.mgr_tag) {
+        if (c == '"' || c == '\\')
+            ss << '\\';
+        ss << c;
+    }
+    ss << "\",\"loads_started\":" << stats.loads_started
+       << ",\"loads_completed\":" << stats.loads_completed
+       << ",\"cache_hits\":" << stats.cache_hits
+       << ",\"disk_reloads\":" << stats.disk_reloads
+       << ",\"cache_hit_rate\":" << stats.cache_hit_rate()
+       << ",\"resident_count\":" << stats.resident_count
+       << ",\"resident_bytes\":" << stats.resident_bytes
+       << ",\"cached_count\":" << stats.cached_count
+       << ",\"cached_bytes\":" << stats.cached_bytes
+       << ",\"pending_loads\":" << stats.pending_loads
+       << ",\"finalize_backlog\":" << stats.finalize_backlog
+       << ",\"dedup_hits\":" << stats.dedup_hits
+       << ",\"dedup_file_bytes\":" << stats.dedup_file_bytes
+       << ",\"dedup_bytes_saved\":" << stats.dedup_bytes_saved
+       << ",\"load_latency_us\":{"
+       << "\"count\":" << stats.load_latency.count()
+       << ",\"mean\":" << stats.load_latency.mean().count()
+       << ",\"p50\":" << stats.load_latency.percentile(50).count()  // NOLINT
+       << ",\"p90\":" << stats.load_latency.percentile(90).count()  // NOLINT
+       << ",\"p99\":" << stats.load_latency.percentile(99).count()  // NOLINT
+       << ",\"max\":" << stats.load_latency.max().count()
+       << "}}";
+    return ss.str();
+}
+
+/**
+ * @brief Registry of stats providers of all alive resource managers
+ *
+ * Providers are called from the thread which collects the stats, so collect()
+ * must be called from the thread that uses resource managers
+ */
+class resource_mgr_stats_registry {
+    SINGLETON_IMPL(resource_mgr_stats_registry);
+
+public:
+    resource_mgr_stats_registry() = default;
+    ~resource_mgr_stats_registry() = default;
+
+    void insert(const string& mgr_tag, function<resource_mgr_stats()> provider) {
+        std::lock_guard lock{_mutex};
+        _providers.insert_or_assign(mgr_tag, move(provider));
+    }
+
+    void remove(const string& mgr_tag) {
+        std::lock_guard lock{_mutex};
+        _providers.erase(mgr_tag);
+    }
+
+    [[nodiscard]]
+    optional<resource_mgr_stats> get(const string& mgr_tag) const {
+        function<resource_mgr_stats()> provider;
+        {
+            std::lock_guard lock{_mutex};
+            auto found = _providers.find(mgr_tag);
+            if (found == _providers.end())
+                return nullopt;
+            provider = found->second;
+        }
+        return provider();
+    }
+
+    [[nodiscard]]
+    vector<resource_mgr_stats> collect() const {
+        /* Providers are called without the lock because they may destroy the manager */
+        vector<function<resource_mgr_stats()>> providers;
+        {
+            std::lock_guard lock{_mutex};
+            for (auto& [_, provider] : _providers)
+                providers.push_back(provider);
+        }
+
+        vector<resource_mgr_stats> result;
+        for (auto& provider : providers)
+            result.push_back(provider());
+
+        std::sort(result.begin(), result.end(), [](auto& a, auto& b) { return a.mgr_tag < b.mgr_tag; });
+        return result;
+    }
+
+    /**
+     * @brief Dumps stats of all resource managers as JSON array
+     *
+     * @return the JSON string
+     */
+    [[nodiscard]]
+    string to_json() const {
+        string result = "[";
+        for (auto& stats : collect()) {
+            if (result.size() > 1)
+                result += ',';
+            result += core::to_json(stats);
+        }
+        return result + "]";
+    }
+
+private:
+    mutable std::mutex                               _mutex;
+    hash_map<string, function<resource_mgr_stats()>> _providers;
+};
+
+inline resource_mgr_stats_registry& resource_mgr_stats_reg() {
+    return resource_mgr_stats_registry::instance();
+}
+} // namespace core
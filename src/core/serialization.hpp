@@ -5,7 +5,8 @@
 
 
 #define PE_SERIALIZE(...) void serialize(core::vector<core::byte>& _s) const { core::serialize_all(_s, __VA_ARGS__); } \
-                           void deserialize(core::span<const core::byte>& _d) { core::deserialize_all(_d, __VA_ARGS__); }
+                           void deserialize(core::span<const core::byte>& _d) { core::deserialize_all(_d, __VA_ARGS__); } \
+                           [[nodiscard]] size_t serialized_size() const { return core::serialized_size_all(__VA_ARGS__); }
 
 #define PE_SERIALIZE_OVERRIDE(...)                                                                 \
     void serialize(core::vector<core::byte>& _s) const override {                                  \
@@ -13,6 +14,9 @@
     }                                                                                              \
     void deserialize(core::span<const core::byte>& _d) override {                                  \
         core::deserialize_all(_d, __VA_ARGS__);                                                    \
+    }                                                                                              \
+    [[nodiscard]] size_t serialized_size() const override {                                        \
+        return core::serialized_size_all(__VA_ARGS__);                                             \
     }
 
 #define PE_SERIALIZE_SUPER(SUPER_CLASS, ...)                                                       \
@@ -23,6 +27,9 @@
     void deserialize(core::span<const core::byte>& _d) {                                           \
         SUPER_CLASS::deserialize(_d);                                                              \
         core::deserialize_all(_d, __VA_ARGS__);                                                    \
+    }                                                                                              \
+    [[nodiscard]] size_t serialized_size() const {                                                 \
+        return SUPER_CLASS::serialized_size() + core::serialized_size_all(__VA_ARGS__);            \
     }
 
 namespace core
@@ -32,6 +39,13 @@ namespace core
         virtual ~serializable_base() = default;
         virtual void serialize(core::vector<core::byte>& _s) const = 0;
         virtual void deserialize(core::span<const core::byte>& _d) = 0;
+
+        [[nodiscard]]
+        virtual size_t serialized_size() const {
+            core::vector<core::byte> s;
+            serialize(s);
+            return s.size();
+        }
     };
 
     using std::begin;
@@ -44,6 +58,10 @@ namespace core
     template <typename T>
     struct pe_deserialize;
 
+    /* Optional size functor for types with external serialization: size_t operator()(const T&) */
+    template <typename T>
+    struct pe_serialized_size;
+
     using byte_vector = vector<byte>;
 
     template <typename T>
@@ -96,6 +114,42 @@ namespace core
                 t.emplace(get<0>(*begin(t)), get<1>(*begin(t)));
             };
 
+    template <typename T, size_t S>
+    struct vec;
+
+    /**
+     * @brief Describes types whose serialized form is equal to their memory representation on little-endian
+     *
+     * word_size is the size of scalar components of the type (0 - not trivially serializable).
+     * Specializations must guarantee that the type consists of such scalars without padding and
+     * serializes them in memory order. Contiguous ranges of these types are (de)serialized with
+     * a single memcpy (and a per-word byte swap on big-endian)
+     */
+    template <typename T>
+    struct trivially_serializable {
+        static constexpr size_t word_size =
+            (Integral<T> || FloatingPoint<T>) && !std::is_same_v<T, bool> ? sizeof(T) : 0;
+    };
+
+    template <typename T, size_t S>
+    struct trivially_serializable<vec<T, S>> {
+        static constexpr size_t word_size =
+            sizeof(vec<T, S>) == sizeof(T) * S ? trivially_serializable<T>::word_size : 0;
+    };
+
+    template <typename T>
+    concept TriviallySerializable =
+            std::is_trivially_copyable_v<T> &&
+            trivially_serializable<T>::word_size != 0 &&
+            sizeof(T) % trivially_serializable<T>::word_size == 0;
+
+    template <typename T>
+    concept TriviallySerializableRange =
+            requires (T& t) {
+                { begin(t) } -> std::contiguous_iterator;
+                std::data(t);
+            } && TriviallySerializable<std::remove_cvref_t<decltype(*begin(std::declval<T&>()))>>;
+
     template <size_t size>
     using byte_array = array<byte, size>;
 
@@ -158,11 +212,58 @@ namespace core
         ((serialize(args, out)), ...);
     }
 
+    template <typename T>
+    inline size_t serialized_size(const T& v);
+
+    template <typename... Ts>
+    inline size_t serialized_size_all(const Ts&... args) {
+        return (size_t(0) + ... + serialized_size(args));
+    }
+
+
+    /**
+     * @brief Checks that serialized_size() of the type doesn't serialize values into the temporary buffer
+     */
+    template <typename T>
+    constexpr bool serialized_size_is_direct() {
+        if constexpr (SerializableMemberF<T>) {
+            return requires(const T& v) { { v.serialized_size() } -> std::convertible_to<size_t>; };
+        }
+        else if constexpr (SerializableExternalF<T>) {
+            return TriviallySerializable<T> ||
+                   requires(const T& v) { { pe_serialized_size<T>()(v) } -> std::convertible_to<size_t>; };
+        }
+        else if constexpr (Optional<T>) {
+            return serialized_size_is_direct<typename T::value_type>();
+        }
+        else if constexpr (std::is_bounded_array_v<T>) {
+            return serialized_size_is_direct<std::remove_extent_t<T>>();
+        }
+        else if constexpr (SerializableStaticCortege<T>) {
+            return []<size_t... idxs>(std::index_sequence<idxs...>&&) {
+                return (serialized_size_is_direct<std::remove_cvref_t<std::tuple_element_t<idxs, T>>>() && ...);
+            }(std::make_index_sequence<std::tuple_size_v<T>>());
+        }
+        else if constexpr (SerializableArray<T> || SerializableIterable<T> || SerializableMap<T>) {
+            return serialized_size_is_direct<std::remove_cvref_t<decltype(*begin(std::declval<const T&>()))>>();
+        }
+        else {
+            return true;
+        }
+    }
 
     class serializer {
     public:
         template <typename... Ts>
         void write(const Ts&... values) {
+            /* Reserve once for the whole write, but keep the geometric growth for sequences of small writes.
+             * Values without the direct size would be serialized twice, so the buffer just grows for them */
+            if constexpr ((serialized_size_is_direct<Ts>() && ...)) {
+                auto required = _data.size() + serialized_size_all(values...);
+                if (required > _data.capacity())
+                    _data.reserve(std::max(required, _data.capacity() * 2));
+            }
+
             (serialize(values, _data), ...);
         }
 
@@ -385,41 +486,274 @@ namespace core
                 std::make_index_sequence<std::tuple_size_v<std::remove_reference_t<T>>>());
     }
 
+    //===================== Trivially serializable ranges
+
+    namespace serialization_details
+    {
+        template <size_t WordSize>
+        inline void byte_swap_words(byte* data, size_t size) {
+            using word_t = std::conditional_t<WordSize == 8, u64,
+                           std::conditional_t<WordSize == 4, u32,
+                           std::conditional_t<WordSize == 2, u16, u8>>>;
+
+            if constexpr (WordSize > 1) {
+                for (size_t i = 0; i < size; i += WordSize) {
+                    word_t word;
+                    memcpy(&word, data + i, WordSize);
+                    word = platform_dependent::byte_swap(word);
+                    memcpy(data + i, &word, WordSize);
+                }
+            }
+        }
+
+        /**
+         * @brief Passes the head of the output to the sink while the value is being serialized
+         *
+         * Installed by core::streaming_serializer for its buffer. Ranges call flush_point() between elements
+         * and large trivial ranges are written in chunks, so the output doesn't hold the whole serialized value.
+         * Other outputs (temporary buffers of custom serializers) are never flushed
+         */
+        struct flush_hook {
+            byte_vector* output;
+            size_t       chunk_size;
+            void (*flush)(void* context);
+            void* context;
+        };
+
+        inline thread_local flush_hook* active_flush_hook = nullptr;
+
+        /**
+         * @brief Makes the hook active until the end of the scope
+         */
+        class flush_hook_scope {
+        public:
+            flush_hook_scope(flush_hook& hook): _previous(active_flush_hook) {
+                active_flush_hook = &hook;
+            }
+
+            ~flush_hook_scope() {
+                active_flush_hook = _previous;
+            }
+
+            flush_hook_scope(const flush_hook_scope&) = delete;
+            flush_hook_scope& operator=(const flush_hook_scope&) = delete;
+
+        private:
+            flush_hook* _previous;
+        };
+
+        inline flush_hook* flush_hook_for(const byte_vector& out) {
+            auto hook = active_flush_hook;
+            return hook && hook->output == &out ? hook : nullptr;
+        }
+
+        inline void flush_point(byte_vector& out) {
+            if (auto hook = flush_hook_for(out); hook && out.size() >= hook->chunk_size)
+                hook->flush(hook->context);
+        }
+
+        template <TriviallySerializable T>
+        inline void append_trivial(const T* data, size_t count, byte_vector& out) {
+            auto size = count * sizeof(T);
+            out.resize(out.size() + size);
+
+            auto dst = out.data() + (out.size() - size);
+            if (size)
+                memcpy(dst, data, size);
+
+            if constexpr (std::endian::native == std::endian::big)
+                byte_swap_words<trivially_serializable<T>::word_size>(dst, size);
+        }
+
+        template <TriviallySerializable T>
+        inline void write_trivial(const T* data, size_t count, byte_vector& out) {
+            auto hook = flush_hook_for(out);
+            if (!hook) {
+                append_trivial(data, count, out);
+                return;
+            }
+
+            auto step = std::max<size_t>(hook->chunk_size / sizeof(T), 1);
+            for (size_t i = 0; i < count; i += step) {
+                append_trivial(data + i, std::min(step, count - i), out);
+                flush_point(out);
+            }
+        }
+
+        template <TriviallySerializable T>
+        inline void read_trivial(T* data, size_t count, span<const byte>& in) {
+            Expects(count <= static_cast<size_t>(in.size()) / sizeof(T));
+
+            auto size = count * sizeof(T);
+            if (size)
+                memcpy(data, in.data(), size);
+            in = in.subspan(static_cast<ptrdiff_t>(size));
+
+            if constexpr (std::endian::native == std::endian::big)
+                byte_swap_words<trivially_serializable<T>::word_size>(reinterpret_cast<byte*>(data), size); // NOLINT
+        }
+    } // namespace serialization_details
+
     //===================== Iterable
 
     // Special for array
     template <SerializableArray T>
     inline void serialize(const T& vec, byte_vector& out) {
-        for (auto p = begin(vec); p != end(vec); ++p)
-            serialize(*p, out);
+        if constexpr (TriviallySerializableRange<const T>) {
+            serialization_details::write_trivial(vec.data(), vec.size(), out);
+        }
+        else {
+            for (auto p = begin(vec); p != end(vec); ++p) {
+                serialize(*p, out);
+                serialization_details::flush_point(out);
+            }
+        }
     }
 
     template <SerializableArray T>
     inline void deserialize(T& vec, span<const byte>& in) {
-        for (auto& e : vec)
-            deserialize(e, in);
+        if constexpr (TriviallySerializableRange<T>) {
+            serialization_details::read_trivial(vec.data(), vec.size(), in);
+        }
+        else {
+            for (auto& e : vec)
+                deserialize(e, in);
+        }
     }
 
     template <SerializableIterable T>
     inline void serialize(const T& vec, byte_vector& out) {
         serialize(static_cast<u64>(end(vec) - begin(vec)), out);
 
-        for (auto p = begin(vec); p != end(vec); ++p)
-            serialize(*p, out);
+        if constexpr (TriviallySerializableRange<const T>) {
+            serialization_details::write_trivial(std::data(vec), static_cast<size_t>(end(vec) - begin(vec)), out);
+        }
+        else {
+            for (auto p = begin(vec); p != end(vec); ++p) {
+                serialize(*p, out);
+                serialization_details::flush_point(out);
+            }
+        }
     }
 
     template <SerializableIterable T>
     inline void deserialize(T& vec, span<const byte>& in) {
-        auto inserter = std::back_inserter(vec);
-
         u64 size;
         deserialize(size, in);
 
-        for (decltype(size) i = 0; i < size; ++i) {
-            std::decay_t<decltype(*begin(vec))> v;
-            deserialize(v, in);
-            inserter = move(v);
+        if constexpr (TriviallySerializableRange<T> && requires { vec.resize(size_t(0)); }) {
+            using value_t = std::decay_t<decltype(*begin(vec))>;
+            Expects(size <= static_cast<u64>(in.size()) / sizeof(value_t));
+
+            auto old_size = static_cast<size_t>(end(vec) - begin(vec));
+            vec.resize(old_size + static_cast<size_t>(size));
+            serialization_details::read_trivial(std::data(vec) + old_size, static_cast<size_t>(size), in);
+        }
+        else {
+            auto inserter = std::back_inserter(vec);
+
+            for (decltype(size) i = 0; i < size; ++i) {
+                std::decay_t<decltype(*begin(vec))> v;
+                deserialize(v, in);
+                inserter = move(v);
+            }
+        }
+    }
+
+    //===================== Aligned ranges
+
+    /**
+     * @brief The alignment of payloads written by serialize_aligned
+     *
+     * Payloads are aligned relative to the start of the output, so they stay aligned in memory
+     * when serialized data is loaded at the address with the same alignment (heap buffers and memory mapped files)
+     */
+    constexpr size_t serialization_payload_alignment = 16;
+
+    /**
+     * @brief Writes the padding size and zero bytes so the next written byte is aligned relative to the start of output
+     *
+     * @param out - the output
+     * @param alignment - the alignment (must be less than 256)
+     */
+    inline void serialize_padding(byte_vector& out, size_t alignment = serialization_payload_alignment) {
+        auto padding = static_cast<u8>((alignment - (out.size() + 1) % alignment) % alignment);
+        serialize(padding, out);
+        out.resize(out.size() + padding, byte(0));
+    }
+
+    inline void deserialize_padding(span<const byte>& in) {
+        u8 padding; // NOLINT
+        deserialize(padding, in);
+
+        Expects(padding <= in.size());
+        in = in.subspan(padding);
+    }
+
+    /**
+     * @brief Serializes the contiguous range with the aligned payload
+     *
+     * The payload can be borrowed by deserialize_view without copying
+     *
+     * @param range - the contiguous range to serialize
+     * @param out - the output
+     */
+    template <typename T> requires TriviallySerializable<std::remove_cvref_t<decltype(*std::data(std::declval<const T&>()))>>
+    inline void serialize_aligned(const T& range, byte_vector& out) {
+        auto size = static_cast<size_t>(std::size(range));
+        serialize(static_cast<u64>(size), out);
+        serialize_padding(out);
+        serialization_details::write_trivial(std::data(range), size, out);
+    }
+
+    /**
+     * @brief Deserializes the range written by serialize_aligned
+     *
+     * Replaces content of the vector
+     */
+    template <TriviallySerializable T>
+    inline void deserialize_aligned(vector<T>& vec, span<const byte>& in) {
+        u64 size; // NOLINT
+        deserialize(size, in);
+        deserialize_padding(in);
+
+        Expects(size <= static_cast<u64>(in.size()) / sizeof(T));
+        vec.resize(static_cast<size_t>(size));
+        serialization_details::read_trivial(vec.data(), vec.size(), in);
+    }
+
+    /**
+     * @brief Deserializes the range written by serialize_aligned without copying
+     *
+     * The view points into the input if the payload is aligned for T and the platform is little-endian.
+     * Otherwise the payload is copied into the storage and the view points to the storage.
+     * The input must outlive the view
+     *
+     * @param view - the result view
+     * @param storage - the fallback storage
+     * @param in - the input
+     *
+     * @return true if the view borrows the input
+     */
+    template <TriviallySerializable T>
+    inline bool deserialize_view(span<const T>& view, vector<T>& storage, span<const byte>& in) {
+        u64 size; // NOLINT
+        deserialize(size, in);
+        deserialize_padding(in);
+
+        Expects(size <= static_cast<u64>(in.size()) / sizeof(T));
+
+        auto address = reinterpret_cast<uintptr_t>(in.data()); // NOLINT
+        if (std::endian::native == std::endian::little && address % alignof(T) == 0) {
+            view = span<const T>(reinterpret_cast<const T*>(in.data()), static_cast<ptrdiff_t>(size)); // NOLINT
+            in   = in.subspan(static_cast<ptrdiff_t>(size * sizeof(T)));
+            return true;
         }
+
+        storage.resize(static_cast<size_t>(size));
+        serialization_details::read_trivial(storage.data(), storage.size(), in);
+        view = span<const T>(storage.data(), static_cast<ptrdiff_t>(storage.size()));
+        return false;
     }
 
     //==================== Map
@@ -427,8 +761,10 @@ namespace core
     void serialize(const T& map, byte_vector& out) {
         serialize(static_cast<u64>(map.size()), out);
 
-        for (auto p = begin(map); p != end(map); ++p)
+        for (auto p = begin(map); p != end(map); ++p) {
             serialize(*p, out);
+            serialization_details::flush_point(out);
+        }
     }
 
     template <SerializableMap T>
@@ -446,14 +782,118 @@ namespace core
     //==================== C-array
     template <typename T, size_t S>
     void serialize(const T(&arr)[S], byte_vector& out) { // NOLINT
-        for (auto& v : arr)
-            serialize(v, out);
+        if constexpr (TriviallySerializable<T>) {
+            serialization_details::write_trivial(arr, S, out);
+        }
+        else {
+            for (auto& v : arr) {
+                serialize(v, out);
+                serialization_details::flush_point(out);
+            }
+        }
     }
 
     template <typename T, size_t S>
     void deserialize(T(&arr)[S], span<const byte>& in) { // NOLINT
-        for (auto& v : arr)
-            deserialize(v, in);
+        if constexpr (TriviallySerializable<T>) {
+            serialization_details::read_trivial(arr, S, in);
+        }
+        else {
+            for (auto& v : arr)
+                deserialize(v, in);
+        }
+    }
+
+    //==================== Serialized size
+
+    /**
+     * @brief Calculates the size of serialized value without serialization
+     *
+     * The size is exact, except aligned ranges (serialize_aligned) which count the maximum padding.
+     * Types with custom serialization may provide the serialized_size() member function
+     * (PE_SERIALIZE generates it) or the pe_serialized_size<T> specialization,
+     * otherwise the value is serialized into the temporary buffer
+     *
+     * @param v - the value
+     *
+     * @return the size in bytes
+     */
+    template <typename T>
+    inline size_t serialized_size(const T& v) {
+        if constexpr (SerializableMemberF<T>) {
+            if constexpr (requires { { v.serialized_size() } -> std::convertible_to<size_t>; }) {
+                return v.serialized_size();
+            }
+            else {
+                byte_vector tmp;
+                v.serialize(tmp);
+                return tmp.size();
+            }
+        }
+        else if constexpr (SerializableExternalF<T>) {
+            if constexpr (requires { { pe_serialized_size<T>()(v) } -> std::convertible_to<size_t>; }) {
+                return pe_serialized_size<T>()(v);
+            }
+            else if constexpr (TriviallySerializable<T>) {
+                return sizeof(T);
+            }
+            else {
+                byte_vector tmp;
+                pe_serialize<T>()(v, tmp);
+                return tmp.size();
+            }
+        }
+        else if constexpr (Integral<T> || FloatingPoint<T>) {
+            return sizeof(T);
+        }
+        else if constexpr (Enum<T>) {
+            return sizeof(std::underlying_type_t<T>);
+        }
+        else if constexpr (Optional<T>) {
+            return sizeof(bool) + (v ? serialized_size(*v) : 0);
+        }
+        else if constexpr (std::is_bounded_array_v<T>) {
+            if constexpr (TriviallySerializable<std::remove_extent_t<T>>) {
+                return sizeof(T);
+            }
+            else {
+                size_t size = 0;
+                for (auto& e : v)
+                    size += serialized_size(e);
+                return size;
+            }
+        }
+        else if constexpr (SerializableStaticCortege<T>) {
+            return [&v]<size_t... idxs>(std::index_sequence<idxs...>&&) {
+                using std::get;
+                return serialized_size_all(get<idxs>(v)...);
+            }(std::make_index_sequence<std::tuple_size_v<T>>());
+        }
+        else if constexpr (SerializableArray<T> || SerializableIterable<T> || SerializableMap<T>) {
+            size_t size = SerializableArray<T> ? 0 : sizeof(u64);
+
+            if constexpr (TriviallySerializableRange<const T>) {
+                size += static_cast<size_t>(end(v) - begin(v)) * sizeof(*begin(v));
+            }
+            else {
+                for (auto& e : v)
+                    size += serialized_size(e);
+            }
+            return size;
+        }
+        else {
+            static_assert(!std::is_same_v<T, T>, "Type is not serializable");
+            return 0;
+        }
+    }
+
+    /**
+     * @brief Calculates the maximum size of the range serialized with serialize_aligned
+     */
+    template <typename T>
+    inline size_t serialized_aligned_size(const T& range) {
+        return sizeof(u64) + sizeof(u8) + (serialization_payload_alignment - 1) +
+               static_cast<size_t>(std::size(range)) * sizeof(*std::data(range));
     }
 
     //===================== Span
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <unistd.h>
+#include "serialization.hpp"
+
+namespace core
+{
+/**
+ * @brief Receives serialized data in chunks
+ */
+class serialization_sink {
+public:
+    virtual ~serialization_sink() = default;
+
+    virtual void write(span<const byte> chunk) = 0;
+
+    /**
+     * @brief Called after the last chunk
+     */
+    virtual void finish() {}
+};
+
+/**
+ * @brief Collects chunks into the byte vector
+ */
+class byte_vector_sink : public serialization_sink {
+public:
+    void write(span<const byte> chunk) override {
+        _data.insert(_data.end(), chunk.begin(), chunk.end());
+    }
+
+    [[nodiscard]]
+    const byte_vector& data() const {
+        return _data;
+    }
+
+private:
+    byte_vector _data;
+};
+
+/**
+ * @brief Writes chunks into the file
+ *
+ * @throw runtime_error if the file can't be opened or written
+ */
+class file_sink : public serialization_sink {
+public:
+    file_sink(const string& file_path):
+        _file_path(file_path), _ofs(file_path, std::ios::out | std::ios::binary | std::ios::trunc) {
+        if (!_ofs.is_open())
+            throw std::runtime_error("Can't open file '" + file_path + "' for writing");
+    }
+
+    void write(span<const byte> chunk) override {
+        _ofs.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size())); // NOLINT
+        if (_ofs.bad())
+            throw std::runtime_error("Can't write file '" + _file_path + "'");
+    }
+
+    void finish() override {
+        _ofs.flush();
+        if (_ofs.bad())
+            throw std::runtime_error("Can't write file '" + _file_path + "'");
+    }
+
+private:
+    string        _file_path;
+    std::ofstream _ofs;
+};
+
+/**
+ * @brief Writes chunks into the file descriptor, the descriptor is not closed
+ *
+ * @throw runtime_error if the descriptor can't be written
+ */
+class fd_sink : public serialization_sink {
+public:
+    fd_sink(int fd): _fd(fd) {}
+
+    void write(span<const byte> chunk) override {
+        while (!chunk.empty()) {
+            auto rc = ::write(_fd, chunk.data(), static_cast<size_t>(chunk.size()));
+            if (rc < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::runtime_error(std::string("Can't write file descriptor: ") + std::strerror(errno));
+            }
+            chunk = chunk.subspan(rc);
+        }
+    }
+
+private:
+    int _fd;
+};
+
+/**
+ * @brief Serializer which passes data to the sink in fixed-size chunks
+ *
+ * Values are serialized into the internal buffer which goes to the sink when it exceeds the chunk size.
+ * The buffer is flushed during serialization of nested ranges too (see serialization_details::flush_hook),
+ * so the serialized form of a value is never kept in memory at whole. Only the buffer of a single element
+ * of a range (or a single value with custom serialization which doesn't contain ranges) may exceed the chunk size.
+ * The format is the same as for core::serializer.
+ *
+ * Flushed sizes are multiples of serialization_payload_alignment, so payloads of serialize_aligned stay aligned
+ * relative to the start of the stream
+ */
+class streaming_serializer {
+public:
+    static constexpr size_t default_chunk_size = 1 << 20;
+
+    streaming_serializer(serialization_sink& sink, size_t chunk_size = default_chunk_size):
+        _sink(sink), _chunk_size(std::max(chunk_size, serialization_payload_alignment)) {
+        _buffer.reserve(_chunk_size);
+    }
+
+    template <typename... Ts>
+    void write(const Ts&... values) {
+        ((write_one(values)), ...);
+    }
+
+    /**
+     * @brief Writes the range in the format of serialized iterable
+     *
+     * @param range - the range
+     */
+    template <typename T>
+    void write_range(const T& range) {
+        auto hook  = make_flush_hook();
+        auto scope = serialization_details::flush_hook_scope(hook);
+
+        auto size = static_cast<size_t>(std::size(range));
+        serialize(static_cast<u64>(size), _buffer);
+
+        if constexpr (TriviallySerializableRange<const T>) {
+            serialization_details::write_trivial(std::data(range), size, _buffer);
+        }
+        else {
+            for (auto& v : range) {
+                serialize(v, _buffer);
+                serialization_details::flush_point(_buffer);
+            }
+        }
+        flush_chunks();
+    }
+
+    /**
+     * @brief Passes the rest of data to the sink and finishes the sink
+     */
+    void finish() {
+        if (!_buffer.empty()) {
+            _sink.write(_buffer);
+            _written += _buffer.size();
+            _buffer.clear();
+        }
+        _sink.finish();
+    }
+
+    /**
+     * @brief Gets the count of bytes passed to the sink
+     */
+    [[nodiscard]]
+    u64 written() const {
+        return _written;
+    }
+
+private:
+    template <typename T>
+    void write_one(const T& value) {
+        auto hook  = make_flush_hook();
+        auto scope = serialization_details::flush_hook_scope(hook);
+
+        serialize(value, _buffer);
+        flush_chunks();
+    }
+
+    serialization_details::flush_hook make_flush_hook() {
+        return {&_buffer,
+                _chunk_size,
+                [](void* context) { static_cast<streaming_serializer*>(context)->flush_chunks(); },
+                this};
+    }
+
+    void flush_chunks() {
+        if (_buffer.size() < _chunk_size)
+            return;
+
+        auto size = _buffer.size() - _buffer.size() % serialization_payload_alignment;
+        _sink.write(span<const byte>(_buffer.data(), static_cast<ptrdiff_t>(size)));
+        _written += size;
+
+        _buffer.erase(_buffer.begin(), _buffer.begin() + static_cast<ptrdiff_t>(size));
+    }
+
+private:
+    serialization_sink& _sink;
+    size_t              _chunk_size;
+    byte_vector         _buffer;
+    u64                 _written = 0;
+};
+
+/**
+ * @brief Serializes values straight into the file
+ *
+ * @throw runtime_error if the file can't be written
+ *
+ * @param file_path - path to the file
+ * @param values - values to serialize
+ */
+template <typename... Ts>
+void serialize_to_file(const string& file_path, const Ts&... values) {
+    file_sink            sink(file_path);
+    streaming_serializer s(sink);
+    s.write(values...);
+    s.finish();
+}
+} // namespace core
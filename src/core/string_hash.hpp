@@ -1,9 +1,31 @@
 #pragma once
 
+#include <cstring>
 #include "types.hpp"
 
 namespace core
 {
+namespace hash_dtls
+{
+    constexpr u64 prime1 = 0x9e3779b185ebca87ULL;
+    constexpr u64 prime2 = 0xc2b2ae3d27d4eb4fULL;
+    constexpr u64 prime3 = 0x165667b19e3779f9ULL;
+
+    constexpr u64 rotl(u64 value, u32 bits) {
+        return (value << bits) | (value >> (64U - bits));
+    }
+
+    constexpr u64 round(u64 acc, u64 word) {
+        return rotl(acc + word * prime2, 31) * prime1; // NOLINT
+    }
+
+    inline u64 load64(const byte* ptr) {
+        u64 value; // NOLINT
+        std::memcpy(&value, ptr, sizeof(value));
+        return value;
+    }
+} // namespace hash_dtls
+
 inline u32 hash_djb(span<const byte> data, u32 start = 5381) {
     for (auto b : data) start = (start << 5U) + start + static_cast<u8>(b);
     return start;
@@ -19,6 +41,43 @@ inline u64 hash_fnv1a64(span<const byte> data, u64 start = 0xcbf29ce484222325) {
     return start;
 }
 
+/**
+ * @brief Fast non-cryptographic hash for large buffers
+ *
+ * Four independent lanes consume 32 bytes per iteration, so it is an order of magnitude faster than fnv1a64
+ * on file contents. The result depends on the byte order of the platform
+ *
+ * @param data - the data
+ * @param seed - the seed
+ *
+ * @return the hash
+ */
+inline u64 hash_fast64(span<const byte> data, u64 seed = 0) {
+    using namespace hash_dtls;
+
+    auto ptr  = data.data();
+    auto size = static_cast<u64>(data.size());
+    auto end  = ptr + size;
+
+    u64 lanes[] = {seed + prime1 + prime2, seed + prime2, seed, seed - prime1}; // NOLINT
+    for (; end - ptr >= 32; ptr += 32) // NOLINT
+        for (size_t i = 0; i < 4; ++i)
+            lanes[i] = round(lanes[i], load64(ptr + i * 8)); // NOLINT
+
+    u64 h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18) + size; // NOLINT
+    for (; end - ptr >= 8; ptr += 8)                                                                 // NOLINT
+        h = rotl(h ^ round(0, load64(ptr)), 27) * prime1 + prime3;                                   // NOLINT
+    for (; ptr != end; ++ptr)
+        h = rotl(h ^ (static_cast<u8>(*ptr) * prime3), 11) * prime1; // NOLINT
+
+    h ^= h >> 33U; // NOLINT
+    h *= prime2;
+    h ^= h >> 29U; // NOLINT
+    h *= prime3;
+    h ^= h >> 32U; // NOLINT
+    return h;
+}
+
 inline u32 hash_djb(string_view str, u32 start = 5381) {
     return hash_djb(
         span(reinterpret_cast<const byte*>(str.data()), static_cast<ptrdiff_t>(str.size())), start);
@@ -1,5 +1,7 @@
 #include "grx_animation.hpp"
+#include "core/compact_serialization.hpp"
 #include "core/math.hpp"
+#include "core/pe_throw.hpp"
 #include "grx_skeleton.hpp"
 #include <assimp/anim.h>
 #include <assimp/scene.h>
@@ -14,6 +16,20 @@ inline bool less(double a, double b) {
 inline bool eq(double a, double b) {
     return approx_equal(a, b, 0.0000001);
 }
+
+enum class key_times_encoding : u8 { raw = 0, integral_delta };
+
+/* Times are integral and exactly representable in i64 */
+template <typename T>
+bool has_integral_times(const vector<T>& keys) {
+    constexpr double limit = 9007199254740992.0; /* 2^53 */
+
+    return std::all_of(keys.begin(), keys.end(), [](auto& key) {
+        double whole; // NOLINT
+        auto   frac = std::modf(key.time, &whole);
+        return std::fpclassify(frac) == FP_ZERO && std::abs(key.time) <= limit;
+    });
+}
 } // namespace
 
 class aiScene;
@@ -238,6 +254,95 @@ grx_animation_optimized::grx_animation_optimized(const grx_animation& animation,
     }
 }
 
+void grx_animation_optimized::serialize(vector<byte>& out) const {
+    serialize_varint(_channels.size(), out);
+
+    for (auto& keys : _channels) {
+        serialize_varint(keys.size(), out);
+
+        if (has_integral_times(keys)) {
+            core::serialize(key_times_encoding::integral_delta, out);
+
+            i64 prev = 0;
+            for (auto& key : keys) {
+                auto time = static_cast<i64>(key.time);
+                serialize_varint(zigzag_encode(time - prev), out);
+                prev = time;
+            }
+        }
+        else {
+            core::serialize(key_times_encoding::raw, out);
+            for (auto& key : keys)
+                core::serialize(key.time, out);
+        }
+
+        for (auto& key : keys)
+            core::serialize(key.value, out);
+    }
+
+    serialize_all(out, _duration, _ticks_per_second);
+}
+
+void grx_animation_optimized::deserialize(span<const byte>& in) {
+    auto channels_count = deserialize_varint(in);
+    Expects(channels_count <= static_cast<u64>(in.size()));
+    _channels.resize(channels_count);
+
+    for (auto& keys : _channels) {
+        auto count = deserialize_varint(in);
+        Expects(count <= static_cast<u64>(in.size()));
+        keys.resize(count);
+
+        key_times_encoding encoding; // NOLINT
+        core::deserialize(encoding, in);
+
+        if (encoding == key_times_encoding::integral_delta) {
+            i64 prev = 0;
+            for (auto& key : keys) {
+                prev += zigzag_decode(deserialize_varint(in));
+                key.time = static_cast<double>(prev);
+            }
+        }
+        else if (encoding == key_times_encoding::raw) {
+            for (auto& key : keys)
+                core::deserialize(key.time, in);
+        }
+        else {
+            pe_throw std::runtime_error("Invalid animation key times encoding");
+        }
+
+        for (auto& key : keys)
+            core::deserialize(key.value, in);
+    }
+
+    deserialize_all(in, _duration, _ticks_per_second);
+}
+
+size_t grx_animation_optimized::serialized_size() const {
+    auto size = varint_size(_channels.size()) + sizeof(_duration) + sizeof(_ticks_per_second);
+
+    for (auto& keys : _channels) {
+        size += varint_size(keys.size()) + sizeof(key_times_encoding);
+
+        if (has_integral_times(keys)) {
+            i64 prev = 0;
+            for (auto& key : keys) {
+                auto time = static_cast<i64>(key.time);
+                size += varint_size(zigzag_encode(time - prev));
+                prev = time;
+            }
+        }
+        else {
+            size += keys.size() * sizeof(double);
+        }
+
+        for (auto& key : keys)
+            size += core::serialized_size(key.value);
+    }
+
+    return size;
+}
+
 hash_map<string, grx_animation> get_animations_from_assimp(const aiScene* scene) {
     if (!scene->HasAnimations())
         throw std::runtime_error("Scene does not have animations");
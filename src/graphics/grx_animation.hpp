@@ -155,11 +155,19 @@ public:
  */
 class grx_animation_optimized { // NOLINT
 public:
-    PE_SERIALIZE(_channels, _duration, _ticks_per_second)
-
     grx_animation_optimized() = default;
     grx_animation_optimized(const grx_animation& animation, const class grx_skeleton& skeleton);
 
+    /*
+     * Key times are usually whole ticks, so they are stored as varint deltas;
+     * channels with fractional times fall back to raw doubles
+     */
+    void serialize(core::vector<core::byte>& out) const;
+    void deserialize(core::span<const core::byte>& in);
+
+    [[nodiscard]]
+    size_t serialized_size() const;
+
 private:
     core::vector<core::vector<grx_combined_key>> _channels;
     double                                       _duration;
@@ -9,6 +9,10 @@ extern "C" {
 }
 
 #include "grx_types.hpp"
+#include "grx_compressed_color_map.hpp"
+#include <util/texture_encode.hpp>
+#include <util/mipmap_gen.hpp>
+#include <util/pixel_kernels.hpp>
 #include <core/async.hpp>
 #include <core/fiber_pool.hpp>
 #include <core/container_extensions.hpp>
@@ -19,6 +23,8 @@ extern "C" {
 #include <core/serialization.hpp>
 #include <core/assert.hpp>
 #include <util/compression.hpp>
+#include <util/asset_pack.hpp>
+#include <util/petx_format.hpp>
 #include <util/vtf_format.hpp>
 
 namespace grx
@@ -34,6 +40,31 @@ constexpr u8 COLOR_VAL_MAX = 255;
 constexpr core::u32 MIPMAPS_COUNT = 8;
 constexpr auto MIPMAP_MIN_SIZE = core::vec{2U, 2U};
 
+/* .petx files start with the signature and the format version, the current version is util::petx_view::format_version.
+ * Files with the legacy signature have no version, their mipmaps were stored with the sizes of the old power of two
+ * layout */
+constexpr auto PETX_SIGNATURE        = core::array{'P', 'E', 'T', 'V'};
+constexpr auto PETX_LEGACY_SIGNATURE = core::array{'P', 'E', 'T', 'X'};
+
+/**
+ * @brief Gets the size of the mipmap: every mipmap is half of the previous one but not less than MIPMAP_MIN_SIZE
+ *
+ * @param size - the size of the largest level
+ * @param level - the level, 0 - the largest level
+ *
+ * @return the mipmap size
+ */
+inline vec2u mipmap_size(vec2u size, core::u32 level) {
+    for (core::u32 i = 0; i < level; ++i) {
+        size /= 2U;
+        if (size.x() < MIPMAP_MIN_SIZE.x())
+            size.x() = MIPMAP_MIN_SIZE.x();
+        if (size.y() < MIPMAP_MIN_SIZE.y())
+            size.y() = MIPMAP_MIN_SIZE.y();
+    }
+    return size;
+}
+
 /**
  * @brief Provides access to the pixel data
  *
@@ -293,21 +324,23 @@ public:
     }
 
     void flip_horizontal() {
-        auto half_size = vec2u{_size.x() / 2, _size.y()};
-        for (auto [x, y] : core::dimensional_seq(half_size)) {
-            auto tmp_color                = (*this)[y][x].get();
-            (*this)[y][x]                 = (*this)[y][_size.x() - x - 1].get();
-            (*this)[y][_size.x() - x - 1] = tmp_color;
-        }
+        util::flip_pixels_horizontal(reinterpret_cast<core::byte*>(_data), _size, sizeof(T) * NPP);
     }
 
     void flip_vertical() {
-        auto half_size = vec2u{_size.x(), _size.y() / 2};
-        for (auto [x, y] : core::dimensional_seq(half_size)) {
-            auto tmp_color                = (*this)[y][x].get();
-            (*this)[y][x]                 = (*this)[_size.y() - y - 1][x].get();
-            (*this)[_size.y() - y - 1][x] = tmp_color;
-        }
+        util::flip_pixels_vertical(reinterpret_cast<core::byte*>(_data), _size, sizeof(T) * NPP);
+    }
+
+    /**
+     * @brief Writes the rotated image to dst, the size of dst must be size().yx() for 90 degree rotations
+     */
+    template <bool DstConst>
+    void rotate_to(const grx_color_map_view<T, NPP, DstConst>& dst, util::pixel_rotation rotation) const {
+        util::rotate_pixels(reinterpret_cast<const core::byte*>(_data),
+                            _size,
+                            sizeof(T) * NPP,
+                            reinterpret_cast<core::byte*>(dst.data()),
+                            rotation);
     }
 
 private:
@@ -325,15 +358,11 @@ public:
 
         static core::pair<vec2u, size_t> skip_compcount(vec2u size, uint mipmap) {
             size_t skip = 0;
-            for ([[maybe_unused]] uint i = 0; i < mipmap; ++i) {
-                skip += size.x() * size.y() * NPP;
-                size /= 2U;
-                if (size.x() < MIPMAP_MIN_SIZE.x())
-                    size.x() = MIPMAP_MIN_SIZE.x();
-                if (size.y() < MIPMAP_MIN_SIZE.y())
-                    size.y() = MIPMAP_MIN_SIZE.y();
+            for (uint i = 0; i < mipmap; ++i) {
+                auto level_size = mipmap_size(size, i);
+                skip += size_t(level_size.x()) * level_size.y() * NPP;
             }
-            return {size, skip};
+            return {mipmap_size(size, mipmap), skip};
         }
 
         grx_color_map_level_iterator& operator++() noexcept {
@@ -383,7 +412,7 @@ public:
     };
 
     grx_color_map_level_view(T* data, const vec2u& size, uint mipmap_count):
-        _begin(size, mipmap_count, data), _end(size, mipmap_count, data, mipmap_count) {}
+        _begin(size, mipmap_count, data), _end(size, mipmap_count, data, mipmap_count + 1) {}
 
     grx_color_map_level_iterator begin() const noexcept {
         return _begin;
@@ -404,41 +433,22 @@ public:
     using c_array = T[]; // NOLINT
 
     static size_t calc_compcount(const vec2u& size, core::u32 mipmaps) {
-        size_t compcount = size.x() * size.y() * NPP;
-        auto mipmap_size = size / 2U;
-
-        for (core::u32 i = 0; i < mipmaps; ++i) {
-            compcount += mipmap_size.x() * mipmap_size.y() * NPP;
-            mipmap_size /= 2U;
-            if (mipmap_size.x() < MIPMAP_MIN_SIZE.x())
-                mipmap_size.x() = MIPMAP_MIN_SIZE.x();
-            if (mipmap_size.y() == MIPMAP_MIN_SIZE.y())
-                mipmap_size.y() = MIPMAP_MIN_SIZE.y();
+        size_t compcount = 0;
+        for (core::u32 i = 0; i <= mipmaps; ++i) {
+            auto level_size = mipmap_size(size, i);
+            compcount += size_t(level_size.x()) * level_size.y() * NPP;
         }
-
         return compcount;
     }
 
     grx_color_map(T* raw_data, const vec2u& size, core::u32 mipmaps = 0):
         _size(size), _mipmaps(mipmaps) {
-        if (mipmaps && (!core::is_power_of_two(size.x()) || !core::is_power_of_two(size.y()))) {
-            auto newsize = core::vec{core::next_power_of_two(_size.x()), core::next_power_of_two(_size.y())};
-            LOG_WARNING("Sizes for mipmaping must be power of two: change size from {} to {}", _size, newsize);
-            _size = newsize;
-        }
-
         _compcount = calc_compcount(_size, _mipmaps);
         _data = make_unique<c_array>(_compcount);
         memcpy(_data.get(), raw_data, _compcount * sizeof(T));
     }
 
     grx_color_map(const vec2u& size, core::u32 mipmaps = 0): _size(size), _mipmaps(mipmaps) {
-        if (mipmaps && (!core::is_power_of_two(size.x()) || !core::is_power_of_two(size.y()))) {
-            auto newsize = core::vec{core::next_power_of_two(_size.x()), core::next_power_of_two(_size.y())};
-            LOG_WARNING("Sizes for mipmaping must be power of two: change size from {} to {}", _size, newsize);
-            _size = newsize;
-        }
-
         _compcount = calc_compcount(_size, _mipmaps);
         _data = make_unique<c_array>(_compcount);
     }
@@ -476,14 +486,154 @@ public:
 
     ~grx_color_map() noexcept = default;
 
-    static grx_color_map from_bytes(core::span<core::byte> bytes) {
+    /**
+     * @brief Decompresses the largest level of the block compressed color map
+     *
+     * Mipmaps are regenerated if the compressed color map has them
+     *
+     * @throw runtime_error if channels count of the compressed color map does not match
+     *
+     * @param compressed - the block compressed color map
+     *
+     * @return the decompressed color map
+     */
+    static grx_color_map from_compressed(const grx_compressed_color_map& compressed) {
+        static_assert(std::is_same_v<T, uint8_t> && (NPP == 3 || NPP == 4),
+                      "Compressed color map can be decompressed only to RGB or RGBA u8 color map");
+
+        if (compressed.channels_count() != NPP)
+            pe_throw std::runtime_error(core::format("Wrong channels count: compressed color map has {} channels, "
+                                                     "but color map require {} channels",
+                                                     compressed.channels_count(),
+                                                     NPP));
+
+        grx_color_map result(compressed.size());
+        compressed.decompress(0, result.data(), NPP);
+
+        if (compressed.has_mipmaps())
+            result.gen_mipmaps();
+
+        return result;
+    }
+
+    /**
+     * @brief Encodes the color map with block compression
+     *
+     * Mipmaps are generated from the largest level down to 1x1, so sizes may be non power of two.
+     * Blocks of each level are encoded in parallel
+     *
+     * @param format - the block format
+     * @param quality - the quality mode of the encoder
+     * @param mipmaps - settings of the full mipmap chain, nullopt - encode the largest level only
+     * @param pool - the fiber pool which runs encoding jobs, nullptr - the global fiber pool
+     *
+     * @return the block compressed color map
+     */
+    [[nodiscard]]
+    grx_compressed_color_map
+    to_compressed(util::dxt_format                   format,
+                  util::dxt_encode_quality           quality = util::dxt_encode_quality::fast,
+                  core::optional<util::mip_settings> mipmaps = util::mip_settings{},
+                  core::fiber_pool*                  pool    = nullptr) const {
+        static_assert(std::is_same_v<T, uint8_t> && (NPP == 3 || NPP == 4),
+                      "Only RGB or RGBA u8 color map can be block compressed");
+
+        /* Mipmaps of the compressed color map go down to 1x1 */
+        auto sizes = mipmaps ? util::mip_chain_sizes(_size) : core::vector<vec2u>{};
+        sizes.insert(sizes.begin(), _size);
+
+        size_t pixels_count = 0;
+        size_t data_size    = 0;
+        for (auto& size : sizes) {
+            pixels_count += size_t(size.x()) * size.y() * NPP;
+            data_size += util::dxt_data_size(format, size);
+        }
+
+        core::vector<T> pixels(pixels_count);
+        std::memcpy(pixels.data(), _data.get(), size_t(_size.x()) * _size.y() * NPP);
+        if (mipmaps)
+            util::generate_mipmaps(_data.get(),
+                                   _size,
+                                   NPP,
+                                   core::span<const vec2u>(sizes).subspan(1),
+                                   pixels.data() + size_t(_size.x()) * _size.y() * NPP,
+                                   *mipmaps,
+                                   pool);
+
+        core::vector<core::byte> data(data_size);
+        size_t                   pixels_offset = 0;
+        size_t                   data_offset   = 0;
+        for (auto& size : sizes) {
+            auto level_size = util::dxt_data_size(format, size);
+            util::dxt_encode(format,
+                             pixels.data() + pixels_offset,
+                             size,
+                             NPP,
+                             core::span<core::byte>(data).subspan(static_cast<ssize_t>(data_offset),
+                                                                  static_cast<ssize_t>(level_size)),
+                             quality,
+                             pool);
+            pixels_offset += size_t(size.x()) * size.y() * NPP;
+            data_offset += level_size;
+        }
+
+        return {format, _size, static_cast<core::u32>(sizes.size()), core::move(data)};
+    }
+
+    /**
+     * @brief Pixels of .petx levels of the color map
+     */
+    static constexpr auto petx_pixels = std::is_same_v<T, float> ? util::petx_pixels::f32 : util::petx_pixels::u8;
+
+    /**
+     * @brief Loads the color map from .petx bytes
+     *
+     * Levels of .petx v2 files are decompressed or copied straight into the color map. Mipmaps of legacy files are
+     * regenerated from the largest level
+     *
+     * @throw runtime_error if bytes are invalid or pixels of the file don't match the color map
+     *
+     * @param bytes - the file data
+     *
+     * @return the color map
+     */
+    static grx_color_map from_bytes(core::span<const core::byte> bytes) {
         if constexpr (std::endian::native == std::endian::big)
             pe_throw std::runtime_error("Implement me for big endian");
 
         using namespace core;
 
+        if (util::petx_view::is_petx(bytes)) {
+            auto view = util::petx_view(bytes);
+            PeRelRequireF(view.pixels() == petx_pixels && view.channels() == NPP,
+                          "Invalid petx pixels: gets {} with {} channels but {} with {} channels required",
+                          magic_enum::enum_name(view.pixels()),
+                          view.channels(),
+                          magic_enum::enum_name(petx_pixels),
+                          NPP);
+
+            grx_color_map result(view.size(), view.levels_count() - 1);
+
+            u32 level = 0;
+            for (auto level_view : result.mipmap_view()) {
+                PeRelRequireF(view.level(level).size == level_view.size(),
+                              "Invalid petx level {} size: gets {} but {} required",
+                              level,
+                              view.level(level).size,
+                              level_view.size());
+                view.read_level(level++,
+                                span<byte>(reinterpret_cast<byte*>(level_view.data()), // NOLINT
+                                           static_cast<ssize_t>(level_view.components_count() * sizeof(T))));
+            }
+
+            return result;
+        }
+
         deserializer_view ds{bytes};
-        ds.read_get<array<char, 4>>();
+        auto              signature = ds.read_get<array<char, 4>>();
+        PeRelRequireF(signature == PETX_LEGACY_SIGNATURE,
+                      "{}",
+                      signature == PETX_SIGNATURE ? "Unsupported petx version" : "Invalid petx signature");
 
         auto channels = ds.read_get<u32>();
         PeRelRequireF(channels == NPP, "Invalid channels count: gets {} but {} required", channels, NPP);
@@ -491,97 +641,66 @@ public:
         auto size = ds.read_get<vec<u32, 2>>();
         auto mipmaps = ds.read_get<u32>();
 
-        if (mipmaps && (!core::is_power_of_two(size.x()) || !core::is_power_of_two(size.y())))
-            pe_throw std::runtime_error("Sizes must be power of two");
-
         ds.read_get<u64>(); /* Skip compressed size */
 
-        auto compcount      = calc_compcount(size, mipmaps);
-        auto data           = make_unique<c_array>(compcount);
-        auto img_compressed = bytes.subspan(28);
-        auto img_data       = util::decompress_block(img_compressed, compcount * sizeof(T));
-
-        PeRelRequireF(compcount == static_cast<size_t>(img_data.size()),
-                      "Invalid image size: gets {} but {} required",
+        auto img_data    = util::decompress(bytes.subspan(28)); // NOLINT
+        auto level_count = size_t(size.x()) * size.y() * NPP;
+        PeRelRequireF(level_count * sizeof(T) <= static_cast<size_t>(img_data.size()),
+                      "Invalid image size: gets {} but at least {} required",
                       img_data.size(),
-                      compcount);
-        memcpy(data.get(), img_data.data(), compcount * sizeof(T));
+                      level_count * sizeof(T));
 
-        grx_color_map result;
-        result._size = size;
-        result._data = move(data);
-        result._mipmaps = mipmaps;
-        result._compcount = compcount;
+        grx_color_map result(size);
+        memcpy(result.data(), img_data.data(), level_count * sizeof(T));
+        if (mipmaps)
+            result.gen_mipmaps();
 
         return result;
     }
 
+    /**
+     * @brief Serializes the color map to .petx v2 bytes
+     *
+     * Levels are stored as-is by default: grx_mapped_color_map serves them directly from the mapped file and
+     * from_bytes only copies them. Compressed levels are smaller on disk but are always decompressed on load.
+     *
+     * @param compress - compress levels with the "texture" asset codec
+     *
+     * @return the file data
+     */
     [[nodiscard]]
-    core::vector<core::byte> to_bytes() const {
-        if constexpr (std::endian::native == std::endian::big)
-            pe_throw std::runtime_error("Implement me for big endian");
-
+    core::vector<core::byte> to_bytes(bool compress = false) const {
         using namespace core;
 
-        serializer s;
-        s.write(array{'P', 'E', 'T', 'X'});
-        s.write(static_cast<u32>(NPP));
-        s.write(static_cast<vec<u32, 2>>(_size));
-        s.write(_mipmaps);
-        s.write(util::compress(span{reinterpret_cast<core::byte*>(_data.get()), // NOLINT
-                                    static_cast<ssize_t>(_compcount)},
-                               util::COMPRESS_FAST));
-
-        return s.detach_data();
-    }
-
-    void gen_mipmaps() {
-        if (!core::is_power_of_two(_size.x()) || !core::is_power_of_two(_size.y()))
-            pe_throw std::runtime_error("Sizes must be power of two");
-
-        auto compcount = calc_compcount(_size, MIPMAPS_COUNT);
-        auto newdata = make_unique<c_array>(compcount);
-        auto ptr = newdata.get();
-
-        auto src_compcount = _size.x() * _size.y() * NPP;
-        std::memcpy(ptr, _data.get(), src_compcount * sizeof(T));
-
-        auto   mipmap_size  = _size;
-        size_t src_displacement = 0;
-        for (core::u32 i = 0; i < MIPMAPS_COUNT; ++i) {
-            auto new_mipmap_size = mipmap_size / 2U;
-            if (mipmap_size.x() < MIPMAP_MIN_SIZE.x())
-                mipmap_size.x() = MIPMAP_MIN_SIZE.x();
-            if (mipmap_size.y() == MIPMAP_MIN_SIZE.y())
-                mipmap_size.y() = MIPMAP_MIN_SIZE.y();
-
-            if constexpr (core::FloatingPoint<T>)
-                stbir_resize_float(ptr + src_displacement,
-                                   static_cast<int>(mipmap_size.x()),
-                                   static_cast<int>(mipmap_size.y()),
-                                   0,
-                                   ptr + src_displacement + src_compcount,
-                                   static_cast<int>(new_mipmap_size.x()),
-                                   static_cast<int>(new_mipmap_size.y()),
-                                   0,
-                                   static_cast<int>(NPP));
-            else
-                stbir_resize_uint8(ptr + src_displacement,
-                                   static_cast<int>(mipmap_size.x()),
-                                   static_cast<int>(mipmap_size.y()),
-                                   0,
-                                   ptr + src_displacement + src_compcount,
-                                   static_cast<int>(new_mipmap_size.x()),
-                                   static_cast<int>(new_mipmap_size.y()),
-                                   0,
-                                   static_cast<int>(NPP));
-
-            auto dst_compcount = new_mipmap_size.x() * new_mipmap_size.y() * NPP;
-
-            src_displacement += src_compcount;
-            src_compcount = dst_compcount;
-            mipmap_size = new_mipmap_size;
-        }
+        vector<util::petx_level_data> levels;
+        for (auto level_view : mipmap_view())
+            levels.push_back({level_view.size(),
+                              span<const byte>(reinterpret_cast<const byte*>(level_view.data()), // NOLINT
+                                               static_cast<ssize_t>(level_view.components_count() * sizeof(T)))});
+
+        return util::petx_write(petx_pixels, static_cast<u32>(NPP), levels, compress);
+    }
+
+    /**
+     * @brief Generates MIPMAPS_COUNT mipmaps from the largest level
+     *
+     * Sizes need not be power of two, every mipmap is half of the previous one but not less than MIPMAP_MIN_SIZE.
+     * Levels are filtered in parallel row chunks of the fiber pool
+     *
+     * @param settings - the filter and color space settings
+     * @param pool - the fiber pool which runs filtering jobs, nullptr - the global fiber pool
+     */
+    void gen_mipmaps(const util::mip_settings& settings = {}, core::fiber_pool* pool = nullptr) {
+        auto compcount      = calc_compcount(_size, MIPMAPS_COUNT);
+        auto newdata        = make_unique<c_array>(compcount);
+        auto base_compcount = size_t(_size.x()) * _size.y() * NPP;
+        std::memcpy(newdata.get(), _data.get(), base_compcount * sizeof(T));
+
+        core::array<vec2u, MIPMAPS_COUNT> sizes;
+        for (core::u32 i = 0; i < MIPMAPS_COUNT; ++i)
+            sizes[i] = mipmap_size(_size, i + 1);
+
+        util::generate_mipmaps(_data.get(), _size, NPP, sizes, newdata.get() + base_compcount, settings, pool);
 
         _data = move(newdata);
         _mipmaps = MIPMAPS_COUNT;
@@ -709,18 +828,14 @@ public:
     auto to_ldr(float gamma = 1.f, float exposure = 1.f) const
         -> std::enable_if_t<Enable, grx_color_map<uint8_t, NPP>> {
         auto result = grx_color_map<uint8_t, NPP>(_size, _mipmaps);
-        for (size_t i = 0; i < _compcount; ++i) {
-            auto mapped = T(1.0) - std::exp(-_data[i] * exposure);
-            result.data()[i] = static_cast<uint8_t>(T(255.0) * std::pow(mapped, T(1.0) / gamma));
-        }
+        util::tone_map(_data.get(), result.data(), _compcount, gamma, exposure);
         return result;
     }
 
     template <bool Enable = !std::is_floating_point_v<T>>
     auto to_hdr() const -> std::enable_if_t<Enable, grx_color_map<float, NPP>> {
         auto result = grx_color_map<float, NPP>(_size, _mipmaps);
-        for (size_t i = 0; i < _compcount; ++i)
-            result.data()[i] = static_cast<float>(_data[i]) / 255.f;
+        util::u8_to_float(_data.get(), result.data(), _compcount);
         return result;
     }
 
@@ -747,35 +862,23 @@ public:
     }
 
     grx_color_map rotated_left() const {
-        auto res = grx_color_map(_size.yx(), _mipmaps);
-        auto src_view = mipmap_view();
-        auto dst_view = res.mipmap_view();
-        for (auto [dst, src] : core::zip_view(dst_view, src_view))
-            for (auto [x, y] : core::dimensional_seq(src.size()))
-                dst[src.size().x() - x - 1][y] = src[y][x].get();
-
-        return res;
+        return rotated(util::pixel_rotation::left);
     }
 
     grx_color_map rotated_right() const {
-        auto res = grx_color_map(_size.yx(), _mipmaps);
-        auto src_view = mipmap_view();
-        auto dst_view = res.mipmap_view();
-        for (auto [dst, src] : core::zip_view(dst_view, src_view))
-            for (auto [x, y] : core::dimensional_seq(src.size()))
-                dst[x][src.size().y() - y - 1] = src[y][x].get();
-
-        return res;
+        return rotated(util::pixel_rotation::right);
     }
 
     grx_color_map rotated_180() const {
-        grx_color_map res = grx_color_map(_size, _mipmaps);
+        return rotated(util::pixel_rotation::half);
+    }
 
+    grx_color_map rotated(util::pixel_rotation rotation) const {
+        auto res = grx_color_map(rotation == util::pixel_rotation::half ? _size : _size.yx(), _mipmaps);
         auto src_view = mipmap_view();
         auto dst_view = res.mipmap_view();
         for (auto [dst, src] : core::zip_view(dst_view, src_view))
-            for (auto [x, y] : core::dimensional_seq(src.size()))
-                dst[src.size().y() - y - 1][src.size().x() - x - 1] = src[y][x].get();
+            src.rotate_to(dst, rotation);
 
         return res;
     }
@@ -829,7 +932,7 @@ using grx_float_color_map_rgba = grx_color_map<float, 4>;
  */
 template <core::MathVector T = color_rgb>
 core::try_opt<grx_color_map<typename T::value_type, T::size()>>
-try_load_color_map_from_bytes(core::span<core::byte> bytes) {
+try_load_color_map_from_bytes(core::span<const core::byte> bytes) {
     static_assert(T::size() <= 4 && T::size() > 0,
                   "Wrong color type. T must be uint8_t or float, Size must be 1 "
                   "<= Size <= 4");
@@ -846,8 +949,31 @@ try_load_color_map_from_bytes(core::span<core::byte> bytes) {
     else if constexpr (T::size() == 4)
         type = STBI_rgb_alpha;
 
-    if (bytes.size() > 4 && core::deserializer_view{bytes}.read_get<core::array<char, 4>>() ==
-                                core::array{'P', 'E', 'T', 'X'}) {
+    /* Block compressed textures are decompressed only when they are loaded as the color map */
+    if (grx_compressed_color_map::is_compressed_petx(bytes)) {
+        if constexpr (T::size() == 3 || T::size() == 4) {
+            auto map = grx_color_map<uint8_t, T::size()>::from_compressed(grx_compressed_color_map::from_bytes(bytes));
+            if constexpr (std::is_same_v<typename T::value_type, uint8_t>)
+                return map;
+            else
+                return map.to_hdr();
+        }
+        else
+            return {std::runtime_error("Block compressed petx can be loaded only as RGB or RGBA color map")};
+    }
+
+    /* Float .petx v2 levels are loaded as-is */
+    auto is_petx_v2 = util::petx_view::is_petx(bytes);
+    if (is_petx_v2 && util::petx_view(bytes).pixels() == util::petx_pixels::f32) {
+        if constexpr (std::is_same_v<typename T::value_type, float>)
+            return grx_color_map<float, T::size()>::from_bytes(bytes);
+        else
+            return grx_color_map<float, T::size()>::from_bytes(bytes).to_ldr();
+    }
+
+    auto signature = bytes.size() > 4 ? core::deserializer_view{bytes}.read_get<core::array<char, 4>>()
+                                      : core::array<char, 4>{};
+    if (is_petx_v2 || signature == PETX_SIGNATURE || signature == PETX_LEGACY_SIGNATURE) {
         if constexpr (std::is_same_v<typename T::value_type, uint8_t>)
             return grx_color_map<uint8_t, T::size()>::from_bytes(bytes);
         else
@@ -914,8 +1040,8 @@ template <core::MathVector T = color_rgb>
 [[nodiscard]]
 core::try_opt<grx_color_map<typename T::value_type, T::size()>>
 try_load_color_map(const core::string& file_path) {
-    if (auto file = core::try_read_binary_file(core::path_eval(file_path)))
-        return try_load_color_map_from_bytes<T>(*file);
+    if (auto file = util::try_map_asset(file_path))
+        return try_load_color_map_from_bytes<T>(file->bytes());
     else
         return {std::runtime_error("Can't open file \"" + file_path + "\"")};
 }
@@ -987,7 +1113,7 @@ static constexpr int default_jpeg_quality = 95;
  * @tparam T - the type of the color component
  * @tparam S - the color channels count
  * @param color_map - the color map to be saved
- * @param extension - the image extension
+ * @param extension - the image extension, "petx" files are written with uncompressed (mappable) levels
  *
  * @return byte vector with image or exception in try_opt
  */
@@ -0,0 +1,198 @@
+#include "grx_compressed_color_map.hpp"
+
+#include <core/serialization.hpp>
+#include <util/asset_pack.hpp>
+#include <util/petx_format.hpp>
+#include <util/vtf_format.hpp>
+
+namespace grx
+{
+using namespace core;
+
+namespace {
+    void check_petx_level_size(const util::petx_view& view, u32 level) {
+        auto expected = grx_compressed_color_map::level_size(view.size(), level);
+        if (view.level(level).size != expected)
+            pe_throw std::runtime_error(core::format("Invalid compressed color map level {} size: gets {} but {} required",
+                                                     level,
+                                                     view.level(level).size,
+                                                     expected));
+    }
+} // namespace
+
+struct grx_compressed_color_map::storage_t {
+    optional<util::asset_data> asset;
+    vector<vector<byte>>       owned;
+};
+
+grx_compressed_color_map::grx_compressed_color_map(util::dxt_format format,
+                                                   const vec2u&     size,
+                                                   u32              levels_count,
+                                                   vector<byte>     data):
+    _format(format), _size(size), _levels_count(levels_count) {
+    validate_levels_count();
+
+    size_t required = 0;
+    for (u32 i = 0; i < _levels_count; ++i)
+        required += util::dxt_data_size(_format, level_size(i));
+
+    if (required != data.size())
+        pe_throw std::runtime_error(core::format(
+            "Invalid compressed color map data size: gets {} but {} required", data.size(), required));
+
+    auto storage = make_shared<storage_t>();
+    auto blocks  = span<const byte>(storage->owned.emplace_back(move(data)));
+
+    for (u32 i = 0; i < _levels_count; ++i) {
+        auto level_bytes = static_cast<ssize_t>(util::dxt_data_size(_format, level_size(i)));
+        _levels.push_back(blocks.first(level_bytes));
+        blocks = blocks.subspan(level_bytes);
+    }
+
+    _storage = move(storage);
+}
+
+grx_compressed_color_map::grx_compressed_color_map(util::dxt_format            format,
+                                                   const vec2u&                size,
+                                                   vector<span<const byte>>    levels,
+                                                   shared_ptr<const storage_t> storage):
+    _format(format),
+    _size(size),
+    _levels_count(static_cast<u32>(levels.size())),
+    _storage(move(storage)),
+    _levels(move(levels)) {
+    validate_levels_count();
+
+    for (u32 i = 0; i < _levels_count; ++i) {
+        auto required = util::dxt_data_size(_format, level_size(i));
+        if (static_cast<size_t>(_levels[i].size()) != required)
+            pe_throw std::runtime_error(core::format(
+                "Invalid compressed color map level {} size: gets {} but {} required", i, _levels[i].size(), required));
+    }
+}
+
+void grx_compressed_color_map::validate_levels_count() const {
+    if (_size.x() == 0 || _size.y() == 0)
+        pe_throw std::runtime_error("Compressed color map size must be non-zero");
+
+    if (_levels_count == 0 || _levels_count > max_levels_count(_size))
+        pe_throw std::runtime_error(
+            core::format("Invalid levels count {} for compressed color map {}", _levels_count, _size));
+}
+
+grx_compressed_color_map grx_compressed_color_map::from_vtf(const util::vtf_view& vtf) {
+    auto format = vtf.high_res_dxt_format();
+    if (!format)
+        pe_throw std::runtime_error("VTF high resolution image is not block compressed");
+
+    auto size         = static_cast<vec2u>(vtf.high_res_size());
+    auto levels_count = std::min(std::max(vtf.mipmap_count(), 1U), max_levels_count(size));
+
+    vector<byte> data;
+    for (u32 i = 0; i < levels_count; ++i) {
+        auto level = vtf.high_res_mipmap_data(i);
+        data.insert(data.end(), level.begin(), level.end());
+    }
+
+    return {*format, size, levels_count, move(data)};
+}
+
+bool grx_compressed_color_map::is_compressed_petx(span<const byte> bytes) {
+    if (!util::petx_view::is_petx(bytes))
+        return false;
+
+    deserializer_view ds{bytes};
+    ds.read_get<array<char, 4>>();
+    ds.read_get<u32>(); /* Skip the version */
+
+    auto pixels = ds.read_get<u32>();
+    return pixels >= u32(util::petx_pixels::dxt1) && pixels <= u32(util::petx_pixels::bc7);
+}
+
+grx_compressed_color_map grx_compressed_color_map::from_bytes(span<const byte> bytes) {
+    if constexpr (std::endian::native == std::endian::big)
+        pe_throw std::runtime_error("Implement me for big endian");
+
+    if (!is_compressed_petx(bytes))
+        pe_throw std::runtime_error("Invalid compressed color map signature");
+
+    auto view = util::petx_view(bytes);
+
+    vector<byte> data;
+    for (u32 i = 0; i < view.levels_count(); ++i) {
+        check_petx_level_size(view, i);
+
+        auto offset = data.size();
+        data.resize(offset + view.level(i).raw_size);
+        view.read_level(i, span<byte>(data).subspan(static_cast<ssize_t>(offset)));
+    }
+
+    return {*util::petx_block_format(view.pixels()), view.size(), view.levels_count(), move(data)};
+}
+
+grx_compressed_color_map grx_compressed_color_map::from_asset(util::asset_data asset) {
+    if (!is_compressed_petx(asset.bytes()))
+        pe_throw std::runtime_error("Invalid compressed color map signature");
+
+    auto storage = make_shared<storage_t>();
+    auto view    = util::petx_view(storage->asset.emplace(move(asset)).bytes());
+
+    /* Uncompressed levels are views into the asset, its data is not moved with the asset */
+    vector<span<const byte>> levels;
+    for (u32 i = 0; i < view.levels_count(); ++i) {
+        check_petx_level_size(view, i);
+
+        if (auto level = view.try_view(i))
+            levels.push_back(*level);
+        else
+            levels.push_back(storage->owned.emplace_back(view.read_level(i)));
+    }
+
+    if (storage->owned.size() == levels.size())
+        storage->asset.reset();
+
+    return {*util::petx_block_format(view.pixels()), view.size(), move(levels), move(storage)};
+}
+
+vector<byte> grx_compressed_color_map::to_bytes(bool compress) const {
+    vector<util::petx_level_data> levels;
+    for (u32 i = 0; i < _levels_count; ++i)
+        levels.push_back({level_size(i), _levels[i]});
+
+    return util::petx_write(util::petx_block_pixels(_format), u32(channels_count()), levels, compress);
+}
+
+u32 grx_compressed_color_map::max_levels_count(const vec2u& size) {
+    u32 levels = 1;
+    for (auto side = std::max(size.x(), size.y()); side > 1; side /= 2)
+        ++levels;
+    return levels;
+}
+
+vec2u grx_compressed_color_map::level_size(const vec2u& size, u32 level) {
+    return {std::max(size.x() >> level, 1U), std::max(size.y() >> level, 1U)};
+}
+
+span<const byte> grx_compressed_color_map::level_data(u32 level) const {
+    if (level >= _levels_count)
+        pe_throw std::runtime_error(
+            core::format("Invalid level {}: compressed color map has {} levels", level, _levels_count));
+
+    return _levels[level];
+}
+
+size_t grx_compressed_color_map::byte_size() const {
+    size_t result = 0;
+    for (auto& level : _levels)
+        result += static_cast<size_t>(level.size());
+    return result;
+}
+
+bool grx_compressed_color_map::is_asset_view() const {
+    return _storage && _storage->asset.has_value();
+}
+
+void grx_compressed_color_map::decompress(u32 level, u8* output, size_t channels, fiber_pool* pool) const {
+    util::dxt_decode(_format, level_data(level), level_size(level), output, channels, pool);
+}
+} // namespace grx
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <core/vec.hpp>
+#include <util/texture_decode.hpp>
+
+namespace core {
+    class fiber_pool;
+}
+
+namespace util {
+    class vtf_view;
+    class asset_data;
+}
+
+namespace grx
+{
+/**
+ * @brief Represents a block compressed image with mipmaps in the main memory
+ *
+ * Blocks are kept as-is, so the image can be uploaded to the video memory without decompression.
+ * Levels are stored from the largest to the smallest one, every level is half of the previous level
+ * (but not less than one pixel)
+ *
+ * The image is serialized to .petx v2 files (see util::petx_view) with blocks of every level stored separately.
+ */
+class grx_compressed_color_map {
+public:
+    grx_compressed_color_map() = default;
+
+    /**
+     * @brief Constructs the compressed color map from blocks of all levels
+     *
+     * @throw runtime_error if the size is zero, there are too many levels or the data size does not match levels
+     *
+     * @param format - the block format
+     * @param size - the size of the largest level in pixels
+     * @param levels_count - the count of levels including the largest one
+     * @param data - blocks of all levels from the largest to the smallest one
+     */
+    grx_compressed_color_map(util::dxt_format         format,
+                             const core::vec2u&       size,
+                             core::u32                levels_count,
+                             core::vector<core::byte> data);
+
+    /**
+     * @brief Extracts blocks of the high resolution image and all its mipmaps from the vtf file
+     *
+     * @throw runtime_error if the image is not block compressed or the data is truncated
+     *
+     * @param vtf - the vtf file
+     *
+     * @return the compressed color map
+     */
+    static grx_compressed_color_map from_vtf(const util::vtf_view& vtf);
+
+    /**
+     * @brief Loads the compressed color map from .petx bytes
+     *
+     * @throw runtime_error if bytes are invalid
+     *
+     * @param bytes - the file data
+     *
+     * @return the compressed color map with copied blocks
+     */
+    static grx_compressed_color_map from_bytes(core::span<const core::byte> bytes);
+
+    /**
+     * @brief Loads the compressed color map from the .petx asset
+     *
+     * Uncompressed levels of .petx v2 files are not copied: the color map keeps the asset alive and levels are
+     * views into it, so levels of mapped assets are read from the page cache only when they are uploaded
+     *
+     * @throw runtime_error if the asset is invalid
+     *
+     * @param asset - the asset data, see util::try_map_asset()
+     *
+     * @return the compressed color map
+     */
+    static grx_compressed_color_map from_asset(util::asset_data asset);
+
+    /**
+     * @brief Checks that bytes contain the compressed color map
+     */
+    static bool is_compressed_petx(core::span<const core::byte> bytes);
+
+    /**
+     * @brief Serializes the compressed color map to .petx v2 bytes
+     *
+     * @param compress - compress levels with the "texture" asset codec, levels which don't shrink enough and all
+     * levels of files written without compression can be mapped without copying
+     *
+     * @return the file data
+     */
+    [[nodiscard]]
+    core::vector<core::byte> to_bytes(bool compress = true) const;
+
+    /**
+     * @brief Gets the count of levels in the full mipmap chain (down to 1x1)
+     */
+    static core::u32 max_levels_count(const core::vec2u& size);
+
+    /**
+     * @brief Gets the size of the level in pixels
+     */
+    static core::vec2u level_size(const core::vec2u& size, core::u32 level);
+
+    [[nodiscard]]
+    core::vec2u level_size(core::u32 level) const {
+        return level_size(_size, level);
+    }
+
+    /**
+     * @brief Gets blocks of the level
+     *
+     * @param level - the level, 0 - the largest level
+     *
+     * @return blocks in row-major order
+     */
+    [[nodiscard]]
+    core::span<const core::byte> level_data(core::u32 level) const;
+
+    /**
+     * @brief Decompresses the level
+     *
+     * This is the fallback for the case when the video driver can't consume block compressed data
+     *
+     * @param level - the level, 0 - the largest level
+     * @param output - level_size(level).x() * level_size(level).y() * channels bytes
+     * @param channels - 3 for RGB output or 4 for RGBA output
+     * @param pool - the fiber pool which runs decoding jobs, nullptr - the global fiber pool
+     */
+    void decompress(core::u32         level,
+                    core::u8*         output,
+                    size_t            channels = 4,
+                    core::fiber_pool* pool     = nullptr) const;
+
+    /**
+     * @brief Gets the count of channels which the texture should have (3 for DXT1 and 4 for others)
+     */
+    [[nodiscard]]
+    size_t channels_count() const {
+        return _format == util::dxt_format::dxt1 ? 3 : 4;
+    }
+
+    [[nodiscard]]
+    util::dxt_format format() const {
+        return _format;
+    }
+
+    [[nodiscard]]
+    const core::vec2u& size() const {
+        return _size;
+    }
+
+    [[nodiscard]]
+    core::u32 levels_count() const {
+        return _levels_count;
+    }
+
+    [[nodiscard]]
+    bool has_mipmaps() const {
+        return _levels_count > 1;
+    }
+
+    /**
+     * @brief Gets the size of blocks of all levels
+     */
+    [[nodiscard]]
+    size_t byte_size() const;
+
+    /**
+     * @brief Checks that levels are views into the asset which the color map was loaded from
+     */
+    [[nodiscard]]
+    bool is_asset_view() const;
+
+private:
+    /* Owns blocks: the asset and levels which were decompressed or copied */
+    struct storage_t;
+
+    grx_compressed_color_map(util::dxt_format                           format,
+                             const core::vec2u&                         size,
+                             core::vector<core::span<const core::byte>> levels,
+                             core::shared_ptr<const storage_t>          storage);
+
+    void validate_levels_count() const;
+
+private:
+    util::dxt_format                           _format       = util::dxt_format::dxt1;
+    core::vec2u                                _size         = {0, 0};
+    core::u32                                  _levels_count = 0;
+    core::shared_ptr<const storage_t>          _storage;
+    core::vector<core::span<const core::byte>> _levels;
+};
+} // namespace grx
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <core/compact_serialization.hpp>
 #include <core/serialization.hpp>
+#include <core/serialization_sink.hpp>
 #include <core/slice_range_view.hpp>
 
 #include <core/files.hpp>
@@ -118,21 +120,9 @@ struct grx_mesh_element { // NOLINT
     }
 };
 
-/**
- * @brief Represents a mesh (or mesh group) with typed buffers
- *
- * Buffers of all mesh elements with same target type stores in
- * the one flat buffer and ready to be copied into video memory
- *
- * @tparam Ts - buffer types
- */
-template <MeshBufT... Ts>
-class grx_cpu_mesh_group {
-public:
-    using grx_cpu_mesh_group_tag = void;
-    static constexpr size_t buffers_count = sizeof...(Ts);
-
-    void serialize(core::vector<core::byte>& _s) const {
+namespace details {
+    template <MeshBufT... Ts>
+    void mesh_group_serialize_header(core::vector<core::byte>& _s) {
         core::u64 buf_count = sizeof...(Ts);
         core::serialize(buf_count, _s);
 
@@ -142,11 +132,15 @@ public:
         };
 
         (write_tag(Ts::tag), ...);
+    }
 
-        core::serialize_all(_s, _elements, _data);
+    template <MeshBufT... Ts>
+    constexpr size_t mesh_group_header_size() {
+        return sizeof(core::u64) + sizeof(core::u32) * sizeof...(Ts);
     }
 
-    void deserialize(core::span<const core::byte>& _d) {
+    template <MeshBufT... Ts>
+    void mesh_group_deserialize_header(core::span<const core::byte>& _d) {
         core::u64 buf_count; // NOLINT
         core::deserialize(buf_count, _d);
 
@@ -165,8 +159,68 @@ public:
         };
 
         (check_tag(Ts::tag), ...);
+    }
+
+    /* Indices are delta encoded, other buffers are aligned, so they can be borrowed */
+    template <MeshBufT T, typename B>
+    void mesh_group_serialize_buffer(const B& buff, core::vector<core::byte>& _s) {
+        if constexpr (T::tag == mesh_buf_tag::index)
+            core::serialize_delta_encoded(buff, _s);
+        else
+            core::serialize_aligned(buff, _s);
+    }
+
+    template <MeshBufT T, typename B>
+    size_t mesh_group_buffer_size(const B& buff) {
+        if constexpr (T::tag == mesh_buf_tag::index)
+            return core::delta_encoded_size(buff);
+        else
+            return core::serialized_aligned_size(buff);
+    }
+
+    template <MeshBufT T>
+    void mesh_group_deserialize_buffer(typename T::type& buff, core::span<const core::byte>& _d) {
+        if constexpr (T::tag == mesh_buf_tag::index)
+            core::deserialize_delta_encoded(buff, _d);
+        else
+            core::deserialize_aligned(buff, _d);
+    }
+}
+
+/**
+ * @brief Represents a mesh (or mesh group) with typed buffers
+ *
+ * Buffers of all mesh elements with same target type stores in
+ * the one flat buffer and ready to be copied into video memory
+ *
+ * @tparam Ts - buffer types
+ */
+template <MeshBufT... Ts>
+class grx_cpu_mesh_group {
+public:
+    using grx_cpu_mesh_group_tag = void;
+    static constexpr size_t buffers_count = sizeof...(Ts);
+
+    void serialize(core::vector<core::byte>& _s) const {
+        details::mesh_group_serialize_header<Ts...>(_s);
+        core::serialize(_elements, _s);
 
-        core::deserialize_all(_d, _elements, _data);
+        std::apply([&_s](auto&... buffs) { (details::mesh_group_serialize_buffer<Ts>(buffs, _s), ...); }, _data);
+    }
+
+    void deserialize(core::span<const core::byte>& _d) {
+        details::mesh_group_deserialize_header<Ts...>(_d);
+        core::deserialize(_elements, _d);
+
+        std::apply([&_d](auto&... buffs) { (details::mesh_group_deserialize_buffer<Ts>(buffs, _d), ...); }, _data);
+    }
+
+    [[nodiscard]]
+    size_t serialized_size() const {
+        return details::mesh_group_header_size<Ts...>() + core::serialized_size(_elements) +
+               std::apply(
+                   [](auto&... buffs) { return (size_t(0) + ... + details::mesh_group_buffer_size<Ts>(buffs)); },
+                   _data);
     }
 
     /**
@@ -503,6 +557,61 @@ public:
         }
     }
 
+    static constexpr bool has_uv_buf() {
+        return has_mesh_buf_tag<mesh_buf_tag::uv, Ts...>();
+    }
+
+    /**
+     * @brief Gets bounds of texture coordinates of the mesh element
+     *
+     * @param element_index - index of mesh element
+     *
+     * @return the minimum and the maximum coordinates, min > max if the element has no vertices
+     */
+    template <bool C = has_uv_buf()>
+    [[nodiscard]]
+    auto uv_bounds(uint element_index) const -> std::enable_if_t<C, core::pair<vec2f, vec2f>> {
+        auto& element = _elements.at(element_index);
+        auto& uvs     = get<mesh_buf_tag::uv>();
+
+        auto min = vec2f::filled_with(core::numlim<float>::max());
+        auto max = vec2f::filled_with(core::numlim<float>::lowest());
+        for (uint i = element.start_vertex_pos; i < element.start_vertex_pos + element.vertices_count; ++i) {
+            min = {std::min(min.x(), uvs[i].x()), std::min(min.y(), uvs[i].y())};
+            max = {std::max(max.x(), uvs[i].x()), std::max(max.y(), uvs[i].y())};
+        }
+
+        return {min, max};
+    }
+
+    /**
+     * @brief Transforms texture coordinates of the mesh element: uv = offset + uv * scale
+     *
+     * Used to remap coordinates into the region of the texture atlas
+     *
+     * @param element_index - index of mesh element
+     * @param offset - the offset
+     * @param scale - the scale
+     */
+    template <bool C = has_uv_buf()>
+    auto transform_uvs(uint element_index, const vec2f& offset, const vec2f& scale) -> std::enable_if_t<C> {
+        auto& element = _elements.at(element_index);
+        auto& uvs     = get<mesh_buf_tag::uv>();
+
+        for (uint i = element.start_vertex_pos; i < element.start_vertex_pos + element.vertices_count; ++i)
+            uvs[i] = offset + uvs[i] * scale;
+    }
+
+    /**
+     * @brief Sets the material of the mesh element
+     *
+     * @param element_index - index of mesh element
+     * @param material_index - index of the material
+     */
+    void material_index(uint element_index, uint material_index) {
+        _elements.at(element_index).material_index = material_index;
+    }
+
 private:
     core::tuple<typename Ts::type...> _data;
     core::vector<grx_mesh_element>    _elements;
@@ -548,6 +657,141 @@ public:
     }
 };
 
+/**
+ * @brief Read-only mesh group which borrows buffers from the serialized grx_cpu_mesh_group
+ *
+ * Buffers point directly into serialized data (e.g. the memory mapped asset or the decompressed
+ * asset cache entry), so the mesh can be uploaded into video memory without intermediate copies.
+ * Buffers are copied only if the payload is misaligned in memory. Delta encoded indices are always
+ * decoded into the own storage.
+ * Use materialize() to get the mutable mesh group
+ *
+ * @tparam Ts - buffer types
+ */
+template <MeshBufT... Ts>
+class grx_cpu_mesh_group_view {
+public:
+    template <typename T>
+    using buffer_view_t = core::span<const typename T::type::value_type>;
+
+    grx_cpu_mesh_group_view() = default;
+    ~grx_cpu_mesh_group_view() = default;
+
+    grx_cpu_mesh_group_view(grx_cpu_mesh_group_view&&) noexcept = default;
+    grx_cpu_mesh_group_view& operator=(grx_cpu_mesh_group_view&&) noexcept = default;
+
+    grx_cpu_mesh_group_view(const grx_cpu_mesh_group_view&) = delete;
+    grx_cpu_mesh_group_view& operator=(const grx_cpu_mesh_group_view&) = delete;
+
+    /**
+     * @brief Deserializes the mesh group
+     *
+     * @param data - serialized grx_cpu_mesh_group, the span will be advanced past the mesh group
+     * @param source - the owner of serialized data, it stays alive while the view exists
+     */
+    grx_cpu_mesh_group_view(core::span<const core::byte>& data, core::shared_ptr<const void> source):
+        _source(core::move(source)) {
+        details::mesh_group_deserialize_header<Ts...>(data);
+        core::deserialize(_elements, data);
+        _deserialize_buffers(data, std::make_index_sequence<sizeof...(Ts)>());
+    }
+
+    void serialize(core::vector<core::byte>& _s) const {
+        details::mesh_group_serialize_header<Ts...>(_s);
+        core::serialize(_elements, _s);
+
+        std::apply([&_s](auto&... views) { (details::mesh_group_serialize_buffer<Ts>(views, _s), ...); }, _views);
+    }
+
+    [[nodiscard]]
+    size_t serialized_size() const {
+        return details::mesh_group_header_size<Ts...>() + core::serialized_size(_elements) +
+               std::apply(
+                   [](auto&... views) { return (size_t(0) + ... + details::mesh_group_buffer_size<Ts>(views)); },
+                   _views);
+    }
+
+    /**
+     * @brief Gets data of buffer
+     *
+     * @tparam tag - the tag of the buffer
+     *
+     * @return the view of the buffer
+     */
+    template <mesh_buf_tag tag, size_t BuffIdx = mesh_buf_tag_to_index<tag, Ts...>>
+    [[nodiscard]]
+    auto get() const {
+        return std::get<BuffIdx>(_views);
+    }
+
+    [[nodiscard]]
+    const core::vector<grx_mesh_element>& elements() const {
+        return _elements;
+    }
+
+    [[nodiscard]]
+    size_t elements_count() const {
+        return _elements.size();
+    }
+
+    /**
+     * @brief Checks that all buffers except indices point into serialized data
+     *
+     * @return true if no buffer was copied
+     */
+    [[nodiscard]]
+    bool is_borrowed() const {
+        return _borrowed;
+    }
+
+    /**
+     * @brief Copies buffers into the mutable mesh group
+     *
+     * @return the mesh group
+     */
+    [[nodiscard]]
+    grx_cpu_mesh_group<Ts...> materialize() const {
+        return _materialize(std::make_index_sequence<sizeof...(Ts)>());
+    }
+
+private:
+    template <size_t Idx>
+    bool _deserialize_buffer(core::span<const core::byte>& data) {
+        using spec_t = std::tuple_element_t<Idx, core::tuple<Ts...>>;
+
+        if constexpr (spec_t::tag == mesh_buf_tag::index) {
+            core::deserialize_delta_encoded(std::get<Idx>(_storage), data);
+            std::get<Idx>(_views) = std::get<Idx>(_storage);
+            return true;
+        }
+        else {
+            return core::deserialize_view(std::get<Idx>(_views), std::get<Idx>(_storage), data);
+        }
+    }
+
+    template <size_t... Idxs>
+    void _deserialize_buffers(core::span<const core::byte>& data, std::index_sequence<Idxs...>&&) {
+        ((_borrowed = _deserialize_buffer<Idxs>(data) && _borrowed), ...);
+    }
+
+    template <size_t... Idxs>
+    grx_cpu_mesh_group<Ts...> _materialize(std::index_sequence<Idxs...>&&) const {
+        grx_cpu_mesh_group<Ts...> mesh;
+        mesh.elements(_elements);
+        ((mesh.template set<Idxs>(
+             typename Ts::type(std::get<Idxs>(_views).begin(), std::get<Idxs>(_views).end()))),
+         ...);
+        return mesh;
+    }
+
+private:
+    core::tuple<buffer_view_t<Ts>...>   _views;
+    core::tuple<typename Ts::type...>   _storage;
+    core::vector<grx_mesh_element>      _elements;
+    core::shared_ptr<const void>        _source;
+    bool                                _borrowed = true;
+};
+
 template <typename T>
 concept CpuMeshGroup = requires { typename T::grx_cpu_mesh_group_tag; };
 
@@ -640,10 +884,7 @@ inline bool try_save_mesh_group(const core::string& file_path, const T& mesh_gro
 
 template <CpuMeshGroup T>
 inline void save_mesh_group(const core::string& file_path, const T& mesh_group) {
-    core::serializer s;
-    s.write(mesh_group);
-
-    core::write_file(file_path, s.data());
+    core::serialize_to_file(file_path, mesh_group);
 }
 
 template <CpuMeshGroup T>
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "grx_color_map.hpp"
+
+namespace grx
+{
+/**
+ * @brief Levels of the .petx v2 image without copying
+ *
+ * Uncompressed levels are views into the asset, so levels of mapped files and asset packs are read from the page
+ * cache on access. Compressed levels are decompressed once on load. Views are valid while the mapped color map
+ * is alive
+ *
+ * @tparam T - the type of the color channel value
+ * @tparam NPP - channels count
+ */
+template <ColorComponent T, size_t NPP>
+class grx_mapped_color_map {
+public:
+    /**
+     * @brief Maps the .petx v2 image
+     *
+     * @throw runtime_error if the file can't be found, it is not .petx v2 image or its pixels don't match
+     *
+     * @param file_path - a path to the image file
+     *
+     * @return the mapped color map
+     */
+    static grx_mapped_color_map map(const core::string& file_path) {
+        auto asset = util::try_map_asset(file_path);
+        if (!asset)
+            pe_throw std::runtime_error("Can't open file \"" + file_path + "\"");
+
+        return grx_mapped_color_map(core::move(*asset));
+    }
+
+    /**
+     * @brief Reads levels of the .petx v2 image
+     *
+     * @throw runtime_error if the asset is not .petx v2 image or its pixels don't match
+     *
+     * @param asset - the asset data, see util::try_map_asset()
+     */
+    explicit grx_mapped_color_map(util::asset_data asset): _asset(core::move(asset)) {
+        auto view = util::petx_view(_asset.bytes());
+        if (view.pixels() != grx_color_map<T, NPP>::petx_pixels || view.channels() != NPP)
+            pe_throw std::runtime_error(core::format("Invalid petx pixels: gets {} with {} channels but {} with {} "
+                                                     "channels required",
+                                                     magic_enum::enum_name(view.pixels()),
+                                                     view.channels(),
+                                                     magic_enum::enum_name(grx_color_map<T, NPP>::petx_pixels),
+                                                     NPP));
+
+        for (core::u32 i = 0; i < view.levels_count(); ++i) {
+            auto& level = view.level(i);
+            _sizes.push_back(level.size);
+
+            /* The asset data is not moved with the asset, views stay valid */
+            auto data = view.try_view(i);
+            if (data && reinterpret_cast<std::uintptr_t>(data->data()) % alignof(T) == 0) { // NOLINT
+                _levels.push_back(reinterpret_cast<const T*>(data->data())); // NOLINT
+                continue;
+            }
+
+            auto& owned = _owned.emplace_back(std::make_unique<T[]>(level.raw_size / sizeof(T))); // NOLINT
+            view.read_level(i,
+                            core::span<core::byte>(reinterpret_cast<core::byte*>(owned.get()), // NOLINT
+                                                   static_cast<ssize_t>(level.raw_size)));
+            _levels.push_back(owned.get());
+        }
+    }
+
+    /**
+     * @brief Gets the view of the level
+     *
+     * The view is read-only, the mapping can't be written
+     *
+     * @param level - the level, 0 - the largest level
+     */
+    [[nodiscard]]
+    grx_color_map_view<T, NPP, true> level(core::u32 level) const {
+        if (level >= _levels.size())
+            pe_throw std::runtime_error(
+                core::format("Invalid level {}: mapped color map has {} levels", level, _levels.size()));
+
+        return grx_color_map_view<T, NPP, true>(const_cast<T*>(_levels[level]), _sizes[level]); // NOLINT
+    }
+
+    /**
+     * @brief Checks that the level is a view into the asset
+     */
+    [[nodiscard]]
+    bool is_level_view(core::u32 level) const {
+        auto data  = reinterpret_cast<const core::byte*>(_levels.at(level)); // NOLINT
+        auto bytes = _asset.bytes();
+        return data >= bytes.data() && data < bytes.data() + bytes.size();
+    }
+
+    [[nodiscard]]
+    const vec2u& size() const {
+        return _sizes.front();
+    }
+
+    [[nodiscard]]
+    core::u32 levels_count() const {
+        return static_cast<core::u32>(_levels.size());
+    }
+
+    [[nodiscard]]
+    bool is_mapped() const {
+        return _asset.is_mapped();
+    }
+
+private:
+    util::asset_data                   _asset;
+    core::vector<vec2u>                _sizes;
+    core::vector<const T*>             _levels;
+    core::vector<std::unique_ptr<T[]>> _owned; // NOLINT
+};
+
+using grx_mapped_color_map_rgb  = grx_mapped_color_map<uint8_t, 3>;
+using grx_mapped_color_map_rgba = grx_mapped_color_map<uint8_t, 4>;
+
+using grx_mapped_float_color_map_rgb  = grx_mapped_color_map<float, 3>;
+using grx_mapped_float_color_map_rgba = grx_mapped_color_map<float, 4>;
+} // namespace grx
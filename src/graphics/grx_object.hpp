@@ -206,6 +206,13 @@ public:
     grx_object(const grx_cpu_mesh_group<BufTs...>& mesh_group, grx_object_instanced_tag&&):
         grx_object(mesh_group, std::make_index_sequence<sizeof...(BufTs)>()) {}
 
+    /**
+     * @brief Uploads buffers borrowed from serialized data without intermediate copies
+     */
+    template <MeshBufT... BufTs>
+    grx_object(const grx_cpu_mesh_group_view<BufTs...>& mesh_view):
+        grx_object(mesh_view, std::make_index_sequence<sizeof...(BufTs)>()) {}
+
     template <bool Enable = !IsInstanced, bool Skeleton = has_skeleton(), typename... FinalTransformsT>
     std::enable_if_t<Enable> draw(const glm::mat4&                            vp,
                                   const glm::mat4&                            model,
@@ -233,9 +240,14 @@ public:
         }
 
         _vbo.bind_vao();
+
+        /* Elements of the same material (e.g. the texture atlas page) keep texture bindings */
+        auto bound_material = core::numlim<uint>::max();
         for (auto& element : _elements) {
-            if (enable_textures)
+            if (enable_textures && element.material_index != bound_material) {
                 draw_setup_textures(element);
+                bound_material = element.material_index;
+            }
 
             _vbo.draw(element.indices_count, element.start_vertex_pos, element.start_index_pos);
         }
@@ -260,9 +272,12 @@ public:
             m = vp * m;
         _vbo.template set_nth_type<vbo_vector_matrix4, 0>(model_mats);
 
+        auto bound_material = core::numlim<uint>::max();
         for (auto& element : _elements) {
-            if (enable_textures)
+            if (enable_textures && element.material_index != bound_material) {
                 draw_setup_textures(element);
+                bound_material = element.material_index;
+            }
 
             _vbo.draw_instanced(model_mats.size(),
                                 element.indices_count,
@@ -298,9 +313,12 @@ public:
         grx_ssbo<core::vector<glm::mat4>> ssbo;
         ssbo.set(0, all_final_transforms);
 
+        auto bound_material = core::numlim<uint>::max();
         for (auto& element : _elements) {
-            if (enable_textures)
+            if (enable_textures && element.material_index != bound_material) {
                 draw_setup_textures(element);
+                bound_material = element.material_index;
+            }
 
             _vbo.draw_instanced(model_mats.size(),
                                 element.indices_count,
@@ -418,6 +436,12 @@ private:
         //    _aabb.merge(e.aabb);
     }
 
+    template <MeshBufT... BufTs, size_t... Idxs>
+    grx_object(const grx_cpu_mesh_group_view<BufTs...>& mesh_view, std::index_sequence<Idxs...>&&):
+        _elements(mesh_view.elements()) {
+        ((_vbo.template set_data<Idxs>(mesh_view.template get<BufTs::tag>())), ...);
+    }
+
     template <MeshBufT... BufTs>
     void _set_from_mesh_group(const grx_cpu_mesh_group<BufTs...>& mesh_group) {
         _set_from_mesh_group(mesh_group, std::make_index_sequence<sizeof...(BufTs)>());
@@ -505,13 +529,13 @@ auto try_load_object(const core::shared_ptr<object_texture_mgr_t>& texture_mgr,
     auto relative_dir = core::path_eval(relative_path / "..");
 
     if (core::has_extension(absolute_path, ".dae")) {
-        auto data = core::try_read_file(absolute_path);
+        auto data = util::try_read_asset(absolute_path);
 
         if (!data)
             return std::runtime_error("Can't load mesh at path '" + absolute_path + "'");
 
         try {
-            auto str_data = grx_utils::collada_bake_bind_shape_matrix(*data);
+            auto str_data = grx_utils::collada_bake_bind_shape_matrix(data->str());
             auto scene    = details::assimp_load_scene(str_data);
             auto guard    = core::scope_guard{[&]() {
                 details::assimp_release_scene(scene);
@@ -546,11 +570,11 @@ auto try_load_object(const core::shared_ptr<object_texture_mgr_t>& texture_mgr,
         }
     } else {
         ObjectT object;
-        auto obj_data = core::try_read_binary_file(absolute_path);
+        auto obj_data = util::try_read_asset(absolute_path);
         if (!obj_data)
             return std::runtime_error("Can't load object at path '" + absolute_path + "'");
         else {
-            deserializer_view ds{*obj_data};
+            deserializer_view ds{obj_data->bytes()};
             ds.read(object);
             return object;
         }
@@ -1,9 +1,13 @@
+#include <filesystem>
 #include <core/resource_mgr_base.hpp>
+#include <util/asset_cache.hpp>
+#include <util/asset_pack.hpp>
 #include "graphics/algorithms/grx_frustum_culling.hpp"
 #include "graphics/grx_debug.hpp"
 #include "grx_object.hpp"
 #include "grx_movable.hpp"
 #include "grx_animation_player.hpp"
+#include "grx_texture_atlas.hpp"
 
 namespace grx
 {
@@ -297,14 +301,43 @@ struct grx_cached_mesh_t : public details::skeleton_storage<MeshT::has_bone_buf(
 
     template <bool HasSkeleton = MeshT::has_bone_buf()>
     void serialize(core::vector<core::byte>& s) const {
-        core::serialize_all(s, mesh, texture_path_sets, aabb, overlap_aabb);
+        if (mesh_view)
+            mesh_view->serialize(s);
+        else
+            core::serialize(mesh, s);
+
+        core::serialize_all(s, texture_path_sets, aabb, overlap_aabb, atlas_regions, atlas_sources);
         if constexpr (HasSkeleton)
             grx_object_skeleton::serialize(s);
     }
 
     template <bool HasSkeleton = MeshT::has_bone_buf()>
     void deserialize(core::span<const core::byte>& d) {
-        core::deserialize_all(d, mesh, texture_path_sets, aabb, overlap_aabb);
+        core::deserialize_all(d, mesh, texture_path_sets, aabb, overlap_aabb, atlas_regions, atlas_sources);
+        if constexpr (HasSkeleton)
+            grx_object_skeleton::deserialize(d);
+    }
+
+    template <bool HasSkeleton = MeshT::has_bone_buf()>
+    [[nodiscard]]
+    size_t serialized_size() const {
+        auto size = (mesh_view ? mesh_view->serialized_size() : mesh.serialized_size()) +
+                    core::serialized_size_all(texture_path_sets, aabb, overlap_aabb, atlas_regions, atlas_sources);
+        if constexpr (HasSkeleton)
+            size += grx_object_skeleton::serialized_size();
+        return size;
+    }
+
+    /**
+     * @brief Deserializes the cached mesh with mesh buffers borrowed from serialized data
+     *
+     * @param d - serialized data
+     * @param source - the owner of serialized data, it will be released after the upload into video memory
+     */
+    template <bool HasSkeleton = MeshT::has_bone_buf()>
+    void deserialize_borrowed(core::span<const core::byte>& d, core::shared_ptr<const void> source) {
+        mesh_view.emplace(d, core::move(source));
+        core::deserialize_all(d, texture_path_sets, aabb, overlap_aabb, atlas_regions, atlas_sources);
         if constexpr (HasSkeleton)
             grx_object_skeleton::deserialize(d);
     }
@@ -331,7 +364,7 @@ struct grx_cached_mesh_t : public details::skeleton_storage<MeshT::has_bone_buf(
 
     template <typename M = grx_cpu_mesh_group<Ts...>>
     gpu_t to_object() && {
-        gpu_t object{mesh};
+        gpu_t object = mesh_view ? gpu_t(*mesh_view) : gpu_t(mesh);
         object.set_textures(
             load_texture_sets_from_paths<object_texture_t::component_type,
                                          object_texture_t::channels_count()>(texture_path_sets));
@@ -345,6 +378,120 @@ struct grx_cached_mesh_t : public details::skeleton_storage<MeshT::has_bone_buf(
         return object;
     }
 
+    /**
+     * @brief Version of the DAE import result
+     *
+     * Must be incremented when from_assimp, skeleton or animation import changes
+     * its output. It invalidates all baked meshes in the asset cache
+     */
+    static constexpr core::u32 dae_importer_version = 5;
+
+    /**
+     * @brief Describes everything besides the source file that affects the DAE import result
+     *
+     * @param texture_mgr_tag - the tag of the texture manager stored in texture paths
+     * @param relative_dir - the directory of the model relative to models_dir
+     * @param atlas - texture atlas settings, nullopt if atlasing is disabled
+     *
+     * @return the signature for the baked asset cache key
+     */
+    static core::string baked_signature(const core::string&                       texture_mgr_tag,
+                                        const core::string&                       relative_dir,
+                                        const core::optional<grx_atlas_settings>& atlas = {}) {
+        core::string signature = "grx_cached_mesh:";
+        ((signature += std::to_string(static_cast<core::u32>(Ts::tag)) + ","), ...);
+
+        return signature + ":" + texture_mgr_tag + ":" + relative_dir + ":" + (atlas ? atlas->signature() : "");
+    }
+
+    /**
+     * @brief Groups small textures of the mesh into atlas pages, see grx_atlas_bake()
+     *
+     * Pages are saved next to the asset cache entries, their paths replace texture paths of atlased materials.
+     * The mesh is left untouched if the bake fails
+     *
+     * @param settings - the atlas settings
+     * @param cache_key - the key of the asset cache entry, it makes names of page files unique
+     * @param texture_mgr_tag - the tag of the texture manager stored in texture paths
+     */
+    void bake_texture_atlas(const grx_atlas_settings& settings,
+                            const core::md5_hash&     cache_key,
+                            const core::string&       texture_mgr_tag) {
+        using color_t = core::vec<object_texture_t::component_type, object_texture_t::channels_count()>;
+        using map_t   = grx_color_map<object_texture_t::component_type, object_texture_t::channels_count()>;
+
+        /* Textures are hashed from the bytes they are decoded from */
+        core::hash_map<core::string, core::md5_hash> hashes;
+
+        auto new_mesh  = mesh;
+        auto new_paths = texture_path_sets;
+        auto result    = grx_atlas_bake<object_texture_t::component_type, object_texture_t::channels_count()>(
+            new_mesh,
+            new_paths,
+            [&](const core::resource_path_t& path) -> core::optional<map_t> {
+                auto absolute = path.path.absolute();
+                auto file     = util::try_map_asset(absolute);
+                if (!file)
+                    return core::nullopt;
+
+                auto map = try_load_color_map_from_bytes<color_t>(file->bytes());
+                if (!map)
+                    return core::nullopt;
+
+                hashes.insert_or_assign(absolute, core::md5(file->bytes()));
+                return core::move(map).value();
+            },
+            settings);
+
+        core::vector<grx_atlas_source> sources;
+        for (auto& path : result.sources)
+            sources.push_back(grx_atlas_source{path.path, hashes.at(path.path.absolute())});
+
+        for (auto& page : result.pages) {
+            for (auto& [map, i] : core::value_index_view(page.maps)) {
+                if (!map)
+                    continue;
+
+                auto tag  = static_cast<grx_texture_set_tag>(i);
+                auto name =
+                    core::format("atlas/{}_{}_{}.petx", cache_key, page.material, magic_enum::enum_name(tag));
+                auto path     = core::cfg_path("cache_dir", name);
+                auto absolute = path.absolute();
+
+                std::filesystem::create_directories(std::filesystem::path(absolute).parent_path());
+                core::write_file(absolute, map->to_bytes());
+
+                new_paths[page.material].set(
+                    tag, core::resource_path_t{texture_mgr_tag, path, core::load_significance_t::medium});
+            }
+        }
+
+        mesh              = core::move(new_mesh);
+        texture_path_sets = core::move(new_paths);
+        atlas_regions     = core::move(result.regions);
+        atlas_sources     = core::move(sources);
+    }
+
+    /**
+     * @brief Checks that files of atlas pages were not removed and source textures were not changed since the bake
+     *
+     * Source textures are hashed on every check, they are small enough for atlasing (see grx_atlas_settings)
+     */
+    [[nodiscard]]
+    bool atlas_is_actual() const {
+        for (auto& region : atlas_regions)
+            for (auto& path : texture_path_sets.at(region.page_material).options())
+                if (path && !std::filesystem::exists(path->path.absolute()))
+                    return false;
+
+        for (auto& source : atlas_sources) {
+            auto file = util::try_map_asset(source.path.absolute());
+            if (!file || core::md5(file->bytes()) != source.content_hash)
+                return false;
+        }
+        return true;
+    }
+
     template <typename M = grx_cpu_mesh_group<Ts...>>
     static grx_cached_mesh_t
     load_async(const core::shared_ptr<mgr_t>& mgr, const core::cfg_path& path) {
@@ -356,12 +503,37 @@ struct grx_cached_mesh_t : public details::skeleton_storage<MeshT::has_bone_buf(
         auto relative_dir = core::path_eval(path.path / "..");
 
         if (core::has_extension(absolute_path, ".dae")) {
-            auto data = core::try_read_file(absolute_path);
+            auto asset = util::try_read_asset(absolute_path);
 
-            if (!data)
+            if (!asset)
                 pe_throw std::runtime_error("Can't load mesh at path '" + absolute_path + "'");
 
-            auto str_data = grx_utils::collada_bake_bind_shape_matrix(*data);
+            auto  data      = asset->str();
+            auto& cache     = util::global_asset_cache();
+            auto& atlas     = mgr->texture_atlas();
+            auto  cache_key = util::asset_cache::make_key(
+                data, baked_signature(mgr->texture_mgr().mgr_tag(), relative_dir, atlas), dae_importer_version);
+
+            if (auto baked = cache.try_load(cache_key)) {
+                try {
+                    /* Mesh buffers stay in the decompressed entry until the upload */
+                    auto source = core::make_shared<core::byte_vector>(core::move(*baked));
+                    auto bytes  = core::span<const core::byte>(*source);
+                    cached.deserialize_borrowed(bytes, core::move(source));
+                    if (!cached.atlas_is_actual())
+                        pe_throw std::runtime_error("texture atlas pages are missing or outdated");
+
+                    DLOG("grx_cached_mesh: {} loaded from the asset cache", absolute_path);
+                    return cached;
+                }
+                catch (const std::exception& e) {
+                    LOG_WARNING("grx_cached_mesh: broken asset cache entry for {}: {}", absolute_path, e.what());
+                    cache.remove(cache_key);
+                    cached = grx_cached_mesh_t{};
+                }
+            }
+
+            auto str_data = grx_utils::collada_bake_bind_shape_matrix(data);
             auto scene    = details::assimp_load_scene(str_data);
             auto guard    = core::scope_guard{[&]() {
                 details::assimp_release_scene(scene);
@@ -389,23 +561,46 @@ struct grx_cached_mesh_t : public details::skeleton_storage<MeshT::has_bone_buf(
                 cached.texture_path_sets = get_texture_paths_from_assimp(
                     "models_dir", relative_dir, scene, mgr->texture_mgr().mgr_tag());
             }
+
+            /* Pages are stored in the cache directory, so atlasing requires the enabled cache */
+            if (atlas && cache.is_enabled()) {
+                try {
+                    cached.bake_texture_atlas(*atlas, cache_key, mgr->texture_mgr().mgr_tag());
+                    if (!cached.atlas_regions.empty())
+                        DLOG("grx_cached_mesh: {} materials of {} moved into texture atlas pages",
+                             cached.atlas_regions.size(),
+                             absolute_path);
+                }
+                catch (const std::exception& e) {
+                    LOG_WARNING("grx_cached_mesh: can't bake texture atlas for {}: {}", absolute_path, e.what());
+                }
+            }
+
+            core::serializer s;
+            s.write(cached);
+            cache.store(cache_key, s.data(), "mesh");
         }
         else {
-            auto bytes = core::try_read_binary_file(absolute_path);
-            if (!bytes)
+            /* Mesh buffers of uncompressed entries of mounted packs are borrowed directly from the mapping */
+            auto asset = util::try_read_asset(absolute_path);
+            if (!asset)
                 pe_throw std::runtime_error("Can't open object at path '" + absolute_path + "'");
 
-            auto ds = core::deserializer_view(*bytes);
-            ds.read(cached);
+            auto source = core::make_shared<util::asset_data>(core::move(*asset));
+            auto bytes  = source->bytes();
+            cached.deserialize_borrowed(bytes, core::move(source));
         }
 
         return cached;
     }
 
     grx_cpu_mesh_group<Ts...> mesh;
+    core::optional<grx_cpu_mesh_group_view<Ts...>> mesh_view; /* Replaces the mesh if loaded with borrowed buffers */
     core::vector<grx_texture_path_set> texture_path_sets;
     grx_aabb                           aabb = grx_aabb::maximized();
     grx_aabb                           overlap_aabb = grx_aabb::maximized();
+    core::vector<grx_atlas_region>     atlas_regions; /* Materials which textures were moved into atlas pages */
+    core::vector<grx_atlas_source>     atlas_sources; /* Contents of textures which were moved into atlas pages */
 };
 
 template <bool IsInstanced, typename MeshT, typename... Ts>
@@ -456,6 +651,22 @@ public:
         return *_texture_mgr;
     }
 
+    /**
+     * @brief Enables grouping of small textures into atlas pages when meshes are baked into the asset cache
+     *
+     * Must be set before loading, changed settings produce new asset cache keys
+     *
+     * @param settings - the atlas settings, nullopt disables atlasing
+     */
+    void texture_atlas(core::optional<grx_atlas_settings> settings) {
+        _texture_atlas = core::move(settings);
+    }
+
+    [[nodiscard]]
+    const core::optional<grx_atlas_settings>& texture_atlas() const {
+        return _texture_atlas;
+    }
+
     grx_object_mgr(typename core::constructor_accessor<grx_object_mgr>::cref,
                    const core::string& imgr_tag):
         super_t(core::constructor_accessor<super_t>{}, imgr_tag),
@@ -463,6 +674,7 @@ public:
 
 private:
     core::shared_ptr<object_texture_mgr_t> _texture_mgr;
+    core::optional<grx_atlas_settings>     _texture_atlas;
 };
 
 template <bool IsInstanced, typename MeshT>
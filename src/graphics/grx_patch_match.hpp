@@ -0,0 +1,75 @@
+#pragma once
+
+#include <util/patch_match.hpp>
+#include "grx_color_map.hpp"
+
+namespace grx
+{
+/**
+ * @brief Finds the best block of the sample for every block of the source map
+ *
+ * See util::patch_match_exact()
+ *
+ * @param src - the source map
+ * @param sample - the sample map
+ * @param settings - settings
+ * @param pool - the fiber pool (nullptr - the global fiber pool)
+ *
+ * @return matches
+ */
+template <size_t NPP>
+util::patch_match_result grx_patch_match(const grx_color_map<core::u8, NPP>& src,
+                                         const grx_color_map<core::u8, NPP>& sample,
+                                         const util::patch_match_settings&   settings = {},
+                                         core::fiber_pool*                   pool     = nullptr) {
+    return util::patch_match_exact(src.data(), src.size(), sample.data(), sample.size(), NPP, settings, pool);
+}
+
+/**
+ * @brief Finds a close block of the sample for every block of the source map
+ *
+ * See util::patch_match_approx()
+ *
+ * @param src - the source map
+ * @param sample - the sample map
+ * @param settings - settings
+ * @param approx - the quality and the seed
+ * @param pool - the fiber pool (nullptr - the global fiber pool)
+ *
+ * @return matches
+ */
+template <size_t NPP>
+util::patch_match_result grx_patch_match_approx(const grx_color_map<core::u8, NPP>&      src,
+                                                const grx_color_map<core::u8, NPP>&      sample,
+                                                const util::patch_match_settings&        settings = {},
+                                                const util::patch_match_approx_settings& approx   = {},
+                                                core::fiber_pool*                        pool     = nullptr) {
+    return util::patch_match_approx(
+        src.data(), src.size(), sample.data(), sample.size(), NPP, settings, approx, pool);
+}
+
+/**
+ * @brief Replaces every block of the map with the most similar block of the sample
+ *
+ * @param image - the map
+ * @param sample - the sample map
+ * @param settings - settings
+ * @param approx - settings of the approximate search (nullopt - the exhaustive search)
+ * @param pool - the fiber pool (nullptr - the global fiber pool)
+ *
+ * @return matches
+ */
+template <size_t NPP>
+util::patch_match_result
+grx_patch_mosaic(grx_color_map<core::u8, NPP>&                           image,
+                 const grx_color_map<core::u8, NPP>&                     sample,
+                 const util::patch_match_settings&                       settings = {},
+                 const core::optional<util::patch_match_approx_settings>& approx   = core::nullopt,
+                 core::fiber_pool*                                       pool     = nullptr) {
+    auto result = approx ? grx_patch_match_approx(image, sample, settings, *approx, pool)
+                         : grx_patch_match(image, sample, settings, pool);
+    util::patch_apply(
+        image.data(), image.size(), sample.data(), sample.size(), NPP, settings.block_size, result);
+    return result;
+}
+} // namespace grx
@@ -344,6 +344,14 @@ void grx_skeleton_optimized::deserialize(span<const byte>& in) {
     core::deserialize_all(in, _final_transforms, _depth);
 }
 
+size_t grx_skeleton_optimized::serialized_size() const {
+    /* Children spans are serialized as two u64: the offset and the size */
+    auto size = sizeof(u64) + core::serialized_size_all(_final_transforms, _depth);
+    for (auto& node : _storage)
+        size += core::serialized_size_all(node.aabb, node.idx, node.offset, node.transform) + sizeof(u64) * 2;
+    return size;
+}
+
 grx_skeleton_optimized::grx_skeleton_optimized(const unique_ptr<grx_bone_node>& root,
                                                const grx_skeleton_data&         skeleton_data):
     _final_transforms(skeleton_data.final_transforms) {
@@ -73,6 +73,9 @@ public:
     void serialize(core::vector<core::byte>& out) const;
     void deserialize(core::span<const core::byte>& in);
 
+    [[nodiscard]]
+    size_t serialized_size() const;
+
     grx_skeleton_optimized() = default;
     ~grx_skeleton_optimized() = default;
 
@@ -40,6 +40,19 @@ namespace grx::grx_texture_helper {
         }
     }
 
+    inline GLenum compressed_internal_format(util::dxt_format format) {
+        switch (format) {
+        case util::dxt_format::dxt1:             return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case util::dxt_format::dxt1_onebitalpha: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case util::dxt_format::dxt3:             return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+        case util::dxt_format::dxt5:             return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case util::dxt_format::bc7:              return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        default:
+            PeAbortF("{}", "Unknown block compression format");
+            return 0;
+        }
+    }
+
     inline GLenum gl_texture_access(texture_access access) {
         switch (access) {
         case texture_access::read:      return GL_READ_ONLY;
@@ -90,25 +103,15 @@ namespace grx::grx_texture_helper {
         GLenum type   = is_float ? GL_FLOAT : GL_UNSIGNED_BYTE;
 
         auto compsize = is_float ? sizeof(float) : 1U;
-        auto cur_w    = static_cast<GLsizei>(w);
-        auto cur_h    = static_cast<GLsizei>(h);
-        auto cur_size = cur_w * cur_h * static_cast<int>(channels * compsize);
-        auto levels   = static_cast<int>(has_pregen_mipmaps ? MIPMAPS_COUNT + 1 : 1);
+        auto levels   = has_pregen_mipmaps ? MIPMAPS_COUNT + 1 : 1U;
 
-        for (int i = 0; i < levels; ++i) {
+        /* Pregenerated mipmaps follow the grx_color_map layout */
+        for (core::u32 i = 0; i < levels; ++i) {
+            auto size = static_cast<vec2i>(mipmap_size({w, h}, i));
             GL_TRACE(
-                glTextureSubImage2D, name, i, 0, 0, cur_w, cur_h, format, type, color_map_data);
-            color_map_data = static_cast<const char*>(color_map_data) + cur_size;
-
-            cur_w /= 2;
-            cur_h /= 2;
-            constexpr auto mipmap_min = static_cast<vec2i>(MIPMAP_MIN_SIZE);
-
-            if (cur_w == mipmap_min.x())
-                cur_w = mipmap_min.x();
-            if (cur_h == mipmap_min.y())
-                cur_h = mipmap_min.y();
-            cur_size = cur_w * cur_h * static_cast<int>(channels * compsize);
+                glTextureSubImage2D, name, static_cast<int>(i), 0, 0, size.x(), size.y(), format, type, color_map_data);
+            color_map_data =
+                static_cast<const char*>(color_map_data) + static_cast<size_t>(size.x() * size.y()) * channels * compsize;
         }
 
         if (!has_pregen_mipmaps)
@@ -153,6 +156,86 @@ namespace grx::grx_texture_helper {
         GL_TRACE(glTextureParameteri, dst_name, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     }
 
+    bool compressed_textures_supported(util::dxt_format format) {
+        if (format == util::dxt_format::bc7)
+            return GLEW_ARB_texture_compression_bptc || GLEW_VERSION_4_2;
+        return GLEW_EXT_texture_compression_s3tc;
+    }
+
+    uint create_compressed_texture(uint w, uint h, util::dxt_format format, uint levels, const void* levels_data) {
+        auto name         = create_texture();
+        auto internal_fmt = compressed_internal_format(format);
+
+        GL_TRACE(glTextureStorage2D,
+                 name,
+                 static_cast<GLsizei>(levels),
+                 internal_fmt,
+                 static_cast<GLsizei>(w),
+                 static_cast<GLsizei>(h));
+
+        if (levels_data) {
+            for (uint i = 0; i < levels; ++i) {
+                auto size = grx_compressed_color_map::level_size({w, h}, i);
+                upload_compressed_level(name, i, size.x(), size.y(), format, levels_data);
+                levels_data = static_cast<const char*>(levels_data) + util::dxt_data_size(format, size);
+            }
+        }
+
+        GL_TRACE(glTextureParameteri, name, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels - 1));
+        GL_TRACE(glTextureParameteri, name, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        GL_TRACE(glTextureParameteri, name, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+
+        return name;
+    }
+
+    void copy_compressed_texture(uint dst_name, uint src_name, uint w, uint h, uint levels) {
+        copy_compressed_texture_levels(dst_name, 0, src_name, 0, w, h, levels);
+    }
+
+    void upload_compressed_level(uint name, uint level, uint w, uint h, util::dxt_format format, const void* data) {
+        GL_TRACE(glCompressedTextureSubImage2D,
+                 name,
+                 static_cast<GLint>(level),
+                 0,
+                 0,
+                 static_cast<GLsizei>(w),
+                 static_cast<GLsizei>(h),
+                 compressed_internal_format(format),
+                 static_cast<GLsizei>(util::dxt_data_size(format, {w, h})),
+                 data);
+    }
+
+    void copy_compressed_texture_levels(
+        uint dst_name, uint dst_level, uint src_name, uint src_level, uint w, uint h, uint levels) {
+        for (uint i = 0; i < levels; ++i) {
+            auto size = grx_compressed_color_map::level_size({w, h}, i);
+            GL_TRACE(glCopyImageSubData,
+                     src_name,
+                     GL_TEXTURE_2D,
+                     static_cast<GLint>(src_level + i),
+                     0,
+                     0,
+                     0,
+                     dst_name,
+                     GL_TEXTURE_2D,
+                     static_cast<GLint>(dst_level + i),
+                     0,
+                     0,
+                     0,
+                     static_cast<GLsizei>(size.x()),
+                     static_cast<GLsizei>(size.y()),
+                     1);
+        }
+    }
+
+    void get_compressed_texture(void* dst, uint src_name, uint w, uint h, util::dxt_format format, uint levels) {
+        for (uint i = 0; i < levels; ++i) {
+            auto data_size = util::dxt_data_size(format, grx_compressed_color_map::level_size({w, h}, i));
+            GL_TRACE(glGetCompressedTextureImage, src_name, static_cast<GLint>(i), static_cast<GLsizei>(data_size), dst);
+            dst = static_cast<char*>(dst) + data_size;
+        }
+    }
+
     void get_texture(void* dst, uint src_name, uint x, uint y, uint channels, bool is_float) {
         GLenum format = format_from_channels(channels);
         GLenum type   = is_float ? GL_FLOAT : GL_UNSIGNED_BYTE;
@@ -36,6 +36,15 @@ namespace grx
 
         void copy_texture(uint dst_name, uint src_name, uint w, uint h);
 
+        bool compressed_textures_supported(util::dxt_format format);
+        uint create_compressed_texture(
+            uint w, uint h, util::dxt_format format, uint levels, const void* levels_data = nullptr);
+        void copy_compressed_texture(uint dst_name, uint src_name, uint w, uint h, uint levels);
+        void upload_compressed_level(uint name, uint level, uint w, uint h, util::dxt_format format, const void* data);
+        void copy_compressed_texture_levels(
+            uint dst_name, uint dst_level, uint src_name, uint src_level, uint w, uint h, uint levels);
+        void get_compressed_texture(void* dst, uint src_name, uint w, uint h, util::dxt_format format, uint levels);
+
         void get_texture(void* dst, uint src_name, uint x, uint y, uint channels, bool is_float);
 
         void bind_unit     (uint name, uint number);
@@ -126,9 +135,129 @@ namespace grx
             }
         }
 
+        /**
+         * @brief Constuct a texture from block compressed color map
+         *
+         * Blocks are uploaded as-is. If the video driver does not support the block format (S3TC or BPTC), the
+         * color map is decompressed with all levels
+         *
+         * @throw runtime_error if channels count of the compressed color map does not match S
+         *
+         * @param color_map - the block compressed color map
+         * @param top_level - the first uploaded level, the texture has the size of this level
+         */
+        grx_texture(const grx_compressed_color_map& color_map, core::u32 top_level = 0):
+            _size(color_map.size()) {
+            static_assert(std::is_same_v<T, uint8_t> && (S == 3 || S == 4),
+                          "Compressed texture must have uint8_t RGB or RGBA format");
+
+            if (color_map.channels_count() != S)
+                pe_throw std::runtime_error(core::format("Wrong channels count: compressed color map has {} "
+                                                         "channels, but texture require {} channels",
+                                                         color_map.channels_count(),
+                                                         S));
+
+            if (!grx_texture_helper::compressed_textures_supported(color_map.format())) {
+                LOG_WARNING("PERFORMANCE: block compressed textures are not supported, compressed color map with "
+                            "size {} will be decompressed",
+                            color_map.size());
+                *this = grx_texture(grx_color_map<T, S>::from_compressed(color_map));
+                return;
+            }
+
+            if (top_level >= color_map.levels_count())
+                pe_throw std::runtime_error(core::format(
+                    "Top level {} is out of {} levels of the compressed color map", top_level, color_map.levels_count()));
+
+            _compressed_format = color_map.format();
+            _levels_count      = color_map.levels_count() - top_level;
+            _top_level         = top_level;
+            _size              = grx_compressed_color_map::level_size(color_map.size(), top_level);
+            _gl_name           = grx_texture_helper::create_compressed_texture(
+                _size.x(), _size.y(), *_compressed_format, _levels_count);
+
+            /* Levels are uploaded separately, they may be views into the mapped file */
+            for (auto level = top_level; level < color_map.levels_count(); ++level) {
+                auto level_size = color_map.level_size(level);
+                grx_texture_helper::upload_compressed_level(_gl_name,
+                                                            level - top_level,
+                                                            level_size.x(),
+                                                            level_size.y(),
+                                                            *_compressed_format,
+                                                            color_map.level_data(level).data());
+            }
+        }
+
+        /**
+         * @brief Changes resident levels of the block compressed texture
+         *
+         * The texture is reallocated with levels [top_level, levels count) of the source. Levels which are already
+         * resident are copied in the video memory, other ones are uploaded from the source. The storage of
+         * compressed textures is immutable, so every change costs a new allocation and the copy of the levels which
+         * stay resident, and the raw id of the texture changes
+         *
+         * @throw runtime_error if the texture is not block compressed, the source does not match the texture
+         * or top_level is out of range
+         *
+         * @param source - the compressed color map this texture was created from
+         * @param top_level - the new top level
+         */
+        void stream_levels(const grx_compressed_color_map& source, core::u32 top_level) {
+            if (!_compressed_format || *_compressed_format != source.format() ||
+                source.levels_count() != _top_level + _levels_count)
+                pe_throw std::runtime_error("Texture levels can be streamed only from its compressed color map");
+            if (top_level >= source.levels_count())
+                pe_throw std::runtime_error(core::format(
+                    "Top level {} is out of {} levels of the compressed color map", top_level, source.levels_count()));
+
+            if (top_level == _top_level)
+                return;
+
+            auto size   = grx_compressed_color_map::level_size(source.size(), top_level);
+            auto levels = source.levels_count() - top_level;
+            auto name   = grx_texture_helper::create_compressed_texture(size.x(), size.y(), *_compressed_format, levels);
+
+            /* Levels above the resident ones are uploaded, others are copied */
+            auto first_copied = std::max(top_level, _top_level);
+            for (auto level = top_level; level < first_copied; ++level) {
+                auto level_size = grx_compressed_color_map::level_size(source.size(), level);
+                grx_texture_helper::upload_compressed_level(name,
+                                                            level - top_level,
+                                                            level_size.x(),
+                                                            level_size.y(),
+                                                            *_compressed_format,
+                                                            source.level_data(level).data());
+            }
+
+            auto copied_size = grx_compressed_color_map::level_size(source.size(), first_copied);
+            grx_texture_helper::copy_compressed_texture_levels(name,
+                                                               first_copied - top_level,
+                                                               _gl_name,
+                                                               first_copied - _top_level,
+                                                               copied_size.x(),
+                                                               copied_size.y(),
+                                                               source.levels_count() - first_copied);
+
+            grx_texture_helper::delete_texture(_gl_name);
+            _gl_name      = name;
+            _size         = size;
+            _levels_count = levels;
+            _top_level    = top_level;
+        }
+
         grx_texture& operator=(const grx_color_map<T, S>& color_map) {
             static_assert(std::is_same_v<T, uint8_t> || std::is_same_v<T, float>,
                           "T must be uint8_t or float only");
+
+            /* The storage of block compressed texture can't be reused */
+            if (_compressed_format) {
+                grx_texture_helper::delete_texture(_gl_name);
+                _gl_name           = no_name;
+                _compressed_format = core::nullopt;
+                _levels_count      = MIPMAPS_COUNT + 1;
+                _top_level         = 0;
+            }
+
             _size = color_map.size();
 
             constexpr size_t pixel_size = S * sizeof(T);
@@ -200,7 +329,19 @@ namespace grx
          *
          * @param texture - texture to be copied
          */
-        grx_texture(const grx_texture& texture): _size(texture._size) {
+        grx_texture(const grx_texture& texture):
+            _size(texture._size),
+            _compressed_format(texture._compressed_format),
+            _levels_count(texture._levels_count),
+            _top_level(texture._top_level) {
+            if (_compressed_format) {
+                _gl_name = grx_texture_helper::create_compressed_texture(
+                    _size.x(), _size.y(), *_compressed_format, _levels_count);
+                grx_texture_helper::copy_compressed_texture(
+                    _gl_name, texture._gl_name, _size.x(), _size.y(), _levels_count);
+                return;
+            }
+
             _gl_name = grx_texture_helper::create_texture(
                     _size.x(), _size.y(), static_cast<uint>(S), std::is_floating_point_v<T>);
 
@@ -216,6 +357,9 @@ namespace grx
          * @param texture - texture to be copied
          */
         grx_texture& operator= (const grx_texture& texture) {
+            if (_compressed_format || texture._compressed_format)
+                return *this = grx_texture(texture);
+
             _size = texture._size;
 
             if (_size != texture._size || _gl_name == no_name) {
@@ -241,7 +385,12 @@ namespace grx
          *
          * @param texture - texture to be moved
          */
-        grx_texture(grx_texture&& texture) noexcept : _gl_name(texture._gl_name), _size(texture._size) {
+        grx_texture(grx_texture&& texture) noexcept:
+            _gl_name(texture._gl_name),
+            _size(texture._size),
+            _compressed_format(texture._compressed_format),
+            _levels_count(texture._levels_count),
+            _top_level(texture._top_level) {
             texture._gl_name = no_name;
         }
 
@@ -256,8 +405,11 @@ namespace grx
             if (_gl_name == no_name)
                 grx_texture_helper::delete_texture(_gl_name);
 
-            _gl_name = texture._gl_name;
-            _size    = texture._size;
+            _gl_name           = texture._gl_name;
+            _size              = texture._size;
+            _compressed_format = texture._compressed_format;
+            _levels_count      = texture._levels_count;
+            _top_level         = texture._top_level;
 
             texture._gl_name = no_name;
 
@@ -366,6 +518,10 @@ namespace grx
          */
         [[nodiscard]]
         grx_color_map<T, S> to_color_map() const {
+            if constexpr (std::is_same_v<T, uint8_t> && (S == 3 || S == 4))
+                if (_compressed_format)
+                    return grx_color_map<T, S>::from_compressed(to_compressed_color_map());
+
             grx_color_map<T, S> result(_size, MIPMAPS_COUNT);
 
             grx_texture_helper::get_texture(
@@ -374,6 +530,55 @@ namespace grx
             return result;
         }
 
+        /**
+         * @brief Load blocks of the compressed texture from video memory
+         *
+         * @throw runtime_error if the texture is not block compressed
+         *
+         * @return compressed color map with all levels of the texture
+         */
+        [[nodiscard]]
+        grx_compressed_color_map to_compressed_color_map() const {
+            if (!_compressed_format)
+                pe_throw std::runtime_error("Texture is not block compressed");
+
+            core::vector<core::byte> data;
+            for (core::u32 i = 0; i < _levels_count; ++i)
+                data.resize(data.size() +
+                            util::dxt_data_size(*_compressed_format, grx_compressed_color_map::level_size(_size, i)));
+
+            grx_texture_helper::get_compressed_texture(
+                data.data(), _gl_name, _size.x(), _size.y(), *_compressed_format, _levels_count);
+
+            return {*_compressed_format, _size, _levels_count, core::move(data)};
+        }
+
+        /**
+         * @brief Gets the block compression format of the texture
+         *
+         * @return the format or nullopt if the texture is not block compressed
+         */
+        [[nodiscard]]
+        const core::optional<util::dxt_format>& compressed_format() const {
+            return _compressed_format;
+        }
+
+        /**
+         * @brief Gets the count of levels in the video memory
+         */
+        [[nodiscard]]
+        core::u32 levels_count() const {
+            return _levels_count;
+        }
+
+        /**
+         * @brief Gets the level of the source compressed color map which is the largest level of the texture
+         */
+        [[nodiscard]]
+        core::u32 top_level() const {
+            return _top_level;
+        }
+
         /**
          * @brief Gets OpenGl texture id
          *
@@ -395,8 +600,11 @@ namespace grx
         }
 
     private:
-        uint        _gl_name = no_name;
-        core::vec2u _size;
+        uint                             _gl_name = no_name;
+        core::vec2u                      _size;
+        core::optional<util::dxt_format> _compressed_format;
+        core::u32                        _levels_count = MIPMAPS_COUNT + 1;
+        core::u32                        _top_level    = 0;
     };
 
 
@@ -0,0 +1,341 @@
+#pragma once
+
+#include <algorithm>
+#include <core/md5.hpp>
+#include <util/atlas_packer.hpp>
+#include "grx_color_map.hpp"
+#include "grx_cpu_mesh_group.hpp"
+#include "grx_texture_path_set.hpp"
+
+namespace grx
+{
+/**
+ * @brief Region of the atlas page which replaces textures of the source material
+ */
+struct grx_atlas_region {
+    PE_SERIALIZE(source_material, page_material, uv_offset, uv_scale)
+
+    uint  source_material = 0;
+    uint  page_material   = 0;
+    vec2f uv_offset       = {0.f, 0.f};
+    vec2f uv_scale        = {1.f, 1.f};
+
+    /**
+     * @brief Maps texture coordinates of the source material into the page
+     */
+    [[nodiscard]]
+    vec2f map(const vec2f& uv) const {
+        return uv_offset + uv * uv_scale;
+    }
+};
+
+struct grx_atlas_settings {
+    util::atlas_settings packing;
+
+    /* Textures larger than this in any dimension keep their own GL textures */
+    core::u32 max_texture_size = 256; // NOLINT
+
+    /* Texture coordinates of atlased elements must be in [-uv_epsilon, 1 + uv_epsilon], wrapped textures can't be
+     * atlased */
+    float uv_epsilon = 1e-3f; // NOLINT
+
+    /**
+     * @brief Describes settings for the baked asset cache key
+     */
+    [[nodiscard]]
+    core::string signature() const {
+        return core::format("atlas:{}:{}:{}:{}:{}",
+                            packing.page_size,
+                            packing.padding,
+                            packing.mip_safe_levels,
+                            max_texture_size,
+                            uv_epsilon);
+    }
+};
+
+/**
+ * @brief Page of the texture atlas
+ *
+ * @tparam T - the type of the color channel value
+ * @tparam NPP - channels count
+ */
+template <ColorComponent T, size_t NPP>
+struct grx_atlas_page {
+    static constexpr auto tags_count = static_cast<size_t>(grx_texture_set_tag::grx_texture_set_tag_count);
+
+    uint                                                           material = 0; /* The material which uses the page */
+    core::array<core::optional<grx_color_map<T, NPP>>, tags_count> maps;
+};
+
+/**
+ * @brief Texture which was moved into atlas pages
+ *
+ * Baked meshes are keyed by the model file, so the contents of source textures are stored with the pages to detect
+ * stale bakes
+ */
+struct grx_atlas_source {
+    PE_SERIALIZE(path, content_hash.lo, content_hash.hi)
+
+    core::cfg_path path;
+    core::md5_hash content_hash;
+};
+
+template <ColorComponent T, size_t NPP>
+struct grx_atlas_bake_result {
+    core::vector<grx_atlas_region>       regions;
+    core::vector<grx_atlas_page<T, NPP>> pages;
+    core::vector<core::resource_path_t>  sources; /* Textures of atlased materials, each one is listed once */
+};
+
+/**
+ * @brief Copies the image into the page and extrudes its edge texels into the gutter
+ *
+ * @param image - the image
+ * @param page - the page
+ * @param pos - the position of the image in the page
+ * @param gutter - the gutter width
+ */
+template <ColorComponent T, size_t NPP>
+void grx_atlas_blit(const grx_color_map<T, NPP>& image, grx_color_map<T, NPP>& page, vec2u pos, core::u32 gutter) {
+    auto size = image.size();
+    if (size.x() == 0 || size.y() == 0)
+        return;
+
+    PeRelRequireF(pos.x() >= gutter && pos.y() >= gutter && pos.x() + size.x() + gutter <= page.size().x() &&
+                      pos.y() + size.y() + gutter <= page.size().y(),
+                  "Image {} at {} with the gutter {} is out of the page {}",
+                  size,
+                  pos,
+                  gutter,
+                  page.size());
+
+    for (core::u32 y = 0; y < size.y() + 2 * gutter; ++y) {
+        auto src_y = std::clamp<core::i64>(core::i64(y) - gutter, 0, core::i64(size.y()) - 1);
+        auto src   = image.data() + size_t(src_y) * size.x() * NPP;
+        auto dst   = page.data() + (size_t(pos.y() - gutter + y) * page.size().x() + pos.x() - gutter) * NPP;
+
+        for (core::u32 x = 0; x < gutter; ++x)
+            std::memcpy(dst + size_t(x) * NPP, src, NPP * sizeof(T));
+
+        std::memcpy(dst + size_t(gutter) * NPP, src, size_t(size.x()) * NPP * sizeof(T));
+
+        auto last = src + size_t(size.x() - 1) * NPP;
+        for (core::u32 x = 0; x < gutter; ++x)
+            std::memcpy(dst + size_t(gutter + size.x() + x) * NPP, last, NPP * sizeof(T));
+    }
+}
+
+/**
+ * @brief Composes atlas pages from images and generates their mipmaps
+ *
+ * @param images - images in the order of the layout placements
+ * @param layout - the layout from util::atlas_pack()
+ *
+ * @return pages
+ */
+template <ColorComponent T, size_t NPP>
+core::vector<grx_color_map<T, NPP>> grx_atlas_compose(core::span<const grx_color_map<T, NPP>* const> images,
+                                                      const util::atlas_layout&                       layout) {
+    PeRelRequireF(static_cast<size_t>(images.size()) == layout.placements.size(),
+                  "Images count {} differs with placements count {}",
+                  images.size(),
+                  layout.placements.size());
+
+    core::vector<grx_color_map<T, NPP>> pages;
+    for (auto& size : layout.pages)
+        pages.emplace_back(size);
+
+    for (size_t i = 0; i < layout.placements.size(); ++i) {
+        auto& p = layout.placements[i];
+        grx_atlas_blit(*images[static_cast<ssize_t>(i)], pages[p.page], p.pos, layout.gutter);
+    }
+
+    for (auto& page : pages)
+        page.gen_mipmaps();
+
+    return pages;
+}
+
+/**
+ * @brief Groups small textures of materials into atlas pages
+ *
+ * Every material whose textures have the same size not greater than max_texture_size and whose elements have
+ * texture coordinates in [0, 1] is a candidate. Candidates with the same set of texture tags are packed together,
+ * textures of every tag get their own pages with the same layout. Materials with identical texture paths share one
+ * region. Groups with less than two regions are left as is.
+ *
+ * Texture coordinates of atlased elements are remapped into regions and elements are switched to materials of pages.
+ * Texture path sets of atlased materials are cleared and empty sets are appended for page materials, the caller
+ * saves pages and fills them with paths
+ *
+ * @param mesh - the mesh group
+ * @param texture_path_sets - texture paths of materials
+ * @param load_texture - callable (const core::resource_path_t&) -> core::optional<grx_color_map<T, NPP>>
+ * @param settings - the atlas settings
+ *
+ * @return regions of atlased materials and pages
+ */
+template <ColorComponent T, size_t NPP, MeshBufT... Ts, typename F>
+grx_atlas_bake_result<T, NPP> grx_atlas_bake(grx_cpu_mesh_group<Ts...>&          mesh,
+                                             core::vector<grx_texture_path_set>& texture_path_sets,
+                                             F&&                                 load_texture,
+                                             const grx_atlas_settings&           settings = {}) {
+    using map_t = grx_color_map<T, NPP>;
+    constexpr auto tags_count = grx_atlas_page<T, NPP>::tags_count;
+
+    grx_atlas_bake_result<T, NPP> result;
+
+    if constexpr (grx_cpu_mesh_group<Ts...>::has_uv_buf()) {
+        auto materials_count = static_cast<uint>(texture_path_sets.size());
+
+        /* Elements of materials, materials with wrapped coordinates are not candidates */
+        core::vector<core::vector<uint>> material_elements(materials_count);
+        core::vector<bool>               wrapped(materials_count, false);
+
+        for (uint i = 0; i < mesh.elements_count(); ++i) {
+            auto material = mesh.elements()[i].material_index;
+            if (material >= materials_count)
+                continue;
+
+            material_elements[material].push_back(i);
+
+            auto [min, max] = mesh.uv_bounds(i);
+            if (min.x() < -settings.uv_epsilon || min.y() < -settings.uv_epsilon ||
+                max.x() > 1.f + settings.uv_epsilon || max.y() > 1.f + settings.uv_epsilon)
+                wrapped[material] = true;
+        }
+
+        /* Values of the hash map are moved on rehash, candidates keep pointers to loaded textures */
+        core::hash_map<core::string, core::shared_ptr<const map_t>> loaded;
+        auto load = [&](const core::resource_path_t& path) -> const map_t* {
+            auto key = path.path.dir_key + ":" + path.path.path;
+            auto pos = loaded.find(key);
+            if (pos == loaded.end()) {
+                core::shared_ptr<const map_t> map;
+                if (auto texture = load_texture(path))
+                    map = core::make_shared<const map_t>(core::move(*texture));
+                pos = loaded.emplace(key, core::move(map)).first;
+            }
+            return pos->second.get();
+        };
+
+        struct candidate_t {
+            core::vector<uint>                    materials;
+            core::array<const map_t*, tags_count> maps = {};
+            vec2u                                 size;
+        };
+
+        /* Candidates are grouped by the mask of tags, the key of the candidate is texture paths of the material */
+        core::hash_map<core::u32, core::vector<candidate_t>> groups;
+        core::hash_map<core::string, size_t>                 candidates;
+
+        for (uint material = 0; material < materials_count; ++material) {
+            if (material_elements[material].empty() || wrapped[material])
+                continue;
+
+            core::u32                             mask = 0;
+            core::string                          key;
+            core::array<const map_t*, tags_count> maps = {};
+            core::optional<vec2u>                 size;
+            bool                                  compatible = true;
+
+            for (size_t tag = 0; tag < tags_count && compatible; ++tag) {
+                auto& path = texture_path_sets[material].options()[tag];
+                if (!path)
+                    continue;
+
+                maps[tag]  = load(*path);
+                compatible = maps[tag] && maps[tag]->size().x() <= settings.max_texture_size &&
+                             maps[tag]->size().y() <= settings.max_texture_size &&
+                             (!size || *size == maps[tag]->size());
+
+                if (compatible) {
+                    size = maps[tag]->size();
+                    mask |= 1U << tag;
+                    key += path->path.dir_key + ":" + path->path.path + "|";
+                }
+            }
+
+            if (!compatible || mask == 0)
+                continue;
+
+            auto& group          = groups[mask];
+            auto [pos, inserted] = candidates.emplace(key, group.size());
+            if (inserted)
+                group.push_back(candidate_t{{}, maps, *size});
+
+            group[pos->second].materials.push_back(material);
+        }
+
+        /* Hash map iteration order is not stable, keep baked results reproducible */
+        core::vector<core::u32> masks;
+        for (auto& [mask, _] : groups)
+            masks.push_back(mask);
+        std::sort(masks.begin(), masks.end());
+
+        core::hash_set<core::string> sources;
+
+        for (auto mask : masks) {
+            auto& group = groups[mask];
+            if (group.size() < 2)
+                continue;
+
+            core::vector<vec2u> sizes;
+            for (auto& c : group)
+                sizes.push_back(c.size);
+
+            auto layout     = util::atlas_pack(sizes, settings.packing);
+            auto first_page = result.pages.size();
+
+            for (size_t i = 0; i < layout.pages.size(); ++i) {
+                result.pages.emplace_back().material = static_cast<uint>(texture_path_sets.size());
+                texture_path_sets.emplace_back();
+            }
+
+            for (size_t tag = 0; tag < tags_count; ++tag) {
+                if (!(mask & (1U << tag)))
+                    continue;
+
+                core::vector<const map_t*> images;
+                for (auto& c : group)
+                    images.push_back(c.maps[tag]);
+
+                auto pages = grx_atlas_compose<T, NPP>(images, layout);
+                for (size_t i = 0; i < pages.size(); ++i)
+                    result.pages[first_page + i].maps[tag] = core::move(pages[i]);
+            }
+
+            for (size_t i = 0; i < group.size(); ++i) {
+                auto& p         = layout.placements[i];
+                auto  page_size = static_cast<vec2f>(layout.pages[p.page]);
+                auto  region    = grx_atlas_region{0,
+                                                 result.pages[first_page + p.page].material,
+                                                 static_cast<vec2f>(p.pos) / page_size,
+                                                 static_cast<vec2f>(p.size) / page_size};
+
+                for (auto material : group[i].materials) {
+                    region.source_material = material;
+                    result.regions.push_back(region);
+
+                    for (auto element : material_elements[material]) {
+                        mesh.transform_uvs(element, region.uv_offset, region.uv_scale);
+                        mesh.material_index(element, region.page_material);
+                    }
+
+                    for (auto& path : texture_path_sets[material].options())
+                        if (path && sources.emplace(path->path.dir_key + ":" + path->path.path).second)
+                            result.sources.push_back(*path);
+
+                    texture_path_sets[material] = grx_texture_path_set{};
+                }
+            }
+        }
+
+        std::sort(result.regions.begin(), result.regions.end(), [](auto& a, auto& b) {
+            return a.source_material < b.source_material;
+        });
+    }
+
+    return result;
+}
+} // namespace grx
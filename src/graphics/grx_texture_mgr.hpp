@@ -2,6 +2,7 @@
 
 #include "graphics/grx_types.hpp"
 #include "grx_texture.hpp"
+#include "grx_texture_residency.hpp"
 
 #include <core/serialization.hpp>
 #include <core/config_manager.hpp>
@@ -28,28 +29,44 @@ public:
         super_t(core::move(mgr), file_path, load_significance) {}
 
     grx_texture_provider(const grx_texture_provider& resource):
-        super_t(resource), _cached_id(resource._cached_id) {}
+        super_t(resource), _cached_id(resource._cached_id), _cached_generation(resource._cached_generation) {}
 
     grx_texture_provider& operator=(const grx_texture_provider& resource) {
         super_t::operator=(resource);
-        _cached_id = resource._cached_id;
+        _cached_id         = resource._cached_id;
+        _cached_generation = resource._cached_generation;
 
         return *this;
     }
 
     grx_texture_provider(grx_texture_provider&& resource) noexcept:
-        super_t(core::move(resource)), _cached_id(resource._cached_id) {
+        super_t(core::move(resource)),
+        _cached_id(resource._cached_id),
+        _cached_generation(resource._cached_generation) {
         resource._cached_id = core::numlim<uint>::max();
     }
 
     grx_texture_provider& operator=(grx_texture_provider&& resource) noexcept {
         super_t::operator=(core::move(resource));
-        _cached_id = resource._cached_id;
+        _cached_id         = resource._cached_id;
+        _cached_generation = resource._cached_generation;
 
         resource._cached_id = core::numlim<uint>::max();
 
         return *this;
     }
+
+    /**
+     * @brief Reports the size of the texture on the screen
+     *
+     * Streamed textures load levels which are enough for the largest reported size. Does nothing if the texture
+     * is not streamed
+     *
+     * @param screen_size - the size of the texture on the screen in pixels
+     */
+    void request_screen_size(const core::vec2f& screen_size) const {
+        this->_storage->request_screen_size(this->_resource_id, screen_size);
+    }
     /**
      * @brief Bind texture. Equivalent of glBindTexture
      */
@@ -84,37 +101,308 @@ public:
         grx_texture_helper::bind_unit(_cached_id, number);
     }
 private:
+    /* Streamed textures are reallocated when their levels change, the generation of the manager tells it.
+     * The manager which holds the texture is resolved once with the raw id, it doesn't change while
+     * the provider uses the texture, so a bind only compares the cached generation */
     void wait_for_id() const {
-        if (_cached_id == core::numlim<uint>::max())
-            _cached_id = this->_storage->access(this->_resource_id).raw_id();
+        if (_cached_id == core::numlim<uint>::max() || _cached_generation != *_generation) {
+            _cached_id         = this->_storage->access(this->_resource_id).raw_id();
+            _generation        = &this->_storage->streaming_generation(this->_resource_id);
+            _cached_generation = *_generation;
+        }
     }
 
-    uint _cached_id = core::numlim<uint>::max();
+    mutable uint             _cached_id         = core::numlim<uint>::max();
+    mutable core::u64        _cached_generation = 0;
+    mutable const core::u64* _generation        = nullptr;
 };
 
 
+/**
+ * @brief The cached form of the texture
+ *
+ * Block compressed textures are cached compressed, they are 4-8 times smaller than decompressed color maps
+ */
 template <ColorComponent T, size_t S>
-class grx_texture_mgr : public core::resource_mgr_base<grx_color_map<T, S>,
+using grx_texture_cache = core::variant<grx_color_map<T, S>, grx_compressed_color_map>;
+
+
+template <ColorComponent T, size_t S>
+class grx_texture_mgr : public core::resource_mgr_base<grx_texture_cache<T, S>,
                                                        grx_texture<T, S>,
                                                        grx_texture_mgr<T, S>,
                                                        grx_texture_provider<T, S>> {
 public:
-    using core::resource_mgr_base<grx_color_map<T, S>,
-                                  grx_texture<T, S>,
-                                  grx_texture_mgr<T, S>,
-                                  grx_texture_provider<T, S>>::resource_mgr_base;
+    using super_t = core::resource_mgr_base<grx_texture_cache<T, S>,
+                                            grx_texture<T, S>,
+                                            grx_texture_mgr<T, S>,
+                                            grx_texture_provider<T, S>>;
+
+    using super_t::super_t;
+    using typename super_t::resource_id_t;
+
+    static constexpr bool supports_compression = std::is_same_v<T, core::u8> && (S == 3 || S == 4);
+
+    /**
+     * @brief Enables progressive streaming of block compressed textures
+     *
+     * Textures loaded after this call are created with the mip tail only (levels not larger than tail_size),
+     * so they are ready for the first frame. Higher levels are uploaded by update_streaming() within the budgets
+     * of settings, levels which are not needed anymore are dropped under memory pressure
+     *
+     * @param settings - the memory and upload budgets
+     * @param tail_size - the maximal size of levels which are uploaded on load
+     */
+    void enable_streaming(const grx_texture_residency::settings_t& settings = {}, core::u32 tail_size = 128) { // NOLINT
+        if (_residency)
+            _residency->settings(settings);
+        else
+            _residency = grx_texture_residency(settings);
+        _tail_size = tail_size;
+    }
+
+    /**
+     * @brief Uploads and drops levels of streamed textures
+     *
+     * Must be called in the render thread once per frame. Every texture of the plan is reallocated and its resident
+     * levels are copied in the video memory (see grx_texture::stream_levels). Plans have at most one drop or load
+     * per texture and loads are limited by the upload budget, so the copies are bounded by the budget and the
+     * resident levels of the loaded textures
+     */
+    void update_streaming() {
+        if (!_residency)
+            return;
+
+        auto plan = _residency->update();
+
+        for (auto& drop : plan.drops)
+            stream_levels(drop.id, drop.level);
+
+        for (auto& load : plan.loads) {
+            stream_levels(load.id, load.level);
+            _residency->level_loaded(load.id, load.level);
+        }
+
+        if (!plan.drops.empty() || !plan.loads.empty())
+            ++_streaming_generation;
+    }
+
+    /**
+     * @brief Requests levels of the streamed texture which are enough for the screen size
+     *
+     * The largest size reported between updates wins. Does nothing if the texture is not streamed
+     *
+     * @param id - the resource id
+     * @param screen_size - the size of the texture on the screen in pixels
+     */
+    void request_screen_size(resource_id_t id, const core::vec2f& screen_size) {
+        if (auto [owner, owner_id] = this->content_owner(id); owner != this)
+            return owner->request_screen_size(owner_id, screen_size);
+
+        auto source = _stream_sources.find(id);
+        if (source == _stream_sources.end())
+            return;
+
+        _residency->request_level(id, grx_texture_residency::level_for_screen_size(source->second.size(), screen_size));
+    }
+
+    /**
+     * @brief Gets the counter of streaming updates which reallocated textures, cached raw ids are invalid when it
+     * changes
+     *
+     * The counter is shared by all streamed textures of the manager
+     */
+    [[nodiscard]]
+    core::u64 streaming_generation() const {
+        return _streaming_generation;
+    }
+
+    /**
+     * @brief Gets the streaming generation of the manager which actually holds the texture
+     *
+     * Textures shared by the content deduplication are streamed by the manager which loaded them.
+     * The reference stays valid while the texture is used
+     *
+     * @param id - the resource id
+     */
+    [[nodiscard]]
+    const core::u64& streaming_generation(resource_id_t id) {
+        return this->content_owner(id).first->_streaming_generation;
+    }
+
+    /**
+     * @brief Gets residency of streamed textures
+     *
+     * @return the residency or nullptr if the streaming is disabled
+     */
+    [[nodiscard]]
+    const grx_texture_residency* streaming_residency() const {
+        return _residency ? &*_residency : nullptr;
+    }
+
+    grx_texture<T, S> make_resource(resource_id_t id, grx_texture_cache<T, S>&& cache) {
+        if constexpr (supports_compression) {
+            auto compressed = std::get_if<grx_compressed_color_map>(&cache);
+            if (_residency && compressed && grx_texture_helper::compressed_textures_supported(compressed->format())) {
+                auto levels = compressed->levels_count();
+                auto tail   = grx_texture_residency::mip_tail_level(compressed->size(), levels, _tail_size);
+
+                if (tail > 0) {
+                    core::vector<core::u64> level_bytes;
+                    for (core::u32 i = 0; i < levels; ++i)
+                        level_bytes.push_back(core::u64(compressed->level_data(i).size()));
+
+                    auto texture = grx_texture<T, S>(*compressed, tail);
+                    _residency->add(id, core::move(level_bytes), tail);
+                    _stream_sources.insert_or_assign(id, core::move(*compressed));
+
+                    DLOG("resource_mgr[{}]: texture {} streamed from level {}", this->mgr_tag(), id, tail);
+                    return texture;
+                }
+            }
+        }
+
+        return from_cache(core::move(cache));
+    }
+
+    /* The source of the streamed texture is cached instead of its resident levels */
+    grx_texture_cache<T, S> make_cache(resource_id_t id, grx_texture<T, S>&& texture) {
+        if (auto source = _stream_sources.find(id); source != _stream_sources.end()) {
+            auto result = grx_texture_cache<T, S>(core::move(source->second));
+            release_resource(id);
+            return result;
+        }
+
+        return to_cache(core::move(texture));
+    }
+
+    void release_resource(resource_id_t id) {
+        if (_stream_sources.erase(id))
+            _residency->remove(id);
+    }
 
     auto load_async_cached(const core::cfg_path& path) {
         DLOG("resource_mgr[{}]: async load texture {}", this->mgr_tag(), path);
-        return load_color_map_async<core::vec<core::u8, S>>(path.absolute());
+        return core::submit_job(load_cache, path.absolute());
+    }
+
+    /* The source was mapped by the content deduplication */
+    auto load_async_cached(const core::cfg_path& path, util::asset_data file) {
+        DLOG("resource_mgr[{}]: async load texture {}", this->mgr_tag(), path);
+        return core::submit_job(load_cache_mapped, core::move(file));
+    }
+
+    /**
+     * @brief Loads the texture to the cached form
+     *
+     * @throw runtime_error if the image can't be loaded
+     *
+     * @param file_path - a path to the image file
+     *
+     * @return the cached texture
+     */
+    static grx_texture_cache<T, S> load_cache(const core::string& file_path) {
+        auto file = util::try_map_asset(file_path);
+        if (!file)
+            pe_throw std::runtime_error("Can't open file \"" + file_path + "\"");
+
+        return load_cache_mapped(core::move(*file));
     }
 
-    static grx_color_map<T, S> to_cache(grx_texture<T, S> texture) {
+    /**
+     * @brief Loads the texture to the cached form from the mapped file
+     *
+     * Blocks of compressed .petx and DXT vtf files are kept as-is if the channels count matches,
+     * other images are loaded as color maps. Uncompressed levels of .petx v2 files stay in the mapping until they
+     * are uploaded
+     *
+     * @throw runtime_error if the image can't be loaded
+     *
+     * @param file - the mapped image file
+     *
+     * @return the cached texture
+     */
+    static grx_texture_cache<T, S> load_cache_mapped(util::asset_data file) {
+        auto bytes = file.bytes();
+        if constexpr (supports_compression) {
+            if (grx_compressed_color_map::is_compressed_petx(bytes)) {
+                auto compressed = grx_compressed_color_map::from_asset(core::move(file));
+                if (compressed.channels_count() == S)
+                    return compressed;
+
+                /* Throws the channels count error */
+                return grx_color_map<T, S>::from_compressed(compressed);
+            }
+            else if (auto vtf = util::vtf_view(bytes); vtf.is_valid() && vtf.high_res_dxt_format() &&
+                                                       vtf.high_res_channels_count() == S) {
+                return grx_compressed_color_map::from_vtf(vtf);
+            }
+        }
+
+        return try_load_color_map_from_bytes<core::vec<T, S>>(bytes).value();
+    }
+
+    /**
+     * @brief Maps source bytes of the texture for the content deduplication
+     *
+     * @param file_path - a path to the image file
+     *
+     * @return the asset data or nullopt if the file can't be found
+     */
+    static core::optional<util::asset_data> map_content(const core::string& file_path) {
+        return util::try_map_asset(file_path);
+    }
+
+    static grx_texture_cache<T, S> to_cache(grx_texture<T, S> texture) {
+        if constexpr (supports_compression)
+            if (texture.compressed_format())
+                return texture.to_compressed_color_map();
+
         return texture.to_color_map();
     }
 
-    static grx_texture<T, S> from_cache(grx_color_map<T, S>&& color_map) {
-        return grx_texture(color_map);
+    static grx_texture<T, S> from_cache(grx_texture_cache<T, S>&& cache) {
+        if constexpr (supports_compression)
+            if (auto compressed = std::get_if<grx_compressed_color_map>(&cache))
+                return grx_texture<T, S>(*compressed);
+
+        return grx_texture<T, S>(std::get<grx_color_map<T, S>>(cache));
     }
+
+    static core::u64 cached_size(const grx_texture_cache<T, S>& cache) {
+        if (auto compressed = std::get_if<grx_compressed_color_map>(&cache))
+            return compressed->byte_size();
+
+        return std::get<grx_color_map<T, S>>(cache).components_count() * sizeof(T);
+    }
+
+    static core::u64 resource_size(const grx_texture<T, S>& texture) {
+        auto& size = texture.size();
+
+        if (auto& format = texture.compressed_format()) {
+            core::u64 result = 0;
+            for (core::u32 i = 0; i < texture.levels_count(); ++i)
+                result += util::dxt_data_size(*format, grx_compressed_color_map::level_size(size, i));
+            return result;
+        }
+
+        /* Base level with the full mipmap chain */
+        return core::u64(size.x()) * size.y() * S * sizeof(T) * 4 / 3;
+    }
+
+private:
+    void stream_levels(resource_id_t id, core::u32 level) {
+        auto source  = _stream_sources.find(id);
+        auto texture = this->try_access(id);
+        PeAssert(source != _stream_sources.end() && texture);
+
+        texture->stream_levels(source->second, level);
+    }
+
+private:
+    core::optional<grx_texture_residency>                   _residency;
+    core::hash_map<resource_id_t, grx_compressed_color_map> _stream_sources;
+    core::u32                                               _tail_size            = 128; // NOLINT
+    core::u64                                               _streaming_generation = 0;
 };
 } // namespace grx
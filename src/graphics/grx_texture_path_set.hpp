@@ -27,6 +27,11 @@ public:
         core::deserialize(this->options(), d);
     }
 
+    [[nodiscard]]
+    size_t serialized_size() const {
+        return core::serialized_size(this->options());
+    }
+
     static grx_texture_path_set
     from_assimp(const core::string&       path_dir_key,
                 const core::string&       path_prefix,
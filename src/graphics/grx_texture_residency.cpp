@@ -0,0 +1,222 @@
+#include "grx_texture_residency.hpp"
+
+#include <core/print.hpp>
+#include <cmath>
+
+namespace grx
+{
+using namespace core;
+
+u32 grx_texture_residency::mip_tail_level(vec2u size, u32 levels_count, u32 tail_size) {
+    for (u32 i = 0; i < levels_count; ++i) {
+        auto w = std::max(size.x() >> i, 1U);
+        auto h = std::max(size.y() >> i, 1U);
+        if (std::max(w, h) <= tail_size)
+            return i;
+    }
+    return levels_count ? levels_count - 1 : 0;
+}
+
+u32 grx_texture_residency::level_for_screen_size(vec2u size, vec2f screen_size) {
+    if (screen_size.x() <= 0.f || screen_size.y() <= 0.f)
+        return numlim<u32>::max();
+
+    auto ratio = std::min(float(size.x()) / screen_size.x(), float(size.y()) / screen_size.y());
+    if (ratio <= 1.f)
+        return 0;
+
+    return u32(std::floor(std::log2(ratio)));
+}
+
+void grx_texture_residency::add(texture_id id, vector<u64> level_bytes, u32 min_level) {
+    if (_textures.contains(id))
+        pe_throw std::runtime_error(format("grx_texture_residency: texture {} is already tracked", id));
+    if (min_level >= level_bytes.size())
+        pe_throw std::runtime_error(format(
+            "grx_texture_residency: min level {} is out of {} levels of texture {}", min_level, level_bytes.size(), id));
+
+    for (auto i = min_level; i < level_bytes.size(); ++i)
+        _resident_bytes += level_bytes[i];
+
+    auto& texture       = _textures[id];
+    texture.level_bytes = move(level_bytes);
+    texture.min_level   = min_level;
+    texture.resident    = min_level;
+    texture.last_used   = _tick;
+}
+
+void grx_texture_residency::remove(texture_id id) {
+    auto found = _textures.find(id);
+    if (found == _textures.end())
+        return;
+
+    auto& texture = found->second;
+    for (auto i = texture.resident; i < texture.level_bytes.size(); ++i)
+        _resident_bytes -= texture.level_bytes[i];
+    if (texture.loading)
+        _pending_bytes -= texture.level_bytes[*texture.loading];
+
+    _textures.erase(found);
+}
+
+void grx_texture_residency::request_level(texture_id id, u32 level) {
+    auto& texture = get(id);
+    level         = std::min(level, u32(texture.level_bytes.size()) - 1);
+
+    /* The largest level requested between updates wins */
+    texture.desired      = texture.request_tick == _tick ? std::min(texture.desired, level) : level;
+    texture.request_tick = _tick;
+    texture.last_used    = _tick;
+}
+
+grx_texture_residency::plan_t grx_texture_residency::update() {
+    plan_t plan;
+
+    /* The budget may be lowered, textures which are not used now give their levels back */
+    make_room(0, _tick, {}, plan, true);
+
+    vector<pair<texture_id, texture_t*>> candidates;
+    for (auto& [id, texture] : _textures)
+        if (!texture.loading && texture.resident > texture.desired)
+            candidates.emplace_back(id, &texture);
+
+    std::sort(candidates.begin(), candidates.end(), [](auto& lhs, auto& rhs) {
+        auto lgap = lhs.second->resident - lhs.second->desired;
+        auto rgap = rhs.second->resident - rhs.second->desired;
+        if (lgap != rgap)
+            return lgap > rgap;
+        if (lhs.second->last_used != rhs.second->last_used)
+            return lhs.second->last_used > rhs.second->last_used;
+        return lhs.first < rhs.first;
+    });
+
+    auto                 upload_left = _settings.upload_budget;
+    hash_set<texture_id> loaders;
+
+    for (auto& [id, texture] : candidates) {
+        /* Levels of the texture were dropped for another one */
+        if (std::any_of(plan.drops.begin(), plan.drops.end(), [id = id](auto& drop) { return drop.id == id; }))
+            continue;
+
+        auto level = texture->resident - 1;
+        auto bytes = texture->level_bytes[level];
+        if (!plan.loads.empty() && bytes > upload_left)
+            break;
+
+        loaders.insert(id);
+        if (!make_room(bytes, texture->last_used, loaders, plan, false)) {
+            loaders.erase(id);
+            continue;
+        }
+
+        texture->loading = level;
+        _pending_bytes += bytes;
+        upload_left -= std::min(bytes, upload_left);
+        plan.loads.push_back({id, level});
+    }
+
+    ++_tick;
+    return plan;
+}
+
+void grx_texture_residency::level_loaded(texture_id id, u32 level) {
+    auto found = _textures.find(id);
+    if (found == _textures.end())
+        return;
+
+    auto& texture = found->second;
+    if (texture.loading != level)
+        pe_throw std::runtime_error(format("grx_texture_residency: level {} of texture {} was not requested", level, id));
+
+    texture.loading.reset();
+    _pending_bytes -= texture.level_bytes[level];
+    _resident_bytes += texture.level_bytes[level];
+    texture.resident = level;
+}
+
+const grx_texture_residency::texture_t& grx_texture_residency::get(texture_id id) const {
+    auto found = _textures.find(id);
+    if (found == _textures.end())
+        pe_throw std::runtime_error(format("grx_texture_residency: texture {} is not tracked", id));
+    return found->second;
+}
+
+grx_texture_residency::texture_t& grx_texture_residency::get(texture_id id) {
+    return const_cast<texture_t&>(std::as_const(*this).get(id)); // NOLINT
+}
+
+bool grx_texture_residency::make_room(
+    u64 extra, u64 used_before, const hash_set<texture_id>& protect, plan_t& plan, bool partial) {
+    auto used = _resident_bytes + _pending_bytes;
+    if (used + extra <= _settings.memory_budget)
+        return true;
+    auto need = used + extra - _settings.memory_budget;
+
+    /* Levels above the desired one go first, then levels of least recently used textures */
+    struct victim_t {
+        texture_id id;
+        texture_t* texture;
+        u32        limit;
+        bool       surplus;
+    };
+
+    vector<victim_t> victims;
+    u64              available = 0;
+    for (auto& [id, texture] : _textures) {
+        if (texture.loading || protect.contains(id))
+            continue;
+
+        auto limit = texture.resident;
+        if (texture.resident < texture.desired) {
+            limit = std::min(texture.desired, texture.min_level);
+            victims.push_back({id, &texture, limit, true});
+        }
+        if (texture.last_used < used_before && limit < texture.min_level) {
+            limit = texture.min_level;
+            victims.push_back({id, &texture, limit, false});
+        }
+
+        for (auto i = texture.resident; i < limit; ++i)
+            available += texture.level_bytes[i];
+    }
+
+    if (available < need && !partial)
+        return false;
+
+    std::sort(victims.begin(), victims.end(), [](auto& lhs, auto& rhs) {
+        if (lhs.surplus != rhs.surplus)
+            return lhs.surplus;
+        if (lhs.texture->last_used != rhs.texture->last_used)
+            return lhs.texture->last_used < rhs.texture->last_used;
+        return lhs.id < rhs.id;
+    });
+
+    u64 freed = 0;
+    for (auto& victim : victims) {
+        auto level = victim.texture->resident;
+        while (level < victim.limit && freed < need)
+            freed += victim.texture->level_bytes[level++];
+
+        drop_to(victim.id, *victim.texture, level, plan);
+        if (freed >= need)
+            break;
+    }
+
+    return freed >= need;
+}
+
+void grx_texture_residency::drop_to(texture_id id, texture_t& texture, u32 level, plan_t& plan) {
+    if (level <= texture.resident)
+        return;
+
+    for (auto i = texture.resident; i < level; ++i)
+        _resident_bytes -= texture.level_bytes[i];
+    texture.resident = level;
+
+    auto found = std::find_if(plan.drops.begin(), plan.drops.end(), [id](auto& drop) { return drop.id == id; });
+    if (found != plan.drops.end())
+        found->level = level;
+    else
+        plan.drops.push_back({id, level});
+}
+} // namespace grx
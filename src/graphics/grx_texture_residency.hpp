@@ -0,0 +1,197 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <core/vec.hpp>
+
+namespace grx
+{
+/**
+ * @brief Tracks resident mip levels of streamed textures and plans uploads and evictions
+ *
+ * Levels of a texture are resident from the top level to the smallest one. The mip tail (levels from the minimal
+ * level) is always resident, higher levels are uploaded one by one: textures with the largest gap between resident
+ * and desired levels go first, then recently used ones. When the memory budget is exceeded, top levels are dropped
+ * from textures that have more levels than they need and then from least recently used ones.
+ *
+ * The class knows nothing about the video memory, the owner executes plans returned by update()
+ */
+class grx_texture_residency {
+public:
+    using texture_id = core::u64;
+
+    struct settings_t {
+        /* Limit of resident and uploading bytes */
+        core::u64 memory_budget = 256ULL << 20U; // NOLINT
+
+        /* Bytes uploaded per update, at least one level is uploaded anyway */
+        core::u64 upload_budget = 4ULL << 20U; // NOLINT
+    };
+
+    struct load_t {
+        texture_id id;
+        core::u32  level;
+    };
+
+    struct drop_t {
+        texture_id id;
+        core::u32  level; /* The new top level */
+    };
+
+    struct plan_t {
+        core::vector<drop_t> drops;
+        core::vector<load_t> loads;
+    };
+
+    grx_texture_residency() = default;
+    explicit grx_texture_residency(const settings_t& settings): _settings(settings) {}
+
+    /**
+     * @brief Gets the first level of the mip tail
+     *
+     * @param size - the size of the largest level
+     * @param levels_count - the count of levels
+     * @param tail_size - the maximal size of levels in the tail
+     *
+     * @return the first level which is not larger than tail_size, or the last level
+     */
+    static core::u32 mip_tail_level(core::vec2u size, core::u32 levels_count, core::u32 tail_size);
+
+    /**
+     * @brief Gets the level which is enough to draw the texture on the screen area
+     *
+     * @param size - the size of the largest level
+     * @param screen_size - the size of the texture on the screen in pixels
+     *
+     * @return the level which is not smaller than screen_size
+     */
+    static core::u32 level_for_screen_size(core::vec2u size, core::vec2f screen_size);
+
+    /**
+     * @brief Starts tracking of the texture
+     *
+     * @throw runtime_error if the texture is already tracked or min_level is out of range
+     *
+     * @param id - the texture id
+     * @param level_bytes - sizes of levels from the largest to the smallest one
+     * @param min_level - the first level of the mip tail, levels [min_level, levels count) are resident
+     */
+    void add(texture_id id, core::vector<core::u64> level_bytes, core::u32 min_level);
+
+    /**
+     * @brief Stops tracking of the texture, its levels and pending loads are forgotten
+     */
+    void remove(texture_id id);
+
+    [[nodiscard]]
+    bool contains(texture_id id) const {
+        return _textures.contains(id);
+    }
+
+    /**
+     * @brief Requests the level for the texture and marks it as used by the current update
+     *
+     * The largest level requested between updates wins. Textures which were never requested want the largest level
+     *
+     * @throw runtime_error if the texture is not tracked
+     *
+     * @param id - the texture id
+     * @param level - the desired top level, it is clamped to the last level
+     */
+    void request_level(texture_id id, core::u32 level);
+
+    /**
+     * @brief Plans drops and loads of levels
+     *
+     * Drops are applied immediately. Loads are pending until level_loaded() is called
+     *
+     * @return the plan
+     */
+    plan_t update();
+
+    /**
+     * @brief Completes the pending load of the level
+     *
+     * Loads of removed textures are ignored
+     *
+     * @param id - the texture id
+     * @param level - the loaded level
+     */
+    void level_loaded(texture_id id, core::u32 level);
+
+    [[nodiscard]]
+    core::u32 resident_level(texture_id id) const {
+        return get(id).resident;
+    }
+
+    [[nodiscard]]
+    core::u32 desired_level(texture_id id) const {
+        return get(id).desired;
+    }
+
+    [[nodiscard]]
+    core::u32 min_level(texture_id id) const {
+        return get(id).min_level;
+    }
+
+    [[nodiscard]]
+    bool is_loading(texture_id id) const {
+        return get(id).loading.has_value();
+    }
+
+    /**
+     * @brief Gets the size of resident levels of all textures
+     */
+    [[nodiscard]]
+    core::u64 resident_bytes() const {
+        return _resident_bytes;
+    }
+
+    /**
+     * @brief Gets the size of levels which are loading now
+     */
+    [[nodiscard]]
+    core::u64 pending_bytes() const {
+        return _pending_bytes;
+    }
+
+    [[nodiscard]]
+    const settings_t& settings() const {
+        return _settings;
+    }
+
+    void settings(const settings_t& value) {
+        _settings = value;
+    }
+
+private:
+    struct texture_t {
+        core::vector<core::u64>  level_bytes;
+        core::u32                min_level;
+        core::u32                resident;
+        core::u32                desired   = 0;
+        core::u64                last_used = 0;
+        core::optional<core::u64> request_tick;
+        core::optional<core::u32> loading;
+    };
+
+    const texture_t& get(texture_id id) const;
+    texture_t&       get(texture_id id);
+
+    /* Drops levels until the extra bytes fit the budget, textures of the protected set are not touched.
+     * Levels of textures used before the used_before tick may be dropped. Nothing is dropped if the room can't be
+     * made, unless partial is true */
+    bool make_room(core::u64                         extra,
+                   core::u64                         used_before,
+                   const core::hash_set<texture_id>& protect,
+                   plan_t&                           plan,
+                   bool                              partial);
+    void drop_to(texture_id id, texture_t& texture, core::u32 level, plan_t& plan);
+
+private:
+    settings_t                           _settings;
+    core::hash_map<texture_id, texture_t> _textures;
+    core::u64                            _resident_bytes = 0;
+    core::u64                            _pending_bytes  = 0;
+    core::u64                            _tick           = 0;
+};
+} // namespace grx
@@ -22,6 +22,11 @@ public:
         core::deserialize(this->options(), d);
     }
 
+    [[nodiscard]]
+    size_t serialized_size() const {
+        return core::serialized_size(this->options());
+    }
+
     grx_texture_set() = default;
 
     grx_texture_set(const core::shared_ptr<grx_texture_mgr<T, S>>& texture_mgr,
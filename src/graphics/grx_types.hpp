@@ -216,6 +216,20 @@ namespace core {
         }
     };
 
+    template <glm::length_t C, glm::length_t R, typename T, glm::qualifier Q>
+    struct pe_serialized_size<glm::mat<C, R, T, Q>> {
+        constexpr size_t operator()(const glm::mat<C, R, T, Q>&) const {
+            return sizeof(T) * C * R;
+        }
+    };
+
+    template <glm::length_t C, glm::length_t R, typename T, glm::qualifier Q>
+    struct trivially_serializable<glm::mat<C, R, T, Q>> {
+        /* Columns are serialized in memory order only for square matrices */
+        static constexpr size_t word_size =
+            C == R && sizeof(glm::mat<C, R, T, Q>) == sizeof(T) * C * R ? trivially_serializable<T>::word_size : 0;
+    };
+
     template <>
     struct pe_serialize<glm::quat> {
         void operator()(const glm::quat& q, byte_vector& out) const {
@@ -229,4 +243,11 @@ namespace core {
             core::deserialize_all(in, q.w, q.x, q.y, q.z);
         }
     };
+
+    template <>
+    struct pe_serialized_size<glm::quat> {
+        constexpr size_t operator()(const glm::quat&) const {
+            return sizeof(float) * 4;
+        }
+    };
 }
@@ -67,10 +67,9 @@ void _grx_rebind_vector_vec2f_vbo(uint vbo_id, uint location) {
     glVertexAttribPointer(location, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
 }
 
-void _grx_set_data_vector_vec2f_vbo(uint vbo_id, uint location, const vbo_vector_vec2f& data) {
+void _grx_set_data_vector_vec2f_vbo(uint vbo_id, uint location, core::span<const core::vec2f> data) {
     glBindBuffer(GL_ARRAY_BUFFER, vbo_id);
-    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(sizeof(vbo_vector_vec2f::value_type) * data.size()),
-                 data.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.size_bytes()), data.data(), GL_STATIC_DRAW);
     glEnableVertexAttribArray(location);
     glVertexAttribPointer(location, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
 }
@@ -114,10 +113,9 @@ void _grx_rebind_vector_vec3f_vbo(uint vbo_id, uint location) {
     glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
 }
 
-void _grx_set_data_vector_vec3f_vbo(uint vbo_id, uint location, const vbo_vector_vec3f& data) {
+void _grx_set_data_vector_vec3f_vbo(uint vbo_id, uint location, core::span<const core::vec3f> data) {
     glBindBuffer(GL_ARRAY_BUFFER, vbo_id);
-    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(sizeof(vbo_vector_vec3f::value_type) * data.size()),
-                 data.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.size_bytes()), data.data(), GL_STATIC_DRAW);
     glEnableVertexAttribArray(location);
     glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
 }
@@ -127,10 +125,9 @@ void _grx_rebind_vector_indices_ebo(uint vbo_id) {
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_id);
 }
 
-void _grx_set_data_vector_indices_ebo(uint vbo_id, const vbo_vector_indices& data) {
+void _grx_set_data_vector_indices_ebo(uint vbo_id, core::span<const uint> data) {
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_id);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(sizeof(vbo_vector_indices::value_type) * data.size()),
-                 data.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.size_bytes()), data.data(), GL_STATIC_DRAW);
 }
 
 void _grx_set_data_vector_matrix_vbo(uint vbo_id, const glm::mat4* matrices, size_t size) {
@@ -21,13 +21,13 @@ bool _grx_bind_vao(win_vao_map_t& vao_map);
 void _grx_bind_vbo(uint target, uint vbo_id);
 
 void _grx_rebind_vector_vec2f_vbo(uint vbo_id, uint location);
-void _grx_set_data_vector_vec2f_vbo(uint vbo_id, uint location, const vbo_vector_vec2f& data);
+void _grx_set_data_vector_vec2f_vbo(uint vbo_id, uint location, core::span<const core::vec2f> data);
 
 void _grx_rebind_vector_vec3f_vbo(uint vbo_id, uint location);
-void _grx_set_data_vector_vec3f_vbo(uint vbo_id, uint location, const vbo_vector_vec3f& data);
+void _grx_set_data_vector_vec3f_vbo(uint vbo_id, uint location, core::span<const core::vec3f> data);
 
 void _grx_rebind_vector_indices_ebo(uint vbo_id);
-void _grx_set_data_vector_indices_ebo(uint vbo_id, const vbo_vector_indices& data);
+void _grx_set_data_vector_indices_ebo(uint vbo_id, core::span<const uint> data);
 
 void _grx_set_data_vector_matrix_vbo(uint vbo_id, const glm::mat4* matrices, size_t size);
 
@@ -246,12 +246,23 @@ public:
 
     template <size_t I>
     void set_data(const std::tuple_element_t<I, std::tuple<Ts...>>& vbo_data) {
+        using DataT = std::tuple_element_t<I, std::tuple<Ts...>>;
+        set_data<I>(core::span<const typename DataT::value_type>(vbo_data.data(),
+                                                                 static_cast<ptrdiff_t>(vbo_data.size())));
+    }
+
+    /**
+     * @brief Uploads data from the contiguous view (e.g. the mesh buffer borrowed from the serialized asset)
+     */
+    template <size_t I>
+    void set_data(core::span<const typename std::tuple_element_t<I, std::tuple<Ts...>>::value_type> vbo_data) {
         using DataT = std::tuple_element_t<I, std::tuple<Ts...>>;
         static_assert(VboVectorVec2f<DataT> || VboVectorVec3f<DataT> || VboVectorIndices<DataT> ||
                       VboVectorMatrix4<DataT> || VboVectorBone<DataT>);
 
-        auto                            id  = _vbo_ids[I];
-        [[maybe_unused]] constexpr auto loc = location<I>();
+        auto                            id   = _vbo_ids[I];
+        auto                            size = static_cast<size_t>(vbo_data.size());
+        [[maybe_unused]] constexpr auto loc  = location<I>();
 
         if constexpr (VboVectorVec2f<DataT>)
             _grx_set_data_vector_vec2f_vbo(id, loc, vbo_data);
@@ -260,11 +271,11 @@ public:
         else if constexpr (VboVectorIndices<DataT>)
             _grx_set_data_vector_indices_ebo(id, vbo_data);
         else if constexpr (VboVectorMatrix4<DataT>)
-            _grx_set_data_vector_matrix_vbo(id, vbo_data.data(), vbo_data.size());
+            _grx_set_data_vector_matrix_vbo(id, vbo_data.data(), size);
         else if constexpr (VboVectorBone<DataT>)
-            _grx_set_data_vector_bone_vbo(id, loc, vbo_data.data(), vbo_data[0].size(), vbo_data.size());
+            _grx_set_data_vector_bone_vbo(id, loc, vbo_data.data(), DataT::value_type::size(), size);
 
-        _vbo_sizes[I] = static_cast<uint>(vbo_data.size());
+        _vbo_sizes[I] = static_cast<uint>(size);
     }
 
     template <size_t I>
@@ -65,3 +65,15 @@ concept VboData = VboVectorVec2f<T> || VboVectorVec3f<T> || VboVectorIndices<T>
                   VboVectorMatrix4<T> || VboVectorBone<T>;
 
 } // namespace grx
+
+namespace core
+{
+template <>
+struct trivially_serializable<grx::grx_bone_vertex_data> {
+    static_assert(sizeof(grx::grx_bone_vertex_data) == sizeof(u32) * 2 * MAX_BONES_PER_VERTEX &&
+                      offsetof(grx::grx_bone_vertex_data, weights) == sizeof(u32) * MAX_BONES_PER_VERTEX,
+                  "grx_bone_vertex_data must be ids followed by weights without padding");
+
+    static constexpr size_t word_size = sizeof(u32);
+};
+} // namespace core
@@ -1,6 +1,9 @@
+#pragma once
+
 #include <core/container_extensions.hpp>
 #include <core/vec.hpp>
 #include <core/ston.hpp>
+#include <core/fiber_pool.hpp>
 #include <graphics/grx_color_map.hpp>
 #include <graphics/grx_cpu_mesh_group.hpp>
 
@@ -33,11 +36,16 @@ public:
     struct face_data {
         u32 a, b, c;
 
-        void recalc_normal(vector<vertex_data>& vertices) const {
+        [[nodiscard]]
+        vec3f weighted_normal(const vector<vertex_data>& vertices) const {
             auto& pa = vertices[a].position;
             auto& pb = vertices[b].position;
             auto& pc = vertices[c].position;
-            auto n = (pb - pa).cross(pc - pa);
+            return (pb - pa).cross(pc - pa);
+        }
+
+        void recalc_normal(vector<vertex_data>& vertices) const {
+            auto n = weighted_normal(vertices);
             vertices[a].normal += n;
             vertices[b].normal += n;
             vertices[c].normal += n;
@@ -50,6 +58,12 @@ public:
         }
     };
 
+    struct brush_stroke {
+        float force;
+        float brush_size;
+        vec2f position;
+    };
+
     static terrain_editor generate_flat(const vec2f& size, const vec2u& split_count) {
         auto hmap = grx_float_color_map_r({2, 2});
         for (auto c : hmap)
@@ -61,112 +75,114 @@ public:
         return v;
     }
 
+    /**
+     * @brief Generates the terrain from the height map
+     *
+     * Heights are interpolated from four nearest pixels weighted by curve_func of inverse distances to them.
+     * Vertices, faces and normals are generated by rows in parallel jobs of the fiber pool. The sampling loop
+     * has no branches and reads precomputed columns, so the compiler vectorizes it
+     *
+     * @param height_map - the height map
+     * @param size - the size of the terrain in the XZ plane
+     * @param max_height - the height of height map values of 1
+     * @param split_count - vertices count between border vertices in every dimension
+     * @param curve_func - the weight of the pixel by the inverse distance to it
+     * @param pool - the fiber pool (nullptr - the global fiber pool)
+     *
+     * @return the terrain
+     */
     template <typename F = decltype(terrain_gen_identity_curve)>
     static terrain_editor generate(const grx_float_color_map_r& height_map,
                                    const vec2f&                 size,
                                    float                        max_height,
                                    const vec2u&                 split_count,
-                                   F&&                          curve_func = terrain_gen_identity_curve) {
-        terrain_editor res;
-
-        res.vertex_count = split_count + vec2u{2, 2};
-        res.size         = size;
-
-        static constexpr auto take_color =
-            [](const grx_float_color_map_r& height_map, const vec2f& size_f, vec2f pos, auto&& curve_func) {
-                auto p  = pos * size_f;
-                auto p1 = vec{std::floor(p.x()), std::floor(p.y())};
-                auto p2 = vec{std::ceil(p.x()), std::ceil(p.y())};
-                auto p3 = vec{p2.x(), p1.y()};
-                auto p4 = vec{p1.x(), p2.y()};
-
-                auto color1 = height_map[size_t(p1.y())][size_t(p1.x())];
-                auto color2 = height_map[size_t(p2.y())][size_t(p2.x())];
-                auto color3 = height_map[size_t(p3.y())][size_t(p3.x())];
-                auto color4 = height_map[size_t(p4.y())][size_t(p4.x())];
-
-                auto dst1 = (p - p1).magnitude();
-                auto dst2 = (p - p2).magnitude();
-                auto dst3 = (p - p3).magnitude();
-                auto dst4 = (p - p4).magnitude();
-
-                constexpr auto mindst = 0.00001f;
-
-                if (dst1 < mindst)
-                    return color1.get().x();
-                if (dst2 < mindst)
-                    return color2.get().x();
-                if (dst3 < mindst)
-                    return color3.get().x();
-                if (dst4 < mindst)
-                    return color4.get().x();
-
-                dst1 = 1.f / dst1;
-                dst2 = 1.f / dst2;
-                dst3 = 1.f / dst3;
-                dst4 = 1.f / dst4;
-
-                auto dp1 = curve_func(dst1);
-                auto dp2 = curve_func(dst2);
-                auto dp3 = curve_func(dst3);
-                auto dp4 = curve_func(dst4);
+                                   F&&                          curve_func = terrain_gen_identity_curve,
+                                   core::fiber_pool*            pool       = nullptr) {
+        auto width = height_map.size().x();
+
+        auto sample_row = [&](const sample_columns& cols, float py, float* heights) {
+            constexpr auto mindst = 0.00001f;
+
+            auto y1   = std::floor(py);
+            auto y2   = std::ceil(py);
+            auto dy1  = py - y1;
+            auto dy2  = py - y2;
+            auto row1 = height_map.data() + size_t(y1) * width;
+            auto row2 = height_map.data() + size_t(y2) * width;
+
+            for (size_t x = 0; x < cols.pos.size(); ++x) {
+                auto dx1 = cols.pos[x] - float(cols.first[x]);
+                auto dx2 = cols.pos[x] - float(cols.second[x]);
+
+                /* Pixels: 1 - (first, y1), 2 - (second, y2), 3 - (second, y1), 4 - (first, y2) */
+                auto dst1 = std::sqrt(dx1 * dx1 + dy1 * dy1);
+                auto dst2 = std::sqrt(dx2 * dx2 + dy2 * dy2);
+                auto dst3 = std::sqrt(dx2 * dx2 + dy1 * dy1);
+                auto dst4 = std::sqrt(dx1 * dx1 + dy2 * dy2);
+
+                auto color1 = row1[cols.first[x]];
+                auto color2 = row2[cols.second[x]];
+                auto color3 = row1[cols.second[x]];
+                auto color4 = row2[cols.first[x]];
+
+                auto dp1 = curve_func(1.f / std::max(dst1, mindst));
+                auto dp2 = curve_func(1.f / std::max(dst2, mindst));
+                auto dp3 = curve_func(1.f / std::max(dst3, mindst));
+                auto dp4 = curve_func(1.f / std::max(dst4, mindst));
 
                 auto inf_max = dp1 + dp2 + dp3 + dp4;
-
-                if (inf_max < 0.000001f && inf_max > -0.000001f)
-                    return color1.get().x();
-
-                auto inf1 = dp1 / inf_max;
-                auto inf2 = dp2 / inf_max;
-                auto inf3 = dp3 / inf_max;
-                auto inf4 = dp4 / inf_max;
-
-                return color1.get().x() * inf1 + color2.get().x() * inf2 + color3.get().x() * inf3 +
-                       color4.get().x() * inf4;
-            };
-
-        static constexpr auto make_vertex = [](const grx_float_color_map_r& hmap,
-                                               float                        max_height,
-                                               const vec2f&                 size_f,
-                                               const vec2u&                 vert_idxs,
-                                               const vec2u&                 vert_count,
-                                               const vec2f&                 size,
-                                               auto&&                       curve_func) {
-            auto f  = size * vec2f(vert_idxs) / vec2f(vert_count);
-            auto fy = max_height * take_color(hmap, size_f, f, curve_func);
-            return vec{f.x(), fy, f.y()};
+                auto color   = color1 * (dp1 / inf_max) + color2 * (dp2 / inf_max) + color3 * (dp3 / inf_max) +
+                             color4 * (dp4 / inf_max);
+
+                /* Selects instead of early returns keep the loop vectorizable */
+                color = inf_max < 0.000001f && inf_max > -0.000001f ? color1 : color; // NOLINT
+                color = dst4 < mindst ? color4 : color;
+                color = dst3 < mindst ? color3 : color;
+                color = dst2 < mindst ? color2 : color;
+                color = dst1 < mindst ? color1 : color;
+
+                heights[x] = max_height * color;
+            }
         };
 
-        auto  size_f     = vec2f(height_map.size() - vec2u{1, 1}) / size;
-        auto& vert_count = res.vertex_count;
-        auto  uv_max     = vec2f(vert_count - vec2u{1, 1});
-
-        for (auto [x, y] : dimensional_seq(vert_count))
-            res.vertices.push_back({make_vertex(height_map, max_height, size_f, {x, y}, vert_count, size, curve_func),
-                                       vec{float(x), float(y)} / uv_max});
-
-        for (auto [x, y] : dimensional_seq(vert_count - vec2u{1, 1})) {
-            res.faces.push_back({y * vert_count.x() + x, (y + 1) * vert_count.x() + x, y * vert_count.x() + x + 1});
-            auto& f1      = res.faces.back();
-            auto  face_id = u32(res.faces.size() - 1);
-            f1.recalc_normal(res.vertices);
-            res.vertices[f1.a].internal_face_id = face_id;
-            res.vertices[f1.b].internal_face_id = face_id;
-            res.vertices[f1.c].internal_face_id = face_id;
-
-            res.faces.push_back(
-                {y * vert_count.x() + x + 1, (y + 1) * vert_count.x() + x, (y + 1) * vert_count.x() + x + 1});
-            auto& f2 = res.faces.back();
-            face_id  = u32(res.faces.size() - 1);
-            f2.recalc_normal(res.vertices);
-            res.vertices[f2.a].internal_face_id = face_id;
-            res.vertices[f2.b].internal_face_id = face_id;
-            res.vertices[f2.c].internal_face_id = face_id;
-        }
+        return generate_rows(height_map, size, split_count, pool, sample_row);
+    }
 
-        for (auto& v : res.vertices) v.normal.make_normalize();
+    /**
+     * @brief Generates the terrain from the height map with the bilinear interpolation of heights
+     *
+     * Faster than generate(), see it for details
+     *
+     * @param height_map - the height map
+     * @param size - the size of the terrain in the XZ plane
+     * @param max_height - the height of height map values of 1
+     * @param split_count - vertices count between border vertices in every dimension
+     * @param pool - the fiber pool (nullptr - the global fiber pool)
+     *
+     * @return the terrain
+     */
+    static terrain_editor generate_bilinear(const grx_float_color_map_r& height_map,
+                                            const vec2f&                 size,
+                                            float                        max_height,
+                                            const vec2u&                 split_count,
+                                            core::fiber_pool*            pool = nullptr) {
+        auto width = height_map.size().x();
+
+        auto sample_row = [&](const sample_columns& cols, float py, float* heights) {
+            auto y1   = std::floor(py);
+            auto ty   = py - y1;
+            auto row1 = height_map.data() + size_t(y1) * width;
+            auto row2 = height_map.data() + size_t(std::ceil(py)) * width;
+
+            for (size_t x = 0; x < cols.pos.size(); ++x) {
+                auto tx     = cols.pos[x] - float(cols.first[x]);
+                auto top    = row1[cols.first[x]] + (row1[cols.second[x]] - row1[cols.first[x]]) * tx;
+                auto bottom = row2[cols.first[x]] + (row2[cols.second[x]] - row2[cols.first[x]]) * tx;
+                heights[x]  = max_height * (top + (bottom - top) * ty);
+            }
+        };
 
-        return res;
+        return generate_rows(height_map, size, split_count, pool, sample_row);
     }
 
     void recalc_normals_smooth() {
@@ -176,50 +192,69 @@ public:
             face.recalc_normal(vertices);
         for (auto& v : vertices)
             v.normal.make_normalize();
-    }
 
-    void amplify(float force, float brush_size, const vec2f& position, auto attenuation_f) {
-        auto  vert_f     = vec2f(vertex_count - vec{1U, 1U}) / size;
-        auto  vertpos    = vert_f * position;
-        auto  vertidx    = vec2u{u32(std::round(vertpos.x())), u32(std::round(vertpos.y()))};
-        auto& start_vert = vertices[vertidx.y() * vertex_count.x() + vertidx.x()];
-        auto  start_xz   = start_vert.position.xz();
-        auto  halfbrush  = brush_size * 0.5f;
-        /* For using faster magnitude2 */
-        auto halfbrush_2 = halfbrush * halfbrush;
-
-        auto idx_min = vertidx;
-        auto idx_max = vertidx;
-
-        /* TODO: simplify/optimize this */
-        while (idx_max.x() < vertex_count.x() &&
-               (start_xz - vertices[vertidx.y() * vertex_count.x() + idx_max.x()].position.xz())
-                       .magnitude_2() <= halfbrush_2)
-            ++idx_max.x();
-        while (idx_min.x() < vertex_count.x() &&
-               (start_xz - vertices[vertidx.y() * vertex_count.x() + idx_min.x()].position.xz())
-                       .magnitude_2() <= halfbrush_2)
-            --idx_min.x();
-        while (idx_max.y() < vertex_count.y() &&
-               (start_xz - vertices[idx_max.y() * vertex_count.x() + vertidx.x()].position.xz())
-                       .magnitude_2() <= halfbrush_2)
-            ++idx_max.y();
-        while (idx_min.y() < vertex_count.y() &&
-               (start_xz - vertices[idx_min.y() * vertex_count.x() + vertidx.x()].position.xz())
-                       .magnitude_2() <= halfbrush_2)
-            --idx_min.y();
+        dirty_min = vec2u::filled_with(core::numlim<u32>::max());
+        dirty_max = {0, 0};
+    }
 
-        for (auto [x, y] : dimensional_seq(idx_min, idx_max)) {
-            auto& v = vertices[y * vertex_count.x() + x];
-            auto dist = (start_xz - v.position.xz()).magnitude();
-            if (dist > halfbrush)
-                continue;
+    /**
+     * @brief Recalculates normals after changes of vertex positions in the rectangle
+     *
+     * Normals of changed vertices and of their one-ring are gathered from faces touching them. Faces are
+     * accumulated in the same order as by recalc_normals_smooth(), so normals are bit-identical to the full
+     * recalculation
+     *
+     * @param min - the first changed vertex in every dimension
+     * @param max - the vertex after the last changed one in every dimension
+     */
+    void recalc_normals_smooth(const vec2u& min, const vec2u& max) {
+        if (min.x() >= max.x() || min.y() >= max.y())
+            return;
+
+        auto ring_min = vec2u{min.x() ? min.x() - 1 : 0, min.y() ? min.y() - 1 : 0};
+        auto ring_max = vec2u{std::min(max.x() + 1, vertex_count.x()), std::min(max.y() + 1, vertex_count.y())};
+
+        auto cells       = vertex_count - vec2u{1, 1};
+        auto face_normal = [&](u32 cx, u32 cy, u32 face) {
+            return faces[face_index(cx, cy, face)].weighted_normal(vertices);
+        };
 
-            auto coeff = attenuation_f((halfbrush - dist) / halfbrush);
-            v.position.y() += force * coeff;
+        for (auto [x, y] : dimensional_seq(ring_min, ring_max)) {
+            auto& normal = vertices[y * vertex_count.x() + x].normal;
+            normal       = gather_normal(x, y, cells, face_normal);
+            normal.make_normalize();
         }
+    }
 
-        recalc_normals_smooth();
+    /**
+     * @brief Recalculates normals of vertices changed since the last recalculation
+     */
+    void recalc_dirty_normals() {
+        recalc_normals_smooth(dirty_min, dirty_max);
+        dirty_min = vec2u::filled_with(core::numlim<u32>::max());
+        dirty_max = {0, 0};
+    }
+
+    void amplify(float force, float brush_size, const vec2f& position, auto attenuation_f) {
+        amplify_positions(force, brush_size, position, attenuation_f);
+        recalc_dirty_normals();
+    }
+
+    /**
+     * @brief Applies strokes one by one and recalculates normals once
+     *
+     * @param strokes - strokes
+     * @param attenuation_f - the force multiplier by the distance to the brush border (1 - the center)
+     */
+    void amplify(core::span<const brush_stroke> strokes, auto attenuation_f) {
+        for (auto& stroke : strokes)
+            amplify_positions(stroke.force, stroke.brush_size, stroke.position, attenuation_f);
+        recalc_dirty_normals();
+    }
+
+    [[nodiscard]]
+    const vector<vertex_data>& get_vertices() const {
+        return vertices;
     }
 
     [[nodiscard]]
@@ -318,10 +353,205 @@ public:
     }
 
 private:
+    /* Height map coordinates of vertex columns, the same for all rows */
+    struct sample_columns {
+        vector<float> pos;
+        vector<u32>   first;  /* floor(pos) */
+        vector<u32>   second; /* ceil(pos) */
+    };
+
+    /* sample_row(columns, height map y, heights) fills heights of the vertex row */
+    template <typename F>
+    static terrain_editor generate_rows(const grx_float_color_map_r& height_map,
+                                        const vec2f&                 size,
+                                        const vec2u&                 split_count,
+                                        core::fiber_pool*            pool,
+                                        F&&                          sample_row) {
+        terrain_editor res;
+
+        res.vertex_count = split_count + vec2u{2, 2};
+        res.size         = size;
+
+        auto& vert_count = res.vertex_count;
+        auto  size_f     = vec2f(height_map.size() - vec2u{1, 1}) / size;
+        auto  uv_max     = vec2f(vert_count - vec2u{1, 1});
+        auto  cells      = vert_count - vec2u{1, 1};
+
+        /* Rows of vertices per job */
+        auto rows_per_job = std::max<size_t>(1, 16384 / vert_count.x()); // NOLINT
+
+        sample_columns cols;
+        vector<float>  xs(vert_count.x());
+        vector<float>  us(vert_count.x());
+        for (u32 x = 0; x < vert_count.x(); ++x) {
+            xs[x] = size.x() * float(x) / float(vert_count.x());
+            us[x] = float(x) / uv_max.x();
+            cols.pos.push_back(xs[x] * size_f.x());
+            cols.first.push_back(u32(std::floor(cols.pos.back())));
+            cols.second.push_back(u32(std::ceil(cols.pos.back())));
+        }
+
+        res.vertices.resize(size_t(vert_count.x()) * vert_count.y());
+        core::parallel_for(
+            vert_count.y(),
+            rows_per_job,
+            [&](size_t begin, size_t end) {
+                vector<float> heights(vert_count.x());
+                for (auto y = begin; y < end; ++y) {
+                    auto z = size.y() * float(y) / float(vert_count.y());
+                    auto v = float(y) / uv_max.y();
+                    sample_row(cols, z * size_f.y(), heights.data());
+
+                    auto row = res.vertices.data() + y * vert_count.x();
+                    for (u32 x = 0; x < vert_count.x(); ++x) {
+                        row[x].position = vec{xs[x], heights[x], z};
+                        row[x].uv       = vec{us[x], v};
+                    }
+                }
+            },
+            pool);
+
+        /* Two faces per cell, cells go by rows */
+        res.faces.resize(size_t(cells.x()) * cells.y() * 2);
+        core::parallel_for(
+            cells.y(),
+            rows_per_job,
+            [&](size_t begin, size_t end) {
+                for (auto y = begin; y < end; ++y) {
+                    auto face   = res.faces.data() + y * cells.x() * 2;
+                    auto top    = u32(y * vert_count.x());
+                    auto bottom = top + vert_count.x();
+                    for (u32 x = 0; x < cells.x(); ++x, face += 2) {
+                        face[0] = {top + x, bottom + x, top + x + 1};
+                        face[1] = {top + x + 1, bottom + x, bottom + x + 1};
+                    }
+                }
+            },
+            pool);
+
+        /* Weighted normals of faces of cell rows above and below the vertex row are computed once per job row */
+        core::parallel_for(
+            vert_count.y(),
+            rows_per_job,
+            [&](size_t begin, size_t end) {
+                vector<vec3f> above(size_t(cells.x()) * 2);
+                vector<vec3f> below(size_t(cells.x()) * 2);
+
+                auto fill = [&](vector<vec3f>& normals, size_t cell_y) {
+                    auto face = res.faces.data() + cell_y * cells.x() * 2;
+                    for (size_t i = 0; i < normals.size(); ++i)
+                        normals[i] = face[i].weighted_normal(res.vertices);
+                };
+
+                if (begin > 0)
+                    fill(below, begin - 1);
+
+                for (auto y = u32(begin); y < end; ++y) {
+                    std::swap(above, below);
+                    if (y < cells.y())
+                        fill(below, y);
+
+                    auto face_normal = [&](u32 cx, u32 cy, u32 face) {
+                        return (cy < y ? above : below)[size_t(cx) * 2 + face];
+                    };
+
+                    for (u32 x = 0; x < vert_count.x(); ++x) {
+                        auto& vertex            = res.vertices[y * vert_count.x() + x];
+                        vertex.normal           = gather_normal(x, y, cells, face_normal);
+                        vertex.internal_face_id = res.last_face(x, y);
+                        vertex.normal.make_normalize();
+                    }
+                }
+            },
+            pool);
+
+        return res;
+    }
+
+    [[nodiscard]]
+    size_t face_index(u32 cell_x, u32 cell_y, u32 face) const {
+        return (size_t(cell_y) * (vertex_count.x() - 1) + cell_x) * 2 + face;
+    }
+
+    /*
+     * Sum of weighted normals of faces of the vertex in the order of faces, the same as the sum of
+     * recalc_normals_smooth(). The first face of the cell has vertices (x, y), (x, y + 1), (x + 1, y),
+     * the second one - (x + 1, y), (x, y + 1), (x + 1, y + 1). face_normal(cell_x, cell_y, face) returns
+     * the weighted normal of the face
+     */
+    template <typename F>
+    static vec3f gather_normal(u32 x, u32 y, const vec2u& cells, F&& face_normal) {
+        auto normal = vec3f::filled_with(0.f);
+
+        if (y > 0) {
+            if (x > 0)
+                normal += face_normal(x - 1, y - 1, 1);
+            if (x < cells.x()) {
+                normal += face_normal(x, y - 1, 0);
+                normal += face_normal(x, y - 1, 1);
+            }
+        }
+        if (y < cells.y()) {
+            if (x > 0) {
+                normal += face_normal(x - 1, y, 0);
+                normal += face_normal(x - 1, y, 1);
+            }
+            if (x < cells.x())
+                normal += face_normal(x, y, 0);
+        }
+        return normal;
+    }
+
+    /* The last face of the vertex */
+    [[nodiscard]]
+    u32 last_face(u32 x, u32 y) const {
+        auto cells = vertex_count - vec2u{1, 1};
+        if (y < cells.y())
+            return u32(x < cells.x() ? face_index(x, y, 0) : face_index(x - 1, y, 1));
+        return u32(x < cells.x() ? face_index(x, y - 1, 1) : face_index(x - 1, y - 1, 1));
+    }
+
+    /* Moves vertices inside the brush, the dirty rectangle is extended by moved vertices */
+    void amplify_positions(float force, float brush_size, const vec2f& position, auto& attenuation_f) {
+        auto  vert_f     = vec2f(vertex_count - vec{1U, 1U}) / size;
+        auto  vertpos    = vert_f * position;
+        auto  vertidx    = vec2u{std::min(u32(std::round(vertpos.x())), vertex_count.x() - 1),
+                             std::min(u32(std::round(vertpos.y())), vertex_count.y() - 1)};
+        auto& start_vert = vertices[vertidx.y() * vertex_count.x() + vertidx.x()];
+        auto  start_xz   = start_vert.position.xz();
+        auto  halfbrush  = brush_size * 0.5f;
+
+        /* Vertices are placed at size * index / vertex_count, the range is extended against rounding errors */
+        auto per_unit = vec2f(vertex_count) / size;
+        auto first    = (start_xz - vec2f::filled_with(halfbrush)) * per_unit;
+        auto last     = (start_xz + vec2f::filled_with(halfbrush)) * per_unit;
+        auto idx_min  = vec2u{u32(std::max(std::floor(first.x()) - 1.f, 0.f)),
+                             u32(std::max(std::floor(first.y()) - 1.f, 0.f))};
+        auto idx_max  = vec2u{u32(std::clamp(std::ceil(last.x()) + 2.f, 0.f, float(vertex_count.x()))),
+                             u32(std::clamp(std::ceil(last.y()) + 2.f, 0.f, float(vertex_count.y())))};
+
+        for (auto [x, y] : dimensional_seq(idx_min, idx_max)) {
+            auto& v = vertices[y * vertex_count.x() + x];
+            auto dist = (start_xz - v.position.xz()).magnitude();
+            if (dist > halfbrush)
+                continue;
+
+            auto coeff = attenuation_f((halfbrush - dist) / halfbrush);
+            v.position.y() += force * coeff;
+
+            dirty_min = vec2u{std::min(dirty_min.x(), x), std::min(dirty_min.y(), y)};
+            dirty_max = vec2u{std::max(dirty_max.x(), x + 1), std::max(dirty_max.y(), y + 1)};
+        }
+    }
+
     vector<vertex_data> vertices;
     vector<face_data>   faces;
     vec2f               size;
     vec2u               vertex_count;
+
+    /* Vertices with positions changed after the last normals recalculation */
+    vec2u dirty_min = vec2u::filled_with(core::numlim<u32>::max());
+    vec2u dirty_max = {0, 0};
 };
 
 inline auto terrain_tanh(float x_magnifier = 3.f) {
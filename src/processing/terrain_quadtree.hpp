@@ -0,0 +1,477 @@
+#pragma once
+
+#include <core/fiber_pool.hpp>
+#include <core/pe_throw.hpp>
+#include <core/print.hpp>
+#include <graphics/algorithms/grx_frustum_culling.hpp>
+#include "terrain_generation.hpp"
+
+namespace prc {
+using core::i64;
+using grx::frustum_bits;
+using grx::grx_aabb;
+using grx::grx_aabb_culling_proxy;
+
+struct terrain_quadtree_settings {
+    u32   tile_cells   = 32;   /* Cells of a node side at every level */                         // NOLINT
+    u32   levels       = 5;    /* Levels of detail, the root covers 2^(levels - 1) leaves per side */ // NOLINT
+    float lod_distance = 64.f; /* The range of the finest level, doubled for every next level */  // NOLINT
+};
+
+/**
+ * Chunked terrain with the distance-based level of detail (CDLOD)
+ *
+ * Heights are stored in the grid of (tile_cells * 2^(levels - 1) + 1)^2 vertices covering the terrain. Nodes of
+ * the quadtree have the same count of cells, the step between vertices of a node is doubled with every level, so
+ * leaves (level 0) have the full resolution and the root is the coarsest one. Every node has its own mesh with
+ * skirts hiding cracks between neighbouring nodes of different levels and the AABB registered in frustum_storage.
+ * Meshes are built lazily, edits rebuild only nodes around changed vertices
+ */
+class terrain_quadtree {
+public:
+    static constexpr u32 no_children = core::numlim<u32>::max();
+
+    struct node_t {
+        u32                    level      = 0;
+        vec2u                  first      = {0, 0};      /* The first vertex of the grid */
+        u32                    children   = no_children; /* The first of four consecutive children */
+        float                  min_height = 0.f;
+        float                  max_height = 0.f;
+        grx_aabb               aabb       = {};          /* With skirts */
+        grx_aabb_culling_proxy aabb_proxy;
+        grx_cpu_mesh_group_t   mesh;
+        u32                    generation = 0; /* Mesh rebuilds count */
+        bool                   dirty      = true;
+    };
+
+    /**
+     * @brief Creates the terrain from the height map with the bilinear interpolation of heights
+     *
+     * @param height_map - the height map
+     * @param size - the size of the terrain in the XZ plane
+     * @param max_height - the height of height map values of 1
+     * @param settings - settings
+     * @param pool - the fiber pool (nullptr - the global fiber pool)
+     */
+    terrain_quadtree(const grx_float_color_map_r&     height_map,
+                     const vec2f&                     size,
+                     float                            max_height,
+                     const terrain_quadtree_settings& settings = {},
+                     core::fiber_pool*                pool     = nullptr):
+        terrain_quadtree(sample_heights(height_map, grid_size(settings), max_height, pool), size, settings) {}
+
+    /**
+     * @brief Creates the terrain from heights of the grid
+     *
+     * @throw runtime_error if settings are invalid or heights count does not match the grid
+     *
+     * @param heights - heights of grid vertices by rows, see grid_size()
+     * @param size - the size of the terrain in the XZ plane
+     * @param settings - settings
+     */
+    terrain_quadtree(vector<float> heights, const vec2f& size, const terrain_quadtree_settings& settings = {}):
+        _heights(move(heights)), _settings(settings), _size(size), _grid(grid_size(settings)) {
+        if (_heights.size() != size_t(_grid.x()) * _grid.y())
+            pe_throw std::runtime_error(
+                core::format("terrain_quadtree: {} heights do not match the grid {}", _heights.size(), _grid));
+
+        /* The tree is complete, all nodes are allocated before children are added */
+        _nodes.resize(((size_t(1) << (2 * _settings.levels)) - 1) / 3);
+        _nodes[0].level = _settings.levels - 1;
+        size_t next     = 1;
+        build_tree(0, next);
+
+        update_nodes(0, {0, 0}, _grid);
+    }
+
+    terrain_quadtree(const terrain_quadtree&) = delete;
+    terrain_quadtree& operator=(const terrain_quadtree&) = delete;
+    terrain_quadtree(terrain_quadtree&&)                 = default;
+    terrain_quadtree& operator=(terrain_quadtree&&) = default;
+    ~terrain_quadtree()                             = default;
+
+    /**
+     * @brief Gets the count of grid vertices in every dimension
+     *
+     * @throw runtime_error if settings are invalid
+     */
+    static vec2u grid_size(const terrain_quadtree_settings& settings) {
+        if (settings.tile_cells == 0 || settings.levels == 0 || settings.levels > 16 || // NOLINT
+            core::u64(settings.tile_cells) << (settings.levels - 1) >= core::numlim<core::u16>::max())
+            pe_throw std::runtime_error(core::format("terrain_quadtree: invalid tile cells {} or levels count {}",
+                                                     settings.tile_cells,
+                                                     settings.levels));
+        return vec2u::filled_with((settings.tile_cells << (settings.levels - 1)) + 1);
+    }
+
+    /**
+     * @brief Gets the camera distance where the level is replaced by the next one
+     */
+    [[nodiscard]]
+    float lod_range(u32 level) const {
+        return _settings.lod_distance * float(1U << level);
+    }
+
+    /**
+     * @brief Selects nodes to draw
+     *
+     * Starts from the root and descends into children while the camera is within the range of their level, so
+     * selected nodes cover the terrain without overlaps. Nodes not visible in tested frustums are skipped,
+     * frustum_storage must be calculated before
+     *
+     * @param camera - the camera position
+     * @param cull - skip not visible nodes
+     * @param tested_bits - tested frustums
+     *
+     * @return indices of selected nodes
+     */
+    [[nodiscard]]
+    vector<u32> select(const vec3f& camera, bool cull = true, frustum_bits tested_bits = frustum_bits::csm_near) const {
+        vector<u32> result;
+        select(0, camera, cull, tested_bits, result);
+        return result;
+    }
+
+    /**
+     * @brief Gets the mesh of the node, rebuilds it if the node was changed
+     *
+     * @param node - the index of the node
+     *
+     * @return the mesh
+     */
+    const grx_cpu_mesh_group_t& mesh(u32 node) {
+        if (_nodes[node].dirty)
+            build_mesh(_nodes[node]);
+        return _nodes[node].mesh;
+    }
+
+    /**
+     * @brief Rebuilds meshes of all changed nodes in parallel jobs of the fiber pool
+     *
+     * @param pool - the fiber pool (nullptr - the global fiber pool)
+     */
+    void build_meshes(core::fiber_pool* pool = nullptr) {
+        vector<u32> dirty;
+        for (u32 i = 0; i < _nodes.size(); ++i)
+            if (_nodes[i].dirty)
+                dirty.push_back(i);
+
+        core::parallel_for(
+            dirty.size(),
+            1,
+            [&](size_t begin, size_t end) {
+                for (auto i = begin; i < end; ++i)
+                    build_mesh(_nodes[dirty[i]]);
+            },
+            pool);
+    }
+
+    void amplify(float force, float brush_size, const vec2f& position, auto attenuation_f) {
+        auto stroke = terrain_editor::brush_stroke{force, brush_size, position};
+        amplify(core::span<const terrain_editor::brush_stroke>(&stroke, 1), attenuation_f);
+    }
+
+    /**
+     * @brief Applies strokes to heights and updates nodes around changed vertices
+     *
+     * @param strokes - strokes
+     * @param attenuation_f - the force multiplier by the distance to the brush border (1 - the center)
+     */
+    void amplify(core::span<const terrain_editor::brush_stroke> strokes, auto attenuation_f) {
+        auto cell        = cell_size();
+        auto changed_min = _grid;
+        auto changed_max = vec2u{0, 0};
+
+        for (auto& stroke : strokes) {
+            auto halfbrush = stroke.brush_size * 0.5f;
+            if (!(halfbrush > 0.f))
+                continue;
+
+            auto first   = (stroke.position - vec2f::filled_with(halfbrush)) / cell;
+            auto last    = (stroke.position + vec2f::filled_with(halfbrush)) / cell;
+            auto idx_min = vec2u{u32(std::clamp(std::floor(first.x()), 0.f, float(_grid.x()))),
+                                 u32(std::clamp(std::floor(first.y()), 0.f, float(_grid.y())))};
+            auto idx_max = vec2u{u32(std::clamp(std::ceil(last.x()) + 1.f, 0.f, float(_grid.x()))),
+                                 u32(std::clamp(std::ceil(last.y()) + 1.f, 0.f, float(_grid.y())))};
+
+            for (auto [x, y] : dimensional_seq(idx_min, idx_max)) {
+                auto dist = (vec2f{float(x), float(y)} * cell - stroke.position).magnitude();
+                if (dist > halfbrush)
+                    continue;
+
+                _heights[size_t(y) * _grid.x() + x] += stroke.force * attenuation_f((halfbrush - dist) / halfbrush);
+
+                changed_min = vec2u{std::min(changed_min.x(), x), std::min(changed_min.y(), y)};
+                changed_max = vec2u{std::max(changed_max.x(), x + 1), std::max(changed_max.y(), y + 1)};
+            }
+        }
+
+        if (changed_min.x() < changed_max.x() && changed_min.y() < changed_max.y())
+            update_nodes(0, changed_min, changed_max);
+    }
+
+    [[nodiscard]]
+    const vector<node_t>& nodes() const {
+        return _nodes;
+    }
+
+    [[nodiscard]]
+    const vector<float>& heights() const {
+        return _heights;
+    }
+
+    [[nodiscard]]
+    const vec2u& grid() const {
+        return _grid;
+    }
+
+    [[nodiscard]]
+    const terrain_quadtree_settings& settings() const {
+        return _settings;
+    }
+
+    [[nodiscard]]
+    vec2f cell_size() const {
+        return _size / vec2f(_grid - vec2u{1, 1});
+    }
+
+private:
+    static vector<float> sample_heights(const grx_float_color_map_r& height_map,
+                                        const vec2u&                 grid,
+                                        float                        max_height,
+                                        core::fiber_pool*            pool) {
+        vector<float> heights(size_t(grid.x()) * grid.y());
+
+        auto width = height_map.size().x();
+        auto max_x = size_t(height_map.size().x() - 1);
+        auto max_y = size_t(height_map.size().y() - 1);
+        /* The rounded scale may put the last vertex slightly past the last texel */
+        auto scale = vec2f(height_map.size() - vec2u{1, 1}) / vec2f(grid - vec2u{1, 1});
+
+        core::parallel_for(
+            grid.y(),
+            std::max<size_t>(1, 16384 / grid.x()), // NOLINT
+            [&](size_t begin, size_t end) {
+                for (auto y = begin; y < end; ++y) {
+                    auto py   = float(y) * scale.y();
+                    auto y1   = std::floor(py);
+                    auto ty   = py - y1;
+                    auto row1 = height_map.data() + size_t(y1) * width;
+                    auto row2 = height_map.data() + std::min<size_t>(size_t(std::ceil(py)), max_y) * width;
+                    auto dst  = heights.data() + y * grid.x();
+
+                    for (u32 x = 0; x < grid.x(); ++x) {
+                        auto px     = float(x) * scale.x();
+                        auto x1     = size_t(std::floor(px));
+                        auto x2     = std::min<size_t>(size_t(std::ceil(px)), max_x);
+                        auto tx     = px - float(x1);
+                        auto top    = row1[x1] + (row1[x2] - row1[x1]) * tx;
+                        auto bottom = row2[x1] + (row2[x2] - row2[x1]) * tx;
+                        dst[x]      = max_height * (top + (bottom - top) * ty);
+                    }
+                }
+            },
+            pool);
+
+        return heights;
+    }
+
+    /* Cells of the node side in grid cells */
+    [[nodiscard]]
+    u32 node_span(u32 level) const {
+        return _settings.tile_cells << level;
+    }
+
+    void build_tree(size_t idx, size_t& next) {
+        auto& node = _nodes[idx];
+        if (node.level == 0)
+            return;
+
+        auto half     = node_span(node.level - 1);
+        node.children = u32(next);
+        next += 4;
+
+        for (u32 i = 0; i < 4; ++i) {
+            auto& child = _nodes[node.children + i];
+            child.level = node.level - 1;
+            child.first = node.first + vec2u{i % 2, i / 2} * half;
+        }
+        for (u32 i = 0; i < 4; ++i)
+            build_tree(node.children + i, next);
+    }
+
+    /*
+     * Updates height ranges and AABBs of nodes around changed vertices [min, max) and marks them dirty. Normals of
+     * the node depend on heights one node step away from its vertices
+     */
+    void update_nodes(u32 idx, const vec2u& min, const vec2u& max) {
+        auto& node = _nodes[idx];
+        auto  step = i64(1) << node.level;
+        auto  last = node.first + vec2u::filled_with(node_span(node.level));
+
+        for (size_t i = 0; i < 2; ++i)
+            if (i64(min.v[i]) > i64(last.v[i]) + step || i64(max.v[i]) <= i64(node.first.v[i]) - step)
+                return;
+
+        node.dirty = true;
+
+        if (node.children == no_children) {
+            node.min_height = core::numlim<float>::max();
+            node.max_height = core::numlim<float>::lowest();
+            for (auto y = node.first.y(); y <= last.y(); ++y) {
+                auto row = _heights.data() + size_t(y) * _grid.x();
+                for (auto x = node.first.x(); x <= last.x(); ++x) {
+                    node.min_height = std::min(node.min_height, row[x]);
+                    node.max_height = std::max(node.max_height, row[x]);
+                }
+            }
+        }
+        else {
+            node.min_height = core::numlim<float>::max();
+            node.max_height = core::numlim<float>::lowest();
+            for (u32 i = 0; i < 4; ++i) {
+                update_nodes(node.children + i, min, max);
+                node.min_height = std::min(node.min_height, _nodes[node.children + i].min_height);
+                node.max_height = std::max(node.max_height, _nodes[node.children + i].max_height);
+            }
+        }
+
+        auto cell = cell_size();
+        auto from = vec2f(node.first) * cell;
+        auto to   = vec2f(last) * cell;
+
+        node.aabb = grx_aabb{{from.x(), node.min_height - skirt_depth(node), from.y()},
+                             {to.x(), node.max_height, to.y()}};
+        node.aabb_proxy.aabb() = grx::grx_aabb_fast(node.aabb);
+    }
+
+    /* Cracks between nodes of different levels are not deeper than the height range of the node */
+    [[nodiscard]]
+    float skirt_depth(const node_t& node) const {
+        auto cell = cell_size();
+        return node.max_height - node.min_height + float(1U << node.level) * std::min(cell.x(), cell.y());
+    }
+
+    [[nodiscard]]
+    float height(i64 x, i64 y) const {
+        return _heights[size_t(y) * _grid.x() + size_t(x)];
+    }
+
+    void build_mesh(node_t& node) {
+        auto cells = _settings.tile_cells;
+        auto side  = cells + 1;
+        auto step  = i64(1) << node.level;
+        auto cell  = cell_size();
+        auto uv_f  = vec2f{1.f, 1.f} / vec2f(_grid - vec2u{1, 1});
+        auto depth = skirt_depth(node);
+
+        grx::vbo_vector_indices indices;
+        grx::vbo_vector_vec3f   positions;
+        grx::vbo_vector_vec2f   uvs;
+        grx::vbo_vector_vec3f   normals;
+        grx::vbo_vector_vec3f   tangents;
+        grx::vbo_vector_vec3f   bitangents;
+
+        auto vertices_count = size_t(side) * side + size_t(cells) * 4;
+        positions.reserve(vertices_count);
+        uvs.reserve(vertices_count);
+        normals.reserve(vertices_count);
+        tangents.reserve(vertices_count);
+        bitangents.reserve(vertices_count);
+        indices.reserve(size_t(cells) * cells * 6 + size_t(cells) * 4 * 6);
+
+        /* Slopes are central differences with the node step, so normals match on borders of nodes of the level */
+        for (auto [x, y] : dimensional_seq(vec2u{side, side})) {
+            auto gx = i64(node.first.x()) + i64(x) * step;
+            auto gy = i64(node.first.y()) + i64(y) * step;
+            auto x1 = std::max<i64>(gx - step, 0);
+            auto x2 = std::min<i64>(gx + step, i64(_grid.x()) - 1);
+            auto y1 = std::max<i64>(gy - step, 0);
+            auto y2 = std::min<i64>(gy + step, i64(_grid.y()) - 1);
+
+            auto dhdx = (height(x2, gy) - height(x1, gy)) / (float(x2 - x1) * cell.x());
+            auto dhdz = (height(gx, y2) - height(gx, y1)) / (float(y2 - y1) * cell.y());
+
+            positions.push_back(vec{float(gx) * cell.x(), height(gx, gy), float(gy) * cell.y()});
+            uvs.push_back(vec{float(gx), float(gy)} * uv_f);
+            normals.push_back(vec{-dhdx, 1.f, -dhdz}.normalize());
+            tangents.push_back(vec{1.f, dhdx, 0.f}.normalize());
+            bitangents.push_back(vec{0.f, dhdz, 1.f}.normalize());
+        }
+
+        /* The same winding as faces of terrain_editor */
+        for (auto [x, y] : dimensional_seq(vec2u{cells, cells})) {
+            auto a = y * side + x;
+            for (auto i : {a, a + side, a + 1, a + 1, a + side, a + side + 1})
+                indices.push_back(i);
+        }
+
+        /* Skirts go around the border, faces of the border segment from p0 to p1 look outside */
+        vector<u32> border;
+        for (u32 x = 0; x < cells; ++x)
+            border.push_back(x);
+        for (u32 y = 0; y < cells; ++y)
+            border.push_back(y * side + cells);
+        for (u32 x = cells; x > 0; --x)
+            border.push_back(cells * side + x);
+        for (u32 y = cells; y > 0; --y)
+            border.push_back(y * side);
+
+        auto skirt = u32(positions.size());
+        for (auto top : border) {
+            positions.push_back(positions[top] - vec{0.f, depth, 0.f});
+            uvs.push_back(uvs[top]);
+            normals.push_back(normals[top]);
+            tangents.push_back(tangents[top]);
+            bitangents.push_back(bitangents[top]);
+        }
+
+        for (u32 i = 0; i < border.size(); ++i) {
+            auto j = (i + 1) % u32(border.size());
+            for (auto idx : {border[i], border[j], skirt + i, border[j], skirt + j, skirt + i})
+                indices.push_back(idx);
+        }
+
+        auto indices_count = u32(indices.size());
+        node.mesh.set<mesh_buf_tag::index>(move(indices));
+        node.mesh.set<mesh_buf_tag::position>(move(positions));
+        node.mesh.set<mesh_buf_tag::uv>(move(uvs));
+        node.mesh.set<mesh_buf_tag::normal>(move(normals));
+        node.mesh.set<mesh_buf_tag::tangent>(move(tangents));
+        node.mesh.set<mesh_buf_tag::bitangent>(move(bitangents));
+        node.mesh.elements({grx::grx_mesh_element{indices_count, u32(vertices_count), 0, 0, node.aabb}});
+
+        ++node.generation;
+        node.dirty = false;
+    }
+
+    [[nodiscard]]
+    float distance_2(const grx_aabb& aabb, const vec3f& point) const {
+        auto nearest = vec{std::clamp(point.x(), aabb.min.x(), aabb.max.x()),
+                           std::clamp(point.y(), aabb.min.y(), aabb.max.y()),
+                           std::clamp(point.z(), aabb.min.z(), aabb.max.z())};
+        return (point - nearest).magnitude_2();
+    }
+
+    void select(u32 idx, const vec3f& camera, bool cull, frustum_bits tested_bits, vector<u32>& result) const {
+        auto& node = _nodes[idx];
+        if (cull && !node.aabb_proxy.is_visible(tested_bits))
+            return;
+
+        auto range = node.level > 0 ? lod_range(node.level - 1) : 0.f;
+        if (node.children == no_children || distance_2(node.aabb, camera) > range * range) {
+            result.push_back(idx);
+            return;
+        }
+
+        for (u32 i = 0; i < 4; ++i)
+            select(node.children + i, camera, cull, tested_bits, result);
+    }
+
+    vector<float>             _heights;
+    terrain_quadtree_settings _settings;
+    vec2f                     _size;
+    vec2u                     _grid;
+    vector<node_t>            _nodes;
+};
+} // namespace prc
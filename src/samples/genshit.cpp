@@ -1,8 +1,5 @@
 #include <core/main.cpp>
-#include <core/container_extensions.hpp>
-#include <graphics/grx_color_map.hpp>
-#include <graphics/grx_shader.hpp>
-#include <graphics/grx_window.hpp>
+#include <graphics/grx_patch_match.hpp>
 
 using namespace core;
 using namespace grx;
@@ -15,44 +12,43 @@ auto load_image(const string& path, uint bs) {
 
 int pe_main(args_view args) {
     if (args.get("--help")) {
-        printline("Usage:\n{} [--quad=N]/[-q N] [path/to/source/image]"
-                  " [path/to/sample/image]", args.program_name());
+        printline("Usage:\n{} [--quad=N]/[-q N] [--approx=QUALITY]/[-a QUALITY] [--compare]"
+                  " [path/to/source/image] [path/to/sample/image]\n"
+                  "  --approx  - the approximate search with the quality from 0 (fastest) to 1\n"
+                  "  --compare - prints the error of the approximate search relative to the exhaustive one",
+                  args.program_name());
         return 0;
     }
 
-    auto bs    = args.by_key_default<uint>({"--quad", "-q"}, 16);
-    auto path1 = args.next("Missing path to source image");
-    auto path2 = args.next("Missing path to sample image");
+    auto bs      = args.by_key_default<uint>({"--quad", "-q"}, 16);
+    auto quality = args.by_key_opt<float>({"--approx", "-a"});
+    auto compare = args.get("--compare");
+    auto path1   = args.next("Missing path to source image");
+    auto path2   = args.next("Missing path to sample image");
     args.require_end();
 
     auto img1 = load_image(path1, bs);
     auto img2 = load_image(path2, bs);
 
-    for (auto src_pos : dimensional_seq(img1.size() / bs)) {
-        auto src_start = src_pos * bs;
-        auto best_cnv  = numlim<int>::max();
-        auto best_pos  = vec{0U, 0U};
-
-        printfl("\r{}/{}", src_pos, img1.size() / bs);
-        for (auto smp_pos : dimensional_seq(img2.size() / bs)) {
-            int cnv = 0;
-            auto smp_start = smp_pos * bs;
-            for (auto bs_pos : dimensional_seq(vec{bs, bs})) {
-                auto result = abs(img2[smp_start + bs_pos].get() -
-                        img1[src_start + bs_pos].get());
-                cnv += result.x() + result.y() + result.z();
-            }
-            if (cnv < best_cnv) {
-                best_cnv = cnv;
-                best_pos = smp_start;
-            }
-        }
-        for (auto bs_pos : dimensional_seq(vec{bs, bs}))
-            img1[src_start + bs_pos] = img2[best_pos + bs_pos].get();
+    auto settings       = util::patch_match_settings{};
+    settings.block_size = bs;
+
+    optional<util::patch_match_approx_settings> approx;
+    if (quality) {
+        approx          = util::patch_match_approx_settings{};
+        approx->quality = *quality;
+    }
+
+    if (approx && compare) {
+        auto exact = grx_patch_match(img1, img2, settings);
+        auto found = grx_patch_match_approx(img1, img2, settings, *approx);
+        printline("Relative error: {}%", util::patch_match_relative_error(found, exact) * 100.0); // NOLINT
     }
 
+    auto result = grx_patch_mosaic(img1, img2, settings, approx);
+    printline("Mean block error: {}", result.total_error() / std::max<size_t>(result.errors.size(), 1));
+
     save_color_map(img1, path1 + ".edit.jpg");
 
     return 0;
 }
-
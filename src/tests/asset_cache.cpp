@@ -0,0 +1,107 @@
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <core/files.hpp>
+#include <core/serialization.hpp>
+#include <util/asset_cache.hpp>
+
+using namespace core;
+using namespace util;
+
+TEST_CASE("Asset cache") {
+    auto dir = std::filesystem::temp_directory_path() / "pengine_asset_cache_test";
+    std::filesystem::remove_all(dir);
+
+    serializer s;
+    s.write(vector<u32>(1000, 228), string("payload")); // NOLINT
+    auto payload = s.detach_data();
+
+    SECTION("key depends on source, importer and version") {
+        auto key = asset_cache::make_key("source", "importer", 1);
+        REQUIRE(key == asset_cache::make_key("source", "importer", 1));
+        REQUIRE(key != asset_cache::make_key("source2", "importer", 1));
+        REQUIRE(key != asset_cache::make_key("source", "importer2", 1));
+        REQUIRE(key != asset_cache::make_key("source", "importer", 2));
+    }
+
+    SECTION("store and load") {
+        for (bool compress : {true, false}) {
+            auto cache = asset_cache(dir.string(), asset_cache_settings{.compress = compress});
+            auto key   = asset_cache::make_key("source", "importer", 1);
+
+            REQUIRE_FALSE(cache.try_load(key));
+            REQUIRE(cache.store(key, payload));
+
+            auto loaded = cache.try_load(key);
+            REQUIRE(loaded);
+            REQUIRE(*loaded == payload);
+
+            cache.remove(key);
+            REQUIRE_FALSE(cache.try_load(key));
+        }
+    }
+
+    SECTION("directory is evaluated once") {
+        /* Entries are stored and looked up in the same evaluated directory */
+        auto cache = asset_cache((dir / "nested" / "..").string() + "/");
+        auto key   = asset_cache::make_key("source", "importer", 1);
+        REQUIRE(cache.store(key, payload));
+
+        REQUIRE(cache.entry_path(key).find("..") == string::npos);
+        REQUIRE(std::filesystem::exists(dir / std::filesystem::path(cache.entry_path(key)).filename()));
+        REQUIRE(cache.try_load(key));
+    }
+
+    SECTION("broken entry") {
+        auto cache = asset_cache(dir.string());
+        auto key   = asset_cache::make_key("source", "importer", 1);
+        REQUIRE(cache.store(key, payload));
+
+        auto bytes = read_binary_file(cache.entry_path(key));
+        bytes.resize(bytes.size() / 2);
+        write_file(cache.entry_path(key), bytes);
+
+        REQUIRE_FALSE(cache.try_load(key));
+    }
+
+    SECTION("garbage collection") {
+        auto settings           = asset_cache_settings{};
+        settings.compress       = false;
+        settings.max_total_size = payload.size() * 2 + asset_cache::header_size * 2;
+
+        auto cache = asset_cache(dir.string(), settings);
+
+        auto key1 = asset_cache::make_key("source1", "importer", 1);
+        auto key2 = asset_cache::make_key("source2", "importer", 1);
+        auto key3 = asset_cache::make_key("source3", "importer", 1);
+        REQUIRE(cache.store(key1, payload));
+        REQUIRE(cache.store(key2, payload));
+        REQUIRE(cache.store(key3, payload));
+
+        auto now = std::filesystem::file_time_type::clock::now();
+        std::filesystem::last_write_time(cache.entry_path(key1), now - std::chrono::minutes(2));
+        std::filesystem::last_write_time(cache.entry_path(key2), now - std::chrono::minutes(1));
+
+        write_file((dir / "garbage").string() + string(asset_cache::entry_extension), "not an entry");
+
+        auto stats = cache.collect_garbage();
+        REQUIRE(stats.removed_entries == 2);
+        REQUIRE(stats.kept_entries == 2);
+        REQUIRE_FALSE(cache.try_load(key1));
+        REQUIRE(cache.try_load(key2));
+        REQUIRE(cache.try_load(key3));
+
+        settings.max_age = std::chrono::seconds(0);
+        std::filesystem::last_write_time(cache.entry_path(key2), now - std::chrono::minutes(1));
+        REQUIRE(asset_cache(dir.string(), settings).collect_garbage().removed_entries >= 1);
+        REQUIRE_FALSE(cache.try_load(key2));
+    }
+
+    SECTION("disabled cache") {
+        auto cache = asset_cache();
+        auto key   = asset_cache::make_key("source", "importer", 1);
+        REQUIRE_FALSE(cache.store(key, payload));
+        REQUIRE_FALSE(cache.try_load(key));
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,134 @@
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <random>
+#include <core/files.hpp>
+#include <util/asset_pack.hpp>
+
+using namespace core;
+using namespace util;
+
+TEST_CASE("Asset pack") {
+    auto dir = std::filesystem::temp_directory_path() / "pengine_asset_pack_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    auto pack_path = (dir / "test.pepk").string();
+
+    auto compressible = vector<byte>(100000, byte(42)); // NOLINT
+
+    auto random = vector<byte>(5000); // NOLINT
+    auto gen    = std::mt19937(228); // NOLINT
+    for (auto& b : random)
+        b = static_cast<byte>(gen());
+
+    write_file((dir / "file.txt").string(), "text file");
+
+    asset_pack_builder builder;
+    builder.add("models/compressible.bin", compressible);
+    builder.add("models/random.bin", random);
+    builder.add("models/stored.bin", compressible, false);
+    builder.add("empty", {});
+    builder.add_file("textures/file.txt", (dir / "file.txt").string());
+    builder.write(pack_path);
+
+    SECTION("duplicated entries") {
+        REQUIRE_THROWS(builder.add("empty", {}));
+    }
+
+    SECTION("read entries") {
+        auto pack = asset_pack(pack_path);
+        REQUIRE(pack.entries().size() == 5);
+
+        auto compressed = pack.find("models/compressible.bin");
+        REQUIRE(compressed);
+        REQUIRE(compressed->flags & asset_pack::entry_compressed);
+        REQUIRE(compressed->stored_size < compressed->raw_size);
+        REQUIRE(*pack.try_read("models/compressible.bin") == compressible);
+        REQUIRE_FALSE(pack.try_view("models/compressible.bin"));
+
+        /* Incompressible data is stored as is */
+        auto random_entry = pack.find("models/random.bin");
+        REQUIRE(random_entry);
+        REQUIRE_FALSE(random_entry->flags & asset_pack::entry_compressed);
+
+        auto view = pack.try_view("models/random.bin");
+        REQUIRE(view);
+        REQUIRE(vector<byte>(view->begin(), view->end()) == random);
+        REQUIRE(reinterpret_cast<uintptr_t>(view->data()) % asset_pack::page_size == 0); // NOLINT
+
+        REQUIRE(*pack.try_read("models/stored.bin") == compressible);
+        REQUIRE(pack.try_view("models/stored.bin"));
+        REQUIRE(pack.try_read("empty")->empty());
+
+        auto text = pack.try_read("textures/file.txt");
+        REQUIRE(text);
+        REQUIRE(string(reinterpret_cast<const char*>(text->data()), text->size()) == "text file"); // NOLINT
+
+        REQUIRE_FALSE(pack.find("models/missing.bin"));
+        REQUIRE_FALSE(pack.try_read("models"));
+        REQUIRE_FALSE(pack.try_read("random.bin"));
+    }
+
+    SECTION("invalid pack") {
+        write_file((dir / "invalid.pepk").string(), "not a pack");
+        REQUIRE_THROWS(asset_pack((dir / "invalid.pepk").string()));
+        REQUIRE_THROWS(asset_pack((dir / "missing.pepk").string()));
+    }
+
+    SECTION("mounts") {
+        auto override_path = (dir / "override.pepk").string();
+        asset_pack_builder override_builder;
+        override_builder.add("random.bin", compressible);
+        override_builder.write(override_path);
+
+        asset_pack_mounts mounts;
+        mounts.mount(pack_path, "gamedata");
+        REQUIRE(mounts.size() == 1);
+
+        auto data = mounts.try_read("gamedata/models/random.bin");
+        REQUIRE(data);
+        REQUIRE(data->is_mapped());
+        REQUIRE(vector<byte>(data->bytes().begin(), data->bytes().end()) == random);
+
+        auto decompressed = mounts.try_read("gamedata/models/compressible.bin");
+        REQUIRE(decompressed);
+        REQUIRE_FALSE(decompressed->is_mapped());
+        REQUIRE(vector<byte>(decompressed->bytes().begin(), decompressed->bytes().end()) == compressible);
+
+        REQUIRE_FALSE(mounts.try_read("models/random.bin"));
+        REQUIRE(mounts.try_read("gamedata/textures/file.txt")->str() == "text file");
+
+        /* Packs mounted later take precedence */
+        mounts.mount(override_path, "gamedata/models/");
+        auto overridden = mounts.try_read("gamedata/models/random.bin");
+        REQUIRE(vector<byte>(overridden->bytes().begin(), overridden->bytes().end()) == compressible);
+
+        /* Data stays valid after unmount */
+        REQUIRE(mounts.unmount(pack_path));
+        REQUIRE_FALSE(mounts.unmount(pack_path));
+        REQUIRE_FALSE(mounts.try_read("gamedata/textures/file.txt"));
+        REQUIRE(vector<byte>(data->bytes().begin(), data->bytes().end()) == random);
+    }
+
+    SECTION("mapped files") {
+        /* No packs are mounted, files are mapped as a whole */
+        auto data = try_map_asset((dir / "file.txt").string());
+        REQUIRE(data);
+        REQUIRE(data->is_mapped());
+        REQUIRE(data->str() == "text file");
+
+        /* Mapping outlives moves */
+        auto moved = move(*data);
+        REQUIRE(moved.str() == "text file");
+
+        write_file((dir / "empty.txt").string(), "");
+        auto empty = try_map_asset((dir / "empty.txt").string());
+        REQUIRE(empty);
+        REQUIRE_FALSE(empty->is_mapped());
+        REQUIRE(empty->bytes().empty());
+
+        REQUIRE_FALSE(try_map_asset((dir / "missing.txt").string()));
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -64,5 +64,23 @@ TEST_CASE("async") {
         }
         REQUIRE(except);
     }
+
+    SECTION("fiber pools") {
+        /* Pools of one thread don't use work_stealing and may coexist with the global pool */
+        auto serial = fiber_pool(1);
+        REQUIRE(serial.submit([] { return 1; }).get() == 1);
+        serial.close();
+
+        /* Only one pool of several threads may exist */
+        if (global_fiber_pool().threads_count() > 1) {
+            REQUIRE_THROWS(fiber_pool(2));
+        }
+        else {
+            auto pool = fiber_pool(2);
+            REQUIRE_THROWS(fiber_pool(2));
+            REQUIRE(pool.submit([] { return 2; }).get() == 2);
+            pool.close();
+        }
+    }
 }
 
@@ -0,0 +1,106 @@
+#include <catch2/catch.hpp>
+#include <util/atlas_packer.hpp>
+#include <random>
+
+using namespace core;
+using namespace util;
+
+namespace {
+vector<vec2u> random_sizes(size_t count, u32 min_size, u32 max_size, u32 seed) {
+    std::mt19937                       gen(seed);
+    std::uniform_int_distribution<u32> dist(min_size, max_size);
+
+    vector<vec2u> sizes(count);
+    for (auto& size : sizes)
+        size = {dist(gen), dist(gen)};
+    return sizes;
+}
+
+bool overlaps(vec2u a_pos, vec2u a_size, vec2u b_pos, vec2u b_size) {
+    return a_pos.x() < b_pos.x() + b_size.x() && b_pos.x() < a_pos.x() + a_size.x() &&
+           a_pos.y() < b_pos.y() + b_size.y() && b_pos.y() < a_pos.y() + a_size.y();
+}
+} // namespace
+
+TEST_CASE("Atlas packer") {
+    SECTION("maxrects fills the area") {
+        auto packer = maxrects_packer({64, 64});
+        for (u32 i = 0; i < 16; ++i) // NOLINT
+            REQUIRE(packer.insert({16, 16}));
+
+        REQUIRE(packer.occupancy() == Approx(1.0));
+        REQUIRE_FALSE(packer.insert({1, 1}));
+
+        auto other = maxrects_packer({64, 32});
+        REQUIRE(other.insert({40, 32}) == vec2u{0, 0});
+        REQUIRE(other.insert({24, 20}) == vec2u{40, 0});
+        REQUIRE(other.insert({24, 12}) == vec2u{40, 20});
+        REQUIRE_FALSE(other.insert({1, 1}));
+    }
+
+    SECTION("packing efficiency") {
+        auto settings       = atlas_settings{};
+        settings.page_size  = {1024, 1024}; // NOLINT
+        settings.padding    = 0;
+        settings.mip_safe_levels = 0;
+
+        auto sizes  = random_sizes(200, 16, 96, 1); // NOLINT
+        auto layout = atlas_pack(sizes, settings);
+
+        REQUIRE(layout.placements.size() == sizes.size());
+        REQUIRE(layout.efficiency() > 0.85); // NOLINT
+    }
+
+    SECTION("gutters and alignment") {
+        auto settings      = atlas_settings{};
+        settings.page_size = {512, 512}; // NOLINT
+
+        auto sizes  = random_sizes(150, 8, 100, 2); // NOLINT
+        auto layout = atlas_pack(sizes, settings);
+        auto gutter = settings.gutter();
+
+        REQUIRE(gutter == 8);
+        REQUIRE(layout.gutter == gutter);
+        REQUIRE(layout.pages.size() > 1);
+        REQUIRE(layout.efficiency() > 0.5); // NOLINT
+
+        for (auto& page : layout.pages) {
+            REQUIRE(page.x() <= 512);
+            REQUIRE(page.y() <= 512);
+            REQUIRE(page.x() % settings.alignment() == 0);
+            REQUIRE(page.y() % settings.alignment() == 0);
+        }
+
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            auto& p = layout.placements[i];
+            REQUIRE(p.size == sizes[i]);
+
+            /* Slots with gutters are aligned and lie inside the page */
+            auto slot_pos = p.pos - vec2u{gutter, gutter};
+            REQUIRE(p.pos.x() >= gutter);
+            REQUIRE(p.pos.y() >= gutter);
+            REQUIRE(slot_pos.x() % settings.alignment() == 0);
+            REQUIRE(slot_pos.y() % settings.alignment() == 0);
+            REQUIRE(p.pos.x() + p.size.x() + gutter <= layout.pages[p.page].x());
+            REQUIRE(p.pos.y() + p.size.y() + gutter <= layout.pages[p.page].y());
+
+            /* Gutters of neighbouring images don't overlap */
+            auto slot_size = p.size + vec2u{2 * gutter, 2 * gutter};
+            for (size_t j = i + 1; j < sizes.size(); ++j) {
+                auto& q = layout.placements[j];
+                if (q.page == p.page)
+                    REQUIRE_FALSE(overlaps(
+                        slot_pos, slot_size, q.pos - vec2u{gutter, gutter}, q.size + vec2u{2 * gutter, 2 * gutter}));
+            }
+        }
+    }
+
+    SECTION("invalid sizes") {
+        auto settings      = atlas_settings{};
+        settings.page_size = {128, 128}; // NOLINT
+
+        REQUIRE_THROWS(atlas_pack(array{vec2u{120, 16}}, settings));
+        REQUIRE(atlas_pack(array{vec2u{112, 16}}, settings).pages.front() == vec2u{128, 32});
+        REQUIRE(atlas_pack(span<const vec2u>(), settings).pages.empty());
+    }
+}
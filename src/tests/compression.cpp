@@ -1,7 +1,14 @@
 #include <catch2/catch.hpp>
+#include <core/fiber_pool.hpp>
+#include <core/scope_guard.hpp>
 #include <core/serialization.hpp>
 #include <core/print.hpp>
+#include <util/codec.hpp>
 #include <util/compression.hpp>
+#include <util/seekable_compression.hpp>
+#include <random>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace core;
 using namespace util;
@@ -40,4 +47,341 @@ TEST_CASE("Compression") {
 
         data += data;
     }
+
+    /* Blocks must end exactly within the output */
+    vector<byte> raw(data.size());
+    std::memcpy(raw.data(), data.data(), raw.size());
+
+    auto deflated  = compress_block(raw);
+    auto truncated = span<const byte>(deflated).subspan(0, static_cast<ssize_t>(deflated.size() / 2));
+    REQUIRE(decompress_block(deflated, raw.size() * 2) == raw);
+    REQUIRE_THROWS(decompress_block(deflated, raw.size() - 1));
+    REQUIRE_THROWS(decompress_block(truncated, raw.size()));
+}
+
+TEST_CASE("Parallel compression") {
+    auto& pool = global_fiber_pool();
+
+    /* Compressible text followed by random bytes */
+    vector<byte> data;
+    auto         gen = std::mt19937(1337); // NOLINT
+    for (size_t i = 0; i < 300000; ++i) // NOLINT
+        data.push_back(static_cast<byte>("pengine "[i % 8]));
+    for (size_t i = 0; i < 200000; ++i) // NOLINT
+        data.push_back(static_cast<byte>(gen()));
+
+    for (int level : {COMPRESS_DEFAULT, 0, COMPRESS_FAST, 5, COMPRESS_BEST}) { // NOLINT
+        u64  last_progress = 0;
+        auto compressed    = compress_parallel(data, level, 65536, [&](u64 count, u64 max) { // NOLINT
+            REQUIRE(max == data.size());
+            REQUIRE(count > last_progress);
+            last_progress = count;
+        }, &pool);
+
+        REQUIRE(last_progress == data.size());
+        REQUIRE(is_block_compressed(compressed));
+        REQUIRE_FALSE(is_block_compressed(compress(data, level)));
+        REQUIRE(decompress_parallel(compressed, {}, &pool) == data);
+    }
+
+    /* Higher levels are not clamped to the fast one anymore */
+    REQUIRE(compress_level_clamp(COMPRESS_BEST) == COMPRESS_BEST);
+    REQUIRE(compress_level_clamp(100) == COMPRESS_BEST); // NOLINT
+    REQUIRE(compress_level_clamp(-100) == COMPRESS_DEFAULT); // NOLINT
+
+    /* Blocks are independent gzip streams */
+    auto one_block = compress_parallel(data, COMPRESS_FAST, data.size(), {}, &pool);
+    auto header    = 4 + 4 + 8 * 3 + 8;
+    REQUIRE(decompress(span<const byte>(one_block).subspan(header)) == data);
+
+    auto empty = compress_parallel(vector<byte>(), COMPRESS_FAST, 1024, {}, &pool); // NOLINT
+    REQUIRE(decompress_parallel(empty, {}, &pool).empty());
+
+    /* Broken block index */
+    auto broken = compress_parallel(data, COMPRESS_FAST, 65536, {}, &pool); // NOLINT
+    broken[4 + 4 + 8 * 3] = byte(1);
+    REQUIRE_THROWS(decompress_parallel(broken, {}, &pool));
+
+    /* Raw size which can't be produced by the payload is rejected before the allocation */
+    auto huge      = one_block;
+    u64  huge_size = u64(1) << 40U;
+    std::memcpy(huge.data() + 8, &huge_size, sizeof(huge_size));  // NOLINT
+    std::memcpy(huge.data() + 16, &huge_size, sizeof(huge_size)); // NOLINT
+    REQUIRE_THROWS(decompress_parallel(huge, {}, &pool));
+}
+
+TEST_CASE("Codecs") {
+    auto gen = std::mt19937(228); // NOLINT
+
+    vector<vector<byte>> inputs(5); // NOLINT
+    /* inputs[0] is empty */
+    inputs[1] = {byte(1), byte(2), byte(3)};
+    for (size_t i = 0; i < 100000; ++i) // NOLINT
+        inputs[2].push_back(static_cast<byte>("the quick brown fox "[(i * 7 / 5) % 20])); // NOLINT
+    for (size_t i = 0; i < 70000; ++i) // NOLINT
+        inputs[3].push_back(static_cast<byte>(gen()));
+    /* Runs and short repeats exercise overlapped matches */
+    for (size_t i = 0; i < 50000; ++i) // NOLINT
+        inputs[4].push_back(static_cast<byte>(i % 1000 < 500 ? 0 : (i / 3) % 7)); // NOLINT
+
+    for (auto id : {codec_id::store, codec_id::zlib, codec_id::lz}) {
+        auto& codec = get_codec(id);
+        REQUIRE(codec.id() == id);
+
+        for (auto& input : inputs) {
+            auto frame = compress_frame(input, {id, COMPRESS_DEFAULT});
+            REQUIRE(is_codec_frame(frame));
+            REQUIRE(codec_frame_raw_size(frame) == input.size());
+            REQUIRE(decompress_frame(frame) == input);
+            REQUIRE(decompress(frame) == input);
+
+            vector<byte> output(input.size());
+            decompress_frame(frame, output);
+            REQUIRE(output == input);
+
+            vector<byte> wrong_size(input.size() + 1);
+            REQUIRE_THROWS(decompress_frame(frame, wrong_size));
+        }
+
+        /* The raw size in the header is bounded by the payload before the allocation */
+        auto huge      = compress_frame(inputs[1], {id, COMPRESS_DEFAULT});
+        u64  huge_size = u64(1) << 40U;
+        std::memcpy(huge.data() + 5, &huge_size, sizeof(huge_size)); // NOLINT
+        REQUIRE_THROWS(codec_frame_raw_size(huge));
+        REQUIRE_THROWS(decompress_frame(huge));
+    }
+
+    /* LZ compresses repetitive data and doesn't expand random data much */
+    REQUIRE(get_codec(codec_id::lz).compress(inputs[2], COMPRESS_DEFAULT).size() < inputs[2].size() / 10);
+    REQUIRE(get_codec(codec_id::lz).compress(inputs[3], COMPRESS_DEFAULT).size() < inputs[3].size() + 512);
+
+    /* Corrupted LZ data never writes out of the buffer */
+    auto lz_data = get_codec(codec_id::lz).compress(inputs[4], COMPRESS_DEFAULT);
+    for (size_t i = 0; i < 200; ++i) { // NOLINT
+        auto broken = lz_data;
+        broken[gen() % broken.size()] = static_cast<byte>(gen());
+        broken.resize(broken.size() - gen() % 3);
+
+        vector<byte> output(inputs[4].size());
+        try {
+            get_codec(codec_id::lz).decompress(broken, output);
+        }
+        catch (const std::runtime_error&) {
+        }
+    }
+
+    REQUIRE_THROWS(decompress_frame(vector<byte>{byte('P'), byte('E'), byte('C'), byte('F'), byte(100)}));
+    REQUIRE(asset_codec("mesh").codec == codec_id::lz);
+    REQUIRE(asset_codec("some_unknown_asset").codec == codec_id::zlib);
+}
+
+TEST_CASE("Streaming compression") {
+    vector<byte> data;
+    auto         gen = std::mt19937(42); // NOLINT
+    for (size_t i = 0; i < 400000; ++i) // NOLINT
+        data.push_back(static_cast<byte>(i % 3000 < 2000 ? "stream "[i % 7] : static_cast<char>(gen()))); // NOLINT
+
+    SECTION("push and pull with small buffers") {
+        compressor   c(COMPRESS_BEST);
+        vector<byte> compressed;
+        array<byte, 100> buffer; // NOLINT
+
+        /* Input goes by uneven pieces */
+        size_t pushed = 0;
+        while (!c.done()) {
+            if (c.needs_input()) {
+                auto size = std::min<size_t>(data.size() - pushed, 777); // NOLINT
+                c.push(span<const byte>(data).subspan(static_cast<ptrdiff_t>(pushed), static_cast<ptrdiff_t>(size)),
+                       pushed + size == data.size());
+                pushed += size;
+            }
+            auto count = c.pull(buffer);
+            compressed.insert(compressed.end(), buffer.begin(), buffer.begin() + static_cast<ptrdiff_t>(count));
+        }
+
+        REQUIRE(c.total_in() == data.size());
+        REQUIRE(c.total_out() == compressed.size());
+        REQUIRE(decompress(compressed) == data);
+
+        decompressor d;
+        vector<byte> decompressed(data.size());
+        size_t       consumed = 0;
+        size_t       written  = 0;
+        while (!d.done()) {
+            if (d.needs_input()) {
+                auto size = std::min<size_t>(compressed.size() - consumed, 33); // NOLINT
+                REQUIRE(size > 0);
+                d.push(span<const byte>(compressed).subspan(static_cast<ptrdiff_t>(consumed),
+                                                            static_cast<ptrdiff_t>(size)));
+                consumed += size;
+            }
+            written += d.pull(span<byte>(decompressed).subspan(static_cast<ptrdiff_t>(written),
+                                                              std::min<ptrdiff_t>(1000, ssize_t(data.size() - written))));
+        }
+        REQUIRE(written == data.size());
+        REQUIRE(decompressed == data);
+
+        /* Truncated stream */
+        auto truncated = compressed;
+        truncated.resize(truncated.size() / 2);
+        REQUIRE_THROWS(decompress(truncated));
+    }
+
+    SECTION("empty input and crafted size hint") {
+        REQUIRE(decompress(vector<byte>()).empty());
+
+        /* The trailer claims ~4 GiB of output, the stream holds just a few bytes */
+        auto compressed = compress(span<const byte>(data).first(100), COMPRESS_FAST); // NOLINT
+        for (size_t i = compressed.size() - 4; i < compressed.size(); ++i)
+            compressed[i] = byte(0xff); // NOLINT
+        REQUIRE_THROWS(decompress(compressed));
+    }
+
+    SECTION("serializer sink") {
+        serializer s;
+        s.write(data, string("tail"));
+
+        byte_vector_sink     output;
+        compressing_sink     sink(output, COMPRESS_FAST, 1000); // NOLINT
+        streaming_serializer ss(sink, 4096); // NOLINT
+        ss.write(data, string("tail"));
+        ss.finish();
+
+        REQUIRE(sink.written() == output.data().size());
+        REQUIRE(decompress(output.data()) == s.data());
+    }
+
+    SECTION("file descriptors") {
+        char raw_path[] = "/tmp/pengine_compression_XXXXXX"; // NOLINT
+        char gz_path[]  = "/tmp/pengine_compression_XXXXXX"; // NOLINT
+        char out_path[] = "/tmp/pengine_compression_XXXXXX"; // NOLINT
+        int  raw_fd     = mkstemp(raw_path);
+        int  gz_fd      = mkstemp(gz_path);
+        int  out_fd     = mkstemp(out_path);
+        REQUIRE((raw_fd >= 0 && gz_fd >= 0 && out_fd >= 0));
+
+        auto scope_exit = scope_guard([&] {
+            ::close(raw_fd);
+            ::close(gz_fd);
+            ::close(out_fd);
+            ::unlink(raw_path);
+            ::unlink(gz_path);
+            ::unlink(out_path);
+        });
+
+        REQUIRE(::write(raw_fd, data.data(), data.size()) == ssize_t(data.size()));
+        ::lseek(raw_fd, 0, SEEK_SET);
+
+        auto compressed_size = compress_fd(raw_fd, gz_fd, COMPRESS_DEFAULT, 4096); // NOLINT
+        REQUIRE(::lseek(gz_fd, 0, SEEK_CUR) == ssize_t(compressed_size));
+
+        ::lseek(gz_fd, 0, SEEK_SET);
+        REQUIRE(decompress_fd(gz_fd, out_fd, 4096) == data.size()); // NOLINT
+
+        vector<byte> result(data.size());
+        ::lseek(out_fd, 0, SEEK_SET);
+        REQUIRE(::read(out_fd, result.data(), result.size()) == ssize_t(data.size()));
+        REQUIRE(result == data);
+
+        /* Known size goes straight into the caller buffer */
+        vector<byte> direct(data.size());
+        ::lseek(gz_fd, 0, SEEK_SET);
+        decompress_fd(gz_fd, direct, 1000); // NOLINT
+        REQUIRE(direct == data);
+
+        vector<byte> small(data.size() - 1);
+        ::lseek(gz_fd, 0, SEEK_SET);
+        REQUIRE_THROWS(decompress_fd(gz_fd, small));
+    }
+}
+
+TEST_CASE("Seekable compression") {
+    auto& pool = global_fiber_pool();
+
+    vector<byte> data;
+    auto         gen = std::mt19937(7); // NOLINT
+    for (size_t i = 0; i < 300000; ++i) // NOLINT
+        data.push_back(static_cast<byte>(i % 1000 < 700 ? "seekable"[i % 8] : static_cast<char>(gen()))); // NOLINT
+
+    constexpr size_t block_size = 4096;
+
+    for (auto codec : {codec_id::store, codec_id::zlib, codec_id::lz}) {
+        auto settings = codec_settings{codec, COMPRESS_FAST};
+
+        /* The writer and the parallel compression produce the same stream */
+        byte_vector_sink output;
+        seekable_writer  writer(output, settings, block_size);
+        for (size_t i = 0; i < data.size(); i += 1234) // NOLINT
+            writer.write(span<const byte>(data).subspan(static_cast<ptrdiff_t>(i),
+                                                        static_cast<ptrdiff_t>(std::min<size_t>(1234, data.size() - i))));
+        writer.finish();
+
+        auto compressed = compress_seekable(data, settings, block_size, &pool);
+        REQUIRE(output.data() == compressed);
+        REQUIRE(writer.written() == compressed.size());
+        REQUIRE(is_seekable_compressed(compressed));
+        REQUIRE_FALSE(is_seekable_compressed(compress(data)));
+
+        seekable_reader reader(compressed);
+        REQUIRE(reader.codec() == codec);
+        REQUIRE(reader.raw_size() == data.size());
+        REQUIRE(reader.blocks_count() == (data.size() + block_size - 1) / block_size);
+        REQUIRE(reader.read_all(&pool) == data);
+
+        auto expected = [&](size_t offset, size_t size) {
+            return vector<byte>(data.begin() + static_cast<ptrdiff_t>(offset),
+                                data.begin() + static_cast<ptrdiff_t>(offset + size));
+        };
+
+        /* Ranges inside one block, across block boundaries, whole blocks and the tail */
+        for (auto [offset, size] : {std::pair<size_t, size_t>{0, 0},
+                                    {10, 100},
+                                    {4000, 200},
+                                    {4096, 4096},
+                                    {5000, 20000},
+                                    {data.size() - 10, 10},
+                                    {0, data.size()}}) {
+            REQUIRE(reader.read(offset, size) == expected(offset, size));
+
+            vector<byte> parallel(size);
+            reader.read_parallel(offset, parallel, &pool);
+            REQUIRE(parallel == expected(offset, size));
+        }
+
+        REQUIRE_THROWS(reader.read(data.size() - 10, 11));
+        REQUIRE_THROWS(reader.read(data.size() + 1, 0));
+    }
+
+    /* Empty input */
+    auto empty = compress_seekable(vector<byte>(), {}, block_size, &pool);
+    REQUIRE(seekable_reader(empty).read_all(&pool).empty());
+
+    /* Broken offset table */
+    auto broken = compress_seekable(data, {codec_id::lz, COMPRESS_DEFAULT}, block_size, &pool);
+    broken[broken.size() - seekable_writer::trailer_size - 1] = byte(0xff); // NOLINT
+    REQUIRE_THROWS(seekable_reader(broken));
+
+    /* Raw size which wraps the block count computation */
+    auto wrapped = compress_seekable(vector<byte>(), {}, block_size, &pool);
+    u64  small_block = 2;
+    u64  huge_size   = std::numeric_limits<u64>::max();
+    std::memcpy(wrapped.data() + 9, &small_block, sizeof(small_block)); // NOLINT
+    std::memcpy(wrapped.data() + wrapped.size() - seekable_writer::trailer_size, &huge_size, sizeof(huge_size));
+    REQUIRE_THROWS(seekable_reader(wrapped));
+
+    /* Block and raw sizes which can't be produced by the compressed blocks */
+    auto tiny       = vector<byte>(100, byte(1)); // NOLINT
+    auto huge       = compress_seekable(tiny, {codec_id::lz, COMPRESS_DEFAULT}, block_size, &pool);
+    u64  huge_block = u64(1) << 40U;
+    std::memcpy(huge.data() + 9, &huge_block, sizeof(huge_block)); // NOLINT
+    std::memcpy(huge.data() + huge.size() - seekable_writer::trailer_size, &huge_block, sizeof(huge_block));
+    REQUIRE_THROWS(seekable_reader(huge));
+
+    /* Corrupted block fails only the reads which touch it */
+    auto corrupted = compress_seekable(data, {codec_id::lz, COMPRESS_DEFAULT}, block_size, &pool);
+    seekable_reader corrupted_reader(corrupted);
+    std::memset(const_cast<byte*>(corrupted_reader.compressed_block(1).data()), 0xff, 8); // NOLINT
+    REQUIRE(corrupted_reader.read(0, block_size) == vector<byte>(data.begin(), data.begin() + block_size));
+    REQUIRE_THROWS(corrupted_reader.read(block_size, 10));
+    REQUIRE_THROWS(corrupted_reader.read_all(&pool));
 }
@@ -67,6 +67,25 @@ TEST_CASE("For loop variations") {
         REQUIRE(str == "-2");
     }
 
+    SECTION("Dimensional sequence") {
+        std::string str;
+        for (auto [x, y] : dimensional_seq(vec2u{3, 2}))
+            str += std::to_string(x) + std::to_string(y) + ' ';
+        REQUIRE(str == "00 10 20 01 11 21 ");
+
+        str.clear();
+        for (auto [x, y] : dimensional_seq(vec2u{1, 2}, vec2u{3, 4}))
+            str += std::to_string(x) + std::to_string(y) + ' ';
+        REQUIRE(str == "12 22 13 23 ");
+
+        str.clear();
+        for (auto [x, y] : dimensional_seq(vec2u{2, 1}, vec2u{2, 4}))
+            str += std::to_string(x) + std::to_string(y) + ' ';
+        for (auto [x, y] : dimensional_seq(vec2u{0, 3}))
+            str += std::to_string(x) + std::to_string(y) + ' ';
+        REQUIRE(str.empty());
+    }
+
     SECTION("Value loop with index") {
         vector<size_t> v1(100);
         vector<size_t> v2(100);
@@ -0,0 +1,78 @@
+#include <catch2/catch.hpp>
+#include <graphics/grx_color_map.hpp>
+#include <util/compression.hpp>
+#include <cstring>
+#include "test_helpers.hpp"
+
+using namespace core;
+using namespace grx;
+using namespace test_helpers;
+
+TEST_CASE("Color map") {
+    SECTION("mipmap layout") {
+        REQUIRE(mipmap_size({37, 21}, 0) == vec2u{37, 21});
+        REQUIRE(mipmap_size({37, 21}, 1) == vec2u{18, 10});
+        REQUIRE(mipmap_size({37, 21}, 4) == vec2u{2, 2});
+        REQUIRE(mipmap_size({256, 4}, 3) == vec2u{32, 2});
+
+        auto map = grx_color_map_rgb({37, 21});
+        map.gen_mipmaps();
+
+        size_t offset = 0;
+        auto   view   = map.mipmap_view().begin();
+        for (u32 level = 0; level <= MIPMAPS_COUNT; ++level, ++view) {
+            REQUIRE((*view).size() == mipmap_size(map.size(), level));
+            REQUIRE((*view).data() == map.data() + offset);
+            offset += (*view).components_count();
+        }
+        REQUIRE(offset == grx_color_map_rgb::calc_compcount(map.size(), MIPMAPS_COUNT));
+    }
+
+    SECTION("petx round trip") {
+        auto image = random_image({37, 21}, 4, 1);
+        auto map   = grx_color_map_rgba(reinterpret_cast<uint8_t*>(image.data()), {37, 21}); // NOLINT
+        map.gen_mipmaps();
+
+        auto bytes = map.to_bytes();
+        REQUIRE(std::memcmp(bytes.data(), PETX_SIGNATURE.data(), 4) == 0);
+
+        auto loaded = grx_color_map_rgba::from_bytes(bytes);
+        REQUIRE(loaded.size() == map.size());
+        REQUIRE(loaded.mipmaps_count() == MIPMAPS_COUNT);
+        REQUIRE(std::memcmp(loaded.data(), map.data(), map.components_count()) == 0);
+
+        /* Levels are stored uncompressed unless asked */
+        auto view = util::petx_view(bytes);
+        REQUIRE_FALSE(view.level(0).flags & util::petx_view::level_compressed);
+
+        auto compressed = grx_color_map_rgba::from_bytes(map.to_bytes(true));
+        REQUIRE(std::memcmp(compressed.data(), map.data(), map.components_count()) == 0);
+
+        /* Unknown versions are rejected */
+        bytes[4] = byte(util::petx_view::format_version + 1);
+        REQUIRE_THROWS(grx_color_map_rgba::from_bytes(bytes));
+    }
+
+    SECTION("legacy petx keeps the largest level and regenerates mipmaps") {
+        auto size  = vec2u{16, 8};
+        auto image = random_image(size, 3, 2);
+
+        /* Mipmaps of legacy files were stored with other sizes, their contents are not used */
+        auto payload = vector<byte>(image.size() + 123, byte(7)); // NOLINT
+        std::memcpy(payload.data(), image.data(), image.size());
+
+        serializer s;
+        s.write(PETX_LEGACY_SIGNATURE);
+        s.write(u32(3));
+        s.write(vec<u32, 2>(size));
+        s.write(MIPMAPS_COUNT);
+        s.write(util::compress(payload));
+
+        auto loaded = grx_color_map_rgb::from_bytes(s.data());
+        auto expect = grx_color_map_rgb(reinterpret_cast<uint8_t*>(image.data()), size); // NOLINT
+        expect.gen_mipmaps();
+
+        REQUIRE(loaded.mipmaps_count() == MIPMAPS_COUNT);
+        REQUIRE(std::memcmp(loaded.data(), expect.data(), expect.components_count()) == 0);
+    }
+}
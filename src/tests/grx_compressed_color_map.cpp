@@ -0,0 +1,179 @@
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <core/files.hpp>
+#include <graphics/grx_compressed_color_map.hpp>
+#include <util/asset_pack.hpp>
+#include <util/petx_format.hpp>
+#include <util/vtf_format.hpp>
+#include "test_helpers.hpp"
+
+using namespace core;
+using namespace grx;
+using namespace util;
+using namespace test_helpers;
+
+namespace {
+vector<byte> random_levels(dxt_format format, vec2u size, u32 levels_count) {
+    size_t count = 0;
+    for (u32 i = 0; i < levels_count; ++i)
+        count += dxt_data_size(format, grx_compressed_color_map::level_size(size, i));
+    return random_bytes(count, size.x() * 131 + size.y() * 7 + u32(format));
+}
+
+/* Blocks of all levels one after another */
+vector<byte> all_levels(const grx_compressed_color_map& map) {
+    vector<byte> result;
+    for (u32 i = 0; i < map.levels_count(); ++i) {
+        auto level = map.level_data(i);
+        result.insert(result.end(), level.begin(), level.end());
+    }
+    return result;
+}
+} // namespace
+
+TEST_CASE("Compressed color map") {
+    SECTION("levels") {
+        REQUIRE(grx_compressed_color_map::max_levels_count({1, 1}) == 1);
+        REQUIRE(grx_compressed_color_map::max_levels_count({256, 64}) == 9);
+        REQUIRE(grx_compressed_color_map::max_levels_count({37, 21}) == 6);
+        REQUIRE(grx_compressed_color_map::level_size({37, 21}, 3) == vec2u{4, 2});
+        REQUIRE(grx_compressed_color_map::level_size({37, 21}, 5) == vec2u{1, 1});
+    }
+
+    SECTION("round trip") {
+        auto formats = {
+            dxt_format::dxt1, dxt_format::dxt1_onebitalpha, dxt_format::dxt3, dxt_format::dxt5, dxt_format::bc7};
+        auto sizes   = {vec2u{64, 64}, vec2u{37, 21}, vec2u{1, 7}, vec2u{256, 32}};
+
+        for (auto format : formats) {
+            for (auto size : sizes) {
+                INFO(magic_enum::enum_name(format) << " " << size.x() << "x" << size.y());
+
+                auto levels_count = grx_compressed_color_map::max_levels_count(size);
+                auto data         = random_levels(format, size, levels_count);
+                auto map          = grx_compressed_color_map(format, size, levels_count, data);
+
+                REQUIRE(map.channels_count() == (format == dxt_format::dxt1 ? 3U : 4U));
+                REQUIRE(map.has_mipmaps() == (levels_count > 1));
+
+                /* Blocks are kept as-is */
+                auto bytes = map.to_bytes();
+                REQUIRE(grx_compressed_color_map::is_compressed_petx(bytes));
+
+                auto loaded = grx_compressed_color_map::from_bytes(bytes);
+                REQUIRE(loaded.format() == format);
+                REQUIRE(loaded.size() == size);
+                REQUIRE(loaded.levels_count() == levels_count);
+                REQUIRE(all_levels(loaded) == data);
+
+                size_t offset = 0;
+                for (u32 i = 0; i < levels_count; ++i) {
+                    auto level      = loaded.level_data(i);
+                    auto level_size = loaded.level_size(i);
+                    REQUIRE(size_t(level.size()) == dxt_data_size(format, level_size));
+                    REQUIRE(std::memcmp(level.data(), data.data() + offset, size_t(level.size())) == 0);
+                    offset += size_t(level.size());
+
+                    /* The fallback decodes the same pixels as the decoder */
+                    vector<u8> decompressed(level_size.x() * level_size.y() * 4);
+                    vector<u8> reference(decompressed.size());
+                    loaded.decompress(i, decompressed.data());
+                    dxt_decode(format, level, level_size, reference.data());
+                    REQUIRE(decompressed == reference);
+                }
+            }
+        }
+    }
+
+    SECTION("vtf blocks") {
+        auto size   = vec2u{64, 32};
+        auto format = dxt_format::dxt5;
+        auto levels = random_levels(format, size, 5);
+        auto file   = make_vtf(vtf_image_format::DXT5, size, 5, levels);
+        auto vtf    = vtf_view(file);
+
+        REQUIRE(vtf.high_res_dxt_format() == format);
+
+        auto map = grx_compressed_color_map::from_vtf(vtf);
+        REQUIRE(map.size() == size);
+        REQUIRE(map.levels_count() == 5);
+        REQUIRE(all_levels(map) == levels);
+
+        vector<u8> decompressed(size.x() * size.y() * 4);
+        vector<u8> reference(decompressed.size());
+        map.decompress(0, decompressed.data());
+        vtf.read_high_res(reference.data());
+        REQUIRE(decompressed == reference);
+
+        REQUIRE_THROWS(vtf.high_res_mipmap_data(5));
+
+        auto rgba = make_vtf(vtf_image_format::RGBA8888, {4, 4}, 1, vector<byte>(64));
+        REQUIRE_FALSE(vtf_view(rgba).high_res_dxt_format());
+        REQUIRE_THROWS(grx_compressed_color_map::from_vtf(vtf_view(rgba)));
+    }
+
+    SECTION("invalid data") {
+        REQUIRE_THROWS(grx_compressed_color_map(dxt_format::dxt1, {8, 8}, 1, vector<byte>(31)));
+        REQUIRE_THROWS(grx_compressed_color_map(dxt_format::dxt1, {8, 8}, 5, vector<byte>(32 + 8 + 8 + 8 + 8)));
+        REQUIRE_THROWS(grx_compressed_color_map(dxt_format::dxt1, {0, 8}, 1, vector<byte>()));
+
+        auto bytes = grx_compressed_color_map(dxt_format::dxt3, {8, 8}, 1, vector<byte>(64)).to_bytes();
+        REQUIRE_THROWS(grx_compressed_color_map::from_bytes(span<const byte>(bytes).first(20)));
+        bytes[24] = byte(8); /* Levels count */
+        REQUIRE_THROWS(grx_compressed_color_map::from_bytes(bytes));
+
+        /* Color maps are not compressed */
+        auto pixels = vector<byte>(64);
+        auto level  = petx_level_data{{4, 4}, pixels};
+        REQUIRE_FALSE(grx_compressed_color_map::is_compressed_petx(petx_write(petx_pixels::u8, 4, {&level, 1})));
+    }
+
+    SECTION("mapped petx") {
+        auto dir = std::filesystem::temp_directory_path() / "pengine_compressed_color_map_test";
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+
+        auto size   = vec2u{64, 32};
+        auto levels = random_levels(dxt_format::dxt1, size, 7);
+        auto map    = grx_compressed_color_map(dxt_format::dxt1, size, 7, levels);
+
+        auto stored_path     = (dir / "stored.petx").string();
+        auto compressed_path = (dir / "compressed.petx").string();
+        REQUIRE(try_write_file(stored_path, map.to_bytes(false)));
+
+        /* Zero blocks are compressed well */
+        REQUIRE(try_write_file(
+            compressed_path, grx_compressed_color_map(dxt_format::dxt1, size, 7, vector<byte>(levels.size())).to_bytes()));
+
+        auto stored = grx_compressed_color_map::from_asset(*try_map_asset(stored_path));
+        REQUIRE(stored.is_asset_view());
+        REQUIRE(stored.levels_count() == 7);
+        REQUIRE(all_levels(stored) == levels);
+        for (u32 i = 0; i < stored.levels_count(); ++i)
+            REQUIRE(reinterpret_cast<uintptr_t>(stored.level_data(i).data()) % petx_view::alignment == 0); // NOLINT
+
+        /* Copies share the mapping */
+        auto copy = stored;
+        REQUIRE(copy.level_data(0).data() == stored.level_data(0).data());
+
+        /* Small levels don't shrink and stay in the mapping */
+        auto compressed_file = try_map_asset(compressed_path);
+        auto view            = petx_view(compressed_file->bytes());
+        REQUIRE(view.level(0).flags & petx_view::level_compressed);
+        REQUIRE_FALSE(view.level(6).flags & petx_view::level_compressed);
+
+        auto compressed = grx_compressed_color_map::from_asset(move(*compressed_file));
+        REQUIRE(compressed.is_asset_view());
+        REQUIRE(all_levels(compressed) == vector<byte>(levels.size()));
+
+        /* Fully compressed files are not kept */
+        auto blocks   = vector<byte>(8);
+        auto level    = petx_level_data{{4, 4}, blocks};
+        auto tiny     = petx_write(petx_pixels::dxt1, 3, {&level, 1}, true, 100.0); // NOLINT
+        auto tiny_map = grx_compressed_color_map::from_asset(asset_data(move(tiny)));
+        REQUIRE_FALSE(tiny_map.is_asset_view());
+        REQUIRE(all_levels(tiny_map) == vector<byte>(8));
+
+        std::filesystem::remove_all(dir);
+    }
+}
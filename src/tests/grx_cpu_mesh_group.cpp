@@ -14,7 +14,6 @@ TEST_CASE("grx_cpu_mesh test") {
     /* Shutdown fibers while exit scope */
     auto scope_exit = scope_guard([]{
         core::details::channel_mem::instance().close_all();
-        core::global_fiber_pool().close();
     });
 
 
@@ -94,6 +93,40 @@ TEST_CASE("grx_cpu_mesh test") {
     }
 
     REQUIRE(mesh == mesh2);
+
+    {
+        auto source = make_shared<byte_vector>(s.data());
+        auto data   = span<const byte>(*source);
+
+        grx_cpu_mesh_group_view<
+            mesh_buf_spec<mesh_buf_tag::index,     vector<u32>>,
+            mesh_buf_spec<mesh_buf_tag::position,  vector<vec3f>>,
+            mesh_buf_spec<mesh_buf_tag::normal,    vector<vec3f>>,
+            mesh_buf_spec<mesh_buf_tag::uv,        vector<vec2f>>,
+            mesh_buf_spec<mesh_buf_tag::tangent,   vector<vec3f>>,
+            mesh_buf_spec<mesh_buf_tag::bitangent, vector<vec3f>>> mesh_view(data, source);
+
+        /* Buffers point into the serialized data */
+        REQUIRE(data.empty());
+        REQUIRE(mesh_view.is_borrowed());
+        REQUIRE(mesh_view.elements_count() == mesh.elements_count());
+
+        auto positions = mesh_view.get<mesh_buf_tag::position>();
+        REQUIRE(positions.data() >= reinterpret_cast<const vec3f*>(source->data())); // NOLINT
+        REQUIRE(positions.data() < reinterpret_cast<const vec3f*>(source->data() + source->size())); // NOLINT
+        REQUIRE(static_cast<size_t>(positions.size()) == mesh.get<mesh_buf_tag::position>().size());
+
+        /* Delta encoded indices are decoded into the own storage */
+        auto indices = mesh_view.get<mesh_buf_tag::index>();
+        REQUIRE(vector<u32>(indices.begin(), indices.end()) == mesh.get<mesh_buf_tag::index>());
+
+        REQUIRE(mesh_view.materialize() == mesh);
+
+        byte_vector reserialized;
+        mesh_view.serialize(reserialized);
+        REQUIRE(reserialized == s.data());
+    }
+
     REQUIRE(mesh == mesh_t::from_assimp(scene->mMeshes[0]));
 
     mesh_t mesh3;
@@ -0,0 +1,79 @@
+#include <catch2/catch.hpp>
+#include <cstring>
+#include <filesystem>
+#include <graphics/grx_mapped_color_map.hpp>
+#include "test_helpers.hpp"
+
+using namespace core;
+using namespace grx;
+using namespace test_helpers;
+
+namespace {
+grx_color_map_rgba random_color_map(vec2u size) {
+    auto image = random_image(size, 4, size.x() * 31 + size.y()); // NOLINT
+    auto map   = grx_color_map_rgba(image.data(), size);
+    map.gen_mipmaps();
+    return map;
+}
+
+template <typename T, size_t NPP, bool Const>
+bool equal(const grx_color_map_view<T, NPP, Const>& lhs, const grx_color_map_view<T, NPP, true>& rhs) {
+    return lhs.size() == rhs.size() && std::memcmp(lhs.data(), rhs.data(), lhs.components_count() * sizeof(T)) == 0;
+}
+} // namespace
+
+TEST_CASE("Mapped color map") {
+    auto dir = std::filesystem::temp_directory_path() / "pengine_mapped_color_map_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    auto map = random_color_map({128, 64}); // NOLINT
+
+    SECTION("uncompressed levels are views into the file") {
+        auto path = (dir / "stored.petx").string();
+        REQUIRE(try_write_file(path, map.to_bytes()));
+
+        auto mapped = grx_mapped_color_map_rgba::map(path);
+        REQUIRE(mapped.is_mapped());
+        REQUIRE(mapped.size() == map.size());
+        REQUIRE(mapped.levels_count() == map.mipmaps_count() + 1);
+
+        u32 level = 0;
+        for (auto level_view : map.mipmap_view()) {
+            REQUIRE(mapped.is_level_view(level));
+            REQUIRE(equal(level_view, mapped.level(level)));
+            ++level;
+        }
+        REQUIRE_THROWS(mapped.level(level));
+    }
+
+    SECTION("compressed levels are decompressed on load") {
+        auto flat = grx_color_map_rgba({64, 64}); // NOLINT
+        std::memset(flat.data(), 0x7f, flat.components_count()); // NOLINT
+
+        auto path = (dir / "compressed.petx").string();
+        REQUIRE(try_write_file(path, flat.to_bytes(true)));
+
+        auto mapped = grx_mapped_color_map_rgba::map(path);
+        REQUIRE_FALSE(mapped.is_level_view(0));
+        REQUIRE(equal(flat.mipmap_view().begin().operator*(), mapped.level(0)));
+    }
+
+    SECTION("color maps are loaded from petx v2") {
+        auto loaded = grx_color_map_rgba::from_bytes(map.to_bytes());
+        REQUIRE(loaded.size() == map.size());
+        REQUIRE(loaded.mipmaps_count() == map.mipmaps_count());
+        REQUIRE(std::memcmp(loaded.data(), map.data(), map.components_count()) == 0);
+
+        auto hdr    = map.to_hdr();
+        auto hdr_rt = grx_float_color_map_rgba::from_bytes(hdr.to_bytes());
+        REQUIRE(std::memcmp(hdr_rt.data(), hdr.data(), hdr.components_count() * sizeof(float)) == 0);
+
+        /* Pixels must match */
+        REQUIRE_THROWS(grx_color_map_rgba::from_bytes(hdr.to_bytes()));
+        REQUIRE_THROWS(grx_color_map_rgb::from_bytes(map.to_bytes()));
+        REQUIRE_THROWS(grx_mapped_color_map_rgba(util::asset_data(hdr.to_bytes())));
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -54,6 +54,7 @@ TEST_CASE("grx_skeleton test") {
     serializer s;
     s.write(skeleton_optimized);
     auto bytes = s.data();
+    REQUIRE(serialized_size(skeleton_optimized) == bytes.size());
 
     auto ds = deserializer_view(bytes);
     grx_skeleton_optimized skeleton_optimized2;
@@ -0,0 +1,182 @@
+#include <catch2/catch.hpp>
+#include <cstring>
+#include <graphics/grx_texture_atlas.hpp>
+
+using namespace core;
+using namespace grx;
+
+namespace {
+grx_color_map_rgba test_image(vec2u size, u8 seed) {
+    auto image = grx_color_map_rgba(size);
+    for (u32 y = 0; y < size.y(); ++y)
+        for (u32 x = 0; x < size.x(); ++x)
+            for (u32 c = 0; c < 4; ++c)
+                image.data()[(size_t(y) * size.x() + x) * 4 + c] = u8(seed + x * 7 + y * 13 + c); // NOLINT
+    return image;
+}
+
+bool same(const vec2f& a, const vec2f& b) {
+    return a.x() == b.x() && a.y() == b.y();
+}
+
+bool texel_equal(const grx_color_map_rgba& a, vec2u a_pos, const grx_color_map_rgba& b, vec2u b_pos) {
+    return std::memcmp(a.data() + (size_t(a_pos.y()) * a.size().x() + a_pos.x()) * 4,
+                       b.data() + (size_t(b_pos.y()) * b.size().x() + b_pos.x()) * 4,
+                       4) == 0;
+}
+
+resource_path_t texture_path(const string& name) {
+    return {"default", cfg_path("textures_dir", name), load_significance_t::medium};
+}
+
+grx_texture_path_set path_set(const string& diffuse, const string& normal = {}) {
+    grx_texture_path_set set;
+    set.set<grx_texture_set_tag::diffuse>(texture_path(diffuse));
+    if (!normal.empty())
+        set.set<grx_texture_set_tag::normal>(texture_path(normal));
+    return set;
+}
+} // namespace
+
+TEST_CASE("Texture atlas") {
+    SECTION("blit extrudes edges into the gutter") {
+        auto image = test_image({8, 4}, 1); // NOLINT
+        auto page  = grx_color_map_rgba({32, 16}); // NOLINT
+        grx_atlas_blit(image, page, {4, 4}, 4);
+
+        for (u32 y = 0; y < 12; ++y) { // NOLINT
+            for (u32 x = 0; x < 16; ++x) { // NOLINT
+                auto src = vec2u{u32(std::clamp(int(x) - 4, 0, 7)), u32(std::clamp(int(y) - 4, 0, 3))};
+                REQUIRE(texel_equal(page, {x, y}, image, src));
+            }
+        }
+
+        REQUIRE(page.data()[(size_t(12) * 32 + 16) * 4] == 0); // NOLINT
+        REQUIRE_THROWS(grx_atlas_blit(image, page, {2, 4}, 4));
+    }
+
+    SECTION("bake") {
+        hash_map<string, grx_color_map_rgba> textures;
+        textures.emplace("a.png", test_image({32, 32}, 1));   // NOLINT
+        textures.emplace("an.png", test_image({32, 32}, 2));  // NOLINT
+        textures.emplace("b.png", test_image({16, 8}, 3));    // NOLINT
+        textures.emplace("bn.png", test_image({16, 8}, 4));   // NOLINT
+        textures.emplace("big.png", test_image({300, 8}, 5)); // NOLINT
+        textures.emplace("c.png", test_image({16, 16}, 6));   // NOLINT
+        textures.emplace("cn.png", test_image({8, 8}, 7));    // NOLINT
+
+        auto load = [&](const resource_path_t& path) -> optional<grx_color_map_rgba> {
+            auto pos = textures.find(path.path.path);
+            if (pos == textures.end())
+                return nullopt;
+            return pos->second;
+        };
+
+        vector<grx_texture_path_set> materials{
+            path_set("a.png", "an.png"),   /* 0: atlased */
+            path_set("b.png", "bn.png"),   /* 1: atlased */
+            path_set("a.png", "an.png"),   /* 2: shares the region with 0 */
+            path_set("big.png"),           /* 3: too large */
+            path_set("c.png"),             /* 4: the only one with diffuse only */
+            path_set("c.png", "cn.png"),   /* 5: sizes differ */
+            path_set("b.png", "bn.png"),   /* 6: wrapped coordinates */
+            path_set("missing.png"),       /* 7: can't be loaded */
+        };
+
+        /* Every element is a quad of one material */
+        vector<vec2f>            uvs;
+        vector<grx_mesh_element> elements;
+        for (uint m = 0; m < materials.size(); ++m) {
+            auto element             = grx_mesh_element{};
+            element.start_vertex_pos = static_cast<uint>(uvs.size());
+            element.vertices_count   = 4;
+            element.material_index   = m;
+            elements.push_back(element);
+
+            auto max = m == 6 ? 2.f : 1.f;
+            uvs.insert(uvs.end(), {vec2f{0.f, 0.f}, vec2f{max, 0.f}, vec2f{0.f, max}, vec2f{0.25f, 0.75f}});
+        }
+
+        grx_cpu_mesh_group_t mesh;
+        mesh.elements(elements);
+        mesh.set<mesh_buf_tag::uv>(vector<vec2f>(uvs));
+        mesh.set<mesh_buf_tag::position>(vector<vec3f>(uvs.size()));
+
+        auto settings                    = grx_atlas_settings{};
+        settings.packing.page_size       = {64, 64}; // NOLINT
+        settings.packing.padding         = 1;
+        settings.packing.mip_safe_levels = 1;
+
+        auto result = grx_atlas_bake<u8, 4>(mesh, materials, load, settings);
+
+        REQUIRE(result.regions.size() == 3);
+        REQUIRE(result.regions[0].source_material == 0);
+        REQUIRE(result.regions[1].source_material == 1);
+        REQUIRE(result.regions[2].source_material == 2);
+        REQUIRE(same(result.regions[0].uv_offset, result.regions[2].uv_offset));
+        REQUIRE(result.regions[0].page_material == result.regions[2].page_material);
+
+        REQUIRE_FALSE(result.pages.empty());
+        REQUIRE(materials.size() == 8 + result.pages.size());
+        for (auto& page : result.pages) {
+            REQUIRE(page.maps[size_t(grx_texture_set_tag::diffuse)]);
+            REQUIRE(page.maps[size_t(grx_texture_set_tag::normal)]);
+            REQUIRE_FALSE(page.maps[size_t(grx_texture_set_tag::specular)]);
+            REQUIRE(page.maps[size_t(grx_texture_set_tag::diffuse)]->has_mipmaps());
+            REQUIRE_FALSE(materials[page.material].options()[0]);
+        }
+
+        /* Sources of pages are listed once */
+        vector<string> sources;
+        for (auto& path : result.sources)
+            sources.push_back(path.path.path);
+        std::sort(sources.begin(), sources.end());
+        REQUIRE(sources == vector<string>{"a.png", "an.png", "b.png", "bn.png"});
+
+        /* Atlased materials are cleared, others are kept */
+        for (uint m : {0U, 1U, 2U})
+            REQUIRE_FALSE(materials[m].options()[0]);
+        for (uint m : {3U, 4U, 5U, 6U, 7U}) {
+            REQUIRE(materials[m].options()[0]);
+            REQUIRE(mesh.elements()[m].material_index == m);
+        }
+
+        /* Texel centers of remapped coordinates hit the same texels in the page */
+        auto& new_uvs = mesh.get<mesh_buf_tag::uv>();
+        for (auto& region : result.regions) {
+            auto  m       = region.source_material;
+            auto& element = mesh.elements()[m];
+            REQUIRE(element.material_index == region.page_material);
+
+            for (uint v = 0; v < 4; ++v)
+                REQUIRE(same(new_uvs[element.start_vertex_pos + v], region.map(uvs[element.start_vertex_pos + v])));
+
+            auto page = std::find_if(result.pages.begin(), result.pages.end(), [&](auto& p) {
+                return p.material == region.page_material;
+            });
+            REQUIRE(page != result.pages.end());
+
+            for (auto [tag, name] : {pair{grx_texture_set_tag::diffuse, m == 1 ? "b.png" : "a.png"},
+                                     pair{grx_texture_set_tag::normal, m == 1 ? "bn.png" : "an.png"}}) {
+                auto& image    = textures.at(name);
+                auto& page_map = *page->maps[size_t(tag)];
+                auto  size     = static_cast<vec2f>(page_map.size());
+
+                for (u32 y = 0; y < image.size().y(); ++y) {
+                    for (u32 x = 0; x < image.size().x(); ++x) {
+                        auto uv = vec2f{(float(x) + 0.5f) / float(image.size().x()),
+                                        (float(y) + 0.5f) / float(image.size().y())};
+                        auto texel = region.map(uv) * size;
+                        REQUIRE(texel_equal(page_map, {u32(texel.x()), u32(texel.y())}, image, {x, y}));
+                    }
+                }
+            }
+        }
+
+        /* Materials of elements without coordinates are not atlased */
+        grx_cpu_mesh_group<mesh_buf_spec<mesh_buf_tag::position, vector<vec3f>>> no_uv;
+        no_uv.elements(elements);
+        auto materials_copy = vector<grx_texture_path_set>{path_set("a.png"), path_set("b.png")};
+        REQUIRE(grx_atlas_bake<u8, 4>(no_uv, materials_copy, load, settings).regions.empty());
+    }
+}
@@ -0,0 +1,210 @@
+#include <catch2/catch.hpp>
+#include <graphics/grx_texture_residency.hpp>
+
+using namespace core;
+using namespace grx;
+
+namespace {
+/* RGBA8 levels of the square texture down to 1x1 */
+vector<u64> levels_bytes(u32 size) {
+    vector<u64> result;
+    for (; size; size /= 2)
+        result.push_back(u64(size) * size * 4);
+    return result;
+}
+
+u64 sum(const vector<u64>& levels, u32 from) {
+    u64 result = 0;
+    for (auto i = from; i < levels.size(); ++i)
+        result += levels[i];
+    return result;
+}
+
+/* Completes all loads of the plan */
+grx_texture_residency::plan_t update(grx_texture_residency& residency) {
+    auto plan = residency.update();
+    for (auto& load : plan.loads)
+        residency.level_loaded(load.id, load.level);
+    return plan;
+}
+} // namespace
+
+TEST_CASE("Texture residency") {
+    SECTION("helpers") {
+        REQUIRE(grx_texture_residency::mip_tail_level({1024, 512}, 11, 128) == 3);
+        REQUIRE(grx_texture_residency::mip_tail_level({64, 64}, 7, 128) == 0);
+        REQUIRE(grx_texture_residency::mip_tail_level({4096, 4096}, 3, 128) == 2);
+
+        REQUIRE(grx_texture_residency::level_for_screen_size({1024, 1024}, {2000.f, 2000.f}) == 0);
+        REQUIRE(grx_texture_residency::level_for_screen_size({1024, 1024}, {256.f, 300.f}) == 1);
+        REQUIRE(grx_texture_residency::level_for_screen_size({1024, 512}, {64.f, 64.f}) == 3);
+        REQUIRE(grx_texture_residency::level_for_screen_size({1024, 1024}, {0.f, 0.f}) == numlim<u32>::max());
+    }
+
+    SECTION("mip tail is resident from the start and levels are streamed smallest first") {
+        auto levels    = levels_bytes(1024); // NOLINT
+        auto residency = grx_texture_residency({.memory_budget = 1ULL << 30U, .upload_budget = 1}); // NOLINT
+        residency.add(1, levels, 3);
+
+        REQUIRE(residency.resident_level(1) == 3);
+        REQUIRE(residency.resident_bytes() == sum(levels, 3));
+
+        /* The upload budget allows one level per update */
+        for (u32 expected = 2; expected != u32(-1); --expected) {
+            auto plan = residency.update();
+            REQUIRE(plan.drops.empty());
+            REQUIRE(plan.loads.size() == 1);
+            REQUIRE(plan.loads[0].level == expected);
+            REQUIRE(residency.is_loading(1));
+            REQUIRE(residency.pending_bytes() == levels[expected]);
+
+            /* Nothing new while the level is loading */
+            REQUIRE(residency.update().loads.empty());
+
+            residency.level_loaded(1, expected);
+            REQUIRE(residency.resident_level(1) == expected);
+        }
+
+        REQUIRE(residency.update().loads.empty());
+        REQUIRE(residency.resident_bytes() == sum(levels, 0));
+        REQUIRE(residency.pending_bytes() == 0);
+    }
+
+    SECTION("upload budget limits loads per update") {
+        auto levels    = levels_bytes(256); // NOLINT
+        auto residency = grx_texture_residency({.memory_budget = 1ULL << 30U, .upload_budget = levels[1] * 2}); // NOLINT
+        for (grx_texture_residency::texture_id id = 0; id < 4; ++id)
+            residency.add(id, levels, 2);
+
+        /* Level 1 of two textures fits the budget */
+        REQUIRE(update(residency).loads.size() == 2);
+        REQUIRE(update(residency).loads.size() == 2);
+
+        /* Level 0 is larger than the budget, but one load per update is allowed */
+        REQUIRE(update(residency).loads.size() == 1);
+    }
+
+    SECTION("screen usage defines desired levels and priorities") {
+        auto levels    = levels_bytes(512); // NOLINT
+        auto residency = grx_texture_residency({.memory_budget = 1ULL << 30U, .upload_budget = 1}); // NOLINT
+        residency.add(1, levels, 4);
+        residency.add(2, levels, 4);
+
+        residency.request_level(1, 3);
+        residency.request_level(2, grx_texture_residency::level_for_screen_size({512, 512}, {500.f, 500.f}));
+        REQUIRE(residency.desired_level(2) == 0);
+
+        /* The texture with the largest gap goes first */
+        auto plan = update(residency);
+        REQUIRE(plan.loads.size() == 1);
+        REQUIRE(plan.loads[0].id == 2);
+
+        for (int i = 0; i < 10; ++i) // NOLINT
+            update(residency);
+
+        REQUIRE(residency.resident_level(1) == 3);
+        REQUIRE(residency.resident_level(2) == 0);
+
+        /* Levels over the desired one are not dropped without memory pressure */
+        residency.request_level(2, 2);
+        REQUIRE(update(residency).drops.empty());
+        REQUIRE(residency.resident_level(2) == 0);
+        REQUIRE(residency.desired_level(2) == 2);
+
+        residency.request_level(1, 100); // NOLINT
+        REQUIRE(residency.desired_level(1) == levels.size() - 1);
+
+        /* The largest level requested between updates wins */
+        residency.request_level(1, 5); // NOLINT
+        REQUIRE(residency.desired_level(1) == 5);
+        residency.update();
+        residency.request_level(1, 6); // NOLINT
+        residency.request_level(1, 4); // NOLINT
+        residency.request_level(1, 7); // NOLINT
+        REQUIRE(residency.desired_level(1) == 4);
+    }
+
+    SECTION("memory pressure drops surplus levels and least recently used textures") {
+        auto levels    = levels_bytes(256); // NOLINT
+        auto tail      = sum(levels, 2);
+        auto residency = grx_texture_residency({.memory_budget = 1ULL << 30U, .upload_budget = 1ULL << 30U}); // NOLINT
+
+        residency.add(1, levels, 2);
+        residency.add(2, levels, 2);
+        residency.add(3, levels, 2);
+        update(residency);
+        update(residency);
+        REQUIRE(residency.resident_bytes() == sum(levels, 0) * 3);
+
+        /* Only the first texture is needed in full resolution, the second one is used with level 1 */
+        residency.request_level(1, 0);
+        residency.request_level(2, 1);
+
+        residency.settings({.memory_budget = sum(levels, 0) + sum(levels, 1) + tail, .upload_budget = 1ULL << 30U});
+        auto plan = residency.update();
+        REQUIRE(plan.loads.empty());
+        REQUIRE(residency.resident_bytes() <= residency.settings().memory_budget);
+
+        /* The surplus level of the second texture goes first, then the unused third texture is dropped to its tail */
+        REQUIRE(residency.resident_level(1) == 0);
+        REQUIRE(residency.resident_level(2) == 1);
+        REQUIRE(residency.resident_level(3) == 2);
+        REQUIRE(plan.drops.size() == 2);
+
+        /* Mip tails are never dropped */
+        residency.settings({.memory_budget = 1, .upload_budget = 1ULL << 30U});
+        residency.update();
+        REQUIRE(residency.resident_level(1) == 2);
+        REQUIRE(residency.resident_level(3) == 2);
+        REQUIRE(residency.resident_bytes() == tail * 3);
+
+        /* Removed textures give their levels back */
+        residency.remove(1);
+        residency.remove(2);
+        residency.remove(3);
+        REQUIRE(residency.resident_bytes() == 0);
+    }
+
+    SECTION("loads make room only from less recently used textures") {
+        auto levels    = levels_bytes(256); // NOLINT
+        auto tail      = sum(levels, 1);
+        auto residency = grx_texture_residency({.memory_budget = levels[0] + tail * 2, .upload_budget = 1ULL << 30U}); // NOLINT
+
+        residency.add(1, levels, 1);
+        residency.add(2, levels, 1);
+
+        /* The first texture takes the budget */
+        residency.request_level(1, 0);
+        update(residency);
+        REQUIRE(residency.resident_level(1) == 0);
+
+        /* The second texture is used later, so the first one is dropped for it */
+        residency.request_level(2, 0);
+        auto plan = update(residency);
+        REQUIRE(plan.drops.size() == 1);
+        REQUIRE(plan.drops[0].id == 1);
+        REQUIRE(plan.loads.size() == 1);
+        REQUIRE(plan.loads[0].id == 2);
+        REQUIRE(residency.resident_level(1) == 1);
+        REQUIRE(residency.resident_level(2) == 0);
+
+        /* Both are used now, nothing can be evicted */
+        residency.request_level(1, 0);
+        residency.request_level(2, 0);
+        plan = update(residency);
+        REQUIRE(plan.drops.empty());
+        REQUIRE(plan.loads.empty());
+    }
+
+    SECTION("invalid arguments") {
+        grx_texture_residency residency;
+        residency.add(1, levels_bytes(4), 1);
+        REQUIRE_THROWS(residency.add(1, levels_bytes(4), 1));
+        REQUIRE_THROWS(residency.add(2, levels_bytes(4), 3));
+        REQUIRE_THROWS(residency.request_level(3, 0));
+
+        /* Loads of removed textures are ignored */
+        residency.remove(1);
+        REQUIRE_NOTHROW(residency.level_loaded(1, 0));
+    }
+}
@@ -0,0 +1,146 @@
+#include <catch2/catch.hpp>
+#include <util/mipmap_gen.hpp>
+#include <cmath>
+#include "test_helpers.hpp"
+
+using namespace core;
+using namespace util;
+using namespace test_helpers;
+
+namespace {
+size_t chain_values(span<const vec2u> sizes, size_t channels) {
+    size_t result = 0;
+    for (auto& size : sizes)
+        result += size_t(size.x()) * size.y() * channels;
+    return result;
+}
+} // namespace
+
+TEST_CASE("Mipmap generation") {
+    auto filters = {mip_filter::box, mip_filter::kaiser, mip_filter::lanczos};
+
+    SECTION("chain sizes") {
+        auto sizes = mip_chain_sizes({1000, 600});
+        REQUIRE(sizes.size() == 9);
+        REQUIRE(sizes.front() == vec2u{500, 300});
+        REQUIRE(sizes[3] == vec2u{62, 37});
+        REQUIRE(sizes.back() == vec2u{1, 1});
+        REQUIRE(mip_chain_sizes({1, 1}).empty());
+        REQUIRE(mip_chain_sizes({1, 4}) == vector<vec2u>{{1, 2}, {1, 1}});
+    }
+
+    SECTION("box filter averages 2x2 pixels") {
+        for (size_t channels = 1; channels <= 4; ++channels) {
+            auto size  = vec2u{64, 32};
+            auto image = random_image(size, channels, u32(channels));
+            auto level = vec2u{32, 16};
+
+            vector<u8> output(size_t(level.x()) * level.y() * channels);
+            generate_mipmaps(image.data(), size, channels, span<const vec2u>(&level, 1), output.data());
+
+            for (u32 y = 0; y < level.y(); ++y) {
+                for (u32 x = 0; x < level.x(); ++x) {
+                    for (size_t c = 0; c < channels; ++c) {
+                        auto at  = [&](u32 sx, u32 sy) { return u32(image[(size_t(sy) * size.x() + sx) * channels + c]); };
+                        auto sum = at(x * 2, y * 2) + at(x * 2 + 1, y * 2) + at(x * 2, y * 2 + 1) + at(x * 2 + 1, y * 2 + 1);
+                        REQUIRE(output[(size_t(y) * level.x() + x) * channels + c] == (sum + 2) / 4);
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("constant images stay constant with non power of two sizes") {
+        for (auto filter : filters) {
+            for (auto size : {vec2u{37, 21}, vec2u{5, 3}, vec2u{1, 13}, vec2u{300, 200}}) {
+                INFO(magic_enum::enum_name(filter) << " " << size.x() << "x" << size.y());
+
+                auto       sizes = mip_chain_sizes(size);
+                vector<u8> image(size_t(size.x()) * size.y() * 4);
+                for (size_t i = 0; i < image.size(); ++i)
+                    image[i] = u8(40 + 50 * (i % 4)); // NOLINT
+
+                vector<u8> output(chain_values(sizes, 4));
+                generate_mipmaps(image.data(), size, 4, sizes, output.data(), {filter, true});
+
+                for (size_t i = 0; i < output.size(); ++i)
+                    REQUIRE(output[i] == u8(40 + 50 * (i % 4))); // NOLINT
+            }
+        }
+    }
+
+    SECTION("filters preserve linear gradients") {
+        auto size = vec2u{256, 64};
+        vector<float> image(size_t(size.x()) * size.y());
+        for (u32 y = 0; y < size.y(); ++y)
+            for (u32 x = 0; x < size.x(); ++x)
+                image[size_t(y) * size.x() + x] = float(x);
+
+        auto sizes = mip_chain_sizes(size);
+        for (auto filter : filters) {
+            INFO(magic_enum::enum_name(filter));
+            vector<float> output(chain_values(sizes, 1));
+            generate_mipmaps(image.data(), size, 1, sizes, output.data(), {filter, false});
+
+            /* Interior pixels of the first level are centered at 2x + 0.5 of the source */
+            for (u32 x = 4; x < sizes[0].x() - 4; ++x)
+                REQUIRE(output[x] == Approx(float(x) * 2.f + 0.5f).margin(0.01));
+        }
+    }
+
+    SECTION("srgb") {
+        /* Black and white columns average to 0.5 in linear space, alpha is averaged as is */
+        auto       size = vec2u{4, 4};
+        vector<u8> image;
+        for (u32 i = 0; i < size.x() * size.y(); ++i) {
+            u8 v = i % 2 ? 255 : 0; // NOLINT
+            image.insert(image.end(), {v, v, v, v});
+        }
+
+        auto       level = vec2u{2, 2};
+        vector<u8> linear(16), srgb(16); // NOLINT
+        generate_mipmaps(image.data(), size, 4, span<const vec2u>(&level, 1), linear.data(), {mip_filter::box, false});
+        generate_mipmaps(image.data(), size, 4, span<const vec2u>(&level, 1), srgb.data(), {mip_filter::box, true});
+
+        REQUIRE(vector<u8>(linear.begin(), linear.begin() + 4) == vector<u8>{128, 128, 128, 128});
+        REQUIRE(vector<u8>(srgb.begin(), srgb.begin() + 4) == vector<u8>{188, 188, 188, 128});
+    }
+
+    SECTION("large images are filtered in parallel") {
+        auto size  = vec2u{1024, 512};
+        auto image = random_image(size, 3, 7);
+        auto sizes = mip_chain_sizes(size);
+
+        vector<u8> parallel(chain_values(sizes, 3));
+        generate_mipmaps(image.data(), size, 3, sizes, parallel.data(), {mip_filter::lanczos, true});
+
+        /* Levels are filtered from the previous one, so generating level by level gives nearly the same result */
+        vector<u8> sequential(parallel.size());
+        auto       src    = image.data();
+        auto       output = sequential.data();
+        auto       prev   = size;
+        for (auto& level : sizes) {
+            generate_mipmaps(src, prev, 3, span<const vec2u>(&level, 1), output, {mip_filter::lanczos, true});
+            src = output;
+            output += size_t(level.x()) * level.y() * 3;
+            prev = level;
+        }
+
+        /* The first level is filtered from the same pixels, next ones differ by rounding of intermediate levels */
+        auto first_level = size_t(sizes[0].x()) * sizes[0].y() * 3;
+        REQUIRE(std::equal(parallel.begin(), parallel.begin() + ssize_t(first_level), sequential.begin()));
+
+        size_t total_difference = 0;
+        for (size_t i = first_level; i < parallel.size(); ++i)
+            total_difference += size_t(std::abs(int(parallel[i]) - int(sequential[i])));
+        REQUIRE(double(total_difference) / double(parallel.size() - first_level) < 0.5);
+    }
+
+    SECTION("invalid arguments") {
+        vector<u8> image(64), output(64);
+        auto       level = vec2u{2, 2};
+        REQUIRE_THROWS(generate_mipmaps(image.data(), {4, 4}, 5, span<const vec2u>(&level, 1), output.data()));
+        level = {0, 2};
+        REQUIRE_THROWS(generate_mipmaps(image.data(), {4, 4}, 4, span<const vec2u>(&level, 1), output.data()));
+    }
+}
@@ -0,0 +1,235 @@
+#include <catch2/catch.hpp>
+#include <core/fiber_pool.hpp>
+#include <util/patch_match.hpp>
+#include <cmath>
+#include <cstdlib>
+#include "test_helpers.hpp"
+
+using namespace core;
+using namespace util;
+using namespace test_helpers;
+
+namespace {
+u32 plain_sad(const vector<u8>& a, vec2u a_size, vec2u a_pos,
+              const vector<u8>& b, vec2u b_size, vec2u b_pos,
+              u32 bs, size_t channels) {
+    u32 sum = 0;
+    for (u32 y = 0; y < bs; ++y)
+        for (u32 x = 0; x < bs; ++x)
+            for (size_t c = 0; c < std::min<size_t>(channels, 3); ++c)
+                sum += static_cast<u32>(
+                    std::abs(int(a[((size_t(a_pos.y()) + y) * a_size.x() + a_pos.x() + x) * channels + c]) -
+                             int(b[((size_t(b_pos.y()) + y) * b_size.x() + b_pos.x() + x) * channels + c])));
+    return sum;
+}
+} // namespace
+
+TEST_CASE("Patch match") {
+    SECTION("block SAD") {
+        for (size_t channels = 1; channels <= 4; ++channels) {
+            for (u32 bs : {1U, 5U, 8U, 16U, 23U}) { // NOLINT
+                INFO("channels " << channels << " block size " << bs);
+                auto size = vec2u{64, 32}; // NOLINT
+                auto a    = random_image(size, channels, 1);
+                auto b    = random_image(size, channels, 2);
+                auto pa   = vec2u{3, 2};
+                auto pb   = vec2u{40, 7}; // NOLINT
+
+                auto pitch = size_t(size.x()) * channels;
+                auto exact = plain_sad(a, size, pa, b, size, pb, bs, channels);
+                auto sad   = block_sad(a.data() + pa.y() * pitch + pa.x() * channels,
+                                     pitch,
+                                     b.data() + pb.y() * pitch + pb.x() * channels,
+                                     pitch,
+                                     {bs, bs},
+                                     channels);
+                REQUIRE(sad == exact);
+
+                /* The partial sum is returned as soon as it reaches the limit */
+                auto partial = block_sad(a.data() + pa.y() * pitch + pa.x() * channels,
+                                         pitch,
+                                         b.data() + pb.y() * pitch + pb.x() * channels,
+                                         pitch,
+                                         {bs, bs},
+                                         channels,
+                                         exact / 2);
+                REQUIRE(partial >= exact / 2);
+                REQUIRE(partial <= exact);
+            }
+        }
+    }
+
+    SECTION("exhaustive search") {
+        for (size_t channels : {1U, 3U, 4U}) {
+            for (u32 bs : {4U, 7U, 16U}) { // NOLINT
+                INFO("channels " << channels << " block size " << bs);
+                auto src_size = vec2u{100, 70}; // NOLINT
+                auto smp_size = vec2u{90, 60};  // NOLINT
+                auto src      = random_image(src_size, channels, 3);
+                auto smp      = random_image(smp_size, channels, 4);
+
+                auto settings       = patch_match_settings{};
+                settings.block_size = bs;
+
+                auto result = patch_match_exact(src.data(), src_size, smp.data(), smp_size, channels, settings);
+                settings.early_termination = false;
+                auto full = patch_match_exact(src.data(), src_size, smp.data(), smp_size, channels, settings);
+
+                REQUIRE(result.blocks == src_size / bs);
+                REQUIRE(result.matches.size() == size_t(result.blocks.x()) * result.blocks.y());
+
+                for (u32 by = 0; by < result.blocks.y(); ++by) {
+                    for (u32 bx = 0; bx < result.blocks.x(); ++bx) {
+                        /* The first best candidate in the row order */
+                        auto src_pos    = vec2u{bx, by} * bs;
+                        auto best       = vec2u{0, 0};
+                        auto best_error = numlim<u32>::max();
+                        for (u32 sy = 0; sy + bs <= smp_size.y(); sy += bs) {
+                            for (u32 sx = 0; sx + bs <= smp_size.x(); sx += bs) {
+                                auto error = plain_sad(src, src_size, src_pos, smp, smp_size, {sx, sy}, bs, channels);
+                                if (error < best_error) {
+                                    best_error = error;
+                                    best       = {sx, sy};
+                                }
+                            }
+                        }
+
+                        auto i = size_t(by) * result.blocks.x() + bx;
+                        REQUIRE(result.matches[i] == best);
+                        REQUIRE(result.errors[i] == best_error);
+                        REQUIRE(full.matches[i] == best);
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("exhaustive search with the candidate step") {
+        /* Steps less and greater than the block size */
+        for (u32 step : {3U, 11U}) { // NOLINT
+            INFO("step " << step);
+            auto channels = size_t(3);
+            auto bs       = 8U;
+            auto src_size = vec2u{48, 40}; // NOLINT
+            auto smp_size = vec2u{50, 45}; // NOLINT
+            auto src      = random_image(src_size, channels, 7);
+            auto smp      = random_image(smp_size, channels, 8);
+
+            auto settings           = patch_match_settings{};
+            settings.block_size     = bs;
+            settings.candidate_step = step;
+
+            auto result = patch_match_exact(src.data(), src_size, smp.data(), smp_size, channels, settings);
+            settings.early_termination = false;
+            auto full = patch_match_exact(src.data(), src_size, smp.data(), smp_size, channels, settings);
+
+            for (u32 by = 0; by < result.blocks.y(); ++by) {
+                for (u32 bx = 0; bx < result.blocks.x(); ++bx) {
+                    auto best_error = numlim<u32>::max();
+                    for (u32 sy = 0; sy + bs <= smp_size.y(); sy += step)
+                        for (u32 sx = 0; sx + bs <= smp_size.x(); sx += step)
+                            best_error = std::min(
+                                best_error,
+                                plain_sad(src, src_size, vec2u{bx, by} * bs, smp, smp_size, {sx, sy}, bs, 3));
+
+                    auto i = size_t(by) * result.blocks.x() + bx;
+                    REQUIRE(result.errors[i] == best_error);
+                    REQUIRE(result.matches[i] == full.matches[i]);
+                    REQUIRE(result.matches[i].x() % step == 0);
+                    REQUIRE(result.matches[i].y() % step == 0);
+                }
+            }
+        }
+    }
+
+    SECTION("approximate search") {
+        /* Smooth images with noise, as photos */
+        auto smooth_image = [](vec2u size, u32 seed) {
+            std::mt19937 gen(seed);
+            vector<u8>   image(size_t(size.x()) * size.y() * 3);
+            for (u32 y = 0; y < size.y(); ++y)
+                for (u32 x = 0; x < size.x(); ++x)
+                    for (u32 c = 0; c < 3; ++c)
+                        image[(size_t(y) * size.x() + x) * 3 + c] = static_cast<u8>(
+                            128.f + 90.f * std::sin(float(x) * 0.05f + float(c + seed)) * // NOLINT
+                                        std::cos(float(y) * 0.07f - float(seed)) +         // NOLINT
+                            float(gen() % 16));                                            // NOLINT
+            return image;
+        };
+
+        auto src_size = vec2u{128, 96}; // NOLINT
+        auto smp_size = vec2u{160, 120}; // NOLINT
+        auto src      = smooth_image(src_size, 1);
+        auto smp      = smooth_image(smp_size, 2);
+
+        auto settings           = patch_match_settings{};
+        settings.block_size     = 8; // NOLINT
+        settings.candidate_step = 2;
+
+        auto exact = patch_match_exact(src.data(), src_size, smp.data(), smp_size, 3, settings);
+
+        auto approx    = patch_match_approx_settings{};
+        approx.quality = 1.f;
+        auto best      = patch_match_approx(src.data(), src_size, smp.data(), smp_size, 3, settings, approx);
+
+        REQUIRE(best.blocks == exact.blocks);
+        for (size_t i = 0; i < best.errors.size(); ++i) {
+            auto pos = best.matches[i];
+            REQUIRE(pos.x() % 2 == 0);
+            REQUIRE(pos.y() % 2 == 0);
+            REQUIRE(best.errors[i] >= exact.errors[i]);
+            REQUIRE(best.errors[i] == plain_sad(src,
+                                                src_size,
+                                                vec2u{u32(i % best.blocks.x()), u32(i / best.blocks.x())} * 8U,
+                                                smp,
+                                                smp_size,
+                                                pos,
+                                                8, // NOLINT
+                                                3));
+        }
+
+        auto best_error = patch_match_relative_error(best, exact);
+        REQUIRE(best_error >= 0.0);
+        REQUIRE(best_error < 0.25); // NOLINT
+
+        /* Lower quality is faster and not better on average */
+        approx.quality = 0.f;
+        auto fast      = patch_match_approx(src.data(), src_size, smp.data(), smp_size, 3, settings, approx);
+        REQUIRE(patch_match_relative_error(fast, exact) >= 0.0);
+        REQUIRE(patch_match_relative_error(fast, exact) < 1.0);
+
+        /* Results depend only on inputs and the seed, a serial pool gives the results of the global one */
+        approx.quality = 1.f;
+        auto serial    = fiber_pool(1);
+        auto pooled =
+            patch_match_approx(src.data(), src_size, smp.data(), smp_size, 3, settings, approx, &serial);
+        serial.close();
+        REQUIRE(pooled.matches == best.matches);
+        REQUIRE(pooled.errors == best.errors);
+
+        REQUIRE(patch_match_relative_error(exact, exact) == 0.0);
+    }
+
+    SECTION("mosaic of the sample itself") {
+        auto size  = vec2u{64, 48}; // NOLINT
+        auto image = random_image(size, 3, 5);
+        auto smp   = image;
+
+        auto result = patch_match_exact(image.data(), size, smp.data(), size, 3);
+        REQUIRE(result.total_error() == 0);
+
+        std::fill(image.begin(), image.end(), u8(0));
+        patch_apply(image.data(), size, smp.data(), size, 3, 16, result); // NOLINT
+        REQUIRE(image == smp);
+    }
+
+    SECTION("invalid arguments") {
+        auto image    = random_image({16, 16}, 3, 6); // NOLINT
+        auto settings = patch_match_settings{};
+        REQUIRE_THROWS(patch_match_exact(image.data(), {16, 16}, image.data(), {16, 16}, 5, settings));
+        REQUIRE_THROWS(patch_match_exact(image.data(), {16, 16}, image.data(), {8, 16}, 3, settings));
+        settings.block_size = 0;
+        REQUIRE_THROWS(patch_match_exact(image.data(), {16, 16}, image.data(), {16, 16}, 3, settings));
+        REQUIRE_THROWS(patch_match_approx(image.data(), {16, 16}, image.data(), {16, 16}, 3, settings));
+    }
+}
@@ -0,0 +1,85 @@
+#include <catch2/catch.hpp>
+#include <util/petx_format.hpp>
+#include "test_helpers.hpp"
+
+using namespace core;
+using namespace util;
+using namespace test_helpers;
+
+TEST_CASE("Petx format") {
+    /* The largest level is random, others are compressible */
+    auto sizes  = array{vec2u{64, 32}, vec2u{32, 16}, vec2u{16, 8}, vec2u{1, 1}};
+    auto pixels = vector<vector<byte>>();
+    for (auto& size : sizes) {
+        auto bytes = size_t(size.x()) * size.y() * 4 * sizeof(float);
+        pixels.push_back(pixels.empty() ? random_bytes(bytes, 1337) : vector<byte>(bytes, byte(7)));
+    }
+
+    vector<petx_level_data> levels;
+    for (size_t i = 0; i < sizes.size(); ++i)
+        levels.push_back({sizes[i], pixels[i]});
+
+    SECTION("round trip") {
+        for (auto compress : {false, true}) {
+            auto bytes = petx_write(petx_pixels::f32, 4, levels, compress);
+            REQUIRE(petx_view::is_petx(bytes));
+
+            auto view = petx_view(bytes);
+            REQUIRE(view.pixels() == petx_pixels::f32);
+            REQUIRE(view.channels() == 4);
+            REQUIRE(view.size() == sizes[0]);
+            REQUIRE(view.levels_count() == sizes.size());
+
+            for (u32 i = 0; i < view.levels_count(); ++i) {
+                auto& level = view.level(i);
+                REQUIRE(level.size == sizes[i]);
+                REQUIRE(level.raw_size == pixels[i].size());
+                REQUIRE(level.offset % petx_view::alignment == 0);
+                REQUIRE(view.read_level(i) == pixels[i]);
+
+                /* Random data and tiny levels don't shrink */
+                auto compressed = compress && i != 0 && i != 3;
+                REQUIRE(bool(level.flags & petx_view::level_compressed) == compressed);
+                REQUIRE(view.try_view(i).has_value() == !compressed);
+                if (!compressed)
+                    REQUIRE(view.try_view(i)->data() == bytes.data() + level.offset);
+            }
+
+            auto small = vector<byte>(10); // NOLINT
+            REQUIRE_THROWS(view.level(4));
+            REQUIRE_THROWS(view.read_level(0, small));
+        }
+    }
+
+    SECTION("block levels") {
+        auto blocks = random_bytes(dxt_data_size(dxt_format::dxt5, {8, 4}), 1337);
+        auto level  = petx_level_data{{8, 4}, blocks};
+        auto bytes  = petx_write(petx_block_pixels(dxt_format::dxt5), 4, {&level, 1});
+        auto view   = petx_view(bytes);
+
+        REQUIRE(petx_block_format(view.pixels()) == dxt_format::dxt5);
+        REQUIRE_FALSE(petx_block_format(petx_pixels::u8));
+        REQUIRE(view.read_level(0) == blocks);
+    }
+
+    SECTION("invalid data") {
+        REQUIRE_THROWS(petx_write(petx_pixels::u8, 4, levels));
+        REQUIRE_THROWS(petx_write(petx_pixels::f32, 5, levels));
+        REQUIRE_THROWS(petx_write(petx_pixels::f32, 4, {}));
+
+        auto bytes = petx_write(petx_pixels::f32, 4, levels);
+        REQUIRE_FALSE(petx_view::is_petx(span<const byte>(bytes).first(16)));
+        REQUIRE_THROWS(petx_view(span<const byte>(bytes).first(100)));
+        REQUIRE_THROWS(petx_view(span<const byte>(bytes).first(ssize_t(petx_view(bytes).level(3).offset + 1))));
+
+        /* Older versions */
+        auto old = bytes;
+        old[4]   = byte(1);
+        REQUIRE_FALSE(petx_view::is_petx(old));
+
+        /* Raw size of the first level */
+        auto broken = bytes;
+        broken[petx_view::header_size + 24] = byte(1);
+        REQUIRE_THROWS(petx_view(broken));
+    }
+}
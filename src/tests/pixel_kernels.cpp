@@ -0,0 +1,100 @@
+#include <catch2/catch.hpp>
+#include <util/pixel_kernels.hpp>
+#include <cmath>
+#include <cstring>
+#include "test_helpers.hpp"
+
+using namespace core;
+using namespace util;
+using namespace test_helpers;
+
+namespace {
+const byte* pixel_at(const vector<byte>& image, u32 width, size_t pixel_size, u32 x, u32 y) {
+    return image.data() + (size_t(y) * width + x) * pixel_size;
+}
+} // namespace
+
+TEST_CASE("Pixel kernels") {
+    SECTION("tone mapping") {
+        vector<float> hdr;
+        for (float v = -1.f; v < 64.f; v += 0.0007f) // NOLINT
+            hdr.push_back(v);
+
+        for (auto [gamma, exposure] : {std::pair{1.f, 1.f}, std::pair{2.2f, 1.f}, std::pair{2.2f, 0.25f}}) {
+            INFO("gamma " << gamma << " exposure " << exposure);
+
+            vector<u8> ldr(hdr.size());
+            tone_map(hdr.data(), ldr.data(), hdr.size(), gamma, exposure);
+
+            size_t differences = 0;
+            for (size_t i = 0; i < hdr.size(); ++i) {
+                auto mapped = std::max(0.f, 1.f - std::exp(-hdr[i] * exposure));
+                auto exact  = static_cast<u8>(255.f * std::pow(mapped, 1.f / gamma)); // NOLINT
+                REQUIRE(std::abs(int(ldr[i]) - int(exact)) <= 1);
+                differences += ldr[i] != exact;
+            }
+
+            /* Values differ only near integer boundaries */
+            REQUIRE(differences < hdr.size() / 1000); // NOLINT
+        }
+    }
+
+    SECTION("u8 <-> float") {
+        vector<u8> values(1000); // NOLINT
+        for (size_t i = 0; i < values.size(); ++i)
+            values[i] = u8(i * 7); // NOLINT
+
+        vector<float> floats(values.size());
+        u8_to_float(values.data(), floats.data(), values.size());
+        for (size_t i = 0; i < values.size(); ++i)
+            REQUIRE(floats[i] == float(values[i]) / 255.f); // NOLINT
+
+        vector<u8> back(values.size());
+        float_to_u8(floats.data(), back.data(), floats.size());
+        REQUIRE(back == values);
+
+        vector<float> out_of_range = {-1.f, 2.f, 0.5f, 0.1f}; // NOLINT
+        vector<u8>    clamped(out_of_range.size());
+        float_to_u8(out_of_range.data(), clamped.data(), out_of_range.size());
+        REQUIRE(clamped == vector<u8>{0, 255, 128, 26});
+    }
+
+    SECTION("rotations and flips") {
+        for (size_t pixel_size : {1UL, 2UL, 3UL, 4UL, 8UL, 12UL, 16UL}) {
+            for (auto size : {vec2u{1, 1}, vec2u{7, 3}, vec2u{64, 64}, vec2u{131, 77}, vec2u{600, 300}}) {
+                INFO("pixel size " << pixel_size << " " << size.x() << "x" << size.y());
+
+                auto image = random_bytes(size_t(size.x()) * size.y() * pixel_size, size.x() + u32(pixel_size));
+                auto w     = size.x();
+                auto h     = size.y();
+
+                vector<byte> left(image.size()), right(image.size()), half(image.size());
+                rotate_pixels(image.data(), size, pixel_size, left.data(), pixel_rotation::left);
+                rotate_pixels(image.data(), size, pixel_size, right.data(), pixel_rotation::right);
+                rotate_pixels(image.data(), size, pixel_size, half.data(), pixel_rotation::half);
+
+                auto horizontal = image;
+                auto vertical   = image;
+                flip_pixels_horizontal(horizontal.data(), size, pixel_size);
+                flip_pixels_vertical(vertical.data(), size, pixel_size);
+
+                bool equal = true;
+                for (u32 y = 0; y < h; ++y) {
+                    for (u32 x = 0; x < w; ++x) {
+                        auto src = pixel_at(image, w, pixel_size, x, y);
+                        auto eq  = [&](const vector<byte>& img, u32 width, u32 dx, u32 dy) {
+                            return std::memcmp(pixel_at(img, width, pixel_size, dx, dy), src, pixel_size) == 0;
+                        };
+                        equal = equal && eq(left, h, y, w - x - 1) && eq(right, h, h - y - 1, x) &&
+                                eq(half, w, w - x - 1, h - y - 1) && eq(horizontal, w, w - x - 1, y) &&
+                                eq(vertical, w, x, h - y - 1);
+                    }
+                }
+                REQUIRE(equal);
+            }
+        }
+
+        vector<byte> image(5 * 5); // NOLINT
+        REQUIRE_THROWS(flip_pixels_horizontal(image.data(), {5, 1}, 5)); // NOLINT
+    }
+}
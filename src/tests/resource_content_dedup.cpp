@@ -0,0 +1,175 @@
+#include <catch2/catch.hpp>
+#include <boost/fiber/future/promise.hpp>
+#include <core/resource_mgr_base.hpp>
+
+using namespace core;
+
+namespace {
+hash_map<string, string>& test_files() {
+    static auto files = [] {
+        hash_map<string, string> result;
+        result.emplace("a.png", string(1000, 'a')); // NOLINT
+        result.emplace("b.png", string(1000, 'a')); // NOLINT
+        result.emplace("c.png", string(1000, 'c')); // NOLINT
+        result.emplace("d.png", string(999, 'a'));  // NOLINT
+        return result;
+    }();
+    return files;
+}
+
+struct test_content {
+    string_view data;
+
+    [[nodiscard]]
+    span<const byte> bytes() const {
+        return {reinterpret_cast<const byte*>(data.data()), static_cast<ssize_t>(data.size())}; // NOLINT
+    }
+};
+
+string file_name(const string& path) {
+    auto slash = path.rfind('/');
+    return slash == string::npos ? path : path.substr(slash + 1);
+}
+} // namespace
+
+class dedup_test_mgr;
+using dedup_test_provider = resource_provider_t<dedup_test_mgr>;
+
+class dedup_test_mgr : public resource_mgr_base<int, int, dedup_test_mgr, dedup_test_provider> {
+public:
+    using resource_mgr_base<int, int, dedup_test_mgr, dedup_test_provider>::resource_mgr_base;
+
+    static inline u32 loads        = 0;
+    static inline u32 mapped_loads = 0;
+
+    job_future<int> load_async_cached(const cfg_path& path) {
+        ++loads;
+        fibers::promise<int> promise;
+        promise.set_value(static_cast<int>(test_files().at(path.path).size()));
+        return promise.get_future();
+    }
+
+    job_future<int> load_async_cached(const cfg_path&, test_content content) {
+        ++loads;
+        ++mapped_loads;
+        fibers::promise<int> promise;
+        promise.set_value(static_cast<int>(content.data.size()));
+        return promise.get_future();
+    }
+
+    static optional<test_content> map_content(const string& path) {
+        auto found = test_files().find(file_name(path));
+        if (found == test_files().end())
+            return nullopt;
+        return test_content{found->second};
+    }
+
+    static int to_cache(int value) {
+        return value;
+    }
+
+    static int from_cache(int&& value) {
+        return value;
+    }
+
+    static u64 resource_size(int) {
+        return 16; // NOLINT
+    }
+
+    static u64 cached_size(int) {
+        return 4; // NOLINT
+    }
+};
+
+TEST_CASE("Fast hash") {
+    auto data = string(100, 'x'); // NOLINT
+    auto hash = [&](size_t size) {
+        return hash_fast64(span<const byte>(reinterpret_cast<const byte*>(data.data()), // NOLINT
+                                            static_cast<ssize_t>(size)));
+    };
+
+    /* Every tail length and the seed affect the hash */
+    vector<u64> hashes;
+    for (size_t size = 0; size <= data.size(); ++size)
+        hashes.push_back(hash(size));
+    std::sort(hashes.begin(), hashes.end());
+    REQUIRE(std::unique(hashes.begin(), hashes.end()) == hashes.end());
+
+    auto before = hash(data.size());
+    data[63]    = 'y'; // NOLINT
+    REQUIRE(hash(data.size()) != before);
+    REQUIRE(hash_fast64(span<const byte>(), 1) != hash_fast64(span<const byte>(), 2));
+}
+
+TEST_CASE("Resource content deduplication") {
+    dedup_test_mgr::loads        = 0;
+    dedup_test_mgr::mapped_loads = 0;
+
+    auto mgr = dedup_test_mgr::create_shared("test_dedup_mgr");
+    mgr->content_dedup(true);
+
+    SECTION("same manager") {
+        auto a = mgr->load(cfg_path("a.png"));
+        auto b = mgr->load(cfg_path("b.png"), load_significance_t::low);
+        auto c = mgr->load(cfg_path("c.png"));
+        auto d = mgr->load(cfg_path("d.png"));
+
+        /* Sources are read once, hashing and loading share the mapping */
+        REQUIRE(dedup_test_mgr::loads == 3);
+        REQUIRE(dedup_test_mgr::mapped_loads == 3);
+        REQUIRE(a.usages() == 2);
+        REQUIRE(b.usages() == 2);
+        REQUIRE(a.try_access() == b.try_access());
+        REQUIRE(a.try_access() != c.try_access());
+        REQUIRE(*d.try_access() == 999); // NOLINT
+
+        /* The less significant path doesn't lower the significance of the shared resource */
+        REQUIRE(a.load_significance() == load_significance_t::medium);
+
+        auto stats = mgr->stats();
+        REQUIRE(stats.dedup_hits == 1);
+        REQUIRE(stats.dedup_file_bytes == 1000);
+        REQUIRE(stats.dedup_bytes_saved == 16);
+        REQUIRE(stats.resident_count == 3);
+
+        /* The path which was loaded first is the path of the shared resource */
+        REQUIRE(b.path().path == "a.png");
+    }
+
+    SECTION("managers of the same type") {
+        auto other = dedup_test_mgr::create_shared("test_dedup_mgr_other");
+        other->content_dedup(true);
+
+        auto a = optional<dedup_test_provider>(mgr->load(cfg_path("a.png")));
+        {
+            auto b = other->load(cfg_path("b.png"));
+            REQUIRE(dedup_test_mgr::loads == 1);
+            REQUIRE(b.try_access() == a->try_access());
+            REQUIRE(b.usages() == 1);
+            REQUIRE(a->usages() == 2);
+
+            auto stats = other->stats();
+            REQUIRE(stats.dedup_hits == 1);
+            REQUIRE(stats.dedup_bytes_saved == 16);
+            REQUIRE(stats.resident_count == 0);
+            REQUIRE(mgr->stats().resident_count == 1);
+        }
+
+        /* The alias releases the shared resource */
+        REQUIRE(a->usages() == 1);
+
+        /* The resource is loaded by the alias manager when the owner is destroyed */
+        a.reset();
+        mgr.reset();
+        auto b = other->load(cfg_path("b.png"));
+        REQUIRE(dedup_test_mgr::loads == 2);
+        REQUIRE(dedup_test_mgr::mapped_loads == 1);
+        REQUIRE(*b.try_access() == 1000); // NOLINT
+        REQUIRE(other->stats().disk_reloads == 1);
+
+        /* Deduplication is disabled by default */
+        auto plain = dedup_test_mgr::create_shared("test_dedup_mgr_plain");
+        auto c     = plain->load(cfg_path("a.png"));
+        REQUIRE(dedup_test_mgr::loads == 3);
+    }
+}
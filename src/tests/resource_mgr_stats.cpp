@@ -0,0 +1,112 @@
+#include <catch2/catch.hpp>
+#include <boost/fiber/future/promise.hpp>
+#include <core/resource_mgr_base.hpp>
+
+using namespace core;
+
+class test_resource_mgr;
+using test_resource_provider = resource_provider_t<test_resource_mgr>;
+
+class test_resource_mgr : public resource_mgr_base<int, int, test_resource_mgr, test_resource_provider> {
+public:
+    using resource_mgr_base<int, int, test_resource_mgr, test_resource_provider>::resource_mgr_base;
+
+    job_future<int> load_async_cached(const cfg_path& path) {
+        fibers::promise<int> promise;
+        promise.set_value(static_cast<int>(path.path.size()));
+        return promise.get_future();
+    }
+
+    static int to_cache(int value) {
+        return value;
+    }
+
+    static int from_cache(int&& value) {
+        return value;
+    }
+
+    static u64 resource_size(int) {
+        return 16; // NOLINT
+    }
+
+    static u64 cached_size(int) {
+        return 4; // NOLINT
+    }
+};
+
+TEST_CASE("Latency histogram") {
+    latency_histogram histogram;
+    REQUIRE(histogram.percentile(50).count() == 0);
+
+    for (int i = 1; i <= 1000; ++i) // NOLINT
+        histogram.record(microseconds(i));
+
+    REQUIRE(histogram.count() == 1000);
+    REQUIRE(histogram.max() == microseconds(1000));
+    REQUIRE(histogram.mean() == microseconds(500));
+
+    /* Error is below the bucket width */
+    auto p50 = histogram.percentile(50).count();
+    REQUIRE(p50 >= 256);
+    REQUIRE(p50 <= 1024);
+    REQUIRE(histogram.percentile(90) >= histogram.percentile(50));
+    REQUIRE(histogram.percentile(100) <= histogram.max());
+}
+
+TEST_CASE("Resource manager stats") {
+    auto mgr = test_resource_mgr::create_shared("test_stats_mgr");
+
+    {
+        auto provider = mgr->load(cfg_path("resource_a"), load_significance_t::medium);
+        REQUIRE(provider.try_access());
+
+        auto stats = mgr->stats();
+        REQUIRE(stats.mgr_tag == "test_stats_mgr");
+        REQUIRE(stats.loads_started == 1);
+        REQUIRE(stats.loads_completed == 1);
+        REQUIRE(stats.resident_count == 1);
+        REQUIRE(stats.resident_bytes == 16);
+        REQUIRE(stats.load_latency.count() == 1);
+    }
+
+    /* The medium significance resource goes to the cache */
+    auto stats = mgr->stats();
+    REQUIRE(stats.resident_count == 0);
+    REQUIRE(stats.cached_count == 1);
+    REQUIRE(stats.cached_bytes == 4);
+
+    {
+        auto provider = mgr->load(cfg_path("resource_a"), load_significance_t::medium);
+        REQUIRE(provider.try_access());
+        REQUIRE(mgr->stats().cache_hits == 1);
+
+        auto low = mgr->load(cfg_path("resource_b"), load_significance_t::low);
+        REQUIRE(mgr->stats().finalize_backlog == 1);
+        REQUIRE(low.try_access());
+        REQUIRE(mgr->stats().finalize_backlog == 0);
+    }
+
+    {
+        /* The low significance resource was unloaded and will be read again */
+        auto low = mgr->load(cfg_path("resource_b"), load_significance_t::low);
+        REQUIRE(low.try_access());
+
+        stats = mgr->stats();
+        REQUIRE(stats.disk_reloads == 1);
+        REQUIRE(stats.loads_started == 3);
+        REQUIRE(stats.loads_completed == 3);
+    }
+
+    auto registered = resource_mgr_stats_reg().get("test_stats_mgr");
+    REQUIRE(registered);
+    REQUIRE(registered->loads_started == 3);
+
+    auto json = resource_mgr_stats_reg().to_json();
+    REQUIRE(json.front() == '[');
+    REQUIRE(json.find("\"mgr_tag\":\"test_stats_mgr\"") != string::npos);
+    REQUIRE(json.find("\"loads_started\":3") != string::npos);
+    REQUIRE(json.find("\"p99\":") != string::npos);
+
+    mgr.reset();
+    REQUIRE_FALSE(resource_mgr_stats_reg().get("test_stats_mgr"));
+}
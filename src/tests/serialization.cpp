@@ -1,7 +1,10 @@
 #include <catch2/catch.hpp>
 #include <core/print.hpp>
+#include <core/compact_serialization.hpp>
 #include <core/serialization.hpp>
+#include <core/serialization_sink.hpp>
 #include <core/vec.hpp>
+#include <random>
 
 struct some_type {
     core::pair<core::string, int> a;
@@ -250,4 +253,338 @@ TEST_CASE("serialization & deserialization") {
 
         REQUIRE(a == b);
     }
+
+    SECTION("trivially serializable ranges") {
+        static_assert(TriviallySerializableRange<vector<vec3f>>);
+        static_assert(TriviallySerializableRange<const array<u32, 4>>);
+        static_assert(!TriviallySerializableRange<vector<bool>>);
+        static_assert(!TriviallySerializableRange<vector<string>>);
+
+        vector<vec3f> positions;
+        for (int i = 0; i < 1000; ++i) // NOLINT
+            positions.push_back(vec3f{float(i), float(i) * 0.5f, -float(i)});
+
+        serializer s;
+        s.write(positions);
+
+        /* Same format as the per-element serialization */
+        byte_vector expected;
+        serialize(static_cast<u64>(positions.size()), expected);
+        for (auto& p : positions)
+            serialize_all(expected, p.x(), p.y(), p.z());
+        REQUIRE(s.data() == expected);
+
+        vector<vec3f> result = {vec3f{1.f, 2.f, 3.f}};
+        auto bytes = s.data();
+        auto ds = deserializer_view(bytes);
+        ds.read(result);
+
+        /* Deserialization appends elements */
+        REQUIRE(result.size() == positions.size() + 1);
+        REQUIRE(std::equal(positions.begin(), positions.end(), result.begin() + 1, [](auto& a, auto& b) {
+            return a.x() == b.x() && a.y() == b.y() && a.z() == b.z();
+        }));
+
+        array<u32, 4> arr = {1, 2, 3, 4};
+        u16 c_arr[3] = {5, 6, 7}; // NOLINT
+        string str = "string";
+
+        serializer s2;
+        s2.write(arr, c_arr, str);
+        REQUIRE(format("{}", s2.data()) ==
+                "{ 0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, "
+                "0x05, 0x00, 0x06, 0x00, 0x07, 0x00, "
+                "0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x73, 0x74, 0x72, 0x69, 0x6e, 0x67 }");
+
+        array<u32, 4> arr2;         // NOLINT
+        u16           c_arr2[3];    // NOLINT
+        string        str2;
+        auto bytes2 = s2.data();
+        auto ds2 = deserializer_view(bytes2);
+        ds2.read(arr2, c_arr2, str2);
+
+        REQUIRE(arr == arr2);
+        REQUIRE(std::equal(std::begin(c_arr), std::end(c_arr), std::begin(c_arr2)));
+        REQUIRE(str == str2);
+    }
+
+    SECTION("aligned ranges") {
+        vector<u32> indices = {0, 1, 2, 2, 3, 0};
+        vector<u32> other   = {42};
+
+        byte_vector bytes;
+        serialize(u8(1), bytes);
+        serialize_aligned(indices, bytes);
+        serialize_aligned(other, bytes);
+
+        /* Payloads start at 16-byte boundaries after the u64 size and the u8 padding size */
+        REQUIRE(bytes.size() == 64 + other.size() * sizeof(u32));
+
+        span<const byte> in = bytes;
+        u8 first; // NOLINT
+        deserialize(first, in);
+
+        span<const u32> view;
+        vector<u32>     storage;
+        REQUIRE(deserialize_view(view, storage, in));
+        REQUIRE(storage.empty());
+        REQUIRE(view.data() == reinterpret_cast<const u32*>(bytes.data() + 16)); // NOLINT
+        REQUIRE(vector<u32>(view.begin(), view.end()) == indices);
+
+        vector<u32> copied = {7, 7, 7, 7, 7, 7, 7, 7}; // NOLINT
+        deserialize_aligned(copied, in);
+        REQUIRE(copied == other);
+        REQUIRE(in.empty());
+
+        /* Misaligned input is copied into the storage */
+        byte_vector aligned;
+        serialize_aligned(indices, aligned);
+
+        byte_vector shifted(1);
+        shifted.insert(shifted.end(), aligned.begin(), aligned.end());
+        span<const byte> shifted_in = span<const byte>(shifted).subspan(1);
+
+        REQUIRE_FALSE(deserialize_view(view, storage, shifted_in));
+        REQUIRE(view.data() == storage.data());
+        REQUIRE(storage == indices);
+        REQUIRE(shifted_in.empty());
+    }
+
+    SECTION("serialized size") {
+        struct test_class {
+            PE_SERIALIZE(a, b, c)
+
+            int                                 a = 1;
+            tuple<optional<int>, array<u16, 3>> b = {5, {1, 2, 3}};
+            vector<string>                      c = {"one", "two", "three"};
+        };
+
+        auto check = [](const auto& value) {
+            serializer s;
+            s.write(value);
+            return serialized_size(value) == s.data().size();
+        };
+
+        REQUIRE(check(u8(1)));
+        REQUIRE(check(-1.0));
+        REQUIRE(check(optional<int>()));
+        REQUIRE(check(string("string")));
+        REQUIRE(check(vec3f{1.f, 2.f, 3.f}));
+        REQUIRE(check(vector<vec3f>(100))); // NOLINT
+        REQUIRE(check(test_class()));
+        REQUIRE(check(vector<test_class>(3)));
+
+        hash_map<string, vector<double>> map;
+        map.emplace("one", vector<double>{1.0});
+        map.emplace("two", vector<double>{2.0, 3.0});
+        REQUIRE(check(map));
+        REQUIRE(check(some_type{{"external", 1}, 2.0}));
+        REQUIRE(serialized_size_all(u32(1), string("abc"), test_class()) ==
+                sizeof(u32) + sizeof(u64) + 3 + serialized_size(test_class()));
+
+        /* Aligned ranges count the maximum padding */
+        byte_vector aligned;
+        serialize_aligned(vector<u32>(3), aligned);
+        REQUIRE(serialized_aligned_size(vector<u32>(3)) >= aligned.size());
+        REQUIRE(serialized_aligned_size(vector<u32>(3)) < aligned.size() + serialization_payload_alignment);
+    }
+
+    SECTION("streaming serializer") {
+        struct aligned_buffer {
+            void serialize(byte_vector& out) const {
+                serialize_aligned(data, out);
+            }
+            void deserialize(span<const byte>& in) {
+                deserialize_aligned(data, in);
+            }
+            vector<u32> data = {1, 2, 3};
+        };
+
+        vector<u32> indices(10000); // NOLINT
+        for (size_t i = 0; i < indices.size(); ++i)
+            indices[i] = static_cast<u32>(i);
+
+        vector<string>   strings(100, "string"); // NOLINT
+        optional<double> opt = 1.0;
+
+        serializer s;
+        s.write(u8(1), indices, strings, opt, aligned_buffer());
+
+        byte_vector_sink     sink;
+        streaming_serializer ss(sink, 100); // NOLINT
+        ss.write(u8(1));
+        ss.write_range(indices);
+        ss.write_range(strings);
+
+        /* The sink receives only full chunks before finish */
+        REQUIRE(sink.data().size() == ss.written());
+        REQUIRE(ss.written() % serialization_payload_alignment == 0);
+        REQUIRE(ss.written() > indices.size() * sizeof(u32));
+
+        ss.write(opt, aligned_buffer());
+        ss.finish();
+
+        /* Same format and same padding as for the whole buffer */
+        REQUIRE(sink.data() == s.data());
+        REQUIRE(ss.written() == s.data().size());
+    }
+
+    SECTION("streaming serializer flushes nested ranges") {
+        struct chunk_sink : byte_vector_sink {
+            void write(span<const byte> chunk) override {
+                max_chunk = std::max(max_chunk, static_cast<size_t>(chunk.size()));
+                ++chunks;
+                byte_vector_sink::write(chunk);
+            }
+            size_t max_chunk = 0;
+            size_t chunks    = 0;
+        };
+
+        struct nested {
+            vector<u32>               indices;
+            vector<vector<string>>    names;
+            hash_map<u32, vector<u8>> map;
+
+            PE_SERIALIZE(indices, names, map)
+        };
+
+        nested value;
+        value.indices.resize(5000); // NOLINT
+        value.names.resize(50, vector<string>(20, "name")); // NOLINT
+        for (u32 i = 0; i < 30; ++i) // NOLINT
+            value.map.emplace(i, vector<u8>(i * 10, u8(i))); // NOLINT
+
+        serializer s;
+        s.write(u8(1), value);
+
+        chunk_sink           sink;
+        streaming_serializer ss(sink, 256); // NOLINT
+        ss.write(u8(1), value);
+
+        /* The value is passed to the sink in chunks while it is being serialized */
+        REQUIRE(sink.chunks > s.data().size() / 512); // NOLINT
+        REQUIRE(sink.max_chunk <= 512); // NOLINT
+
+        ss.finish();
+        REQUIRE(sink.data() == s.data());
+    }
+
+    SECTION("streaming serializer flushes the sink in the middle of a value") {
+        /* Records how many bytes the sink got when the serialization reaches it */
+        struct probe {
+            void serialize(byte_vector& out) const {
+                received = sink ? sink->data().size() : 0;
+                core::serialize(u8(0), out);
+            }
+            void deserialize(span<const byte>& in) {
+                core::deserialize(received, in);
+            }
+            const byte_vector_sink* sink     = nullptr;
+            mutable size_t          received = 0;
+        };
+
+        struct snapshot {
+            vector<u32> first;
+            probe       middle;
+            vector<u32> last;
+
+            PE_SERIALIZE(first, middle, last)
+        };
+
+        byte_vector_sink     sink;
+        streaming_serializer ss(sink, 256); // NOLINT
+
+        snapshot value;
+        value.first.resize(4096); // NOLINT
+        value.last.resize(4096);  // NOLINT
+        value.middle.sink = &sink;
+        ss.write(value);
+
+        /* The first range reached the sink before the rest of the value was serialized */
+        REQUIRE(value.middle.received + 256 >= value.first.size() * sizeof(u32));
+        REQUIRE(sink.data().size() + 512 >= serialized_size(value)); // NOLINT
+
+        REQUIRE(serialized_size_is_direct<vector<vector<string>>>());
+        REQUIRE_FALSE(serialized_size_is_direct<probe>());
+    }
+}
+
+TEST_CASE("compact serialization") {
+    using namespace core;
+
+    SECTION("zigzag and varint") {
+        REQUIRE(zigzag_encode(0) == 0);
+        REQUIRE(zigzag_encode(-1) == 1);
+        REQUIRE(zigzag_encode(1) == 2);
+        REQUIRE(zigzag_decode(zigzag_encode(std::numeric_limits<i32>::min())) == std::numeric_limits<i32>::min());
+        REQUIRE(zigzag_decode(zigzag_encode(std::numeric_limits<i64>::max())) == std::numeric_limits<i64>::max());
+
+        serializer s;
+        s.write(varint<u32>{127}, varint<u32>{128}, varint<i64>{-3}, varint<u64>{~0ULL}); // NOLINT
+        REQUIRE(s.data().size() == 1 + 2 + 1 + 10);
+        REQUIRE(serialized_size(varint<u64>{~0ULL}) == 10);
+
+        varint<u32> a, b;
+        varint<i64> c;
+        varint<u64> d;
+        deserializer_view ds{s.data()};
+        ds.read(a, b, c, d);
+        REQUIRE(a.value == 127);
+        REQUIRE(b.value == 128);
+        REQUIRE(c.value == -3);
+        REQUIRE(d.value == ~0ULL);
+    }
+
+    SECTION("delta encoded") {
+        auto gen = std::mt19937(1337); // NOLINT
+
+        for (size_t count : {0UL, 1UL, 3UL, 4UL, 5UL, 17UL, 1000UL, 4099UL}) { // NOLINT
+            delta_encoded<vector<u32>> indices;
+            for (size_t i = 0; i < count; ++i) {
+                /* Mostly small deltas in both directions with some full-width values */
+                auto r = gen();
+                indices.data.push_back(i % 7 == 0 ? r : static_cast<u32>(i) + r % 16); // NOLINT
+            }
+
+            serializer s;
+            s.write(indices, u8(42)); // NOLINT
+            REQUIRE(serialized_size(indices) + 1 == s.data().size());
+
+            delta_encoded<vector<u32>> result;
+            result.data = {1, 2, 3};
+            u8 tail;
+            deserializer_view ds{s.data()};
+            ds.read(result, tail);
+            REQUIRE(result.data == indices.data);
+            REQUIRE(tail == 42);
+        }
+
+        /* Sequential indices take about a byte per value */
+        delta_encoded<vector<u32>> sequential;
+        for (u32 i = 0; i < 10000; ++i) // NOLINT
+            sequential.data.push_back(i);
+        REQUIRE(serialized_size(sequential) < 10000 + 10000 / 4 + 8);
+
+        /* Raw stream-vbyte round trip */
+        vector<u32> values = {0, 255, 256, 65535, 65536, 1U << 24U, ~0U, 7, 8}; // NOLINT
+        byte_vector encoded(stream_vbyte_max_size(values.size()) + 16); // NOLINT
+        encoded.resize(stream_vbyte_encode(values, encoded.data()));
+        REQUIRE(encoded.size() == 3 + 1 + 1 + 2 + 2 + 3 + 4 + 4 + 1 + 1);
+
+        vector<u32> decoded(values.size());
+        REQUIRE(stream_vbyte_decode(encoded, decoded.data(), decoded.size()) == encoded.size());
+        REQUIRE(decoded == values);
+
+        /* The scalar fallback produces the same stream */
+        byte_vector scalar(encoded.size() + 16); // NOLINT
+        auto data_size = stream_vbyte_details::encode_scalar<false>(
+            values.data(), values.size(), scalar.data(), scalar.data() + 3, 0);
+        scalar.resize(3 + data_size);
+        REQUIRE(scalar == encoded);
+
+        vector<u32> scalar_decoded(values.size());
+        stream_vbyte_details::decode_scalar<false>(
+            scalar.data(), scalar.data() + 3, values.size(), scalar_decoded.data(), 0);
+        REQUIRE(scalar_decoded == values);
+    }
 }
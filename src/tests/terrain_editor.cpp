@@ -0,0 +1,125 @@
+#include <catch2/catch.hpp>
+#include <processing/terrain_generation.hpp>
+#include <cstring>
+#include <random>
+
+using namespace core;
+using namespace prc;
+
+namespace {
+terrain_editor random_terrain(vec2u split_count) {
+    auto         hmap = grx_float_color_map_r({33, 17}); // NOLINT
+    std::mt19937 gen(1);
+    for (auto c : hmap)
+        c = vec{float(gen() % 1000) / 1000.f}; // NOLINT
+    return terrain_editor::generate(hmap, {100.f, 60.f}, 10.f, split_count); // NOLINT
+}
+
+bool same_normals(const terrain_editor& a, const terrain_editor& b) {
+    auto& va = a.get_vertices();
+    auto& vb = b.get_vertices();
+    if (va.size() != vb.size())
+        return false;
+
+    for (size_t i = 0; i < va.size(); ++i) {
+        if (std::memcmp(&va[i].normal, &vb[i].normal, sizeof(vec3f)) != 0 ||
+            std::memcmp(&va[i].position, &vb[i].position, sizeof(vec3f)) != 0)
+            return false;
+    }
+    return true;
+}
+
+float smooth(float v) {
+    return v * v;
+}
+} // namespace
+
+TEST_CASE("Terrain editor") {
+    SECTION("incremental normals are identical to the full recalculation") {
+        auto terrain = random_terrain({61, 43}); // NOLINT
+        auto full    = terrain;
+
+        /* Strokes in the middle, over borders and corners */
+        auto strokes = vector<terrain_editor::brush_stroke>{
+            {1.5f, 10.f, {50.f, 30.f}},  // NOLINT
+            {-2.f, 7.f, {0.f, 0.f}},     // NOLINT
+            {0.7f, 25.f, {99.f, 12.f}},  // NOLINT
+            {3.f, 4.f, {20.f, 59.f}},    // NOLINT
+            {-1.f, 200.f, {50.f, 30.f}}, // NOLINT
+        };
+
+        for (auto& stroke : strokes) {
+            terrain.amplify(stroke.force, stroke.brush_size, stroke.position, smooth);
+            full.amplify(stroke.force, stroke.brush_size, stroke.position, smooth);
+            full.recalc_normals_smooth();
+            REQUIRE(same_normals(terrain, full));
+        }
+    }
+
+    SECTION("batch strokes") {
+        auto terrain = random_terrain({40, 40}); // NOLINT
+        auto single  = terrain;
+
+        auto strokes = vector<terrain_editor::brush_stroke>{
+            {1.f, 12.f, {10.f, 10.f}}, // NOLINT
+            {2.f, 6.f, {80.f, 50.f}},  // NOLINT
+            {-1.f, 9.f, {12.f, 14.f}}, // NOLINT
+        };
+
+        terrain.amplify(strokes, smooth);
+        for (auto& stroke : strokes)
+            single.amplify(stroke.force, stroke.brush_size, stroke.position, smooth);
+        REQUIRE(same_normals(terrain, single));
+
+        single.recalc_normals_smooth();
+        REQUIRE(same_normals(terrain, single));
+    }
+
+    SECTION("generated normals are identical to the full recalculation") {
+        auto terrain = random_terrain({20, 30}); // NOLINT
+        auto full    = terrain;
+        full.recalc_normals_smooth();
+        REQUIRE(same_normals(terrain, full));
+    }
+
+    SECTION("generation") {
+        /* The plane is interpolated exactly */
+        auto hmap = grx_float_color_map_r({17, 9}); // NOLINT
+        for (auto [x, y] : dimensional_seq(hmap.size()))
+            hmap[y][x] = vec{float(x) * 0.05f + float(y) * 0.1f}; // NOLINT
+
+        auto size    = vec2f{32.f, 16.f}; // NOLINT
+        auto terrain = terrain_editor::generate_bilinear(hmap, size, 2.f, {50, 30}); // NOLINT
+        auto scale   = vec2f(hmap.size() - vec2u{1, 1}) / size;
+        auto uv_max  = vec2f{51.f, 31.f}; // NOLINT
+
+        auto& vertices = terrain.get_vertices();
+        REQUIRE(vertices.size() == 52 * 32);
+
+        for (u32 i = 0; i < vertices.size(); ++i) {
+            auto& v  = vertices[i];
+            auto  px = v.position.x() * scale.x();
+            auto  pz = v.position.z() * scale.y();
+            REQUIRE_THAT(v.position.y(), Catch::WithinAbs(2.f * (px * 0.05f + pz * 0.1f), 1e-5)); // NOLINT
+            REQUIRE_THAT(v.uv.x(), Catch::WithinAbs(float(i % 52) / uv_max.x(), 1e-6));           // NOLINT
+            REQUIRE_THAT(v.uv.y(), Catch::WithinAbs(float(i / 52) / uv_max.y(), 1e-6));           // NOLINT
+        }
+
+        /* Every vertex refers to a face of it */
+        auto weighted = random_terrain({37, 23}); // NOLINT
+        auto mesh     = weighted.to_mesh();
+        for (u32 i = 0; auto& v : weighted.get_vertices()) {
+            auto& idxs = mesh.get<grx::mesh_buf_tag::index>();
+            auto  face = v.internal_face_id;
+            REQUIRE((idxs[face * 3] == i || idxs[face * 3 + 1] == i || idxs[face * 3 + 2] == i));
+            ++i;
+        }
+
+        /* Row jobs on the global pool give the results of a serial run */
+        auto serial = fiber_pool(1);
+        auto serial_terrain =
+            terrain_editor::generate(hmap, size, 2.f, {50, 30}, terrain_editor::terrain_gen_identity_curve, &serial);
+        serial.close();
+        REQUIRE(same_normals(serial_terrain, terrain_editor::generate(hmap, size, 2.f, {50, 30}))); // NOLINT
+    }
+}
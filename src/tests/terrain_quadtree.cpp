@@ -0,0 +1,221 @@
+#include <catch2/catch.hpp>
+#include <processing/terrain_quadtree.hpp>
+#include <cstring>
+#include <random>
+
+using namespace core;
+using namespace prc;
+
+namespace {
+bool same_vectors(const vector<vec3f>& a, const vector<vec3f>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(vec3f)) == 0;
+}
+
+float smooth(float v) {
+    return v * v;
+}
+
+terrain_quadtree_settings small_settings() {
+    auto settings       = terrain_quadtree_settings{};
+    settings.tile_cells = 4;
+    settings.levels     = 3;
+    settings.lod_distance = 10.f; // NOLINT
+    return settings;
+}
+
+grx_float_color_map_r random_height_map() {
+    auto         hmap = grx_float_color_map_r({9, 13}); // NOLINT
+    std::mt19937 gen(1);
+    for (auto c : hmap)
+        c = vec{float(gen() % 1000) / 1000.f}; // NOLINT
+    return hmap;
+}
+} // namespace
+
+TEST_CASE("Terrain quadtree") {
+    auto settings = small_settings();
+    auto size     = vec2f{64.f, 32.f}; // NOLINT
+
+    SECTION("structure") {
+        auto  terrain = terrain_quadtree(random_height_map(), size, 5.f, settings); // NOLINT
+        auto& nodes   = terrain.nodes();
+
+        REQUIRE(terrain.grid() == vec2u{17, 17});
+        REQUIRE(terrain.heights().size() == 17 * 17);
+        REQUIRE(nodes.size() == 1 + 4 + 16);
+        REQUIRE(nodes[0].level == 2);
+
+        auto [min_height, max_height] = std::minmax_element(terrain.heights().begin(), terrain.heights().end());
+        REQUIRE(nodes[0].min_height == *min_height);
+        REQUIRE(nodes[0].max_height == *max_height);
+
+        u32 leaves = 0;
+        for (auto& node : nodes) {
+            /* AABBs are registered in frustum_storage */
+            auto registered = node.aabb_proxy.aabb().aabb();
+            REQUIRE(std::memcmp(&registered.min, &node.aabb.min, sizeof(vec3f)) == 0);
+            REQUIRE(std::memcmp(&registered.max, &node.aabb.max, sizeof(vec3f)) == 0);
+            REQUIRE(node.aabb.min.y() < node.min_height);
+
+            if (node.children == terrain_quadtree::no_children) {
+                REQUIRE(node.level == 0);
+                ++leaves;
+                continue;
+            }
+
+            auto half = settings.tile_cells << (node.level - 1);
+            for (u32 i = 0; i < 4; ++i) {
+                auto& child = nodes[node.children + i];
+                REQUIRE(child.level == node.level - 1);
+                REQUIRE(child.first == node.first + vec2u{i % 2, i / 2} * half);
+                REQUIRE(child.min_height >= node.min_height);
+                REQUIRE(child.max_height <= node.max_height);
+            }
+        }
+        REQUIRE(leaves == 16);
+    }
+
+    SECTION("heights of the plane") {
+        auto hmap = grx_float_color_map_r({5, 9}); // NOLINT
+        for (auto [x, y] : dimensional_seq(hmap.size()))
+            hmap[y][x] = vec{float(x) * 0.1f + float(y) * 0.05f}; // NOLINT
+
+        auto terrain = terrain_quadtree(hmap, size, 2.f, settings);
+        for (auto [x, y] : dimensional_seq(terrain.grid())) {
+            auto p = vec2f{float(x), float(y)} * vec2f(hmap.size() - vec2u{1, 1}) / 16.f; // NOLINT
+            REQUIRE_THAT(terrain.heights()[y * 17 + x], Catch::WithinAbs(2.f * (p.x() * 0.1f + p.y() * 0.05f), 1e-5));
+        }
+    }
+
+    SECTION("heights of the plane with a non-power-of-two tile") {
+        /* 7 * float(57 / 7) rounds to 57.0000038, the last vertex must not sample past the last texel */
+        auto hmap = grx_float_color_map_r({58, 58}); // NOLINT
+        for (auto [x, y] : dimensional_seq(hmap.size()))
+            hmap[y][x] = vec{float(x) * 0.01f + float(y) * 0.02f}; // NOLINT
+
+        auto npot_settings       = settings;
+        npot_settings.tile_cells = 7; // NOLINT
+        npot_settings.levels     = 1;
+
+        auto terrain = terrain_quadtree(hmap, size, 1.f, npot_settings);
+        REQUIRE(terrain.grid() == vec2u{8, 8});
+        for (auto [x, y] : dimensional_seq(terrain.grid())) {
+            auto p = vec2f{float(x), float(y)} * 57.f / 7.f; // NOLINT
+            REQUIRE_THAT(terrain.heights()[y * 8 + x], Catch::WithinAbs(p.x() * 0.01f + p.y() * 0.02f, 1e-4));
+        }
+    }
+
+    SECTION("meshes") {
+        auto terrain = terrain_quadtree(random_height_map(), size, 5.f, settings); // NOLINT
+        terrain.build_meshes();
+
+        for (u32 i = 0; i < terrain.nodes().size(); ++i) {
+            auto& node      = terrain.nodes()[i];
+            auto& mesh      = terrain.mesh(i);
+            auto& positions = mesh.get<grx::mesh_buf_tag::position>();
+            auto  step      = 1U << node.level;
+
+            REQUIRE(node.generation == 1);
+            REQUIRE(positions.size() == 5 * 5 + 4 * 4);
+            REQUIRE(mesh.get<grx::mesh_buf_tag::index>().size() == 4 * 4 * 6 + 4 * 4 * 6);
+            REQUIRE(mesh.elements().size() == 1);
+
+            for (auto [x, y] : dimensional_seq(vec2u{5, 5})) {
+                auto  g = node.first + vec2u{x, y} * step;
+                auto& p = positions[y * 5 + x];
+                REQUIRE(p.y() == terrain.heights()[g.y() * 17 + g.x()]);
+                REQUIRE_THAT(p.x(), Catch::WithinAbs(float(g.x()) * 4.f, 1e-5)); // NOLINT
+                REQUIRE_THAT(p.z(), Catch::WithinAbs(float(g.y()) * 2.f, 1e-5)); // NOLINT
+            }
+
+            /* Skirts are below the node */
+            for (size_t v = 25; v < positions.size(); ++v) // NOLINT
+                REQUIRE(positions[v].y() <= node.min_height);
+        }
+
+        /* Normals of shared vertices of neighbouring nodes of the level are the same */
+        auto& left  = terrain.mesh(5);
+        auto& right = terrain.mesh(6);
+        REQUIRE(terrain.nodes()[6].first == terrain.nodes()[5].first + vec2u{4, 0});
+        for (u32 y = 0; y < 5; ++y) {
+            auto a = left.get<grx::mesh_buf_tag::normal>()[y * 5 + 4];
+            auto b = right.get<grx::mesh_buf_tag::normal>()[y * 5];
+            REQUIRE(std::memcmp(&a, &b, sizeof(vec3f)) == 0);
+        }
+    }
+
+    SECTION("selection") {
+        auto  terrain = terrain_quadtree(random_height_map(), size, 5.f, settings); // NOLINT
+        auto& nodes   = terrain.nodes();
+
+        /* Far away - only the root */
+        auto far = terrain.select({0.f, 1000.f, 0.f}, false); // NOLINT
+        REQUIRE(far == vector<u32>{0});
+
+        /* Selected nodes cover every cell once, the nearest node is a leaf */
+        auto near = terrain.select({1.f, 3.f, 1.f}, false);
+        auto covered = vector<int>(16 * 16, 0);
+        bool has_leaf = false;
+        bool has_coarse = false;
+        for (auto idx : near) {
+            auto span = settings.tile_cells << nodes[idx].level;
+            for (auto [x, y] : dimensional_seq(nodes[idx].first, nodes[idx].first + vec2u{span, span}))
+                ++covered[y * 16 + x];
+            has_leaf   = has_leaf || nodes[idx].level == 0;
+            has_coarse = has_coarse || nodes[idx].level > 0;
+        }
+        REQUIRE(std::all_of(covered.begin(), covered.end(), [](int c) { return c == 1; }));
+        REQUIRE(has_leaf);
+        REQUIRE(has_coarse);
+        REQUIRE(nodes[near.front()].level == 0);
+    }
+
+    SECTION("edits rebuild only affected nodes") {
+        auto terrain = terrain_quadtree(random_height_map(), size, 5.f, settings); // NOLINT
+        terrain.build_meshes();
+
+        /* The brush near the origin changes vertices of the first leaf only */
+        terrain.amplify(2.f, 5.f, {6.f, 4.f}, smooth); // NOLINT
+
+        vector<u32> generations;
+        for (auto& node : terrain.nodes())
+            generations.push_back(node.generation);
+
+        terrain.build_meshes();
+
+        u32 rebuilt = 0;
+        for (u32 i = 0; i < terrain.nodes().size(); ++i) {
+            auto& node = terrain.nodes()[i];
+            auto  step = 1U << node.level;
+            if (node.generation == generations[i])
+                continue;
+
+            ++rebuilt;
+            /* Changed vertices are in [0, 4) x [0, 4) */
+            REQUIRE(node.first.x() <= 4 + step);
+            REQUIRE(node.first.y() <= 4 + step);
+        }
+        REQUIRE(rebuilt > 0);
+        REQUIRE(rebuilt < terrain.nodes().size() / 2);
+
+        /* Updated nodes are the same as nodes of the new terrain */
+        auto fresh = terrain_quadtree(terrain.heights(), size, settings);
+        fresh.build_meshes();
+        for (u32 i = 0; i < terrain.nodes().size(); ++i) {
+            auto& a = terrain.mesh(i);
+            auto& b = fresh.mesh(i);
+            REQUIRE(same_vectors(a.get<grx::mesh_buf_tag::position>(), b.get<grx::mesh_buf_tag::position>()));
+            REQUIRE(same_vectors(a.get<grx::mesh_buf_tag::normal>(), b.get<grx::mesh_buf_tag::normal>()));
+            REQUIRE(terrain.nodes()[i].min_height == fresh.nodes()[i].min_height);
+            REQUIRE(terrain.nodes()[i].max_height == fresh.nodes()[i].max_height);
+        }
+    }
+
+    SECTION("invalid arguments") {
+        REQUIRE_THROWS(terrain_quadtree(vector<float>(10), size, settings)); // NOLINT
+        settings.levels = 0;
+        REQUIRE_THROWS(terrain_quadtree(vector<float>(), size, settings));
+        settings.levels = 65; // NOLINT
+        REQUIRE_THROWS(terrain_quadtree(vector<float>(), size, settings));
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <core/vec.hpp>
+#include <util/vtf_format.hpp>
+#include <cstring>
+#include <random>
+
+/* Fixtures shared by the tests */
+namespace test_helpers
+{
+using namespace core;
+
+/**
+ * @brief Generates reproducible random bytes
+ */
+inline vector<byte> random_bytes(size_t count, u32 seed) {
+    std::mt19937 gen(seed);
+    vector<byte> result(count);
+    for (auto& b : result)
+        b = static_cast<byte>(gen());
+    return result;
+}
+
+/**
+ * @brief Generates a reproducible random image with 8-bit channels
+ */
+inline vector<u8> random_image(vec2u size, size_t channels, u32 seed) {
+    std::mt19937 gen(seed);
+    vector<u8>   image(size_t(size.x()) * size.y() * channels);
+    for (auto& v : image)
+        v = static_cast<u8>(gen());
+    return image;
+}
+
+/**
+ * @brief Makes a VTF 7.2 file without the low resolution image
+ *
+ * @param format - the high resolution image format
+ * @param size - the size of the largest mipmap
+ * @param mipmaps - the count of mipmaps
+ * @param levels - mipmaps from the largest one, mipmaps which are not given are filled with random bytes
+ *
+ * @return the file bytes, mipmaps are stored from the smallest to the largest as in the format
+ */
+inline vector<byte> make_vtf(util::vtf_image_format format, vec2u size, u8 mipmaps, span<const byte> levels) {
+    vector<byte> file(util::VTF_HEADER_SIZE);
+    auto         write = [&](size_t offset, const auto& value) {
+        std::memcpy(file.data() + offset, &value, sizeof(value));
+    };
+
+    write(0, array{'V', 'T', 'F', '\0'});
+    write(4, array<u32, 2>{7, 2}); // NOLINT
+    write(12, u32(util::VTF_HEADER_SIZE)); // NOLINT
+    write(16, vec2<u16>{u16(size.x()), u16(size.y())}); // NOLINT
+    write(24, u16(1)); // NOLINT
+    write(52, format); // NOLINT
+    write(56, mipmaps); // NOLINT
+    write(57, util::vtf_image_format::DXT1); // NOLINT
+    write(61, vec2<u8>{0, 0}); // NOLINT
+    write(63, u16(1)); // NOLINT
+
+    auto generated = random_bytes(util::vtf_view::skip_mipmaps_bytes(format, mipmaps, size) +
+                                      util::vtf_view::image_data_size(format, size),
+                                  size.x() * 31 + size.y()); // NOLINT
+    auto filler    = span<const byte>(generated);
+
+    vector<span<const byte>> level_spans;
+    for (u32 i = 0; i < mipmaps; ++i) {
+        auto level_size = vec2u{std::max(size.x() >> i, 1U), std::max(size.y() >> i, 1U)};
+        auto length     = ssize_t(util::vtf_view::image_data_size(format, level_size));
+
+        auto& source = levels.size() >= length ? levels : filler;
+        level_spans.push_back(source.first(length));
+        source = source.subspan(length);
+    }
+
+    for (auto i = level_spans.rbegin(); i != level_spans.rend(); ++i)
+        file.insert(file.end(), i->begin(), i->end());
+
+    return file;
+}
+} // namespace test_helpers
@@ -1,2 +1,12 @@
-#define CATCH_CONFIG_MAIN
-#include <catch2/catch.hpp>
\ No newline at end of file
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+#include <core/fiber_pool.hpp>
+
+int main(int argc, char* argv[]) {
+    auto result = Catch::Session().run(argc, argv);
+
+    /* Work-stealing schedulers can be created only once per process, so all tests share the global pool */
+    core::global_fiber_pool().close();
+
+    return result;
+}
@@ -0,0 +1,203 @@
+#include <catch2/catch.hpp>
+#include <util/texture_encode.hpp>
+#include <cmath>
+#include <random>
+
+using namespace core;
+using namespace util;
+
+namespace {
+/* Smooth gradients with soft edges and some noise, like a photo or a painted texture */
+vector<u8> make_image(vec2u size, u32 seed) {
+    std::mt19937                  gen(seed);
+    std::normal_distribution<float> noise(0.f, 3.f);
+
+    vector<u8> image(size_t(size.x()) * size.y() * 4);
+    for (u32 y = 0; y < size.y(); ++y) {
+        for (u32 x = 0; x < size.x(); ++x) {
+            auto fx = float(x) / float(size.x());
+            auto fy = float(y) / float(size.y());
+            auto p  = image.data() + (size_t(y) * size.x() + x) * 4;
+
+            array<float, 4> color = {255.f * fx,
+                                     128.f + 100.f * std::sin(fx * 6.f + fy * 3.f),
+                                     255.f * fy,
+                                     fx + fy < 1.f ? 255.f : 64.f + 128.f * fy};
+            for (size_t c = 0; c < 4; ++c)
+                p[c] = u8(std::clamp(color[c] + noise(gen), 0.f, 255.f));
+        }
+    }
+    return image;
+}
+
+vector<u8> channels_of(const vector<u8>& rgba, size_t first, size_t count) {
+    vector<u8> result;
+    for (size_t i = 0; i < rgba.size(); i += 4)
+        result.insert(result.end(), rgba.begin() + ssize_t(i + first), rgba.begin() + ssize_t(i + first + count));
+    return result;
+}
+
+vector<u8> round_trip(dxt_format format, const vector<u8>& image, vec2u size, dxt_encode_quality quality) {
+    vector<byte> blocks(dxt_data_size(format, size));
+    dxt_encode(format, image.data(), size, 4, blocks, quality);
+
+    vector<u8> decoded(image.size());
+    dxt_decode(format, blocks, size, decoded.data());
+    return decoded;
+}
+} // namespace
+
+TEST_CASE("Texture encoding") {
+    SECTION("psnr") {
+        auto size  = vec2u{256, 128};
+        auto image = make_image(size, 1);
+        auto rgb   = channels_of(image, 0, 3);
+
+        for (auto format : {dxt_format::dxt1, dxt_format::dxt3, dxt_format::dxt5, dxt_format::bc7}) {
+            auto fast = round_trip(format, image, size, dxt_encode_quality::fast);
+            auto high = round_trip(format, image, size, dxt_encode_quality::high);
+
+            auto fast_psnr = image_psnr(rgb, channels_of(fast, 0, 3));
+            auto high_psnr = image_psnr(rgb, channels_of(high, 0, 3));
+
+            INFO(magic_enum::enum_name(format) << " RGB PSNR: fast " << fast_psnr << " dB, high " << high_psnr
+                                               << " dB");
+            REQUIRE(fast_psnr > (format == dxt_format::bc7 ? 38.0 : 33.0));
+            REQUIRE(high_psnr >= fast_psnr);
+
+            if (format != dxt_format::dxt1) {
+                auto alpha      = channels_of(image, 3, 1);
+                auto alpha_psnr = image_psnr(alpha, channels_of(high, 3, 1));
+                INFO("Alpha PSNR " << alpha_psnr << " dB");
+                REQUIRE(alpha_psnr > (format == dxt_format::dxt3 ? 30.0 : 40.0));
+            }
+            else {
+                REQUIRE(channels_of(high, 3, 1) == vector<u8>(size.x() * size.y(), 255));
+            }
+        }
+
+        REQUIRE(std::isinf(image_psnr(rgb, rgb)));
+        REQUIRE_THROWS(image_psnr(rgb, image));
+    }
+
+    SECTION("single color blocks") {
+        array<u8, 64> rgba; // NOLINT
+        for (size_t i = 0; i < 64; i += 4) {
+            rgba[i]     = 200; // NOLINT
+            rgba[i + 1] = 100; // NOLINT
+            rgba[i + 2] = 50;  // NOLINT
+            rgba[i + 3] = 255; // NOLINT
+        }
+
+        array<byte, 8> block; // NOLINT
+        array<u8, 64>  decoded; // NOLINT
+        dxt_encode_block(dxt_format::dxt1, rgba.data(), block.data(), dxt_encode_quality::high);
+        dxt_decode_block(dxt_format::dxt1, block.data(), decoded.data());
+
+        for (size_t i = 0; i < 64; ++i)
+            REQUIRE(std::abs(int(decoded[i]) - int(rgba[i])) <= 4);
+    }
+
+    SECTION("bc7 blocks") {
+        /* Mode 6: R endpoints 0x7F and 0, p-bits 1 and 0 (the p-bit is the lowest bit of all components),
+         * the pixel 15 has the last index */
+        array<byte, 16> mode6 = {}; // NOLINT
+        mode6[0]  = byte(0xC0);     // NOLINT
+        mode6[1]  = byte(0x3F);     // NOLINT
+        mode6[7]  = byte(0x80);     // NOLINT
+        mode6[15] = byte(0xF0);     // NOLINT
+
+        array<u8, 64> decoded; // NOLINT
+        dxt_decode_block(dxt_format::bc7, mode6.data(), decoded.data());
+        REQUIRE(decoded[0] == 255);
+        REQUIRE(decoded[1] == 1);
+        REQUIRE(decoded[3] == 1);
+        REQUIRE(decoded[4] == 255);
+        REQUIRE(decoded[60] == 0);
+        REQUIRE(decoded[63] == 0);
+
+        /* The reserved mode 8 (no mode bit is set) is decoded as transparent black */
+        array<byte, 16> reserved = {}; // NOLINT
+        dxt_decode_block(dxt_format::bc7, reserved.data(), decoded.data());
+        REQUIRE(decoded == array<u8, 64>{});
+
+        /* A flat color and a stripe of two other colors split by a vertical edge do not lie on one line,
+         * but they are encoded with two subsets almost losslessly */
+        array<array<u8, 3>, 3> colors = {array<u8, 3>{230, 40, 90}, {20, 210, 150}, {60, 90, 240}}; // NOLINT
+        array<u8, 64>          edge; // NOLINT
+        for (size_t i = 0; i < 16; ++i) {
+            auto& color = colors[i % 4 < 2 ? 0 : 1 + i / 4 % 2];
+            std::copy(color.begin(), color.end(), edge.begin() + ssize_t(i * 4));
+            edge[i * 4 + 3] = 255; // NOLINT
+        }
+
+        array<byte, 16> block; // NOLINT
+        dxt_encode_block(dxt_format::bc7, edge.data(), block.data(), dxt_encode_quality::high);
+        REQUIRE((u8(block[0]) & 0x3) == 0x2); // NOLINT
+        dxt_decode_block(dxt_format::bc7, block.data(), decoded.data());
+        for (size_t i = 0; i < 64; ++i)
+            REQUIRE(std::abs(int(decoded[i]) - int(edge[i])) <= 3);
+    }
+
+    SECTION("one bit alpha") {
+        auto size  = vec2u{37, 21};
+        auto image = make_image(size, 2);
+        auto alpha = channels_of(image, 3, 1);
+
+        auto decoded = round_trip(dxt_format::dxt1_onebitalpha, image, size, dxt_encode_quality::high);
+        for (size_t i = 0; i < alpha.size(); ++i)
+            REQUIRE(decoded[i * 4 + 3] == (alpha[i] < 128 ? 0 : 255));
+
+        /* Opaque pixels keep the color */
+        vector<u8> opaque_ref, opaque;
+        for (size_t i = 0; i < alpha.size(); ++i) {
+            if (alpha[i] >= 128) {
+                opaque_ref.insert(opaque_ref.end(), image.begin() + ssize_t(i * 4), image.begin() + ssize_t(i * 4 + 3));
+                opaque.insert(opaque.end(), decoded.begin() + ssize_t(i * 4), decoded.begin() + ssize_t(i * 4 + 3));
+            }
+        }
+        REQUIRE(image_psnr(opaque_ref, opaque) > 30.0);
+    }
+
+    SECTION("parallel encoding matches block encoding") {
+        auto size  = vec2u{133, 67};
+        auto image = make_image(size, 3);
+
+        for (auto format :
+             {dxt_format::dxt1, dxt_format::dxt1_onebitalpha, dxt_format::dxt3, dxt_format::dxt5, dxt_format::bc7}) {
+            INFO(magic_enum::enum_name(format));
+
+            /* RGB input is encoded as opaque RGBA */
+            auto rgb = channels_of(image, 0, 3);
+            vector<byte> blocks(dxt_data_size(format, size));
+            dxt_encode(format, rgb.data(), size, 3, blocks);
+
+            auto block_size = dxt_block_size(format);
+            auto count      = dxt_blocks_count(size);
+            for (u32 by = 0; by < count.y(); ++by) {
+                for (u32 bx = 0; bx < count.x(); ++bx) {
+                    array<u8, 64> rgba; // NOLINT
+                    for (u32 y = 0; y < 4; ++y) {
+                        for (u32 x = 0; x < 4; ++x) {
+                            auto sx  = std::min(bx * 4 + x, size.x() - 1);
+                            auto sy  = std::min(by * 4 + y, size.y() - 1);
+                            auto src = rgb.data() + (size_t(sy) * size.x() + sx) * 3;
+                            auto dst = rgba.data() + (y * 4 + x) * 4;
+                            std::copy(src, src + 3, dst);
+                            dst[3] = 255; // NOLINT
+                        }
+                    }
+
+                    array<byte, 16> block; // NOLINT
+                    dxt_encode_block(format, rgba.data(), block.data());
+                    auto offset = (size_t(by) * count.x() + bx) * block_size;
+                    REQUIRE(std::memcmp(block.data(), blocks.data() + offset, block_size) == 0);
+                }
+            }
+        }
+
+        vector<byte> small(10);
+        REQUIRE_THROWS(dxt_encode(dxt_format::dxt5, image.data(), size, 4, small));
+        REQUIRE_THROWS(dxt_encode(dxt_format::dxt5, image.data(), size, 2, small));
+    }
+}
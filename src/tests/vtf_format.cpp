@@ -0,0 +1,170 @@
+#include <catch2/catch.hpp>
+#include <core/md5.hpp>
+#include <util/vtf_format.hpp>
+#include <sstream>
+#include "test_helpers.hpp"
+
+using namespace core;
+using namespace util;
+using namespace test_helpers;
+
+namespace {
+string md5_string(span<const u8> data) {
+    std::stringstream ss;
+    ss << md5(data.data(), static_cast<size_t>(data.size()));
+    return ss.str();
+}
+} // namespace
+
+TEST_CASE("VTF decoding") {
+    SECTION("known DXT blocks") {
+        /* Red and blue endpoints, indices 0, 1, 2, 3 in every row */
+        array<byte, 8> four_colors = {byte(0x00), byte(0xf8), byte(0x1f), byte(0x00),
+                                      byte(0xe4), byte(0xe4), byte(0xe4), byte(0xe4)};
+        array<u8, 64> rgba; // NOLINT
+        dxt_decode_block(dxt_format::dxt1, four_colors.data(), rgba.data());
+
+        for (size_t y = 0; y < 4; ++y) {
+            auto row = rgba.data() + y * 16;
+            REQUIRE(vector<u8>(row, row + 16) ==
+                    vector<u8>{255, 0, 0, 255, 0, 0, 255, 255, 170, 0, 85, 255, 85, 0, 170, 255});
+        }
+
+        /* c0 <= c1 selects 3 colors and transparent black */
+        array<byte, 8> three_colors = {byte(0x1f), byte(0x00), byte(0x00), byte(0xf8),
+                                       byte(0xe4), byte(0xe4), byte(0xe4), byte(0xe4)};
+        dxt_decode_block(dxt_format::dxt1_onebitalpha, three_colors.data(), rgba.data());
+        REQUIRE(vector<u8>(rgba.data(), rgba.data() + 16) ==
+                vector<u8>{0, 0, 255, 255, 255, 0, 0, 255, 127, 0, 127, 255, 0, 0, 0, 0});
+
+        dxt_decode_block(dxt_format::dxt1, three_colors.data(), rgba.data());
+        REQUIRE(rgba[15] == 255);
+
+        /* DXT5 alpha with 8 interpolated values, every pixel uses index 2 */
+        array<byte, 16> dxt5 = {byte(255), byte(0)};
+        u64 alpha_bits = 0;
+        for (u32 i = 0; i < 16; ++i)
+            alpha_bits |= u64(2) << (i * 3);
+        std::memcpy(dxt5.data() + 2, &alpha_bits, 6);
+        dxt_decode_block(dxt_format::dxt5, dxt5.data(), rgba.data());
+        REQUIRE(rgba[3] == 218);
+        REQUIRE(rgba[63] == 218);
+
+        /* DXT3 alpha nibbles: 0, 15, 5, 8 in the first row */
+        array<byte, 16> dxt3 = {byte(0xf0), byte(0x85)};
+        std::memcpy(dxt3.data() + 8, four_colors.data(), four_colors.size());
+        dxt_decode_block(dxt_format::dxt3, dxt3.data(), rgba.data());
+        REQUIRE(vector<u8>(rgba.data(), rgba.data() + 16) ==
+                vector<u8>{255, 0, 0, 0, 0, 0, 255, 255, 170, 0, 85, 85, 85, 0, 170, 136});
+    }
+
+    SECTION("known packed pixels") {
+        array<u8, 8> rgba; // NOLINT
+
+        array<byte, 4> bgra4444 = {byte(0x34), byte(0x12), byte(0xf0), byte(0x0f)};
+        decode_packed_pixels(packed_pixel_format::bgra4444, bgra4444, 2, rgba.data());
+        REQUIRE(rgba == array<u8, 8>{34, 51, 68, 17, 255, 255, 0, 0});
+
+        array<byte, 4> bgra5551 = {byte(0x21), byte(0x84), byte(0xff), byte(0x7f)};
+        decode_packed_pixels(packed_pixel_format::bgra5551, bgra5551, 2, rgba.data());
+        REQUIRE(rgba == array<u8, 8>{8, 8, 8, 255, 255, 255, 255, 0});
+
+        decode_packed_pixels(packed_pixel_format::bgrx5551, bgra5551, 2, rgba.data());
+        REQUIRE(rgba == array<u8, 8>{8, 8, 8, 255, 255, 255, 255, 255});
+
+        array<byte, 8> bgrx8888 = {byte(1), byte(2), byte(3), byte(4), byte(5), byte(6), byte(7), byte(8)};
+        decode_packed_pixels(packed_pixel_format::bgrx8888, bgrx8888, 2, rgba.data());
+        REQUIRE(rgba == array<u8, 8>{3, 2, 1, 255, 7, 6, 5, 255});
+    }
+
+    SECTION("images") {
+        struct image_case {
+            vtf_image_format format;
+            vec2u            size;
+            string           digest; /* md5 of the decoded image */
+        };
+
+        /* Partial blocks, small mipmaps and images large enough for parallel decoding */
+        vector<image_case> cases = {
+            {vtf_image_format::DXT1, {64, 64}, "7d9fd9ca7cc38aab95675fd81210b78c"},
+            {vtf_image_format::DXT1, {37, 21}, "e4e3b992fb0ed0a46862e530cc1d3779"},
+            {vtf_image_format::DXT1, {2, 2}, "706ea2297d56ab0f4e3c52229d3ca2a8"},
+            {vtf_image_format::DXT1, {1, 7}, "0067a0b70a5f113586f1579d623bc341"},
+            {vtf_image_format::DXT1, {512, 260}, "e9a37257e801145145e9e54991f1b57e"},
+            {vtf_image_format::DXT1_ONEBITALPHA, {64, 64}, "d8365d2ced8441dfb2a919c6bc6bf254"},
+            {vtf_image_format::DXT1_ONEBITALPHA, {37, 21}, "79264661bc43e50ebceb134e0f6f43bd"},
+            {vtf_image_format::DXT1_ONEBITALPHA, {2, 2}, "11b496aa1012c41a982a8d3b2d034708"},
+            {vtf_image_format::DXT1_ONEBITALPHA, {1, 7}, "29a46c7912a10187bd6052e09a77600c"},
+            {vtf_image_format::DXT1_ONEBITALPHA, {512, 260}, "5c2c235eb5dfe5699fca1a9da2a7e53e"},
+            {vtf_image_format::DXT3, {64, 64}, "5f4d743fb3cc227c82f27cc26ba8d603"},
+            {vtf_image_format::DXT3, {37, 21}, "5c04e3fbab45c6625781ba0d0afe3370"},
+            {vtf_image_format::DXT3, {2, 2}, "89b3dcfaddda74adf204d700044673a9"},
+            {vtf_image_format::DXT3, {1, 7}, "aa8c4ba6f734fa1ff32742b575817270"},
+            {vtf_image_format::DXT3, {512, 260}, "95299d67677ee0667ecc0a36eed0abe5"},
+            {vtf_image_format::DXT5, {64, 64}, "81eab6d8c2b0a0d654e1b90495c55b82"},
+            {vtf_image_format::DXT5, {37, 21}, "1c1b71981a44d15d0c967dea395864e4"},
+            {vtf_image_format::DXT5, {2, 2}, "55b1eaa9ec11ba7183cf26e95088e93f"},
+            {vtf_image_format::DXT5, {1, 7}, "4882c84c70553cb9b000dbd97382a86c"},
+            {vtf_image_format::DXT5, {512, 260}, "11d1d144c103d12c1732948ccfde1e53"},
+            {vtf_image_format::BGRA4444, {64, 64}, "5be58252031d98606780ed741354a746"},
+            {vtf_image_format::BGRA4444, {37, 21}, "4161c9d55d9b0766114b6c2bbed3eb59"},
+            {vtf_image_format::BGRA4444, {2, 2}, "9c5f0b87697f3ca6ca64b61c5d25e024"},
+            {vtf_image_format::BGRA4444, {1, 7}, "9c3c075ca7e72abecaff6ddcef40392c"},
+            {vtf_image_format::BGRA4444, {512, 260}, "f580dadb7d13aabc7058e4c2765db654"},
+            {vtf_image_format::BGRA5551, {64, 64}, "7db436554abd868ad49ff3dcf77d0516"},
+            {vtf_image_format::BGRA5551, {37, 21}, "3316869d8869e88c62b6e514b8d01007"},
+            {vtf_image_format::BGRA5551, {2, 2}, "b52df15124b6098587fc0bacf25ede51"},
+            {vtf_image_format::BGRA5551, {1, 7}, "f479cafc1c15c03f23ff3a725480f799"},
+            {vtf_image_format::BGRA5551, {512, 260}, "5cf1ae30d160afd9b6e73ad273555a94"},
+            {vtf_image_format::BGRX5551, {64, 64}, "70da115dfcaf6e2f51e4637b390c9edf"},
+            {vtf_image_format::BGRX5551, {37, 21}, "9bc305c18c47d2a14c925683e269d860"},
+            {vtf_image_format::BGRX5551, {2, 2}, "c758fc39734bb0e87ac9e3c7e0f927cb"},
+            {vtf_image_format::BGRX5551, {1, 7}, "cc93ca30a92fa6d3463f6608b7e84793"},
+            {vtf_image_format::BGRX5551, {512, 260}, "2c7ba71080336e956db6ee368a422a89"},
+            {vtf_image_format::BGRX8888, {64, 64}, "72cb353cb3212ab1ef40cbf5b84e3be5"},
+            {vtf_image_format::BGRX8888, {37, 21}, "a2e86b36ac69198823379913462bec9a"},
+            {vtf_image_format::BGRX8888, {2, 2}, "a37cead59ad4e848313760b75937fdad"},
+            {vtf_image_format::BGRX8888, {1, 7}, "e2e7ec5ad6c5319799d508e44ec6b0d0"},
+            {vtf_image_format::BGRX8888, {512, 260}, "998e49dde2d350cf638834a16e2133b6"},
+        };
+
+        for (auto& [format, size, digest] : cases) {
+            auto image = random_bytes(vtf_view::image_data_size(format, size), u32(format) * 1000 + size.x());
+
+            /* Make half of DXT1 blocks use 3-color mode */
+            if (format == vtf_image_format::DXT1 || format == vtf_image_format::DXT1_ONEBITALPHA)
+                for (size_t i = 0; i < image.size(); i += 16)
+                    std::swap(image[i], image[i + 2]);
+
+            auto file = make_vtf(format, size, 5, image);
+            auto vtf  = vtf_view(file);
+            REQUIRE(vtf.is_valid());
+
+            auto       channels = vtf.high_res_channels_count();
+            vector<u8> decoded(size.x() * size.y() * channels);
+            vtf.read_high_res(decoded.data());
+
+            INFO(magic_enum::enum_name(format) << " " << size.x() << "x" << size.y());
+            REQUIRE(md5_string(decoded) == digest);
+        }
+    }
+
+    SECTION("uncompressed formats skip mipmaps") {
+        auto         size = vec2u{16, 8};
+        vector<byte> image(size.x() * size.y() * 4);
+        for (size_t i = 0; i < image.size(); ++i)
+            image[i] = byte(i);
+
+        auto file = make_vtf(vtf_image_format::UVWQ8888, size, 4, image);
+        vector<u8> decoded(image.size());
+        vtf_view(file).read_high_res(decoded.data());
+        REQUIRE(std::memcmp(decoded.data(), image.data(), image.size()) == 0);
+    }
+
+    SECTION("truncated data") {
+        vector<byte> image(10);
+        vector<u8>   output(64 * 64 * 4);
+        REQUIRE_THROWS(dxt_decode(dxt_format::dxt5, image, {64, 64}, output.data()));
+        REQUIRE_THROWS(decode_packed_pixels(packed_pixel_format::bgra4444, image, 6, output.data()));
+    }
+}
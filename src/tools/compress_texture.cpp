@@ -0,0 +1,101 @@
+#include <core/main.cpp>
+#include <core/types.hpp>
+#include <graphics/grx_color_map.hpp>
+
+using namespace core;
+using namespace grx;
+
+PE_DEFAULT_ARGS("--disable-file-logs");
+PE_HELP("compress_texture [options] <input image>\n"
+        "Encodes the image with block compression and saves it as .petx with the full mipmap chain\n\n"
+        "-o/--output             - the output .petx file\n"
+        "-f/--format             - bc1 (opaque), bc1a (one bit alpha), bc2, bc3 or bc7 (default: bc1 for images\n"
+        "                          without alpha and bc3 for others)\n"
+        "-q/--quality            - fast or high (default: fast)\n"
+        "--filter                - mipmap filter: box, kaiser or lanczos (default: box)\n"
+        "--srgb                  - filter mipmaps of sRGB colors in linear space\n"
+        "--no-mipmaps            - encode the largest level only\n"
+        "--mappable              - store levels without compression, so they are memory mapped on load\n");
+
+namespace {
+optional<util::dxt_format> parse_format(const string& name) {
+    if (name == "bc1")
+        return util::dxt_format::dxt1;
+    if (name == "bc1a")
+        return util::dxt_format::dxt1_onebitalpha;
+    if (name == "bc2")
+        return util::dxt_format::dxt3;
+    if (name == "bc3")
+        return util::dxt_format::dxt5;
+    if (name == "bc7")
+        return util::dxt_format::bc7;
+    return nullopt;
+}
+
+optional<util::mip_filter> parse_filter(const string& name) {
+    if (name == "box")
+        return util::mip_filter::box;
+    if (name == "kaiser")
+        return util::mip_filter::kaiser;
+    if (name == "lanczos")
+        return util::mip_filter::lanczos;
+    return nullopt;
+}
+} // namespace
+
+int pe_main(args_view args) {
+    auto output      = args.by_key_require<string>({"-o", "--output"});
+    auto format_name = args.by_key_default<string>({"-f", "--format"}, "");
+    auto quality     = args.by_key_default<string>({"-q", "--quality"}, "fast");
+    auto filter_name = args.by_key_default<string>("--filter", "box");
+    auto srgb        = args.get("--srgb");
+    auto no_mipmaps  = args.get("--no-mipmaps");
+    auto mappable    = args.get("--mappable");
+    auto input       = args.next("Missing input image");
+
+    if (quality != "fast" && quality != "high")
+        throw std::invalid_argument("Unknown quality '" + quality + "'");
+
+    auto filter = parse_filter(filter_name);
+    if (!filter)
+        throw std::invalid_argument("Unknown filter '" + filter_name + "'");
+
+    auto mipmaps = no_mipmaps ? optional<util::mip_settings>() : util::mip_settings{*filter, srgb};
+
+    auto image = load_color_map<color_rgba>(input);
+
+    optional<util::dxt_format> format;
+    if (format_name.empty()) {
+        auto pixels_count = size_t(image.size().x()) * image.size().y();
+        auto opaque       = true;
+        for (size_t i = 0; i < pixels_count && opaque; ++i)
+            opaque = image.data()[i * 4 + 3] == 255; // NOLINT
+        format = opaque ? util::dxt_format::dxt1 : util::dxt_format::dxt5;
+    }
+    else if (!(format = parse_format(format_name))) {
+        throw std::invalid_argument("Unknown format '" + format_name + "'");
+    }
+
+    auto compressed = image.to_compressed(
+        *format, quality == "high" ? util::dxt_encode_quality::high : util::dxt_encode_quality::fast, mipmaps);
+
+    if (!try_write_file(output, compressed.to_bytes(!mappable)))
+        throw std::runtime_error("Can't create file \"" + output + "\"");
+
+    /* Quality of the largest level */
+    vector<u8> decoded(size_t(image.size().x()) * image.size().y() * 4);
+    compressed.decompress(0, decoded.data());
+    auto psnr = util::image_psnr(span<const u8>(image.data(), ssize_t(decoded.size())), decoded);
+
+    LOG("compress_texture: {} {} -> {} ({}, {} levels), {} bytes encoded into {} bytes, PSNR {:.2f} dB",
+        input,
+        image.size(),
+        output,
+        magic_enum::enum_name(*format),
+        compressed.levels_count(),
+        image.size().x() * image.size().y() * 4,
+        compressed.byte_size(),
+        psnr);
+
+    return 0;
+}
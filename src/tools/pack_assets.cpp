@@ -0,0 +1,71 @@
+#include <core/main.cpp>
+#include <core/types.hpp>
+#include <core/views/split.hpp>
+#include <util/asset_pack.hpp>
+
+#include <filesystem>
+
+using namespace core;
+namespace fs = std::filesystem;
+
+PE_DEFAULT_ARGS("--disable-file-logs");
+PE_HELP("pack_assets [options] <input directory>...\n"
+        "Packs all files from the input directories into the asset pack. Entry paths are relative\n"
+        "to the input directory, so the pack must be mounted at the directory location\n\n"
+        "-o/--output             - the output pack file\n"
+        "-l/--level              - compression level (1 - best speed, 9 - best compression)\n"
+        "--store                 - comma-separated extensions that are never compressed (e.g. .pemesh,.petx)\n"
+        "--no-compress           - store all entries uncompressed\n");
+
+int pe_main(args_view args) {
+    auto output      = args.by_key_require<string>({"-o", "--output"});
+    auto level       = args.by_key_default<int>({"-l", "--level"}, util::COMPRESS_DEFAULT);
+    auto store_exts  = args.by_key_default<string>("--store", "");
+    auto no_compress = args.get("--no-compress");
+
+    auto stored_extensions = store_exts / split(',');
+
+    vector<string> input_dirs;
+    while (auto dir = args.try_next())
+        input_dirs.push_back(*dir);
+
+    if (input_dirs.empty())
+        throw std::invalid_argument("Missing input directories");
+
+    util::asset_pack_builder builder(level);
+
+    for (auto& input_dir : input_dirs) {
+        auto root = fs::path(input_dir);
+        if (!fs::is_directory(root))
+            throw std::invalid_argument("'" + input_dir + "' is not a directory");
+
+        for (auto& file : fs::recursive_directory_iterator(root)) {
+            if (!file.is_regular_file())
+                continue;
+
+            auto ext      = file.path().extension().string();
+            auto compress = !no_compress && std::find(stored_extensions.begin(), stored_extensions.end(), ext) ==
+                                                stored_extensions.end();
+
+            builder.add_file(fs::relative(file.path(), root).generic_string(), file.path().string(), compress);
+        }
+    }
+
+    builder.write(output);
+
+    auto pack = util::asset_pack(output);
+
+    u64 raw_size = 0, compressed_count = 0;
+    for (auto& entry : pack.entries()) {
+        raw_size += entry.raw_size;
+        compressed_count += (entry.flags & util::asset_pack::entry_compressed) ? 1 : 0;
+    }
+
+    LOG("pack_assets: {} entries ({} compressed), {} bytes packed into {} bytes",
+        pack.entries().size(),
+        compressed_count,
+        raw_size,
+        fs::file_size(output));
+
+    return 0;
+}
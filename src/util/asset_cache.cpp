@@ -0,0 +1,290 @@
+#include "asset_cache.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <unistd.h>
+
+#include <core/config_manager.hpp>
+#include <core/serialization.hpp>
+#include <core/log.hpp>
+
+using namespace core;
+namespace fs = std::filesystem;
+
+namespace {
+constexpr auto asset_cache_magic = array{'P', 'E', 'A', 'C'};
+
+string to_hex(const md5_hash& hash) {
+    std::stringstream ss;
+    ss << hash;
+    return ss.str();
+}
+
+struct entry_header {
+    array<char, 4> magic;
+    u32            version;
+    md5_hash       key;
+    bool           compressed;
+    u64            raw_size;
+};
+
+optional<entry_header> read_entry_header(span<const byte>& in) {
+    if (static_cast<size_t>(in.size()) < util::asset_cache::header_size)
+        return nullopt;
+
+    entry_header h; // NOLINT
+    deserialize_all(in, h.magic, h.version, h.key.lo, h.key.hi, h.compressed, h.raw_size);
+
+    if (h.magic != asset_cache_magic || h.version != util::asset_cache::format_version)
+        return nullopt;
+
+    return h;
+}
+
+optional<entry_header> read_entry_header(const fs::path& path) {
+    std::ifstream ifs(path, std::ios_base::binary | std::ios_base::in);
+    if (!ifs.is_open())
+        return nullopt;
+
+    array<byte, util::asset_cache::header_size> bytes; // NOLINT
+    ifs.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())); // NOLINT
+    if (static_cast<size_t>(ifs.gcount()) != bytes.size())
+        return nullopt;
+
+    auto in = span<const byte>(bytes);
+    return read_entry_header(in);
+}
+} // namespace
+
+namespace util
+{
+md5_hash asset_cache::make_key(span<const byte> source, string_view importer_signature, u32 importer_version) {
+    auto key_str = to_hex(md5(source));
+    key_str += '|';
+    key_str += importer_signature;
+    key_str += '|';
+    key_str += std::to_string(importer_version);
+    key_str += '|';
+    key_str += std::to_string(format_version);
+
+    return md5(key_str);
+}
+
+asset_cache::asset_cache(string cache_dir, asset_cache_settings settings):
+    _dir(path_eval(cache_dir)), _settings(settings) {}
+
+string asset_cache::entry_path(const md5_hash& key) const {
+    return _dir / to_hex(key) + string(entry_extension);
+}
+
+optional<vector<byte>> asset_cache::try_load(const md5_hash& key) const {
+    if (!is_enabled())
+        return nullopt;
+
+    auto path  = entry_path(key);
+    auto bytes = try_read_binary_file(path);
+    if (!bytes)
+        return nullopt;
+
+    auto in     = span<const byte>(*bytes);
+    auto header = read_entry_header(in);
+
+    if (!header || header->key != key) {
+        LOG_WARNING("asset_cache: invalid entry header in {}", path);
+        return nullopt;
+    }
+
+    vector<byte> result;
+    if (header->compressed) {
+        try {
+            result = decompress(in);
+        }
+        catch (const std::exception& e) {
+            LOG_WARNING("asset_cache: can't decompress entry {}: {}", path, e.what());
+            return nullopt;
+        }
+    }
+    else {
+        result.resize(static_cast<size_t>(in.size()));
+        std::memcpy(result.data(), in.data(), result.size());
+    }
+
+    if (result.size() != header->raw_size) {
+        LOG_WARNING("asset_cache: entry {} has size {} but {} expected", path, result.size(), header->raw_size);
+        return nullopt;
+    }
+
+    /* Mark entry as recently used for the garbage collector */
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+
+    return result;
+}
+
+bool asset_cache::store(const md5_hash& key, span<const byte> payload, string_view asset_type) const {
+    if (!is_enabled())
+        return false;
+
+    static std::atomic<u64> tmp_counter = 0;
+
+    try {
+        platform_dependent::recursive_create_directory(_dir);
+    }
+    catch (const std::exception& e) {
+        LOG_WARNING("asset_cache: {}", e.what());
+        return false;
+    }
+
+    /* Large zlib payloads are compressed by blocks in parallel, decompress() recognizes all formats */
+    vector<byte> compressed;
+    if (_settings.compress) {
+        auto codec = asset_type.empty() ? codec_settings{codec_id::zlib, _settings.compression_level}
+                                        : asset_codec(asset_type);
+
+        if (codec.codec == codec_id::zlib && static_cast<size_t>(payload.size()) > parallel_compression_threshold)
+            compressed = compress_parallel(payload, codec.level);
+        else
+            compressed = compress_frame(payload, codec);
+    }
+
+    auto data = _settings.compress ? span<const byte>(compressed) : payload;
+
+    serializer s;
+    s.write(asset_cache_magic, format_version, key.lo, key.hi, _settings.compress, static_cast<u64>(payload.size()));
+
+    auto path     = entry_path(key);
+    auto tmp_path = path + ".tmp" + std::to_string(::getpid()) + "_" + std::to_string(tmp_counter++);
+
+    {
+        std::ofstream ofs(tmp_path, std::ios_base::binary | std::ios_base::out);
+        if (!ofs.is_open()) {
+            LOG_WARNING("asset_cache: can't create file {}", tmp_path);
+            return false;
+        }
+
+        ofs.write(reinterpret_cast<const char*>(s.data().data()), // NOLINT
+                  static_cast<std::streamsize>(s.data().size()));
+        ofs.write(reinterpret_cast<const char*>(data.data()), // NOLINT
+                  static_cast<std::streamsize>(data.size()));
+
+        if (ofs.bad()) {
+            ofs.close();
+            std::error_code ec;
+            fs::remove(tmp_path, ec);
+            LOG_WARNING("asset_cache: can't write file {}", tmp_path);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tmp_path, path, ec);
+    if (ec) {
+        fs::remove(tmp_path, ec);
+        return false;
+    }
+
+    return true;
+}
+
+void asset_cache::remove(const md5_hash& key) const {
+    if (!is_enabled())
+        return;
+
+    std::error_code ec;
+    fs::remove(entry_path(key), ec);
+}
+
+asset_cache_gc_stats asset_cache::collect_garbage() const {
+    asset_cache_gc_stats stats;
+
+    std::error_code ec;
+    if (!is_enabled() || !fs::is_directory(_dir, ec))
+        return stats;
+
+    struct entry_t {
+        fs::path            path;
+        fs::file_time_type  time;
+        u64                 size;
+    };
+    vector<entry_t> entries;
+
+    auto now = fs::file_time_type::clock::now();
+
+    auto remove_entry = [&](const fs::path& path, u64 size) {
+        std::error_code rm_ec;
+        if (fs::remove(path, rm_ec)) {
+            ++stats.removed_entries;
+            stats.removed_bytes += size;
+        }
+    };
+
+    for (auto& file : fs::directory_iterator(_dir, ec)) {
+        if (!file.is_regular_file(ec))
+            continue;
+
+        auto& path = file.path();
+        auto  size = static_cast<u64>(file.file_size(ec));
+        auto  time = file.last_write_time(ec);
+
+        /* Leftovers of interrupted stores */
+        if (path.filename().string().find(".pecache.tmp") != string::npos) {
+            if (now - time > std::chrono::hours(1))
+                remove_entry(path, size);
+            continue;
+        }
+
+        if (path.extension() != entry_extension)
+            continue;
+
+        if (!read_entry_header(path) || now - time > _settings.max_age) {
+            remove_entry(path, size);
+            continue;
+        }
+
+        entries.push_back(entry_t{path, time, size});
+    }
+
+    u64 total_size = 0;
+    for (auto& e : entries)
+        total_size += e.size;
+
+    /* Remove least recently used entries to fit into the size budget */
+    std::sort(entries.begin(), entries.end(), [](auto& a, auto& b) { return a.time < b.time; });
+
+    for (auto& e : entries) {
+        if (total_size > _settings.max_total_size) {
+            total_size -= e.size;
+            remove_entry(e.path, e.size);
+        }
+        else {
+            ++stats.kept_entries;
+            stats.kept_bytes += e.size;
+        }
+    }
+
+    if (stats.removed_entries)
+        LOG("asset_cache: removed {} stale entries ({} bytes)", stats.removed_entries, stats.removed_bytes);
+
+    return stats;
+}
+
+asset_cache& global_asset_cache() {
+    static asset_cache cache = [] {
+        string dir;
+        try {
+            dir = path_eval(cfg_read_path("cache_dir"));
+        }
+        catch (const std::exception&) {
+            LOG_WARNING("asset_cache: cache_dir is not specified, baked asset cache disabled");
+        }
+
+        auto result = asset_cache(dir);
+        result.collect_garbage();
+        return result;
+    }();
+
+    return cache;
+}
+} // namespace util
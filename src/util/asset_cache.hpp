@@ -0,0 +1,155 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <core/md5.hpp>
+#include "codec.hpp"
+
+namespace util
+{
+struct asset_cache_settings {
+    bool                 compress          = true;
+    int                  compression_level = COMPRESS_FAST;
+    core::u64            max_total_size    = 4ULL * 1024 * 1024 * 1024;  // NOLINT
+    std::chrono::seconds max_age           = std::chrono::hours(24 * 30); // NOLINT
+};
+
+struct asset_cache_gc_stats {
+    size_t    removed_entries = 0;
+    core::u64 removed_bytes   = 0;
+    size_t    kept_entries    = 0;
+    core::u64 kept_bytes      = 0;
+};
+
+/**
+ * @brief On-disk cache for baked (imported and serialized) assets
+ *
+ * Entries are addressed by a key that combines the md5 of the source bytes,
+ * an importer signature and an importer version. Any change of the source file
+ * or the importer produces a new key, so stale entries are never read back.
+ * They are removed by collect_garbage() when they get too old or when the cache
+ * exceeds its size budget.
+ *
+ * Entry layout: "PEAC" | u32 format version | u64 key.lo | u64 key.hi |
+ *               u8 compressed flag | u64 raw size | payload
+ */
+class asset_cache {
+public:
+    static constexpr core::u32 format_version                 = 1;
+    static constexpr size_t    header_size                    = 4 + 4 + 8 + 8 + 1 + 8;
+    static constexpr auto      entry_extension                = core::string_view(".pecache");
+    static constexpr size_t    parallel_compression_threshold = 4 * COMPRESS_BLOCK_SIZE;
+
+    /**
+     * @brief Creates the key of the cache entry
+     *
+     * @param source - bytes of the source asset
+     * @param importer_signature - describes the importer and everything that affects its output
+     * @param importer_version - must be incremented when the importer output changes
+     *
+     * @return the key
+     */
+    static core::md5_hash make_key(core::span<const core::byte> source,
+                                   core::string_view            importer_signature,
+                                   core::u32                    importer_version);
+
+    static core::md5_hash
+    make_key(core::string_view source, core::string_view importer_signature, core::u32 importer_version) {
+        return make_key(core::span<const core::byte>(reinterpret_cast<const core::byte*>(source.data()), // NOLINT
+                                                     static_cast<ssize_t>(source.size())),
+                        importer_signature,
+                        importer_version);
+    }
+
+    /**
+     * @brief Creates disabled cache (all operations are no-op)
+     */
+    asset_cache() = default;
+
+    /**
+     * @brief Creates cache in the specified directory
+     *
+     * The directory will be created on the first store
+     *
+     * @param cache_dir - the directory of the cache, it is evaluated with path_eval() once, so all entries are
+     * looked up and stored in the same directory
+     * @param settings - cache settings
+     */
+    asset_cache(core::string cache_dir, asset_cache_settings settings = {});
+
+    /**
+     * @brief Loads the entry
+     *
+     * @param key - the key of the entry
+     *
+     * @return uncompressed entry payload or nullopt if the entry does not exist or is broken
+     */
+    [[nodiscard]]
+    core::optional<core::vector<core::byte>> try_load(const core::md5_hash& key) const;
+
+    /**
+     * @brief Stores the entry
+     *
+     * The entry is written into a temporary file first and then renamed,
+     * so concurrent readers never see partially written entries
+     *
+     * @param key - the key of the entry
+     * @param payload - the entry data
+     * @param asset_type - selects the codec with asset_codec(), zlib with settings().compression_level if empty
+     *
+     * @return true if the entry was stored
+     */
+    bool store(const core::md5_hash&        key,
+               core::span<const core::byte> payload,
+               core::string_view            asset_type = {}) const;
+
+    /**
+     * @brief Removes the entry
+     *
+     * @param key - the key of the entry
+     */
+    void remove(const core::md5_hash& key) const;
+
+    /**
+     * @brief Removes stale entries
+     *
+     * Removes entries with unknown format, entries which were not used during
+     * settings().max_age and the least recently used entries above settings().max_total_size
+     *
+     * @return statistics of removed and kept entries
+     */
+    asset_cache_gc_stats collect_garbage() const;
+
+    [[nodiscard]]
+    core::string entry_path(const core::md5_hash& key) const;
+
+    [[nodiscard]]
+    bool is_enabled() const {
+        return !_dir.empty();
+    }
+
+    [[nodiscard]]
+    const core::string& dir() const {
+        return _dir;
+    }
+
+    [[nodiscard]]
+    const asset_cache_settings& settings() const {
+        return _settings;
+    }
+
+private:
+    core::string         _dir;
+    asset_cache_settings _settings;
+};
+
+/**
+ * @brief Gets the cache located at the "cache_dir" path from fs.cfg
+ *
+ * The cache is disabled if "cache_dir" is not specified. Garbage collection
+ * runs once on the first access
+ *
+ * @return the global asset cache
+ */
+asset_cache& global_asset_cache();
+
+} // namespace util
@@ -0,0 +1,309 @@
+#include "asset_pack.hpp"
+
+#include <fstream>
+
+#include <core/config_manager.hpp>
+#include <core/serialization.hpp>
+#include <core/string_hash.hpp>
+#include <core/files.hpp>
+#include <core/log.hpp>
+
+using namespace core;
+
+namespace {
+constexpr auto asset_pack_magic = array{'P', 'E', 'P', 'K'};
+
+u64 align_up(u64 value, u64 alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+namespace util
+{
+u64 asset_pack::hash_path(string_view path) {
+    return hash_fnv1a64(path);
+}
+
+asset_pack::asset_pack(const string& pack_path): _path(pack_path), _file(pack_path) {
+    auto data = _file.data();
+
+    if (static_cast<size_t>(data.size()) < header_size)
+        pe_throw std::runtime_error("asset_pack: '" + pack_path + "' is too small");
+
+    auto in = data;
+
+    array<char, 4> magic; // NOLINT
+    u32 version, count, pack_page_size; // NOLINT
+    u64 strings_offset, strings_size;   // NOLINT
+    deserialize_all(in, magic, version, count, pack_page_size, strings_offset, strings_size);
+
+    if (magic != asset_pack_magic)
+        pe_throw std::runtime_error("asset_pack: '" + pack_path + "' is not an asset pack");
+    if (version != format_version)
+        pe_throw std::runtime_error(
+            format("asset_pack: '{}' has version {} but {} required", pack_path, version, format_version));
+
+    auto file_size = static_cast<u64>(data.size());
+    if (header_size + u64(count) * index_entry_size > file_size || strings_offset > file_size ||
+        strings_size > file_size - strings_offset)
+        pe_throw std::runtime_error("asset_pack: '" + pack_path + "' has broken index");
+
+    _strings = string_view(reinterpret_cast<const char*>(data.data()) + strings_offset, strings_size); // NOLINT
+
+    _entries.resize(count);
+    for (auto& e : _entries) {
+        deserialize_all(
+            in, e.path_hash, e.offset, e.stored_size, e.raw_size, e.path_offset, e.path_size, e.flags, e.reserved);
+
+        if (e.offset > file_size || e.stored_size > file_size - e.offset ||
+            u64(e.path_offset) + e.path_size > strings_size)
+            pe_throw std::runtime_error("asset_pack: '" + pack_path + "' has broken entry");
+    }
+}
+
+const asset_pack_entry* asset_pack::find(string_view path) const {
+    auto hash = hash_path(path);
+    auto pos  = std::lower_bound(_entries.begin(), _entries.end(), hash, [](auto& e, u64 h) {
+        return e.path_hash < h;
+    });
+
+    for (; pos != _entries.end() && pos->path_hash == hash; ++pos)
+        if (entry_path(*pos) == path)
+            return &(*pos);
+
+    return nullptr;
+}
+
+optional<span<const byte>> asset_pack::try_view(string_view path) const {
+    auto entry = find(path);
+    if (!entry || (entry->flags & entry_compressed))
+        return nullopt;
+
+    return stored_data(*entry);
+}
+
+optional<vector<byte>> asset_pack::try_read(string_view path) const {
+    auto entry = find(path);
+    if (!entry)
+        return nullopt;
+
+    auto stored = stored_data(*entry);
+    if (entry->flags & entry_compressed)
+        return decompress_block(stored, entry->raw_size);
+
+    return vector<byte>(stored.begin(), stored.end());
+}
+
+void asset_pack_builder::add_item(item_t item) {
+    if (!_paths.emplace(item.path).second)
+        pe_throw std::runtime_error("asset_pack_builder: duplicate entry '" + item.path + "'");
+    _items.push_back(move(item));
+}
+
+void asset_pack_builder::add_file(string path, string file_path, bool compress) {
+    add_item(item_t{move(path), move(file_path), {}, compress});
+}
+
+void asset_pack_builder::add(string path, vector<byte> data, bool compress) {
+    add_item(item_t{move(path), {}, move(data), compress});
+}
+
+void asset_pack_builder::write(const string& pack_path) const {
+    /* Sort by (hash, path) for the binary search in asset_pack::find */
+    vector<const item_t*> items;
+    items.reserve(_items.size());
+    for (auto& item : _items)
+        items.push_back(&item);
+
+    std::sort(items.begin(), items.end(), [](auto a, auto b) {
+        auto ha = asset_pack::hash_path(a->path);
+        auto hb = asset_pack::hash_path(b->path);
+        return ha < hb || (ha == hb && a->path < b->path);
+    });
+
+    vector<asset_pack_entry> entries(items.size());
+    string                   strings;
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        entries[i].path_hash   = asset_pack::hash_path(items[i]->path);
+        entries[i].path_offset = static_cast<u32>(strings.size());
+        entries[i].path_size   = static_cast<u32>(items[i]->path.size());
+        entries[i].flags       = 0;
+        entries[i].reserved    = 0;
+        strings += items[i]->path;
+    }
+
+    auto strings_offset = asset_pack::header_size + entries.size() * asset_pack::index_entry_size;
+    auto data_offset    = align_up(strings_offset + strings.size(), asset_pack::page_size);
+
+    std::ofstream ofs(pack_path, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+    if (!ofs.is_open())
+        pe_throw std::runtime_error("asset_pack_builder: can't create file '" + pack_path + "'");
+
+    auto write_bytes = [&](span<const byte> bytes) {
+        ofs.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())); // NOLINT
+    };
+
+    /* Payloads go first, the index is written when all offsets are known */
+    ofs.seekp(static_cast<std::streamoff>(data_offset));
+
+    u64 offset = data_offset;
+    for (size_t i = 0; i < items.size(); ++i) {
+        auto& item  = *items[i];
+        auto& entry = entries[i];
+
+        vector<byte> file_data;
+        if (!item.file_path.empty()) {
+            auto file = try_read_binary_file(item.file_path);
+            if (!file)
+                pe_throw std::runtime_error("asset_pack_builder: can't read file '" + item.file_path + "'");
+            file_data = move(*file);
+        }
+        auto raw = item.file_path.empty() ? span<const byte>(item.data) : span<const byte>(file_data);
+
+        vector<byte> compressed;
+        if (item.compress && !raw.empty()) {
+            compressed = compress_block(raw, _compression_level);
+            if (static_cast<double>(compressed.size()) > static_cast<double>(raw.size()) * _min_compression_ratio)
+                compressed = {};
+        }
+
+        auto stored = compressed.empty() ? raw : span<const byte>(compressed);
+
+        entry.offset      = offset;
+        entry.stored_size = static_cast<u64>(stored.size());
+        entry.raw_size    = static_cast<u64>(raw.size());
+        entry.flags       = compressed.empty() ? 0 : asset_pack::entry_compressed;
+
+        write_bytes(stored);
+
+        auto next_offset = align_up(offset + entry.stored_size, asset_pack::page_size);
+        auto padding     = vector<char>(next_offset - offset - entry.stored_size, 0);
+        ofs.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        offset = next_offset;
+    }
+
+    serializer s;
+    s.write(asset_pack_magic,
+            asset_pack::format_version,
+            static_cast<u32>(entries.size()),
+            asset_pack::page_size,
+            static_cast<u64>(strings_offset),
+            static_cast<u64>(strings.size()));
+
+    for (auto& e : entries)
+        s.write(e.path_hash, e.offset, e.stored_size, e.raw_size, e.path_offset, e.path_size, e.flags, e.reserved);
+
+    ofs.seekp(0);
+    write_bytes(s.data());
+    ofs.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+
+    if (ofs.bad())
+        pe_throw std::runtime_error("asset_pack_builder: can't write file '" + pack_path + "'");
+}
+
+void asset_pack_mounts::mount(const string& pack_path, string mount_point) {
+    auto pack = std::make_shared<const asset_pack>(pack_path);
+
+    if (!mount_point.empty() && !mount_point.ends_with('/'))
+        mount_point += '/';
+
+    LOG("asset_pack: mount '{}' ({} entries) at '{}'", pack_path, pack->entries().size(), mount_point);
+
+    std::lock_guard lock{_mutex};
+    _packs.push_back(mounted_t{move(mount_point), move(pack)});
+}
+
+bool asset_pack_mounts::unmount(const string& pack_path) {
+    std::lock_guard lock{_mutex};
+
+    auto found = std::find_if(_packs.begin(), _packs.end(), [&](auto& m) { return m.pack->path() == pack_path; });
+    if (found == _packs.end())
+        return false;
+
+    _packs.erase(found);
+    return true;
+}
+
+optional<asset_data> asset_pack_mounts::try_read(string_view relative_path) const {
+    shared_ptr<const asset_pack> pack;
+    const asset_pack_entry*      entry = nullptr;
+    {
+        std::lock_guard lock{_mutex};
+
+        for (auto m = _packs.rbegin(); m != _packs.rend() && !entry; ++m) {
+            if (relative_path.starts_with(m->mount_point)) {
+                entry = m->pack->find(relative_path.substr(m->mount_point.size()));
+                pack  = m->pack;
+            }
+        }
+    }
+
+    if (!entry)
+        return nullopt;
+
+    auto stored = pack->stored_data(*entry);
+    if (entry->flags & asset_pack::entry_compressed)
+        return asset_data(decompress_block(stored, entry->raw_size));
+    else
+        return asset_data(move(pack), stored);
+}
+
+size_t asset_pack_mounts::size() const {
+    std::lock_guard lock{_mutex};
+    return _packs.size();
+}
+
+asset_pack_mounts& mounted_asset_packs() {
+    static asset_pack_mounts mounts;
+    return mounts;
+}
+
+optional<asset_data> try_read_asset(const string& file_path) {
+    auto path    = path_eval(file_path);
+    auto& mounts = mounted_asset_packs();
+
+    if (mounts.size() != 0) {
+        if (auto data = mounts.try_read(cfg_make_relative(path)))
+            return data;
+    }
+
+    if (auto data = try_read_binary_file(path))
+        return asset_data(move(*data));
+
+    return nullopt;
+}
+
+optional<asset_data> try_read_asset(const cfg_path& path) {
+    return try_read_asset(path.absolute());
+}
+
+optional<asset_data> try_map_asset(const string& file_path) {
+    auto path    = path_eval(file_path);
+    auto& mounts = mounted_asset_packs();
+
+    if (mounts.size() != 0) {
+        if (auto data = mounts.try_read(cfg_make_relative(path)))
+            return data;
+    }
+
+    /* Empty and special files can't be mapped, unreadable files are reported by try_read_binary_file */
+    auto stat = platform_dependent::get_file_stat(path);
+    if (stat && stat->type == file_type::regular && stat->size != 0) {
+        try {
+            return asset_data(std::make_shared<const platform_dependent::mapped_file>(path));
+        }
+        catch (const std::runtime_error&) {
+        }
+    }
+
+    if (auto data = try_read_binary_file(path))
+        return asset_data(move(*data));
+
+    return nullopt;
+}
+
+optional<asset_data> try_map_asset(const cfg_path& path) {
+    return try_map_asset(path.absolute());
+}
+} // namespace util
@@ -0,0 +1,339 @@
+#pragma once
+
+#include <mutex>
+#include <core/types.hpp>
+#include <core/platform_dependent.hpp>
+#include "compression.hpp"
+
+namespace core
+{
+class cfg_path;
+}
+
+namespace util
+{
+struct asset_pack_entry {
+    core::u64 path_hash;
+    core::u64 offset;
+    core::u64 stored_size;
+    core::u64 raw_size;
+    core::u32 path_offset;
+    core::u32 path_size;
+    core::u32 flags;
+    core::u32 reserved;
+};
+
+/**
+ * @brief Read-only archive of asset files
+ *
+ * The pack is mapped into memory, so uncompressed entries are available as
+ * views into the mapping without any copying. Entry paths are relative to the
+ * mount point of the pack and use '/' as a separator.
+ *
+ * Layout: "PEPK" | u32 format version | u32 entries count | u32 page size |
+ *         u64 strings offset | u64 strings size |
+ *         index of entries sorted by (path_hash, path) | path strings |
+ *         entry payloads aligned to the page size
+ */
+class asset_pack {
+public:
+    static constexpr core::u32 format_version   = 1;
+    static constexpr core::u32 page_size        = 4096;
+    static constexpr size_t    header_size      = 4 + 4 + 4 + 4 + 8 + 8;
+    static constexpr size_t    index_entry_size = 8 + 8 + 8 + 8 + 4 + 4 + 4 + 4;
+    static constexpr core::u32 entry_compressed = 1U << 0U;
+    static constexpr auto      extension        = core::string_view(".pepk");
+
+    static core::u64 hash_path(core::string_view path);
+
+    /**
+     * @brief Maps the pack into memory and reads its index
+     *
+     * @throw std::runtime_error if the pack can't be mapped or has invalid format
+     *
+     * @param pack_path - the path to the pack file
+     */
+    explicit asset_pack(const core::string& pack_path);
+
+    /**
+     * @brief Finds the entry
+     *
+     * @param path - the path of the entry relative to the pack root
+     *
+     * @return pointer to the entry or nullptr if the entry does not exist
+     */
+    [[nodiscard]]
+    const asset_pack_entry* find(core::string_view path) const;
+
+    /**
+     * @brief Gets the entry data as it is stored in the pack
+     *
+     * @param entry - the entry of this pack
+     *
+     * @return view into the mapped pack (compressed if entry.flags has entry_compressed)
+     */
+    [[nodiscard]]
+    core::span<const core::byte> stored_data(const asset_pack_entry& entry) const {
+        return _file.data().subspan(static_cast<ssize_t>(entry.offset), static_cast<ssize_t>(entry.stored_size));
+    }
+
+    [[nodiscard]]
+    core::string_view entry_path(const asset_pack_entry& entry) const {
+        return _strings.substr(entry.path_offset, entry.path_size);
+    }
+
+    /**
+     * @brief Gets the view of the uncompressed entry without copying
+     *
+     * @param path - the path of the entry relative to the pack root
+     *
+     * @return the view into the mapped pack or nullopt if the entry does not exist or is compressed
+     */
+    [[nodiscard]]
+    core::optional<core::span<const core::byte>> try_view(core::string_view path) const;
+
+    /**
+     * @brief Reads the entry
+     *
+     * @param path - the path of the entry relative to the pack root
+     *
+     * @return decompressed copy of the entry data or nullopt if the entry does not exist
+     */
+    [[nodiscard]]
+    core::optional<core::vector<core::byte>> try_read(core::string_view path) const;
+
+    [[nodiscard]]
+    const core::vector<asset_pack_entry>& entries() const {
+        return _entries;
+    }
+
+    [[nodiscard]]
+    const core::string& path() const {
+        return _path;
+    }
+
+private:
+    core::string                    _path;
+    platform_dependent::mapped_file _file;
+    core::vector<asset_pack_entry>  _entries;
+    core::string_view               _strings;
+};
+
+/**
+ * @brief Creates asset packs
+ */
+class asset_pack_builder {
+public:
+    /**
+     * @brief Creates the builder
+     *
+     * @param compression_level - the compression level for compressed entries
+     * @param min_compression_ratio - entries that don't shrink to this ratio are stored uncompressed
+     */
+    asset_pack_builder(int compression_level = COMPRESS_DEFAULT, double min_compression_ratio = 0.9): // NOLINT
+        _compression_level(compression_level), _min_compression_ratio(min_compression_ratio) {}
+
+    /**
+     * @brief Adds the file to the pack
+     *
+     * The file will be read when the pack is written
+     *
+     * @throw std::runtime_error if the entry with the same path already exists
+     *
+     * @param path - the path of the entry relative to the pack root
+     * @param file_path - the path to the source file
+     * @param compress - try to compress the entry
+     */
+    void add_file(core::string path, core::string file_path, bool compress = true);
+
+    /**
+     * @brief Adds the data to the pack
+     *
+     * @throw std::runtime_error if the entry with the same path already exists
+     *
+     * @param path - the path of the entry relative to the pack root
+     * @param data - the entry data
+     * @param compress - try to compress the entry
+     */
+    void add(core::string path, core::vector<core::byte> data, bool compress = true);
+
+    /**
+     * @brief Writes the pack
+     *
+     * @throw std::runtime_error if a source file can't be read or the pack can't be written
+     *
+     * @param pack_path - the path to the output pack file
+     */
+    void write(const core::string& pack_path) const;
+
+    [[nodiscard]]
+    size_t size() const {
+        return _items.size();
+    }
+
+private:
+    struct item_t {
+        core::string             path;
+        core::string             file_path;
+        core::vector<core::byte> data;
+        bool                     compress;
+    };
+
+    void add_item(item_t item);
+
+    core::vector<item_t>         _items;
+    core::hash_set<core::string> _paths;
+    int                          _compression_level;
+    double                       _min_compression_ratio;
+};
+
+/**
+ * @brief Bytes of the asset
+ *
+ * Either a view into the mounted pack (keeps the pack alive), a mapped file or owned data
+ */
+class asset_data {
+public:
+    asset_data(core::vector<core::byte> data): _owned(core::move(data)), _view(_owned) {}
+
+    asset_data(core::shared_ptr<const asset_pack> pack, core::span<const core::byte> view):
+        _pack(core::move(pack)), _view(view) {}
+
+    asset_data(core::shared_ptr<const platform_dependent::mapped_file> file):
+        _file(core::move(file)), _view(_file->data()) {}
+
+    asset_data(const asset_data&) = delete;
+    asset_data& operator=(const asset_data&) = delete;
+
+    asset_data(asset_data&& d) noexcept:
+        _owned(core::move(d._owned)),
+        _pack(core::move(d._pack)),
+        _file(core::move(d._file)),
+        _view(is_mapped() ? d._view : _owned) {}
+
+    asset_data& operator=(asset_data&& d) noexcept {
+        _owned = core::move(d._owned);
+        _pack  = core::move(d._pack);
+        _file  = core::move(d._file);
+        _view  = is_mapped() ? d._view : core::span<const core::byte>(_owned);
+        return *this;
+    }
+
+    [[nodiscard]]
+    core::span<const core::byte> bytes() const {
+        return _view;
+    }
+
+    [[nodiscard]]
+    core::string_view str() const {
+        return {reinterpret_cast<const char*>(_view.data()), static_cast<size_t>(_view.size())}; // NOLINT
+    }
+
+    /**
+     * @brief Checks if the data is a view into the mapped pack or the mapped file
+     */
+    [[nodiscard]]
+    bool is_mapped() const {
+        return _pack != nullptr || _file != nullptr;
+    }
+
+private:
+    core::vector<core::byte>                                _owned;
+    core::shared_ptr<const asset_pack>                      _pack;
+    core::shared_ptr<const platform_dependent::mapped_file> _file;
+    core::span<const core::byte>                            _view;
+};
+
+/**
+ * @brief Set of mounted asset packs
+ *
+ * Packs mounted later override earlier ones
+ */
+class asset_pack_mounts {
+public:
+    /**
+     * @brief Mounts the pack
+     *
+     * @throw std::runtime_error if the pack can't be opened
+     *
+     * @param pack_path - the path to the pack file
+     * @param mount_point - the directory relative to the fs.cfg location which the pack root maps to
+     */
+    void mount(const core::string& pack_path, core::string mount_point = "");
+
+    /**
+     * @brief Unmounts the pack
+     *
+     * Assets that were read from the pack remain valid
+     *
+     * @param pack_path - the path to the pack file
+     *
+     * @return true if the pack was mounted
+     */
+    bool unmount(const core::string& pack_path);
+
+    /**
+     * @brief Reads the asset from mounted packs
+     *
+     * @param relative_path - the path relative to the fs.cfg location
+     *
+     * @return the asset data or nullopt if no mounted pack contains the asset
+     */
+    [[nodiscard]]
+    core::optional<asset_data> try_read(core::string_view relative_path) const;
+
+    [[nodiscard]]
+    size_t size() const;
+
+private:
+    struct mounted_t {
+        core::string                       mount_point;
+        core::shared_ptr<const asset_pack> pack;
+    };
+
+    mutable std::mutex      _mutex;
+    core::vector<mounted_t> _packs;
+};
+
+asset_pack_mounts& mounted_asset_packs();
+
+/**
+ * @brief Reads the asset from mounted packs or from the filesystem
+ *
+ * @param file_path - the path to the asset file
+ *
+ * @return the asset data or nullopt if the asset can't be found
+ */
+core::optional<asset_data> try_read_asset(const core::string& file_path);
+
+/**
+ * @brief Reads the asset from mounted packs or from the filesystem
+ *
+ * @param path - the path to the asset
+ *
+ * @return the asset data or nullopt if the asset can't be found
+ */
+core::optional<asset_data> try_read_asset(const core::cfg_path& path);
+
+/**
+ * @brief Maps the asset into memory without reading it
+ *
+ * Uncompressed entries of mounted packs are views into the pack, files are mapped as a whole.
+ * Compressed pack entries are decompressed as in try_read_asset
+ *
+ * @param file_path - the path to the asset file
+ *
+ * @return the asset data or nullopt if the asset can't be found
+ */
+core::optional<asset_data> try_map_asset(const core::string& file_path);
+
+/**
+ * @brief Maps the asset into memory without reading it
+ *
+ * @param path - the path to the asset
+ *
+ * @return the asset data or nullopt if the asset can't be found
+ */
+core::optional<asset_data> try_map_asset(const core::cfg_path& path);
+
+} // namespace util
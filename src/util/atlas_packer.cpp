@@ -0,0 +1,186 @@
+#include "atlas_packer.hpp"
+
+#include <algorithm>
+#include <core/print.hpp>
+
+using namespace core;
+
+namespace {
+u32 align_up(u32 value, u32 alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+namespace util
+{
+maxrects_packer::maxrects_packer(vec2u size): _size(size) {
+    if (size.x() != 0 && size.y() != 0)
+        _free.push_back({0, 0, size.x(), size.y()});
+}
+
+optional<vec2u> maxrects_packer::insert(vec2u size) {
+    if (size.x() == 0 || size.y() == 0)
+        return vec2u{0, 0};
+
+    auto best       = _free.end();
+    auto best_short = numlim<u32>::max();
+    auto best_long  = numlim<u32>::max();
+
+    for (auto i = _free.begin(); i != _free.end(); ++i) {
+        if (i->w < size.x() || i->h < size.y())
+            continue;
+
+        auto leftover_x = i->w - size.x();
+        auto leftover_y = i->h - size.y();
+        auto short_side = std::min(leftover_x, leftover_y);
+        auto long_side  = std::max(leftover_x, leftover_y);
+
+        if (short_side < best_short || (short_side == best_short && long_side < best_long)) {
+            best       = i;
+            best_short = short_side;
+            best_long  = long_side;
+        }
+    }
+
+    if (best == _free.end())
+        return nullopt;
+
+    auto used = rect{best->x, best->y, size.x(), size.y()};
+    split_free_rects(used);
+    prune_free_rects();
+
+    _used_area += u64(size.x()) * size.y();
+    return vec2u{used.x, used.y};
+}
+
+double maxrects_packer::occupancy() const {
+    auto area = u64(_size.x()) * _size.y();
+    return area ? static_cast<double>(_used_area) / static_cast<double>(area) : 0.0;
+}
+
+void maxrects_packer::split_free_rects(const rect& used) {
+    vector<rect> result;
+    result.reserve(_free.size() + 4);
+
+    for (auto& f : _free) {
+        if (used.x >= f.x + f.w || used.x + used.w <= f.x || used.y >= f.y + f.h || used.y + used.h <= f.y) {
+            result.push_back(f);
+            continue;
+        }
+
+        /* Up to four maximal rectangles around the used one */
+        if (used.x > f.x)
+            result.push_back({f.x, f.y, used.x - f.x, f.h});
+        if (used.x + used.w < f.x + f.w)
+            result.push_back({used.x + used.w, f.y, f.x + f.w - used.x - used.w, f.h});
+        if (used.y > f.y)
+            result.push_back({f.x, f.y, f.w, used.y - f.y});
+        if (used.y + used.h < f.y + f.h)
+            result.push_back({f.x, used.y + used.h, f.w, f.y + f.h - used.y - used.h});
+    }
+
+    _free = move(result);
+}
+
+void maxrects_packer::prune_free_rects() {
+    auto contains = [](const rect& a, const rect& b) {
+        return b.x >= a.x && b.y >= a.y && b.x + b.w <= a.x + a.w && b.y + b.h <= a.y + a.h;
+    };
+
+    vector<bool> removed(_free.size(), false);
+    for (size_t i = 0; i < _free.size(); ++i) {
+        if (removed[i])
+            continue;
+        for (size_t j = i + 1; j < _free.size(); ++j) {
+            if (removed[j])
+                continue;
+            if (contains(_free[j], _free[i])) {
+                removed[i] = true;
+                break;
+            }
+            if (contains(_free[i], _free[j]))
+                removed[j] = true;
+        }
+    }
+
+    size_t out = 0;
+    for (size_t i = 0; i < _free.size(); ++i)
+        if (!removed[i])
+            _free[out++] = _free[i];
+    _free.resize(out);
+}
+
+double atlas_layout::efficiency() const {
+    u64 images_area = 0;
+    for (auto& p : placements)
+        images_area += u64(p.size.x()) * p.size.y();
+
+    u64 pages_area = 0;
+    for (auto& page : pages)
+        pages_area += u64(page.x()) * page.y();
+
+    return pages_area ? static_cast<double>(images_area) / static_cast<double>(pages_area) : 0.0;
+}
+
+atlas_layout atlas_pack(span<const vec2u> sizes, const atlas_settings& settings) {
+    auto gutter    = settings.gutter();
+    auto alignment = settings.alignment();
+    auto page_size = vec2u{settings.page_size.x() / alignment * alignment,
+                           settings.page_size.y() / alignment * alignment};
+
+    atlas_layout layout;
+    layout.gutter = gutter;
+    layout.placements.resize(static_cast<size_t>(sizes.size()));
+
+    /* Slots are packed in units of the alignment, so every slot starts on the aligned texel */
+    auto slot_units = [&](vec2u size) {
+        return vec2u{align_up(size.x() + 2 * gutter, alignment) / alignment,
+                     align_up(size.y() + 2 * gutter, alignment) / alignment};
+    };
+
+    vector<size_t> order(layout.placements.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        auto sa = sizes[static_cast<ssize_t>(a)];
+        auto sb = sizes[static_cast<ssize_t>(b)];
+        auto ma = std::max(sa.x(), sa.y());
+        auto mb = std::max(sb.x(), sb.y());
+        return ma != mb ? ma > mb : u64(sa.x()) * sa.y() > u64(sb.x()) * sb.y();
+    });
+
+    vector<maxrects_packer> packers;
+    vector<vec2u>           extents;
+
+    for (auto i : order) {
+        auto size  = sizes[static_cast<ssize_t>(i)];
+        auto units = slot_units(size);
+
+        if (units.x() * alignment > page_size.x() || units.y() * alignment > page_size.y())
+            pe_throw std::runtime_error(format(
+                "atlas_pack: image {} with the gutter {} doesn't fit into the page {}", size, gutter, page_size));
+
+        optional<vec2u> pos;
+        u32             page = 0;
+        for (; page < packers.size(); ++page)
+            if ((pos = packers[page].insert(units)))
+                break;
+
+        if (!pos) {
+            packers.emplace_back(page_size / alignment);
+            extents.push_back({0, 0});
+            pos = packers.back().insert(units);
+        }
+
+        auto& extent = extents[page];
+        extent.x()   = std::max(extent.x(), (pos->x() + units.x()) * alignment);
+        extent.y()   = std::max(extent.y(), (pos->y() + units.y()) * alignment);
+
+        layout.placements[i] = {page, *pos * alignment + vec2u{gutter, gutter}, size};
+    }
+
+    layout.pages = move(extents);
+    return layout;
+}
+} // namespace util
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <core/vec.hpp>
+
+namespace util
+{
+struct atlas_settings {
+    /* The maximum size of the page, the last page is trimmed to its content */
+    core::vec2u page_size = {2048, 2048}; // NOLINT
+
+    /* Texels of the gutter around every image at the smallest mip-safe level, edge texels are extruded into it */
+    core::u32 padding = 2;
+
+    /* Mipmaps up to this level keep images apart: slots are aligned to 1 << mip_safe_levels texels and gutters are
+     * padding << mip_safe_levels texels wide at the largest level. Exact for the box filter, wider filters may mix
+     * outer texels of neighbouring gutters */
+    core::u32 mip_safe_levels = 2;
+
+    [[nodiscard]]
+    core::u32 gutter() const {
+        return padding << mip_safe_levels;
+    }
+
+    [[nodiscard]]
+    core::u32 alignment() const {
+        return 1U << mip_safe_levels;
+    }
+};
+
+/**
+ * @brief Packs rectangles into the fixed size area with the MaxRects algorithm
+ *
+ * Free space is kept as the list of maximal free rectangles, every rectangle is placed into the free rectangle
+ * that leaves the shortest leftover side (best short side fit). Rectangles are not rotated
+ */
+class maxrects_packer {
+public:
+    /**
+     * @param size - the size of the area
+     */
+    explicit maxrects_packer(core::vec2u size);
+
+    /**
+     * @brief Places the rectangle
+     *
+     * @param size - the size of the rectangle
+     *
+     * @return the position of the rectangle or nullopt if it doesn't fit
+     */
+    core::optional<core::vec2u> insert(core::vec2u size);
+
+    [[nodiscard]]
+    const core::vec2u& size() const {
+        return _size;
+    }
+
+    /**
+     * @brief Gets the area of placed rectangles
+     */
+    [[nodiscard]]
+    core::u64 used_area() const {
+        return _used_area;
+    }
+
+    /**
+     * @brief Gets the ratio of the used area to the area
+     */
+    [[nodiscard]]
+    double occupancy() const;
+
+private:
+    struct rect {
+        core::u32 x, y, w, h;
+    };
+
+    void split_free_rects(const rect& used);
+    void prune_free_rects();
+
+    core::vec2u        _size;
+    core::vector<rect> _free;
+    core::u64          _used_area = 0;
+};
+
+struct atlas_placement {
+    core::u32   page;
+    core::vec2u pos; /* Position of the image inside the gutter */
+    core::vec2u size;
+};
+
+struct atlas_layout {
+    core::vector<core::vec2u>     pages;      /* Sizes of pages */
+    core::vector<atlas_placement> placements; /* Placements of images in the input order */
+    core::u32                     gutter = 0;
+
+    /**
+     * @brief Gets the ratio of the area of images to the area of pages
+     */
+    [[nodiscard]]
+    double efficiency() const;
+};
+
+/**
+ * @brief Packs images into atlas pages
+ *
+ * Images are placed from the largest one into the first page with enough free space, new pages are opened on
+ * demand. Every page is trimmed to its content rounded up to the slot alignment
+ *
+ * @throw runtime_error if some image with its gutter doesn't fit into the empty page
+ *
+ * @param sizes - sizes of images
+ * @param settings - the page size, padding and mip-safe levels
+ *
+ * @return the layout
+ */
+atlas_layout atlas_pack(core::span<const core::vec2u> sizes, const atlas_settings& settings = {});
+} // namespace util
@@ -0,0 +1,411 @@
+#include "codec.hpp"
+
+#include <mutex>
+
+#include <core/config_manager.hpp>
+#include <core/serialization.hpp>
+#include <core/log.hpp>
+
+using namespace core;
+
+namespace
+{
+constexpr auto   codec_frame_magic       = array{'P', 'E', 'C', 'F'};
+constexpr size_t codec_frame_header_size = 4 + 1 + 8;
+
+/*
+ * LZ codec
+ *
+ * Uses the LZ4 block format: sequences of token | literals length | literals | u16 offset | match length.
+ * The last sequence has literals only; matches never start in the last 12 bytes and never cover
+ * the last 5 bytes, so the decoder can copy by 16 bytes without checking every byte
+ */
+namespace lz
+{
+    constexpr size_t min_match      = 4;
+    constexpr size_t last_literals  = 5;
+    constexpr size_t match_limit    = 12;
+    constexpr size_t max_offset     = 65535;
+    constexpr u32    hash_bits      = 16;
+    constexpr size_t wild_copy_size = 16;
+
+    inline u32 read32(const u8* p) {
+        u32 v; // NOLINT
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline u64 read64(const u8* p) {
+        u64 v; // NOLINT
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline u32 hash(u32 sequence) {
+        return (sequence * 2654435761U) >> (32 - hash_bits); // NOLINT
+    }
+
+    constexpr size_t max_compressed_size(size_t size) {
+        return size + size / 255 + 16; // NOLINT
+    }
+
+    inline void write_length(u8*& op, size_t length) {
+        for (; length >= 255; length -= 255) // NOLINT
+            *op++ = 255; // NOLINT
+        *op++ = static_cast<u8>(length);
+    }
+
+    inline void write_sequence(u8*& op, const u8* literals, size_t literals_size, size_t offset, size_t match_size) {
+        auto token = op++;
+        auto ml    = match_size ? match_size - min_match : 0;
+
+        *token = static_cast<u8>((std::min<size_t>(literals_size, 15) << 4U) | std::min<size_t>(ml, 15)); // NOLINT
+        if (literals_size >= 15) // NOLINT
+            write_length(op, literals_size - 15); // NOLINT
+
+        std::memcpy(op, literals, literals_size);
+        op += literals_size;
+
+        if (match_size) {
+            *op++ = static_cast<u8>(offset);
+            *op++ = static_cast<u8>(offset >> 8U); // NOLINT
+            if (ml >= 15) // NOLINT
+                write_length(op, ml - 15); // NOLINT
+        }
+    }
+
+    /* Returns the count of equal bytes */
+    inline size_t match_length(const u8* a, const u8* b, const u8* b_end) {
+        auto start = b;
+        while (b_end - b >= 8) {
+            auto diff = read64(a) ^ read64(b);
+            if (diff)
+                return static_cast<size_t>(b - start) + static_cast<size_t>(__builtin_ctzll(diff)) / 8;
+            a += 8;
+            b += 8;
+        }
+        while (b < b_end && *a == *b) {
+            ++a;
+            ++b;
+        }
+        return static_cast<size_t>(b - start);
+    }
+
+    vector<byte> compress(span<const byte> data) {
+        auto src  = reinterpret_cast<const u8*>(data.data()); // NOLINT
+        auto size = static_cast<size_t>(data.size());
+
+        vector<byte> out(max_compressed_size(size));
+        auto         op     = reinterpret_cast<u8*>(out.data()); // NOLINT
+        size_t       anchor = 0;
+
+        if (size > match_limit) {
+            auto   table    = vector<u32>(size_t(1) << hash_bits, 0);
+            auto   mf_limit = size - match_limit;
+            size_t ip       = 1;
+
+            while (ip < mf_limit) {
+                auto sequence = read32(src + ip);
+                auto h        = hash(sequence);
+                auto ref      = static_cast<size_t>(table[h]);
+                table[h]      = static_cast<u32>(ip);
+
+                if (ip - ref > max_offset || read32(src + ref) != sequence) {
+                    /* Skip faster through incompressible data */
+                    ip += 1 + ((ip - anchor) >> 6U); // NOLINT
+                    continue;
+                }
+
+                /* Extend backwards over pending literals */
+                while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                    --ip;
+                    --ref;
+                }
+
+                auto length = min_match +
+                              match_length(src + ref + min_match, src + ip + min_match, src + size - last_literals);
+
+                write_sequence(op, src + anchor, ip - anchor, ip - ref, length);
+                ip += length;
+                anchor = ip;
+
+                if (ip < mf_limit)
+                    table[hash(read32(src + ip - 2))] = static_cast<u32>(ip - 2);
+            }
+        }
+
+        write_sequence(op, src + anchor, size - anchor, 0, 0);
+
+        out.resize(static_cast<size_t>(op - reinterpret_cast<u8*>(out.data()))); // NOLINT
+        return out;
+    }
+
+    [[noreturn]] void throw_corrupted() {
+        pe_throw std::runtime_error("lz: corrupted data");
+    }
+
+    inline size_t read_length(const u8*& ip, const u8* iend) {
+        size_t length = 0;
+        u8     b; // NOLINT
+        do {
+            if (ip == iend)
+                throw_corrupted();
+            b = *ip++;
+            length += b;
+        } while (b == 255); // NOLINT
+        return length;
+    }
+
+    void decompress(span<const byte> data, span<byte> output) {
+        auto ip     = reinterpret_cast<const u8*>(data.data()); // NOLINT
+        auto iend   = ip + data.size();
+        auto ostart = reinterpret_cast<u8*>(output.data()); // NOLINT
+        auto op     = ostart;
+        auto oend   = ostart + output.size();
+
+        while (true) {
+            if (ip == iend)
+                throw_corrupted();
+
+            auto token    = *ip++;
+            auto literals = static_cast<size_t>(token >> 4U);
+            if (literals == 15) // NOLINT
+                literals += read_length(ip, iend);
+
+            if (literals > static_cast<size_t>(iend - ip) || literals > static_cast<size_t>(oend - op))
+                throw_corrupted();
+
+            if (static_cast<size_t>(iend - ip) >= literals + wild_copy_size &&
+                static_cast<size_t>(oend - op) >= literals + wild_copy_size) {
+                for (size_t i = 0; i < literals; i += wild_copy_size)
+                    std::memcpy(op + i, ip + i, wild_copy_size);
+            }
+            else {
+                std::memcpy(op, ip, literals);
+            }
+            ip += literals;
+            op += literals;
+
+            /* The last sequence has no match */
+            if (ip == iend)
+                break;
+
+            if (iend - ip < 2)
+                throw_corrupted();
+
+            auto offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8U); // NOLINT
+            ip += 2;
+
+            if (offset == 0 || offset > static_cast<size_t>(op - ostart))
+                throw_corrupted();
+
+            auto length = static_cast<size_t>(token & 15U) + min_match; // NOLINT
+            if ((token & 15U) == 15) // NOLINT
+                length += read_length(ip, iend);
+
+            if (length > static_cast<size_t>(oend - op))
+                throw_corrupted();
+
+            auto match = op - offset;
+            if (offset >= wild_copy_size && static_cast<size_t>(oend - op) >= length + wild_copy_size) {
+                /* Chunks never overlap the bytes which are written by the same chunk */
+                for (size_t i = 0; i < length; i += wild_copy_size)
+                    std::memcpy(op + i, match + i, wild_copy_size);
+            }
+            else {
+                for (size_t i = 0; i < length; ++i)
+                    op[i] = match[i];
+            }
+            op += length;
+        }
+
+        if (op != oend)
+            throw_corrupted();
+    }
+} // namespace lz
+
+class store_codec : public util::codec {
+public:
+    [[nodiscard]]
+    util::codec_id id() const override {
+        return util::codec_id::store;
+    }
+
+    [[nodiscard]]
+    string_view name() const override {
+        return "store";
+    }
+
+    [[nodiscard]]
+    u64 max_expansion() const override {
+        return 1;
+    }
+
+    [[nodiscard]]
+    vector<byte> compress(span<const byte> data, int) const override {
+        return vector<byte>(data.begin(), data.end());
+    }
+
+    void decompress(span<const byte> data, span<byte> output) const override {
+        if (data.size() != output.size())
+            pe_throw std::runtime_error("store: size differs with the raw size");
+        std::memcpy(output.data(), data.data(), static_cast<size_t>(data.size()));
+    }
+};
+
+class zlib_codec : public util::codec {
+public:
+    [[nodiscard]]
+    util::codec_id id() const override {
+        return util::codec_id::zlib;
+    }
+
+    [[nodiscard]]
+    string_view name() const override {
+        return "zlib";
+    }
+
+    /* Deflate encodes at most 258 bytes with ~2 bits */
+    [[nodiscard]]
+    u64 max_expansion() const override {
+        return 1032; // NOLINT
+    }
+
+    [[nodiscard]]
+    vector<byte> compress(span<const byte> data, int compression_level) const override {
+        return util::compress_block(data, compression_level);
+    }
+
+    void decompress(span<const byte> data, span<byte> output) const override {
+        if (util::decompress_into(data, output) != static_cast<size_t>(output.size()))
+            pe_throw std::runtime_error("zlib: decompressed size differs with the raw size");
+    }
+};
+
+class lz_codec : public util::codec {
+public:
+    [[nodiscard]]
+    util::codec_id id() const override {
+        return util::codec_id::lz;
+    }
+
+    [[nodiscard]]
+    string_view name() const override {
+        return "lz";
+    }
+
+    /* Every 0xff byte of the match length adds 255 bytes */
+    [[nodiscard]]
+    u64 max_expansion() const override {
+        return 255; // NOLINT
+    }
+
+    /* The level is ignored, there is only one speed/ratio tradeoff */
+    [[nodiscard]]
+    vector<byte> compress(span<const byte> data, int) const override {
+        return lz::compress(data);
+    }
+
+    void decompress(span<const byte> data, span<byte> output) const override {
+        lz::decompress(data, output);
+    }
+};
+
+u64 read_frame_header(span<const byte>& frame, util::codec_id& id) {
+    if (static_cast<size_t>(frame.size()) < codec_frame_header_size || !util::is_codec_frame(frame))
+        pe_throw std::runtime_error("codec: invalid frame header");
+
+    array<char, 4> magic;    // NOLINT
+    u64            raw_size; // NOLINT
+    deserialize_all(frame, magic, id, raw_size);
+
+    /* Checked before the output is allocated */
+    if (raw_size / util::get_codec(id).max_expansion() > static_cast<u64>(frame.size()))
+        pe_throw std::runtime_error("codec: frame raw size exceeds the maximum expansion of the payload");
+
+    return raw_size;
+}
+} // namespace
+
+namespace util
+{
+const codec& get_codec(codec_id id) {
+    static const store_codec store;
+    static const zlib_codec  zlib;
+    static const lz_codec    lz;
+
+    switch (id) {
+    case codec_id::store: return store;
+    case codec_id::zlib: return zlib;
+    case codec_id::lz: return lz;
+    }
+
+    pe_throw std::runtime_error("codec: unknown codec id " + std::to_string(static_cast<u32>(id)));
+}
+
+codec_settings asset_codec(string_view asset_type) {
+    static std::mutex                       mutex;
+    static hash_map<string, codec_settings> cache;
+
+    std::lock_guard lock{mutex};
+
+    auto found = cache.find(string(asset_type));
+    if (found != cache.end())
+        return found->second;
+
+    auto settings = codec_settings{};
+    if (asset_type == "mesh" || asset_type == "texture")
+        settings = codec_settings{codec_id::lz, COMPRESS_DEFAULT};
+
+    try {
+        auto section = config_section::direct_read("asset_codecs");
+        if (auto codec = section.try_read<codec_id>(string(asset_type)))
+            settings.codec = *codec;
+        if (auto level = section.try_read<int>(string(asset_type) + "_level"))
+            settings.level = *level;
+    }
+    catch (const std::exception& e) {
+        DLOG("asset_codec: can't read codec settings for '{}': {}", asset_type, e.what());
+    }
+
+    cache.emplace(string(asset_type), settings);
+    return settings;
+}
+
+bool is_codec_frame(span<const byte> data) {
+    return static_cast<size_t>(data.size()) >= codec_frame_magic.size() &&
+           std::memcmp(data.data(), codec_frame_magic.data(), codec_frame_magic.size()) == 0;
+}
+
+u64 codec_frame_raw_size(span<const byte> frame) {
+    codec_id id; // NOLINT
+    return read_frame_header(frame, id);
+}
+
+vector<byte> compress_frame(span<const byte> data, codec_settings settings) {
+    auto compressed = get_codec(settings.codec).compress(data, settings.level);
+
+    vector<byte> result;
+    result.reserve(codec_frame_header_size + compressed.size());
+    serialize_all(result, codec_frame_magic, settings.codec, static_cast<u64>(data.size()));
+    result.insert(result.end(), compressed.begin(), compressed.end());
+
+    return result;
+}
+
+void decompress_frame(span<const byte> frame, span<byte> output) {
+    codec_id id; // NOLINT
+    auto     raw_size = read_frame_header(frame, id);
+
+    if (raw_size != static_cast<u64>(output.size()))
+        pe_throw std::runtime_error("codec: frame raw size differs with the output size");
+
+    get_codec(id).decompress(frame, output);
+}
+
+vector<byte> decompress_frame(span<const byte> frame) {
+    vector<byte> result(static_cast<size_t>(codec_frame_raw_size(frame)));
+    decompress_frame(frame, result);
+    return result;
+}
+} // namespace util
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "compression.hpp"
+
+namespace util
+{
+/**
+ * @brief Identifies the codec in the frame header, values are stored in files
+ */
+enum class codec_id : core::u8 {
+    store = 0, /* No compression */
+    zlib,      /* Gzip-framed deflate, the best ratio */
+    lz,        /* Byte-oriented LZ77 (LZ4 block format), the fastest decompression */
+};
+
+/**
+ * @brief Compression algorithm
+ */
+class codec {
+public:
+    virtual ~codec() = default;
+
+    [[nodiscard]]
+    virtual codec_id id() const = 0;
+
+    [[nodiscard]]
+    virtual core::string_view name() const = 0;
+
+    /**
+     * @brief Gets the maximum ratio of the decompressed size to the compressed size
+     *
+     * Raw sizes from headers are checked with it before the output is allocated
+     */
+    [[nodiscard]]
+    virtual core::u64 max_expansion() const = 0;
+
+    /**
+     * @brief Compresses the input
+     *
+     * @param data - byte input
+     * @param compression_level - -1 - default, 1 - best speed, 9 - best compression (codecs may ignore it)
+     *
+     * @return compressed bytes
+     */
+    [[nodiscard]]
+    virtual core::vector<core::byte> compress(core::span<const core::byte> data, int compression_level) const = 0;
+
+    /**
+     * @brief Decompresses the input into the buffer
+     *
+     * @throw runtime_error if the input is corrupted or its decompressed size differs with the buffer size
+     *
+     * @param data - compressed bytes
+     * @param output - the output buffer, must have the exact decompressed size
+     */
+    virtual void decompress(core::span<const core::byte> data, core::span<core::byte> output) const = 0;
+};
+
+/**
+ * @brief Gets the codec
+ *
+ * @throw runtime_error if the codec is unknown
+ *
+ * @param id - the codec id
+ *
+ * @return the codec
+ */
+const codec& get_codec(codec_id id);
+
+/**
+ * @brief Codec and compression level
+ */
+struct codec_settings {
+    codec_id codec = codec_id::zlib;
+    int      level = COMPRESS_DEFAULT;
+};
+
+/**
+ * @brief Gets the codec settings for the asset type
+ *
+ * Settings are read from the [asset_codecs] section of the default config,
+ * e.g. `mesh = lz` or `texture = zlib` (levels are set with `mesh_level = 9`).
+ * Meshes and textures use lz by default, other assets use zlib
+ *
+ * @param asset_type - the asset type (e.g. "mesh", "texture")
+ *
+ * @return codec settings
+ */
+codec_settings asset_codec(core::string_view asset_type);
+
+/**
+ * @brief Compresses the input into a self-describing frame
+ *
+ * Frame: "PECF" | u8 codec id | u64 raw size | compressed bytes
+ *
+ * @param data - byte input
+ * @param settings - the codec and the compression level
+ *
+ * @return the frame
+ */
+core::vector<core::byte> compress_frame(core::span<const core::byte> data, codec_settings settings = {});
+
+/**
+ * @brief Decompresses the frame written by compress_frame
+ *
+ * @throw runtime_error if the frame is invalid
+ *
+ * @param frame - the frame
+ *
+ * @return decompressed bytes
+ */
+core::vector<core::byte> decompress_frame(core::span<const core::byte> frame);
+
+/**
+ * @brief Decompresses the frame written by compress_frame into the buffer
+ *
+ * @throw runtime_error if the frame is invalid or the buffer size differs with the raw size
+ *
+ * @param frame - the frame
+ * @param output - the output buffer
+ */
+void decompress_frame(core::span<const core::byte> frame, core::span<core::byte> output);
+
+/**
+ * @brief Checks that the input is a frame written by compress_frame
+ */
+bool is_codec_frame(core::span<const core::byte> data);
+
+/**
+ * @brief Gets the raw size from the frame header
+ *
+ * @throw runtime_error if the frame is invalid or the raw size exceeds the codec's maximum expansion of the payload
+ */
+core::u64 codec_frame_raw_size(core::span<const core::byte> frame);
+} // namespace util
@@ -1,6 +1,10 @@
 #include "compression.hpp"
+#include "codec.hpp"
 
 #include <zlib.h>
+#include <unistd.h>
+#include <core/fiber_pool.hpp>
+#include <core/serialization.hpp>
 
 using namespace core;
 
@@ -27,128 +31,15 @@ void throw_zlib(int error_code, z_streamp to_free = nullptr) {
 
 constexpr const size_t chunk_size = 16384;
 
-template <bool Inflate>
-vector<byte> compress(span<const byte>                data,
-                      [[maybe_unused]] int            compression_level,
-                      const function<void(u64, u64)>& progress) {
-    z_stream stream;
-
-    Bytef  in[chunk_size];  // NOLINT
-    Bytef  out[chunk_size]; // NOLINT
-    size_t count = 0;
-
-    vector<byte> res;
-    res.reserve(static_cast<size_t>(data.size()));
-
-    stream.zalloc   = Z_NULL;
-    stream.zfree    = Z_NULL;
-    stream.opaque   = Z_NULL;
-    stream.avail_in = 0;
-    stream.next_in  = Z_NULL;
-
-    int rc; // NOLINT
-    if constexpr (Inflate)
-        rc = inflateInit2(&stream, MAX_WBITS + 16);
-    else
-        rc = deflateInit2(&stream,
-                          util::compress_level_clamp(compression_level),
-                          Z_DEFLATED,
-                          MAX_WBITS + 16,
-                          8,
-                          Z_DEFAULT_STRATEGY);
-
-    if (rc != Z_OK)
-        throw_zlib<Inflate>(rc);
-
-    bool work = true;
-    do {
-        stream.avail_in = uInt(static_cast<size_t>(data.size()) - count >= chunk_size
-                                   ? chunk_size
-                                   : static_cast<size_t>(data.size()) - count);
-        memcpy(in, data.data() + count, stream.avail_in);
-        count += stream.avail_in;
-
-        if (progress)
-            progress(count, static_cast<u64>(data.size()));
-
-        if (stream.avail_in == 0)
-            break;
-
-        stream.next_in = in;
-
-        int flsh; // NOLINT
-
-        do {
-            stream.avail_out = chunk_size;
-            stream.next_out  = out;
-
-            if constexpr (Inflate) {
-                flsh = Z_NO_FLUSH;
-                rc = inflate(&stream, flsh);
-            } else {
-                flsh = count < static_cast<size_t>(data.size()) ? Z_NO_FLUSH : Z_FINISH;
-                rc = deflate(&stream, flsh);
-            }
-
-            if (rc != Z_OK && rc != Z_STREAM_END) {
-                if (rc == Z_NEED_DICT)
-                    rc = Z_DATA_ERROR;
-
-                throw_zlib<Inflate>(rc, &stream);
-            }
-
-            auto have = chunk_size - stream.avail_out;
-            auto start = res.size();
-            res.resize(res.size() + have);
-            std::memcpy(res.data() + start, out, have);
-
-        } while (stream.avail_out == 0);
-
-        if constexpr (Inflate)
-            work = rc != Z_STREAM_END;
-        else
-            work = flsh != Z_FINISH;
-    } while (work);
-
-    if constexpr (Inflate)
-        inflateEnd(&stream);
-    else
-        deflateEnd(&stream);
-
-    return res;
-}
-
-template <bool IsConst>
-struct block_storage {
-    block_storage(size_t) {}
-};
-
-template <>
-struct block_storage<true> {
-    block_storage(size_t size) { data.resize(size); }
-    vector<Bytef> data;
-};
+/* zlib counts in uInt */
+constexpr size_t max_zlib_chunk = 1U << 30U;
 
 template <typename T>
 vector<byte> compress_block(span<T> data, int compression_level) {
-    vector<byte> out;
-    out.resize(static_cast<size_t>(data.size()));
-
     z_stream stream;
     stream.zalloc   = Z_NULL;
     stream.zfree    = Z_NULL;
     stream.opaque   = Z_NULL;
-    stream.avail_in = static_cast<uInt>(data.size());
-    stream.avail_out = static_cast<uInt>(out.size());
-    stream.next_out  = reinterpret_cast<Bytef*>(out.data()); // NOLINT
-
-    auto in_tmp = block_storage<std::is_const_v<T>>(static_cast<size_t>(data.size()));
-    if constexpr (std::is_const_v<T>) {
-        stream.next_in = in_tmp.data.data();
-        std::memcpy(in_tmp.data.data(), data.data(), static_cast<size_t>(data.size()));
-    } else {
-        stream.next_in = reinterpret_cast<Bytef*>(data.data()); // NOLINT
-    }
 
     int rc = deflateInit2(&stream,
                           util::compress_level_clamp(compression_level),
@@ -160,8 +51,17 @@ vector<byte> compress_block(span<T> data, int compression_level) {
     if (rc != Z_OK)
         throw_zlib<false>(rc);
 
+    /* Incompressible input grows, so the output is sized by the bound */
+    vector<byte> out;
+    out.resize(deflateBound(&stream, static_cast<uLong>(data.size())));
+
+    stream.avail_in  = static_cast<uInt>(data.size());
+    stream.avail_out = static_cast<uInt>(out.size());
+    stream.next_out  = reinterpret_cast<Bytef*>(out.data()); // NOLINT
+    stream.next_in   = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(data.data())); // NOLINT
+
     rc = deflate(&stream, Z_FINISH);
-    if (rc != Z_OK && rc != Z_STREAM_END) {
+    if (rc != Z_STREAM_END) {
         if (rc == Z_NEED_DICT)
             rc = Z_DATA_ERROR;
         throw_zlib<false>(rc, &stream);
@@ -172,40 +72,52 @@ vector<byte> compress_block(span<T> data, int compression_level) {
     return out;
 }
 
-template <typename T>
-vector<byte> decompress_block(span<T> data, size_t output_size) {
-    vector<byte> out;
-    out.resize(output_size);
-
+/*
+ * Returns the count of decompressed bytes. The stream must end within the data and the output,
+ * streams which don't fit into the output or are cut off are errors
+ */
+size_t decompress_into(span<const byte> data, byte* out, size_t output_size) {
     z_stream stream;
-    stream.zalloc   = Z_NULL;
-    stream.zfree    = Z_NULL;
-    stream.opaque   = Z_NULL;
-    stream.avail_in = static_cast<uInt>(data.size());
-    stream.avail_out = static_cast<uInt>(out.size());
-    stream.next_out  = reinterpret_cast<Bytef*>(out.data()); // NOLINT
-
-    auto in_tmp = block_storage<std::is_const_v<T>>(static_cast<size_t>(data.size()));
-    if constexpr (std::is_const_v<T>) {
-        stream.next_in = in_tmp.data.data();
-        std::memcpy(in_tmp.data.data(), data.data(), static_cast<size_t>(data.size()));
-    } else {
-        stream.next_in = reinterpret_cast<Bytef*>(data.data()); // NOLINT
-    }
+    stream.zalloc    = Z_NULL;
+    stream.zfree     = Z_NULL;
+    stream.opaque    = Z_NULL;
+    stream.avail_in  = static_cast<uInt>(data.size());
+    stream.avail_out = static_cast<uInt>(output_size);
+    stream.next_out  = reinterpret_cast<Bytef*>(out); // NOLINT
+    stream.next_in   = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(data.data())); // NOLINT
+
+    /* zlib rejects the null output even if it is empty */
+    Bytef empty_out; // NOLINT
+    if (!out)
+        stream.next_out = &empty_out;
 
     int rc = inflateInit2(&stream, MAX_WBITS + 16);
 
     if (rc != Z_OK)
         throw_zlib<true>(rc);
 
-    rc = inflate(&stream, Z_NO_FLUSH);
-    if (rc != Z_OK && rc != Z_STREAM_END) {
+    rc = inflate(&stream, Z_FINISH);
+    if (rc != Z_STREAM_END) {
+        if (rc == Z_OK || rc == Z_BUF_ERROR) {
+            auto overflow = stream.avail_out == 0;
+            inflateEnd(&stream);
+            pe_throw std::runtime_error(overflow ? "zlib: decompressed data exceeds the output size"
+                                                 : "zlib: compressed data is truncated");
+        }
         if (rc == Z_NEED_DICT)
             rc = Z_DATA_ERROR;
         throw_zlib<true>(rc, &stream);
     }
     inflateEnd(&stream);
 
+    return output_size - stream.avail_out;
+}
+
+template <typename T>
+vector<byte> decompress_block(span<T> data, size_t output_size) {
+    vector<byte> out;
+    out.resize(output_size);
+    out.resize(decompress_into(data, out.data(), out.size()));
     return out;
 }
 
@@ -231,15 +143,508 @@ vector<byte> decompress_block(span<const byte> data, size_t output_size) {
 }
 }
 
+namespace
+{
+constexpr auto block_frame_magic   = array{'P', 'E', 'Z', 'B'};
+constexpr u32  block_frame_version = 1;
+constexpr u64  block_frame_max_blocks = 1ULL << 32U;
+/* Deflate can't expand a block more than ~1032 times, larger raw sizes in the header are corrupted */
+constexpr u64  block_frame_max_ratio = 1032;
+
+struct block_frame {
+    u64         raw_size;
+    u64         block_size;
+    vector<u64> compressed_sizes;
+    span<const byte> payload;
+
+    [[nodiscard]]
+    size_t block_raw_size(size_t block) const {
+        return static_cast<size_t>(std::min(block_size, raw_size - block * block_size));
+    }
+};
+
+block_frame read_block_frame(span<const byte> data) {
+    array<char, 4> magic;   // NOLINT
+    u32            version; // NOLINT
+    u64            blocks_count; // NOLINT
+    block_frame    frame;
+
+    deserialize_all(data, magic, version, frame.raw_size, frame.block_size, blocks_count);
+
+    if (magic != block_frame_magic || version != block_frame_version)
+        pe_throw std::runtime_error("block compression: invalid frame header");
+
+    if (blocks_count > block_frame_max_blocks || blocks_count * sizeof(u64) > static_cast<u64>(data.size()) ||
+        frame.block_size == 0 ||
+        blocks_count != frame.raw_size / frame.block_size + (frame.raw_size % frame.block_size != 0))
+        pe_throw std::runtime_error("block compression: invalid block index");
+
+    if (blocks_count != 0 && (frame.block_size > std::numeric_limits<u64>::max() / blocks_count ||
+                              frame.raw_size > blocks_count * frame.block_size))
+        pe_throw std::runtime_error("block compression: raw size exceeds the block index");
+
+    frame.compressed_sizes.resize(blocks_count);
+    u64 payload_size = 0;
+    for (auto& size : frame.compressed_sizes) {
+        deserialize(size, data);
+        payload_size += size;
+    }
+
+    if (payload_size != static_cast<u64>(data.size()))
+        pe_throw std::runtime_error("block compression: payload size differs with block index");
+
+    /* Checked before the output is allocated */
+    if (frame.raw_size / block_frame_max_ratio > payload_size)
+        pe_throw std::runtime_error("block compression: raw size exceeds the maximum compression ratio");
+
+    frame.payload = data;
+    return frame;
+}
+} // namespace
+
 namespace util
 {
+compressor::compressor(int compression_level): _stream(make_unique<z_stream>()) {
+    _stream->zalloc   = Z_NULL;
+    _stream->zfree    = Z_NULL;
+    _stream->opaque   = Z_NULL;
+    _stream->avail_in = 0;
+    _stream->next_in  = Z_NULL;
+
+    int rc = deflateInit2(
+        _stream.get(), compress_level_clamp(compression_level), Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY);
+
+    if (rc != Z_OK)
+        throw_zlib<false>(rc);
+}
+
+compressor::~compressor() {
+    if (_stream)
+        deflateEnd(_stream.get());
+}
+
+compressor::compressor(compressor&&) noexcept = default;
+compressor& compressor::operator=(compressor&& c) noexcept {
+    if (_stream)
+        deflateEnd(_stream.get());
+    _stream = move(c._stream);
+    _input  = c._input;
+    _last   = c._last;
+    _done   = c._done;
+    return *this;
+}
+
+void compressor::push(span<const byte> input, bool last) {
+    Expects(needs_input());
+    _input = input;
+    _last  = last;
+}
+
+size_t compressor::pull(span<byte> output) {
+    if (_done || output.empty())
+        return 0;
+
+    if (_stream->avail_in == 0 && !_input.empty()) {
+        auto size          = std::min(static_cast<size_t>(_input.size()), max_zlib_chunk);
+        _stream->next_in   = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(_input.data())); // NOLINT
+        _stream->avail_in  = static_cast<uInt>(size);
+        _input             = _input.subspan(static_cast<ptrdiff_t>(size));
+    }
+
+    auto size          = std::min(static_cast<size_t>(output.size()), max_zlib_chunk);
+    _stream->next_out  = reinterpret_cast<Bytef*>(output.data()); // NOLINT
+    _stream->avail_out = static_cast<uInt>(size);
+
+    auto flush = _last && _input.empty() ? Z_FINISH : Z_NO_FLUSH;
+    int  rc    = deflate(_stream.get(), flush);
+
+    if (rc == Z_STREAM_END)
+        _done = true;
+    else if (rc != Z_OK && rc != Z_BUF_ERROR)
+        throw_zlib<false>(rc);
+
+    return size - _stream->avail_out;
+}
+
+bool compressor::needs_input() const {
+    return !_last && _input.empty() && _stream->avail_in == 0;
+}
+
+bool compressor::done() const {
+    return _done;
+}
+
+u64 compressor::total_in() const {
+    return _stream->total_in;
+}
+
+u64 compressor::total_out() const {
+    return _stream->total_out;
+}
+
+decompressor::decompressor(): _stream(make_unique<z_stream>()) {
+    _stream->zalloc   = Z_NULL;
+    _stream->zfree    = Z_NULL;
+    _stream->opaque   = Z_NULL;
+    _stream->avail_in = 0;
+    _stream->next_in  = Z_NULL;
+
+    int rc = inflateInit2(_stream.get(), MAX_WBITS + 16);
+    if (rc != Z_OK)
+        throw_zlib<true>(rc);
+}
+
+decompressor::~decompressor() {
+    if (_stream)
+        inflateEnd(_stream.get());
+}
+
+decompressor::decompressor(decompressor&&) noexcept = default;
+decompressor& decompressor::operator=(decompressor&& d) noexcept {
+    if (_stream)
+        inflateEnd(_stream.get());
+    _stream = move(d._stream);
+    _input  = d._input;
+    _done   = d._done;
+    return *this;
+}
+
+void decompressor::push(span<const byte> input) {
+    Expects(needs_input());
+    _input = input;
+}
+
+size_t decompressor::pull(span<byte> output) {
+    if (_done || output.empty())
+        return 0;
+
+    if (_stream->avail_in == 0 && !_input.empty()) {
+        auto size          = std::min(static_cast<size_t>(_input.size()), max_zlib_chunk);
+        _stream->next_in   = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(_input.data())); // NOLINT
+        _stream->avail_in  = static_cast<uInt>(size);
+        _input             = _input.subspan(static_cast<ptrdiff_t>(size));
+    }
+
+    auto size          = std::min(static_cast<size_t>(output.size()), max_zlib_chunk);
+    _stream->next_out  = reinterpret_cast<Bytef*>(output.data()); // NOLINT
+    _stream->avail_out = static_cast<uInt>(size);
+
+    int rc = inflate(_stream.get(), Z_NO_FLUSH);
+
+    if (rc == Z_STREAM_END)
+        _done = true;
+    else if (rc == Z_NEED_DICT)
+        throw_zlib<true>(Z_DATA_ERROR);
+    else if (rc != Z_OK && rc != Z_BUF_ERROR)
+        throw_zlib<true>(rc);
+
+    return size - _stream->avail_out;
+}
+
+bool decompressor::needs_input() const {
+    return !_done && _input.empty() && _stream->avail_in == 0;
+}
+
+bool decompressor::done() const {
+    return _done;
+}
+
+u64 decompressor::total_in() const {
+    return _stream->total_in;
+}
+
+u64 decompressor::total_out() const {
+    return _stream->total_out;
+}
+
+namespace {
+optional<u64> gzip_size_hint(span<const byte> data) {
+    /* The gzip trailer ends with the uncompressed size modulo 2^32 */
+    constexpr ptrdiff_t min_gzip_size = 18;
+    if (data.size() < min_gzip_size || data[0] != byte(0x1f) || data[1] != byte(0x8b)) // NOLINT
+        return nullopt;
+
+    u32 size; // NOLINT
+    std::memcpy(&size, data.data() + data.size() - 4, sizeof(size));
+    return size;
+}
+} // namespace
+
 vector<byte> decompress(span<const byte> data, const function<void(u64, u64)>& progress) {
-    return ::compress<true>(data, -1, progress);
+    if (data.empty())
+        return {};
+
+    if (is_block_compressed(data))
+        return decompress_parallel(data, progress);
+
+    if (is_codec_frame(data))
+        return decompress_frame(data);
+
+    decompressor d;
+    d.push(data);
+
+    /* The hint is exact for streams below 4 GiB, the result grows only if it was wrapped.
+     * The trailer is not trusted beyond a few input sizes, so a crafted one can't reserve gigabytes */
+    constexpr size_t max_hint_ratio = 8;
+    auto             hint           = std::min(static_cast<size_t>(gzip_size_hint(data).value_or(0)),
+                                   static_cast<size_t>(data.size()) * max_hint_ratio);
+
+    vector<byte> result;
+    result.reserve(std::max(hint, chunk_size));
+
+    while (!d.done()) {
+        if (result.size() == result.capacity())
+            result.reserve(result.capacity() * 2);
+
+        auto size = result.size();
+        result.resize(result.capacity());
+
+        auto count = d.pull(span<byte>(result).subspan(static_cast<ptrdiff_t>(size)));
+        result.resize(size + count);
+
+        if (count == 0 && d.needs_input())
+            pe_throw std::runtime_error("zlib: unexpected end of stream");
+
+        if (progress)
+            progress(d.total_in(), static_cast<u64>(data.size()));
+    }
+
+    return result;
+}
+
+vector<byte> compress(span<const byte> data, int compression_level, const function<void(u64, u64)>& progress) {
+    compressor c(compression_level);
+
+    vector<byte> result;
+    result.reserve(std::max<size_t>(static_cast<size_t>(data.size()) / 2, chunk_size));
+
+    /* Input is pushed by chunks for the progress callback */
+    constexpr size_t progress_chunk = 1 << 20;
+    size_t           pushed         = 0;
+
+    while (!c.done()) {
+        if (c.needs_input()) {
+            auto size = std::min(static_cast<size_t>(data.size()) - pushed, progress_chunk);
+            c.push(data.subspan(static_cast<ptrdiff_t>(pushed), static_cast<ptrdiff_t>(size)),
+                   pushed + size == static_cast<size_t>(data.size()));
+            pushed += size;
+
+            if (progress)
+                progress(pushed, static_cast<u64>(data.size()));
+        }
+
+        if (result.size() == result.capacity())
+            result.reserve(result.capacity() * 2);
+
+        auto size = result.size();
+        result.resize(result.capacity());
+        result.resize(size + c.pull(span<byte>(result).subspan(static_cast<ptrdiff_t>(size))));
+    }
+
+    return result;
 }
 
-vector<byte>
-compress(span<const byte> data, int compression_level, const function<void(u64, u64)>& progress) {
-    return ::compress<false>(data, compression_level, progress);
+namespace {
+/* Returns 0 at the end of file */
+size_t read_fd(int fd, span<byte> buffer) {
+    while (true) {
+        auto rc = ::read(fd, buffer.data(), static_cast<size_t>(buffer.size()));
+        if (rc >= 0)
+            return static_cast<size_t>(rc);
+        if (errno != EINTR)
+            pe_throw std::runtime_error(string("Can't read file descriptor: ") + std::strerror(errno));
+    }
+}
+} // namespace
+
+u64 compress_fd(int in_fd, int out_fd, int compression_level, size_t buffer_size) {
+    fd_sink          output(out_fd);
+    compressing_sink sink(output, compression_level, buffer_size);
+    vector<byte>     input(buffer_size);
+
+    while (auto count = read_fd(in_fd, input))
+        sink.write(span<const byte>(input).first(static_cast<ptrdiff_t>(count)));
+    sink.finish();
+
+    return sink.written();
+}
+
+u64 decompress_fd(int in_fd, int out_fd, size_t buffer_size) {
+    fd_sink      output(out_fd);
+    decompressor d;
+    vector<byte> input(buffer_size);
+    vector<byte> buffer(buffer_size);
+    u64          written = 0;
+
+    while (!d.done()) {
+        if (d.needs_input()) {
+            auto count = read_fd(in_fd, input);
+            if (count == 0)
+                pe_throw std::runtime_error("zlib: unexpected end of stream");
+            d.push(span<const byte>(input).first(static_cast<ptrdiff_t>(count)));
+        }
+
+        auto count = d.pull(buffer);
+        output.write(span<const byte>(buffer).first(static_cast<ptrdiff_t>(count)));
+        written += count;
+    }
+
+    return written;
+}
+
+void decompress_fd(int in_fd, span<byte> output, size_t buffer_size) {
+    decompressor d;
+    vector<byte> input(buffer_size);
+    size_t       written = 0;
+
+    while (!d.done()) {
+        if (d.needs_input()) {
+            auto count = read_fd(in_fd, input);
+            if (count == 0)
+                pe_throw std::runtime_error("zlib: unexpected end of stream");
+            d.push(span<const byte>(input).first(static_cast<ptrdiff_t>(count)));
+        }
+
+        /* Pulling into the full buffer checks that the stream is not longer than the buffer */
+        byte extra; // NOLINT
+        auto rest = output.subspan(static_cast<ptrdiff_t>(written));
+        auto count = rest.empty() ? d.pull(span<byte>(&extra, 1)) : d.pull(rest);
+        if (rest.empty() && count)
+            pe_throw std::runtime_error("zlib: decompressed size exceeds the buffer size");
+
+        written += count;
+    }
+
+    if (written != static_cast<size_t>(output.size()))
+        pe_throw std::runtime_error("zlib: decompressed size differs with the buffer size");
+}
+
+compressing_sink::compressing_sink(serialization_sink& output, int compression_level, size_t buffer_size):
+    _output(output), _compressor(compression_level), _buffer(std::max<size_t>(buffer_size, 1)) {}
+
+void compressing_sink::write(span<const byte> chunk) {
+    if (chunk.empty())
+        return;
+
+    _compressor.push(chunk);
+    drain();
+}
+
+void compressing_sink::finish() {
+    _compressor.push({}, true);
+    drain();
+    _output.finish();
+}
+
+u64 compressing_sink::written() const {
+    return _compressor.total_out();
+}
+
+void compressing_sink::drain() {
+    while (!_compressor.needs_input() && !_compressor.done()) {
+        auto count = _compressor.pull(_buffer);
+        if (count)
+            _output.write(span<const byte>(_buffer).first(static_cast<ptrdiff_t>(count)));
+    }
+}
+
+size_t decompress_into(span<const byte> data, span<byte> output) {
+    return ::decompress_into(data, output.data(), static_cast<size_t>(output.size()));
+}
+
+bool is_block_compressed(span<const byte> data) {
+    return static_cast<size_t>(data.size()) >= block_frame_magic.size() &&
+           std::memcmp(data.data(), block_frame_magic.data(), block_frame_magic.size()) == 0;
+}
+
+vector<byte> compress_parallel(span<const byte>                data,
+                               int                             compression_level,
+                               size_t                          block_size,
+                               const function<void(u64, u64)>& progress,
+                               fiber_pool*                     pool) {
+    if (!pool)
+        pool = &global_fiber_pool();
+
+    block_size = std::max<size_t>(block_size, 1);
+
+    auto raw_size     = static_cast<size_t>(data.size());
+    auto blocks_count = (raw_size + block_size - 1) / block_size;
+
+    vector<job_future<vector<byte>>> jobs;
+    jobs.reserve(blocks_count);
+
+    for (size_t i = 0; i < blocks_count; ++i) {
+        auto block = data.subspan(static_cast<ptrdiff_t>(i * block_size),
+                                  static_cast<ptrdiff_t>(std::min(block_size, raw_size - i * block_size)));
+        jobs.push_back(pool->submit([block, compression_level] { return ::compress_block(block, compression_level); }));
+    }
+
+    vector<vector<byte>> blocks;
+    blocks.reserve(blocks_count);
+
+    size_t compressed_size = 0;
+
+    wait_all_rethrow(jobs, [&](size_t i, vector<byte>&& block) {
+        compressed_size += block.size();
+        blocks.push_back(move(block));
+
+        if (progress)
+            progress(std::min<u64>((i + 1) * block_size, raw_size), raw_size);
+    });
+
+    vector<byte> result;
+    result.reserve(4 + 4 + 8 * 3 + blocks_count * 8 + compressed_size); // NOLINT
+    serialize_all(result,
+                  block_frame_magic,
+                  block_frame_version,
+                  static_cast<u64>(raw_size),
+                  static_cast<u64>(block_size),
+                  static_cast<u64>(blocks_count));
+
+    for (auto& block : blocks)
+        serialize(static_cast<u64>(block.size()), result);
+
+    for (auto& block : blocks)
+        result.insert(result.end(), block.begin(), block.end());
+
+    return result;
+}
+
+vector<byte> decompress_parallel(span<const byte> data, const function<void(u64, u64)>& progress, fiber_pool* pool) {
+    if (!pool)
+        pool = &global_fiber_pool();
+
+    auto frame = read_block_frame(data);
+
+    vector<byte> result(static_cast<size_t>(frame.raw_size));
+
+    vector<job_future<size_t>> jobs;
+    jobs.reserve(frame.compressed_sizes.size());
+
+    size_t offset = 0;
+    for (size_t i = 0; i < frame.compressed_sizes.size(); ++i) {
+        auto block = frame.payload.subspan(static_cast<ptrdiff_t>(offset),
+                                           static_cast<ptrdiff_t>(frame.compressed_sizes[i]));
+        auto out      = result.data() + i * frame.block_size;
+        auto out_size = frame.block_raw_size(i);
+
+        jobs.push_back(pool->submit([block, out, out_size] { return ::decompress_into(block, out, out_size); }));
+        offset += static_cast<size_t>(frame.compressed_sizes[i]);
+    }
+
+    bool valid = true;
+
+    wait_all_rethrow(jobs, [&](size_t i, size_t size) {
+        valid = size == frame.block_raw_size(i) && valid;
+
+        if (progress)
+            progress(i * frame.block_size + frame.block_raw_size(i), frame.raw_size);
+    });
+
+    if (!valid)
+        pe_throw std::runtime_error("block compression: decompressed block size differs with block index");
+
+    return result;
 }
 
 } // namespace util
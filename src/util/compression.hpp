@@ -1,6 +1,13 @@
 #pragma once
 
 #include "core/types.hpp"
+#include "core/serialization_sink.hpp"
+
+struct z_stream_s;
+
+namespace core {
+    class fiber_pool;
+}
 
 namespace details {
     template <typename T>
@@ -27,8 +34,10 @@ constexpr int COMPRESS_DEFAULT = -1;
 constexpr int COMPRESS_FAST = 1;
 constexpr int COMPRESS_BEST = 9;
 
+constexpr size_t COMPRESS_BLOCK_SIZE = 1 << 20;
+
 inline int compress_level_clamp(int level) {
-    return std::min(std::max(COMPRESS_DEFAULT, level), COMPRESS_FAST);
+    return std::clamp(level, COMPRESS_DEFAULT, COMPRESS_BEST);
 }
 
 /**
@@ -47,6 +56,10 @@ core::vector<core::byte> compress(core::span<const core::byte> data,
 /**
  * @brief Decompress byte input
  *
+ * Input produced by compress_parallel is decompressed with decompress_parallel,
+ * frames of compress_frame (see codec.hpp) are decompressed with the codec of the frame.
+ * Empty input is decompressed to empty output
+ *
  * @param data - byte input
  * @param progress - progress callback as void(u64 decompressed_count, u64 max_count)
  *
@@ -56,6 +69,59 @@ core::vector<core::byte>
 decompress(core::span<const core::byte>                      data,
            const core::function<void(core::u64, core::u64)>& progress = {});
 
+/**
+ * @brief Decompress gzip stream into the buffer
+ *
+ * @param data - byte input
+ * @param output - the output buffer
+ *
+ * @return the count of decompressed bytes (less than the buffer size if the stream is shorter)
+ */
+size_t decompress_into(core::span<const core::byte> data, core::span<core::byte> output);
+
+/**
+ * @brief Compress byte input with independent blocks in parallel
+ *
+ * Every block is a separate gzip stream compressed on the fiber pool.
+ * Layout: "PEZB" | u32 version | u64 raw size | u64 block size | u64 blocks count |
+ *         u64 compressed size of each block | blocks
+ *
+ * @param data - byte input
+ * @param compression_level - -1 - default, 0 - no compression, 1 - best speed, 9 - best compression
+ * @param block_size - size of uncompressed block
+ * @param progress - progress callback as void(u64 compressed_count, u64 max_count)
+ * @param pool - the fiber pool which runs compression jobs, nullptr - the global fiber pool
+ *
+ * @return compressed bytes
+ */
+core::vector<core::byte>
+compress_parallel(core::span<const core::byte>                      data,
+                  int                                               compression_level = COMPRESS_DEFAULT,
+                  size_t                                            block_size        = COMPRESS_BLOCK_SIZE,
+                  const core::function<void(core::u64, core::u64)>& progress          = {},
+                  core::fiber_pool*                                 pool              = nullptr);
+
+/**
+ * @brief Decompress blocks of compress_parallel output in parallel
+ *
+ * @throw runtime_error if the block index is invalid
+ *
+ * @param data - byte input
+ * @param progress - progress callback as void(u64 decompressed_count, u64 max_count)
+ * @param pool - the fiber pool which runs decompression jobs, nullptr - the global fiber pool
+ *
+ * @return decompressed bytes
+ */
+core::vector<core::byte>
+decompress_parallel(core::span<const core::byte>                      data,
+                    const core::function<void(core::u64, core::u64)>& progress = {},
+                    core::fiber_pool*                                 pool     = nullptr);
+
+/**
+ * @brief Checks that the input is produced by compress_parallel
+ */
+bool is_block_compressed(core::span<const core::byte> data);
+
 /**
  * @brief Compress byte input in one iteration
  *
@@ -74,9 +140,11 @@ core::vector<core::byte> compress_block(T&& byte_data, int compression_level = C
 /**
  * @brief Decompress byte input in one iteration
  *
+ * @throw runtime_error if the stream is corrupted, truncated or doesn't fit into output_size bytes
+ *
  * @tparam T - core::byte or const core::byte
  * @param byte_data - byte input
- * @param output_size - size of decompressed output
+ * @param output_size - size of decompressed output (the maximum size, the result has the actual size)
  *
  * @return decompressed bytes
  */
@@ -85,4 +153,197 @@ core::vector<core::byte> decompress_block(T&& byte_data, size_t output_size) {
     return details::decompress_block(
         core::span<std::remove_reference_t<decltype(byte_data[0])>>(byte_data), output_size);
 }
+
+/**
+ * @brief Incremental gzip compressor
+ *
+ * Input passed to push() is not copied, it must stay alive until needs_input() returns true.
+ * The output is pulled into caller buffers, so memory usage doesn't depend on the data size
+ */
+class compressor {
+public:
+    /**
+     * @param compression_level - -1 - default, 0 - no compression, 1 - best speed, 9 - best compression
+     */
+    compressor(int compression_level = COMPRESS_DEFAULT);
+    ~compressor();
+
+    compressor(compressor&&) noexcept;
+    compressor& operator=(compressor&&) noexcept;
+
+    compressor(const compressor&) = delete;
+    compressor& operator=(const compressor&) = delete;
+
+    /**
+     * @brief Sets the next input
+     *
+     * @param input - the input, must be alive until needs_input() returns true
+     * @param last - the input is the last one, the stream will be finished
+     */
+    void push(core::span<const core::byte> input, bool last = false);
+
+    /**
+     * @brief Compresses the pushed input into the buffer
+     *
+     * @param output - the output buffer
+     *
+     * @return the count of written bytes
+     */
+    size_t pull(core::span<core::byte> output);
+
+    /**
+     * @brief Checks that all pushed input was consumed and the stream is not finished
+     */
+    [[nodiscard]]
+    bool needs_input() const;
+
+    /**
+     * @brief Checks that the last input was pushed and all output was pulled
+     */
+    [[nodiscard]]
+    bool done() const;
+
+    [[nodiscard]]
+    core::u64 total_in() const;
+
+    [[nodiscard]]
+    core::u64 total_out() const;
+
+private:
+    core::unique_ptr<z_stream_s> _stream;
+    core::span<const core::byte> _input;
+    bool                         _last = false;
+    bool                         _done = false;
+};
+
+/**
+ * @brief Incremental gzip decompressor
+ *
+ * Input passed to push() is not copied, it must stay alive until needs_input() returns true
+ */
+class decompressor {
+public:
+    decompressor();
+    ~decompressor();
+
+    decompressor(decompressor&&) noexcept;
+    decompressor& operator=(decompressor&&) noexcept;
+
+    decompressor(const decompressor&) = delete;
+    decompressor& operator=(const decompressor&) = delete;
+
+    /**
+     * @brief Sets the next input
+     *
+     * @param input - the input, must be alive until needs_input() returns true
+     */
+    void push(core::span<const core::byte> input);
+
+    /**
+     * @brief Decompresses the pushed input into the buffer
+     *
+     * @throw runtime_error if the stream is corrupted
+     *
+     * @param output - the output buffer
+     *
+     * @return the count of written bytes
+     */
+    size_t pull(core::span<core::byte> output);
+
+    /**
+     * @brief Checks that all pushed input was consumed and the stream is not finished
+     */
+    [[nodiscard]]
+    bool needs_input() const;
+
+    /**
+     * @brief Checks that the end of the stream was reached
+     */
+    [[nodiscard]]
+    bool done() const;
+
+    [[nodiscard]]
+    core::u64 total_in() const;
+
+    [[nodiscard]]
+    core::u64 total_out() const;
+
+private:
+    core::unique_ptr<z_stream_s> _stream;
+    core::span<const core::byte> _input;
+    bool                         _done = false;
+};
+
+/**
+ * @brief Compresses everything from the file descriptor into the other one
+ *
+ * @throw runtime_error if reading or writing fails
+ *
+ * @param in_fd - the input file descriptor
+ * @param out_fd - the output file descriptor
+ * @param compression_level - -1 - default, 0 - no compression, 1 - best speed, 9 - best compression
+ * @param buffer_size - size of input and output buffers
+ *
+ * @return the count of written bytes
+ */
+core::u64 compress_fd(int in_fd, int out_fd, int compression_level = COMPRESS_DEFAULT, size_t buffer_size = 1 << 16);
+
+/**
+ * @brief Decompresses the gzip stream from the file descriptor into the other one
+ *
+ * @throw runtime_error if reading or writing fails or the stream is corrupted
+ *
+ * @param in_fd - the input file descriptor
+ * @param out_fd - the output file descriptor
+ * @param buffer_size - size of input and output buffers
+ *
+ * @return the count of written bytes
+ */
+core::u64 decompress_fd(int in_fd, int out_fd, size_t buffer_size = 1 << 16);
+
+/**
+ * @brief Decompresses the gzip stream with known size from the file descriptor into the buffer
+ *
+ * @throw runtime_error if reading fails, the stream is corrupted or its size differs with the buffer size
+ *
+ * @param in_fd - the input file descriptor
+ * @param output - the output buffer
+ * @param buffer_size - size of the input buffer
+ */
+void decompress_fd(int in_fd, core::span<core::byte> output, size_t buffer_size = 1 << 16);
+
+/**
+ * @brief Compresses the serialized data and passes it to the other sink
+ *
+ * Use with core::streaming_serializer to write compressed assets without keeping
+ * the uncompressed form in memory
+ */
+class compressing_sink : public core::serialization_sink {
+public:
+    /**
+     * @param output - the sink for compressed data
+     * @param compression_level - -1 - default, 0 - no compression, 1 - best speed, 9 - best compression
+     * @param buffer_size - size of the output buffer
+     */
+    compressing_sink(core::serialization_sink& output,
+                     int                       compression_level = COMPRESS_DEFAULT,
+                     size_t                    buffer_size       = 1 << 16);
+
+    void write(core::span<const core::byte> chunk) override;
+    void finish() override;
+
+    /**
+     * @brief Gets the count of compressed bytes passed to the output sink
+     */
+    [[nodiscard]]
+    core::u64 written() const;
+
+private:
+    void drain();
+
+private:
+    core::serialization_sink& _output;
+    compressor                _compressor;
+    core::vector<core::byte>  _buffer;
+};
 } // namespace util
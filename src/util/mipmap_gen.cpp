@@ -0,0 +1,360 @@
+#include "mipmap_gen.hpp"
+
+#include <core/fiber_pool.hpp>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define PE_MIPMAP_GEN_X86
+#endif
+
+using namespace core;
+using namespace util;
+
+namespace
+{
+/* Values per job, small levels are filtered in the calling thread */
+constexpr size_t min_values_per_job = 65536;
+
+constexpr float kaiser_alpha  = 4.f;
+constexpr float filter_radius = 3.f;
+constexpr float pi            = 3.14159265358979f;
+
+float sinc(float x) {
+    if (std::fabs(x) < 1e-5f) // NOLINT
+        return 1.f;
+    return std::sin(pi * x) / (pi * x);
+}
+
+/* Zero order modified Bessel function of the first kind */
+float bessel_i0(float x) {
+    float sum  = 1.f;
+    float term = 1.f;
+    for (int k = 1; k < 20; ++k) { // NOLINT
+        term *= (x / (2.f * float(k))) * (x / (2.f * float(k)));
+        sum += term;
+    }
+    return sum;
+}
+
+float radius(mip_filter filter) {
+    return filter == mip_filter::box ? 0.5f : filter_radius; // NOLINT
+}
+
+float filter_value(mip_filter filter, float x) {
+    auto ax = std::fabs(x);
+    switch (filter) {
+    case mip_filter::box:
+        return ax <= 0.5f ? 1.f : 0.f; // NOLINT
+    case mip_filter::kaiser: {
+        if (ax >= filter_radius)
+            return 0.f;
+        auto t = x / filter_radius;
+        return sinc(x) * bessel_i0(kaiser_alpha * std::sqrt(1.f - t * t)) / bessel_i0(kaiser_alpha);
+    }
+    case mip_filter::lanczos:
+        return ax < filter_radius ? sinc(x) * sinc(x / filter_radius) : 0.f;
+    }
+    return 0.f;
+}
+
+/* Source pixels and weights of every destination pixel along one axis */
+struct filter_table {
+    struct contribution {
+        u32 first;
+        u32 count;
+        u32 weights;
+    };
+
+    vector<contribution> contributions;
+    vector<float>        weights;
+    u32                  max_count = 0;
+};
+
+filter_table make_filter_table(mip_filter filter, u32 src, u32 dst) {
+    auto scale   = float(src) / float(dst);
+    auto stretch = std::max(scale, 1.f);
+    auto support = radius(filter) * stretch;
+
+    filter_table table;
+    table.contributions.reserve(dst);
+
+    vector<float> window;
+    for (u32 d = 0; d < dst; ++d) {
+        auto center = (float(d) + 0.5f) * scale; // NOLINT
+        auto lo     = int(std::floor(center - support));
+        auto hi     = int(std::ceil(center + support));
+
+        /* Weights outside of the image go to edge pixels */
+        auto first = u32(std::clamp(lo, 0, int(src) - 1));
+        auto last  = u32(std::clamp(hi, 0, int(src) - 1));
+        window.assign(last - first + 1, 0.f);
+
+        float sum = 0.f;
+        for (auto i = lo; i <= hi; ++i) {
+            auto w = filter_value(filter, (float(i) + 0.5f - center) / stretch); // NOLINT
+            window[u32(std::clamp(i, int(first), int(last))) - first] += w;
+            sum += w;
+        }
+
+        /* Destination pixel which covers no source pixel centers takes the nearest one */
+        if (std::fabs(sum) < 1e-6f) { // NOLINT
+            std::fill(window.begin(), window.end(), 0.f);
+            window[std::min(u32(center), src - 1) - first] = 1.f;
+            sum = 1.f;
+        }
+
+        /* Zero weights at the window edges are dropped */
+        u32 begin = 0, end = u32(window.size());
+        while (begin + 1 < end && std::fabs(window[begin]) < 1e-6f) // NOLINT
+            ++begin;
+        while (end - 1 > begin && std::fabs(window[end - 1]) < 1e-6f) // NOLINT
+            --end;
+
+        table.contributions.push_back({first + begin, end - begin, u32(table.weights.size())});
+        for (auto i = begin; i < end; ++i)
+            table.weights.push_back(window[i] / sum);
+        table.max_count = std::max(table.max_count, end - begin);
+    }
+
+    return table;
+}
+
+/* sRGB transfer functions, the encoder rounds to the nearest 8-bit value by binary search of midpoints */
+float srgb_to_linear(float v) {
+    return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f); // NOLINT
+}
+
+struct srgb_tables {
+    srgb_tables() {
+        for (u32 i = 0; i < 256; ++i) // NOLINT
+            to_linear[i] = srgb_to_linear(float(i) / 255.f); // NOLINT
+        for (u32 i = 0; i < 255; ++i) // NOLINT
+            midpoints[i] = srgb_to_linear((float(i) + 0.5f) / 255.f); // NOLINT
+    }
+
+    array<float, 256> to_linear; // NOLINT
+    array<float, 255> midpoints; // NOLINT
+};
+
+const srgb_tables& srgb() {
+    static const srgb_tables tables;
+    return tables;
+}
+
+u8 linear_to_srgb8(float v) {
+    auto& midpoints = srgb().midpoints;
+    return u8(std::upper_bound(midpoints.begin(), midpoints.end(), v) - midpoints.begin());
+}
+
+u8 to_u8(float v) {
+    return u8(std::lround(std::clamp(v, 0.f, 255.f)));
+}
+
+/* Converts values to floats, alpha channels stay as is */
+template <typename T>
+void load_values(const T* src, float* dst, size_t count, size_t channels, bool srgb_colors) {
+    if constexpr (std::is_same_v<T, u8>) {
+        if (srgb_colors) {
+            auto& to_linear = srgb().to_linear;
+            auto  has_alpha = channels == 2 || channels == 4;
+            for (size_t i = 0; i < count; ++i) {
+                auto is_alpha = has_alpha && i % channels == channels - 1;
+                dst[i]        = is_alpha ? float(src[i]) / 255.f : to_linear[src[i]]; // NOLINT
+            }
+            return;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i)
+        dst[i] = float(src[i]);
+}
+
+template <typename T>
+void store_values(const float* src, T* dst, size_t count, size_t channels, bool srgb_colors) {
+    if constexpr (std::is_same_v<T, u8>) {
+        if (srgb_colors) {
+            auto has_alpha = channels == 2 || channels == 4;
+            for (size_t i = 0; i < count; ++i) {
+                auto is_alpha = has_alpha && i % channels == channels - 1;
+                dst[i]        = is_alpha ? to_u8(src[i] * 255.f) : linear_to_srgb8(src[i]); // NOLINT
+            }
+        }
+        else {
+            for (size_t i = 0; i < count; ++i)
+                dst[i] = to_u8(src[i]);
+        }
+    }
+    else {
+        std::copy(src, src + count, dst);
+    }
+}
+
+/* Filters the row along x: dst has table.contributions.size() pixels */
+void filter_row(const float* src, float* dst, const filter_table& table, size_t channels) {
+#ifdef PE_MIPMAP_GEN_X86
+    if (channels == 4) {
+        for (auto& c : table.contributions) {
+            auto w   = table.weights.data() + c.weights;
+            auto p   = src + size_t(c.first) * 4;
+            auto acc = _mm_setzero_ps();
+            for (u32 k = 0; k < c.count; ++k)
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(p + k * 4)));
+            _mm_storeu_ps(dst, acc);
+            dst += 4;
+        }
+        return;
+    }
+#endif
+
+    for (auto& c : table.contributions) {
+        auto            w   = table.weights.data() + c.weights;
+        auto            p   = src + size_t(c.first) * channels;
+        array<float, 4> acc = {};
+        for (u32 k = 0; k < c.count; ++k)
+            for (size_t ch = 0; ch < channels; ++ch)
+                acc[ch] += w[k] * p[k * channels + ch];
+        std::copy(acc.begin(), acc.begin() + ssize_t(channels), dst);
+        dst += channels;
+    }
+}
+
+/* dst = sum of weights[k] * rows[first + k], rows are contiguous with the pitch */
+void filter_column(const float* rows, size_t pitch, const float* weights, u32 count, float* dst, size_t width) {
+    size_t i = 0;
+#ifdef PE_MIPMAP_GEN_X86
+    for (; i + 8 <= width; i += 8) { // NOLINT
+        auto acc0 = _mm_setzero_ps();
+        auto acc1 = _mm_setzero_ps();
+        for (u32 k = 0; k < count; ++k) {
+            auto w   = _mm_set1_ps(weights[k]);
+            auto row = rows + k * pitch + i;
+            acc0     = _mm_add_ps(acc0, _mm_mul_ps(w, _mm_loadu_ps(row)));
+            acc1     = _mm_add_ps(acc1, _mm_mul_ps(w, _mm_loadu_ps(row + 4)));
+        }
+        _mm_storeu_ps(dst + i, acc0);
+        _mm_storeu_ps(dst + i + 4, acc1);
+    }
+#endif
+
+    for (; i < width; ++i) {
+        float acc = 0.f;
+        for (u32 k = 0; k < count; ++k)
+            acc += weights[k] * rows[k * pitch + i];
+        dst[i] = acc;
+    }
+}
+
+template <typename T>
+void generate(const T*            base,
+              vec2u               size,
+              size_t              channels,
+              span<const vec2u>   level_sizes,
+              T*                  output,
+              const mip_settings& settings,
+              fiber_pool*         pool) {
+    if (channels == 0 || channels > 4)
+        pe_throw std::runtime_error("generate_mipmaps: channels count must be in [1, 4]");
+
+    for (auto& level_size : level_sizes)
+        if (level_size.x() == 0 || level_size.y() == 0)
+            pe_throw std::runtime_error("generate_mipmaps: level size must be non-zero");
+
+    if (size.x() == 0 || size.y() == 0 || level_sizes.empty())
+        return;
+
+    auto srgb_colors = std::is_same_v<T, u8> && settings.srgb;
+    auto rows_job    = [&](size_t width) { return std::max<size_t>(min_values_per_job / (width * channels), 1); };
+
+    /* The previous level in float precision */
+    vector<float> current(size_t(size.x()) * size.y() * channels);
+    parallel_for(
+        size.y(),
+        rows_job(size.x()),
+        [&](size_t begin, size_t end) {
+            auto offset = begin * size.x() * channels;
+            load_values(base + offset, current.data() + offset, (end - begin) * size.x() * channels, channels, srgb_colors);
+        },
+        pool);
+
+    vector<float> horizontal, next;
+    auto          src_size = size;
+
+    for (auto& dst_size : level_sizes) {
+        auto table_x   = make_filter_table(settings.filter, src_size.x(), dst_size.x());
+        auto table_y   = make_filter_table(settings.filter, src_size.y(), dst_size.y());
+        auto src_pitch = size_t(src_size.x()) * channels;
+        auto dst_pitch = size_t(dst_size.x()) * channels;
+
+        /* Horizontal pass over all source rows */
+        horizontal.resize(src_size.y() * dst_pitch);
+        parallel_for(
+            src_size.y(),
+            rows_job(dst_size.x() * table_x.max_count),
+            [&](size_t begin, size_t end) {
+                for (auto y = begin; y < end; ++y)
+                    filter_row(current.data() + y * src_pitch, horizontal.data() + y * dst_pitch, table_x, channels);
+            },
+            pool);
+
+        /* Vertical pass, destination rows are converted to the output type as soon as they are filtered */
+        next.resize(dst_size.y() * dst_pitch);
+        parallel_for(
+            dst_size.y(),
+            rows_job(dst_size.x() * table_y.max_count),
+            [&](size_t begin, size_t end) {
+                for (auto y = begin; y < end; ++y) {
+                    auto& c = table_y.contributions[y];
+                    filter_column(horizontal.data() + c.first * dst_pitch,
+                                  dst_pitch,
+                                  table_y.weights.data() + c.weights,
+                                  c.count,
+                                  next.data() + y * dst_pitch,
+                                  dst_pitch);
+                }
+                store_values(next.data() + begin * dst_pitch,
+                             output + begin * dst_pitch,
+                             (end - begin) * dst_pitch,
+                             channels,
+                             srgb_colors);
+            },
+            pool);
+
+        output += dst_size.y() * dst_pitch;
+        std::swap(current, next);
+        src_size = dst_size;
+    }
+}
+} // namespace
+
+namespace util
+{
+vector<vec2u> mip_chain_sizes(vec2u size) {
+    vector<vec2u> result;
+    while (size.x() > 1 || size.y() > 1) {
+        size = {std::max(size.x() / 2, 1U), std::max(size.y() / 2, 1U)};
+        result.push_back(size);
+    }
+    return result;
+}
+
+void generate_mipmaps(const u8*           base,
+                      vec2u               size,
+                      size_t              channels,
+                      span<const vec2u>   level_sizes,
+                      u8*                 output,
+                      const mip_settings& settings,
+                      fiber_pool*         pool) {
+    generate(base, size, channels, level_sizes, output, settings, pool);
+}
+
+void generate_mipmaps(const float*        base,
+                      vec2u               size,
+                      size_t              channels,
+                      span<const vec2u>   level_sizes,
+                      float*              output,
+                      const mip_settings& settings,
+                      fiber_pool*         pool) {
+    generate(base, size, channels, level_sizes, output, settings, pool);
+}
+} // namespace util
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <core/vec.hpp>
+
+namespace core {
+    class fiber_pool;
+}
+
+namespace util
+{
+/**
+ * @brief Resampling filters of the mipmap generator
+ */
+enum class mip_filter : core::u8 {
+    box = 0, /* Averages source pixels covered by the destination pixel, the fastest one */
+    kaiser,  /* Kaiser windowed sinc with radius 3, sharp with little ringing */
+    lanczos, /* Lanczos3, the sharpest one */
+};
+
+struct mip_settings {
+    mip_filter filter = mip_filter::box;
+
+    /* Color channels are converted to linear space before filtering, the last channel of 2 and 4 channel
+     * images is alpha and it is always filtered as is. Ignored for float images */
+    bool srgb = false;
+};
+
+/**
+ * @brief Gets sizes of the full mipmap chain down to 1x1, every level is half of the previous one
+ *
+ * @param size - the size of the largest level
+ *
+ * @return sizes of levels after the largest one
+ */
+core::vector<core::vec2u> mip_chain_sizes(core::vec2u size);
+
+/**
+ * @brief Generates mipmaps of the image
+ *
+ * Every level is filtered from the previous one in float precision, so sizes need not be power of two.
+ * Rows of every level are filtered with separable SSE kernels in parallel jobs of the fiber pool
+ *
+ * @throw runtime_error if channels count is not in [1, 4] or some level size is zero
+ *
+ * @param base - the largest level, size.x() * size.y() * channels values
+ * @param size - the size of the largest level
+ * @param channels - the count of channels
+ * @param level_sizes - sizes of generated levels, from the largest to the smallest one
+ * @param output - generated levels one after another
+ * @param settings - the filter settings
+ * @param pool - the fiber pool which runs filtering jobs, nullptr - the global fiber pool
+ */
+void generate_mipmaps(const core::u8*               base,
+                      core::vec2u                   size,
+                      size_t                        channels,
+                      core::span<const core::vec2u> level_sizes,
+                      core::u8*                     output,
+                      const mip_settings&           settings = {},
+                      core::fiber_pool*             pool     = nullptr);
+
+void generate_mipmaps(const float*                  base,
+                      core::vec2u                   size,
+                      size_t                        channels,
+                      core::span<const core::vec2u> level_sizes,
+                      float*                        output,
+                      const mip_settings&           settings = {},
+                      core::fiber_pool*             pool     = nullptr);
+} // namespace util
@@ -0,0 +1,642 @@
+#include "patch_match.hpp"
+
+#include <core/fiber_pool.hpp>
+#include <core/print.hpp>
+#include <core/string_hash.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define PE_PATCH_MATCH_X86
+#endif
+
+using namespace core;
+using namespace util;
+
+namespace
+{
+/* Byte comparisons per job, small images are matched in the calling thread */
+constexpr u64 min_work_per_job = 1ULL << 22;
+
+/* Block rows of the approximate search matched sequentially */
+constexpr u32 approx_band_rows = 8;
+
+using block_sad_fn = u32 (*)(const u8*, size_t, const u8*, size_t, vec2u, size_t, u32);
+
+/* Alpha bytes of 4-channel pixels are skipped, offset is the position of the first byte in the row */
+u32 sad_scalar(const u8* a, const u8* b, size_t count, size_t offset, bool skip_alpha) {
+    u32 sum = 0;
+    for (size_t i = 0; i < count; ++i)
+        if (!skip_alpha || ((offset + i) & 3U) != 3)
+            sum += static_cast<u32>(std::abs(int(a[i]) - int(b[i])));
+    return sum;
+}
+
+#ifdef PE_PATCH_MATCH_X86
+inline __m128i load128(const u8* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); // NOLINT
+}
+
+/* psadbw leaves two 16-bit sums in 64-bit lanes */
+inline u32 reduce_sad(__m128i acc) {
+    return static_cast<u32>(_mm_cvtsi128_si32(_mm_add_epi64(acc, _mm_unpackhi_epi64(acc, acc))));
+}
+
+/* Rows of 16-byte chunks, rows start on the pixel boundary, so the alpha mask of 4-channel pixels is the same for
+ * every chunk */
+u32 block_sad_sse2(const u8* a, size_t a_pitch, const u8* b, size_t b_pitch, vec2u size, size_t channels, u32 limit) {
+    auto row_bytes  = size_t(size.x()) * channels;
+    auto skip_alpha = channels == 4;
+    auto mask       = _mm_set1_epi32(skip_alpha ? 0x00ffffff : -1); // NOLINT
+    auto simd_bytes = row_bytes & ~size_t(15);                      // NOLINT
+
+    u32 sum = 0;
+    for (u32 y = 0; y < size.y() && sum < limit; ++y) {
+        auto ra  = a + y * a_pitch;
+        auto rb  = b + y * b_pitch;
+        auto acc = _mm_setzero_si128();
+        for (size_t i = 0; i < simd_bytes; i += 16) // NOLINT
+            acc = _mm_add_epi64(
+                acc, _mm_sad_epu8(_mm_and_si128(load128(ra + i), mask), _mm_and_si128(load128(rb + i), mask)));
+
+        sum += reduce_sad(acc) +
+               sad_scalar(ra + simd_bytes, rb + simd_bytes, row_bytes - simd_bytes, simd_bytes, skip_alpha);
+    }
+    return sum;
+}
+
+__attribute__((target("avx2"))) inline __m256i load256(const u8* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); // NOLINT
+}
+
+__attribute__((target("avx2")))
+u32 block_sad_avx2(const u8* a, size_t a_pitch, const u8* b, size_t b_pitch, vec2u size, size_t channels, u32 limit) {
+    auto row_bytes  = size_t(size.x()) * channels;
+    auto skip_alpha = channels == 4;
+    auto mask       = _mm256_set1_epi32(skip_alpha ? 0x00ffffff : -1); // NOLINT
+    auto wide_bytes = row_bytes & ~size_t(31);                         // NOLINT
+    auto simd_bytes = row_bytes & ~size_t(15);                         // NOLINT
+
+    u32 sum = 0;
+    for (u32 y = 0; y < size.y() && sum < limit; ++y) {
+        auto ra  = a + y * a_pitch;
+        auto rb  = b + y * b_pitch;
+        auto acc = _mm256_setzero_si256();
+        for (size_t i = 0; i < wide_bytes; i += 32) // NOLINT
+            acc = _mm256_add_epi64(
+                acc, _mm256_sad_epu8(_mm256_and_si256(load256(ra + i), mask), _mm256_and_si256(load256(rb + i), mask)));
+
+        auto acc128 = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        if (simd_bytes != wide_bytes) {
+            auto mask128 = _mm256_castsi256_si128(mask);
+            acc128       = _mm_add_epi64(acc128,
+                                   _mm_sad_epu8(_mm_and_si128(load128(ra + wide_bytes), mask128),
+                                                _mm_and_si128(load128(rb + wide_bytes), mask128)));
+        }
+
+        sum += reduce_sad(acc128) +
+               sad_scalar(ra + simd_bytes, rb + simd_bytes, row_bytes - simd_bytes, simd_bytes, skip_alpha);
+    }
+    return sum;
+}
+#else
+u32 block_sad_scalar(const u8* a, size_t a_pitch, const u8* b, size_t b_pitch, vec2u size, size_t channels, u32 limit) {
+    auto row_bytes  = size_t(size.x()) * channels;
+    auto skip_alpha = channels == 4;
+
+    u32 sum = 0;
+    for (u32 y = 0; y < size.y() && sum < limit; ++y)
+        sum += sad_scalar(a + y * a_pitch, b + y * b_pitch, row_bytes, 0, skip_alpha);
+    return sum;
+}
+#endif
+
+block_sad_fn select_block_sad() {
+#ifdef PE_PATCH_MATCH_X86
+    if (__builtin_cpu_supports("avx2"))
+        return block_sad_avx2;
+    return block_sad_sse2;
+#else
+    return block_sad_scalar;
+#endif
+}
+
+block_sad_fn block_sad_impl() {
+    static const auto function = select_block_sad();
+    return function;
+}
+
+void check_images(vec2u smp_size, size_t channels, u32 block_size) {
+    if (channels == 0 || channels > 4)
+        pe_throw std::runtime_error(format("patch_match: unsupported channels count {}", channels));
+    if (block_size == 0)
+        pe_throw std::runtime_error("patch_match: block size must be greater than zero");
+    if (smp_size.x() < block_size || smp_size.y() < block_size)
+        pe_throw std::runtime_error(format("patch_match: sample {} has no blocks of size {}", smp_size, block_size));
+}
+
+/* Sums of compared channels and the standard deviation of the gray value (the sum of compared channels) */
+struct block_stats {
+    array<u32, 3> sums      = {};
+    float         deviation = 0.f;
+};
+
+block_stats make_stats(const array<u32, 3>& sums, u64 gray_squares, u32 block_size) {
+    auto pixels = double(block_size) * block_size;
+    auto mean   = double(sums[0] + sums[1] + sums[2]) / pixels;
+    auto var    = std::max(0.0, double(gray_squares) / pixels - mean * mean);
+    return {sums, static_cast<float>(std::sqrt(var))};
+}
+
+/*
+ * Block statistics of one row of candidates, computed from sums of pixel columns of the block height.
+ * Columns slide down by the candidate step between rows, so the memory is O(sample width).
+ *
+ * Channel sums wrap around, differences of wrapped sums are exact while block sums fit into u32.
+ * Squares of gray values may not fit, they are 64-bit
+ */
+class candidate_strip {
+public:
+    candidate_strip(const u8* image, vec2u image_size, size_t channels, u32 block_size):
+        _image(image),
+        _width(image_size.x()),
+        _channels(channels),
+        _bs(block_size),
+        _sums(size_t(_width) * 3, 0),
+        _squares(_width, 0) {}
+
+    /* Moves columns to rows [top, top + block size) */
+    void move_to(u32 top) {
+        if (_valid && top > _top && top - _top < _bs) {
+            for (auto y = _top; y < top; ++y) {
+                add_row(y, false);
+                add_row(y + _bs, true);
+            }
+        }
+        else {
+            std::fill(_sums.begin(), _sums.end(), 0);
+            std::fill(_squares.begin(), _squares.end(), 0);
+            for (auto y = top; y < top + _bs; ++y)
+                add_row(y, true);
+        }
+        _top   = top;
+        _valid = true;
+    }
+
+    /* Stats of blocks at columns 0, step, 2 * step, ... of the current rows */
+    void fill(u32 step, u32 count, block_stats* output) const {
+        array<u32, 3> sums    = {};
+        u64           squares = 0;
+        u32           left    = 0;
+        u32           right   = 0;
+
+        auto add_column = [&](u32 x, bool add) {
+            for (size_t c = 0; c < 3; ++c)
+                sums[c] = add ? sums[c] + _sums[x * 3 + c] : sums[c] - _sums[x * 3 + c];
+            squares = add ? squares + _squares[x] : squares - _squares[x];
+        };
+
+        for (u32 i = 0; i < count; ++i) {
+            auto x = i * step;
+            if (x >= right) {
+                sums    = {};
+                squares = 0;
+                left    = x;
+                right   = x;
+            }
+            for (; left < x; ++left)
+                add_column(left, false);
+            for (; right < x + _bs; ++right)
+                add_column(right, true);
+
+            output[i] = make_stats(sums, squares, _bs);
+        }
+    }
+
+private:
+    void add_row(u32 y, bool add) {
+        auto compared = std::min<size_t>(_channels, 3);
+        auto row      = _image + size_t(y) * _width * _channels;
+
+        for (u32 x = 0; x < _width; ++x) {
+            auto pixel = row + size_t(x) * _channels;
+            u32  gray  = 0;
+            for (size_t c = 0; c < compared; ++c) {
+                auto& sum = _sums[size_t(x) * 3 + c];
+                sum       = add ? sum + pixel[c] : sum - pixel[c];
+                gray += pixel[c];
+            }
+            auto& square = _squares[x];
+            square       = add ? square + u64(gray) * gray : square - u64(gray) * gray;
+        }
+    }
+
+    const u8*   _image;
+    u32         _width;
+    size_t      _channels;
+    u32         _bs;
+    vector<u32> _sums;
+    vector<u64> _squares;
+    u32         _top   = 0;
+    bool        _valid = false;
+};
+
+/* Source blocks and candidates of both searches */
+struct match_context {
+    match_context(const u8*                   isrc,
+                  vec2u                       src_size,
+                  const u8*                   ismp,
+                  vec2u                       smp_size,
+                  size_t                      ichannels,
+                  const patch_match_settings& settings,
+                  bool                        with_stats,
+                  fiber_pool*                 pool):
+        src(isrc),
+        smp(ismp),
+        channels(ichannels),
+        bs(settings.block_size),
+        step(settings.candidate_step ? settings.candidate_step : settings.block_size),
+        src_pitch(size_t(src_size.x()) * channels),
+        smp_pitch(size_t(smp_size.x()) * channels),
+        sad(block_sad_impl()) {
+        check_images(smp_size, channels, bs);
+
+        blocks = src_size / bs;
+        grid   = (smp_size - vec2u{bs, bs}) / step + vec2u{1, 1};
+
+        /* Block sums of gray values (not greater than 765) must fit into u32 */
+        constexpr u64 max_gray = 765;
+        if (!with_stats || u64(bs) * bs * max_gray > numlim<u32>::max())
+            return;
+
+        /* Extra memory is O(candidates): stats of candidates and a strip of column sums per job */
+        candidate_stats.resize(candidates_count());
+        parallel_for(
+            grid.y(),
+            std::max<size_t>(1, min_work_per_job / (u64(smp_size.x()) * std::min(step, bs) * 8)), // NOLINT
+            [&](size_t begin, size_t end) {
+                auto strip = candidate_strip(smp, smp_size, channels, bs);
+                for (auto row = begin; row < end; ++row) {
+                    strip.move_to(u32(row) * step);
+                    strip.fill(step, grid.x(), candidate_stats.data() + row * grid.x());
+                }
+            },
+            pool);
+
+        source_stats.resize(blocks_count());
+        parallel_for(
+            source_stats.size(),
+            rows_per_job(bs),
+            [&](size_t begin, size_t end) {
+                for (auto i = begin; i < end; ++i)
+                    source_stats[i] = direct_stats(source_block(i));
+            },
+            pool);
+    }
+
+    [[nodiscard]]
+    size_t blocks_count() const {
+        return size_t(blocks.x()) * blocks.y();
+    }
+
+    [[nodiscard]]
+    size_t candidates_count() const {
+        return size_t(grid.x()) * grid.y();
+    }
+
+    [[nodiscard]]
+    const u8* source_block(size_t i) const {
+        return src + (i / blocks.x()) * bs * src_pitch + (i % blocks.x()) * bs * channels;
+    }
+
+    [[nodiscard]]
+    vec2u candidate_pos(size_t c) const {
+        return vec2u{u32(c % grid.x()), u32(c / grid.x())} * step;
+    }
+
+    [[nodiscard]]
+    const u8* candidate(size_t c) const {
+        auto pos = candidate_pos(c);
+        return smp + pos.y() * smp_pitch + pos.x() * channels;
+    }
+
+    [[nodiscard]]
+    u32 error(size_t i, size_t c, u32 limit) const {
+        return sad(source_block(i), src_pitch, candidate(c), smp_pitch, {bs, bs}, channels, limit);
+    }
+
+    /* The SAD is not less than the sum of absolute differences of channel sums, 0 - no statistics */
+    [[nodiscard]]
+    u32 lower_bound(size_t i, size_t c) const {
+        if (candidate_stats.empty())
+            return 0;
+
+        auto& a = source_stats[i].sums;
+        auto& b = candidate_stats[c].sums;
+        u32   result = 0;
+        for (size_t ch = 0; ch < 3; ++ch)
+            result += a[ch] > b[ch] ? a[ch] - b[ch] : b[ch] - a[ch];
+        return result;
+    }
+
+    [[nodiscard]]
+    block_stats direct_stats(const u8* block) const {
+        auto          compared = std::min<size_t>(channels, 3);
+        array<u32, 3> sums     = {};
+        u64           squares  = 0;
+
+        for (u32 y = 0; y < bs; ++y) {
+            for (u32 x = 0; x < bs; ++x) {
+                auto pixel = block + y * src_pitch + x * channels;
+                u32  gray  = 0;
+                for (size_t c = 0; c < compared; ++c) {
+                    sums[c] += pixel[c];
+                    gray += pixel[c];
+                }
+                squares += u64(gray) * gray;
+            }
+        }
+        return make_stats(sums, squares, bs);
+    }
+
+    static size_t rows_per_job(u32 block_size) {
+        return std::max<size_t>(1, min_work_per_job / (u64(block_size) * block_size * 64)); // NOLINT
+    }
+
+    const u8*    src;
+    const u8*    smp;
+    size_t       channels;
+    u32          bs;
+    u32          step;
+    size_t       src_pitch;
+    size_t       smp_pitch;
+    block_sad_fn sad;
+    vec2u        blocks = {0, 0};
+    vec2u        grid   = {0, 0};
+
+    vector<block_stats> source_stats;
+    vector<block_stats> candidate_stats;
+};
+
+/* Limit of the candidate SAD: earlier candidates win ties */
+u32 candidate_limit(size_t c, size_t best, u32 best_error) {
+    return c < best && best_error != numlim<u32>::max() ? best_error + 1 : best_error;
+}
+
+void fill_result(const match_context& ctx, const vector<size_t>& matches, patch_match_result& result) {
+    result.matches.resize(matches.size());
+    for (size_t i = 0; i < matches.size(); ++i)
+        result.matches[i] = ctx.candidate_pos(matches[i]);
+}
+} // namespace
+
+namespace util
+{
+u64 patch_match_result::total_error() const {
+    u64 result = 0;
+    for (auto error : errors)
+        result += error;
+    return result;
+}
+
+u32 block_sad(const u8* a, size_t a_pitch, const u8* b, size_t b_pitch, vec2u size, size_t channels, u32 limit) {
+    return block_sad_impl()(a, a_pitch, b, b_pitch, size, channels, limit);
+}
+
+patch_match_result patch_match_exact(const u8*                   src,
+                                     vec2u                       src_size,
+                                     const u8*                   smp,
+                                     vec2u                       smp_size,
+                                     size_t                      channels,
+                                     const patch_match_settings& settings,
+                                     fiber_pool*                 pool) {
+    auto ctx = match_context(src, src_size, smp, smp_size, channels, settings, settings.early_termination, pool);
+
+    patch_match_result result;
+    result.blocks = ctx.blocks;
+
+    auto count      = ctx.blocks_count();
+    auto candidates = ctx.candidates_count();
+
+    vector<size_t> matches(count);
+    result.errors.resize(count);
+
+    auto block_work = u64(candidates) * ctx.bs * ctx.bs * channels;
+    parallel_for(
+        count,
+        static_cast<size_t>(std::max<u64>(1, min_work_per_job / block_work)),
+        [&](size_t begin, size_t end) {
+            size_t prev = 0;
+            for (auto i = begin; i < end; ++i) {
+                /* Neighbouring blocks are similar, the match of the previous one is a tight initial limit */
+                auto best       = prev;
+                auto best_error = ctx.error(i, best, numlim<u32>::max());
+
+                for (size_t c = 0; c < candidates; ++c) {
+                    if (c == prev)
+                        continue;
+
+                    auto limit = numlim<u32>::max();
+                    if (settings.early_termination) {
+                        limit = candidate_limit(c, best, best_error);
+                        if (ctx.lower_bound(i, c) >= limit)
+                            continue;
+                    }
+
+                    auto error = ctx.error(i, c, limit);
+                    if (error < best_error || (error == best_error && c < best)) {
+                        best       = c;
+                        best_error = error;
+                    }
+                }
+
+                prev             = best;
+                matches[i]       = best;
+                result.errors[i] = best_error;
+            }
+        },
+        pool);
+
+    fill_result(ctx, matches, result);
+    return result;
+}
+
+patch_match_result patch_match_approx(const u8*                          src,
+                                      vec2u                              src_size,
+                                      const u8*                          smp,
+                                      vec2u                              smp_size,
+                                      size_t                             channels,
+                                      const patch_match_settings&        settings,
+                                      const patch_match_approx_settings& approx,
+                                      fiber_pool*                        pool) {
+    auto ctx = match_context(src, src_size, smp, smp_size, channels, settings, true, pool);
+
+    patch_match_result result;
+    result.blocks = ctx.blocks;
+
+    auto count      = ctx.blocks_count();
+    auto grid       = ctx.grid;
+    auto quality    = std::clamp(approx.quality, 0.f, 1.f);
+    auto iterations = 1 + static_cast<u32>(std::lround(quality * 7.f)); // NOLINT
+    auto samples    = 1 + static_cast<u32>(std::lround(quality * 3.f)); // NOLINT
+    auto tolerance  = 0.5f + 4.f * quality;                              // NOLINT
+
+    /* Neighbouring source blocks are block_size apart, their matches are shifted by the same distance */
+    auto shift = static_cast<u32>(std::lround(float(ctx.bs) / float(ctx.step)));
+
+    vector<size_t> matches(count);
+    result.errors.resize(count);
+
+    auto rng_for = [&](u32 iteration, size_t i) {
+        return std::minstd_rand(static_cast<u32>(hash_fast64(
+            span<const byte>(reinterpret_cast<const byte*>(&i), sizeof(i)), // NOLINT
+            (u64(approx.seed) << 32U) | iteration)));                       // NOLINT
+    };
+
+    auto try_candidate = [&](size_t i, size_t c, size_t& best, u32& best_error) {
+        if (c == best)
+            return;
+
+        auto limit = candidate_limit(c, best, best_error);
+        if (ctx.lower_bound(i, c) >= limit)
+            return;
+
+        /* Blocks with too different contrast are rarely good matches */
+        if (!ctx.candidate_stats.empty()) {
+            auto src_dev = ctx.source_stats[i].deviation;
+            if (std::abs(src_dev - ctx.candidate_stats[c].deviation) > (src_dev + 8.f) * tolerance) // NOLINT
+                return;
+        }
+
+        auto error = ctx.error(i, c, limit);
+        if (error < best_error || (error == best_error && c < best)) {
+            best       = c;
+            best_error = error;
+        }
+    };
+
+    /* Random initialization */
+    parallel_for(
+        count,
+        ctx.blocks.x(),
+        [&](size_t begin, size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                auto rng         = rng_for(0, i);
+                matches[i]       = rng() % ctx.candidates_count();
+                result.errors[i] = ctx.error(i, matches[i], numlim<u32>::max());
+            }
+        },
+        pool);
+
+    vector<size_t> previous;
+
+    /* Rows [row_begin, row_end) are matched sequentially, dir is the direction to already matched neighbours */
+    auto match_block = [&](size_t bx, size_t by, size_t row_begin, size_t row_end, u32 iteration, int dir) {
+        auto i          = by * ctx.blocks.x() + bx;
+        auto best       = matches[i];
+        auto best_error = result.errors[i];
+
+        /* The neighbour's match shifted back by the distance to the neighbour */
+        auto propagate = [&](size_t neighbour, int dx, int dy) {
+            auto x = i64(neighbour % grid.x()) - i64(dx) * shift;
+            auto y = i64(neighbour / grid.x()) - i64(dy) * shift;
+            if (x >= 0 && y >= 0 && x < i64(grid.x()) && y < i64(grid.y()))
+                try_candidate(i, size_t(y) * grid.x() + size_t(x), best, best_error);
+        };
+
+        auto nx = i64(bx) + dir;
+        if (nx >= 0 && nx < i64(ctx.blocks.x()))
+            propagate(matches[i - bx + size_t(nx)], dir, 0);
+
+        auto ny = i64(by) + dir;
+        if (ny >= 0 && ny < i64(ctx.blocks.y())) {
+            auto n = size_t(ny) * ctx.blocks.x() + bx;
+            propagate(size_t(ny) >= row_begin && size_t(ny) < row_end ? matches[n] : previous[n], 0, dir);
+        }
+
+        /* Random search in the exponentially shrinking window around the best match */
+        auto rng = rng_for(iteration + 1, i);
+        for (auto radius = std::max(grid.x(), grid.y()); radius >= 1; radius /= 2) {
+            for (u32 s = 0; s < samples; ++s) {
+                auto cx = i64(best % grid.x()) + i64(rng() % (2 * radius + 1)) - i64(radius);
+                auto cy = i64(best / grid.x()) + i64(rng() % (2 * radius + 1)) - i64(radius);
+                cx      = std::clamp<i64>(cx, 0, i64(grid.x()) - 1);
+                cy      = std::clamp<i64>(cy, 0, i64(grid.y()) - 1);
+                try_candidate(i, size_t(cy) * grid.x() + size_t(cx), best, best_error);
+            }
+        }
+
+        matches[i]       = best;
+        result.errors[i] = best_error;
+    };
+
+    /*
+     * Propagation and random search. Rows are split into bands of the fixed size matched in parallel, matches of
+     * neighbouring rows from other bands are taken from the previous iteration, so results do not depend on
+     * the pool. Odd iterations go in the reverse order
+     */
+    auto bands = (ctx.blocks.y() + approx_band_rows - 1) / approx_band_rows;
+
+    for (u32 iteration = 0; iteration < iterations; ++iteration) {
+        previous     = matches;
+        auto forward = iteration % 2 == 0;
+
+        parallel_for(
+            bands,
+            1,
+            [&](size_t band_begin, size_t band_end) {
+                for (auto band = band_begin; band < band_end; ++band) {
+                    auto row_begin = size_t(band) * approx_band_rows;
+                    auto row_end   = std::min<size_t>(row_begin + approx_band_rows, ctx.blocks.y());
+
+                    for (size_t r = 0; r < row_end - row_begin; ++r) {
+                        for (size_t k = 0; k < ctx.blocks.x(); ++k) {
+                            if (forward)
+                                match_block(k, row_begin + r, row_begin, row_end, iteration, -1);
+                            else
+                                match_block(ctx.blocks.x() - k - 1, row_end - r - 1, row_begin, row_end, iteration, 1);
+                        }
+                    }
+                }
+            },
+            pool);
+    }
+
+    fill_result(ctx, matches, result);
+    return result;
+}
+
+double patch_match_relative_error(const patch_match_result& result, const patch_match_result& reference) {
+    auto error           = result.total_error();
+    auto reference_error = reference.total_error();
+    if (reference_error == 0)
+        return error == 0 ? 0.0 : numlim<double>::infinity();
+    return double(error) / double(reference_error) - 1.0;
+}
+
+void patch_apply(u8*                       dst,
+                 vec2u                     dst_size,
+                 const u8*                 smp,
+                 vec2u                     smp_size,
+                 size_t                    channels,
+                 u32                       block_size,
+                 const patch_match_result& result) {
+    auto dst_pitch = size_t(dst_size.x()) * channels;
+    auto smp_pitch = size_t(smp_size.x()) * channels;
+    auto row_bytes = size_t(block_size) * channels;
+
+    for (u32 by = 0; by < result.blocks.y(); ++by) {
+        for (u32 bx = 0; bx < result.blocks.x(); ++bx) {
+            auto match = result.matches[size_t(by) * result.blocks.x() + bx];
+            for (u32 y = 0; y < block_size; ++y)
+                std::memcpy(dst + (size_t(by) * block_size + y) * dst_pitch + size_t(bx) * row_bytes,
+                            smp + (size_t(match.y()) + y) * smp_pitch + size_t(match.x()) * channels,
+                            row_bytes);
+        }
+    }
+}
+} // namespace util
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <core/vec.hpp>
+
+namespace core {
+    class fiber_pool;
+}
+
+namespace util
+{
+/**
+ * Block matching of 8-bit images
+ *
+ * Images are tightly packed rows of pixels with 1-4 channels. The error of two blocks is the sum of absolute
+ * differences (SAD) of their channels, alpha channels of 4-channel images are ignored. Images are split into
+ * blocks of block_size x block_size pixels, the right and the bottom remainders are not matched
+ */
+
+struct patch_match_settings {
+    core::u32 block_size = 16; // NOLINT
+
+    /* Distance between candidate blocks of the sample in pixels, 0 - block_size */
+    core::u32 candidate_step = 0;
+
+    /*
+     * Stops the SAD of the candidate as soon as its partial sum is not better than the best one and skips candidates
+     * whose channel sums alone differ by more than the best error
+     */
+    bool early_termination = true;
+};
+
+struct patch_match_approx_settings {
+    /*
+     * 0 - the fastest search, 1 - the closest to the exhaustive one. Derives the number of iterations,
+     * random samples per search radius and the tolerance of the contrast difference of candidates
+     */
+    float quality = 0.5f; // NOLINT
+
+    /* Seed of random candidates, results are the same for the same seed */
+    core::u32 seed = 1;
+};
+
+struct patch_match_result {
+    core::vec2u               blocks = {0, 0}; /* Source blocks count in every dimension */
+    core::vector<core::vec2u> matches;         /* Pixel positions of best sample blocks, source blocks by rows */
+    core::vector<core::u32>   errors;          /* SAD of matches */
+
+    [[nodiscard]]
+    core::u64 total_error() const;
+};
+
+/**
+ * @brief Computes the SAD of two blocks
+ *
+ * Uses the fastest instruction set of the CPU: AVX2, SSE2 (psadbw) or plain C++
+ *
+ * @param a - the first block of the first image
+ * @param a_pitch - the row size of the first image in bytes
+ * @param b - the first block of the second image
+ * @param b_pitch - the row size of the second image in bytes
+ * @param size - the size of blocks in pixels
+ * @param channels - channels count
+ * @param limit - the computation stops after the row where the partial sum reaches the limit
+ *
+ * @return the SAD or the partial sum not less than the limit
+ */
+core::u32 block_sad(const core::u8* a,
+                    size_t          a_pitch,
+                    const core::u8* b,
+                    size_t          b_pitch,
+                    core::vec2u     size,
+                    size_t          channels,
+                    core::u32       limit = core::numlim<core::u32>::max());
+
+/**
+ * @brief Finds the best sample block for every source block with the exhaustive search
+ *
+ * Candidates are sample blocks on the grid of candidate_step. Every source block starts from the match of
+ * the previous block, so the early termination cuts most candidates of coherent images. Ties are resolved to
+ * the first candidate in the row order, so results are the same as of the plain search. Source blocks are matched
+ * in parallel jobs of the fiber pool (nullptr - the global fiber pool)
+ *
+ * @throw runtime_error if channels count or the block size is invalid or the sample has no blocks
+ *
+ * @param src - the source image
+ * @param src_size - the size of the source image
+ * @param smp - the sample image
+ * @param smp_size - the size of the sample image
+ * @param channels - channels count of both images
+ * @param settings - settings
+ * @param pool - the fiber pool
+ *
+ * @return matches
+ */
+patch_match_result patch_match_exact(const core::u8*             src,
+                                     core::vec2u                 src_size,
+                                     const core::u8*             smp,
+                                     core::vec2u                 smp_size,
+                                     size_t                      channels,
+                                     const patch_match_settings& settings = {},
+                                     core::fiber_pool*           pool     = nullptr);
+
+/**
+ * @brief Finds a close sample block for every source block with the PatchMatch search
+ *
+ * Blocks start from random candidates and improve them with matches of neighbouring blocks (propagation) and
+ * random candidates in the shrinking window around the best match (random search). Candidates are pruned with
+ * means and deviations of blocks computed at candidate positions only, by sliding sums of sample columns.
+ * Candidates are the same as of patch_match_exact(), so errors are comparable with patch_match_relative_error().
+ * Results depend only on inputs and the seed
+ *
+ * @throw runtime_error if channels count or the block size is invalid or the sample has no blocks
+ *
+ * @param src - the source image
+ * @param src_size - the size of the source image
+ * @param smp - the sample image
+ * @param smp_size - the size of the sample image
+ * @param channels - channels count of both images
+ * @param settings - settings, early_termination is always on
+ * @param approx - the quality and the seed
+ * @param pool - the fiber pool
+ *
+ * @return matches
+ */
+patch_match_result patch_match_approx(const core::u8*                    src,
+                                      core::vec2u                        src_size,
+                                      const core::u8*                    smp,
+                                      core::vec2u                        smp_size,
+                                      size_t                             channels,
+                                      const patch_match_settings&        settings = {},
+                                      const patch_match_approx_settings& approx   = {},
+                                      core::fiber_pool*                  pool     = nullptr);
+
+/**
+ * @brief Computes the error of the match relative to the reference one
+ *
+ * @param result - the match, usually approximate
+ * @param reference - the match of the same images, usually exact
+ *
+ * @return total_error / reference total_error - 1: 0 - the same error, 0.05 - 5% worse
+ */
+double patch_match_relative_error(const patch_match_result& result, const patch_match_result& reference);
+
+/**
+ * @brief Replaces source blocks with their matches
+ *
+ * @param dst - the source image
+ * @param dst_size - the size of the source image
+ * @param smp - the sample image
+ * @param smp_size - the size of the sample image
+ * @param channels - channels count of both images
+ * @param block_size - the block size of the match
+ * @param result - the match
+ */
+void patch_apply(core::u8*                 dst,
+                 core::vec2u               dst_size,
+                 const core::u8*           smp,
+                 core::vec2u               smp_size,
+                 size_t                    channels,
+                 core::u32                 block_size,
+                 const patch_match_result& result);
+} // namespace util
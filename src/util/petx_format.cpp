@@ -0,0 +1,186 @@
+#include "petx_format.hpp"
+
+#include <cstring>
+
+#include <core/print.hpp>
+#include <core/serialization.hpp>
+#include "codec.hpp"
+
+using namespace core;
+
+namespace {
+constexpr auto petx_magic = array{'P', 'E', 'T', 'V'};
+
+u64 align_up(u64 value, u64 alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+namespace util
+{
+bool petx_view::is_petx(span<const byte> bytes) {
+    if (static_cast<size_t>(bytes.size()) < header_size)
+        return false;
+
+    array<char, 4> magic;   // NOLINT
+    u32            version; // NOLINT
+    deserialize_all(bytes, magic, version);
+
+    return magic == petx_magic && version == format_version;
+}
+
+petx_view::petx_view(span<const byte> bytes): _bytes(bytes) {
+    if constexpr (std::endian::native == std::endian::big)
+        pe_throw std::runtime_error("Implement me for big endian");
+
+    if (!is_petx(bytes))
+        pe_throw std::runtime_error("petx: invalid signature or version");
+
+    auto in = bytes;
+
+    array<char, 4> magic;                       // NOLINT
+    u32            version, pixels, channels;   // NOLINT
+    vec<u32, 2>    size;                        // NOLINT
+    u32            levels_count, reserved;      // NOLINT
+    deserialize_all(in, magic, version, pixels, channels, size, levels_count, reserved);
+
+    if (pixels > u32(petx_pixels::bc7))
+        pe_throw std::runtime_error(format("petx: invalid pixels {}", pixels));
+    if (channels == 0 || channels > 4)
+        pe_throw std::runtime_error(format("petx: invalid channels count {}", channels));
+    if (levels_count == 0)
+        pe_throw std::runtime_error("petx: image has no levels");
+
+    auto file_size = static_cast<u64>(bytes.size());
+    if (header_size + u64(levels_count) * level_entry_size > file_size)
+        pe_throw std::runtime_error("petx: levels table is truncated");
+
+    _pixels   = petx_pixels(pixels);
+    _channels = channels;
+    _size     = static_cast<vec2u>(size);
+
+    _levels.resize(levels_count);
+    for (auto& l : _levels) {
+        vec<u32, 2> level_size; // NOLINT
+        deserialize_all(in, level_size, l.offset, l.stored_size, l.raw_size, l.flags, l.reserved);
+        l.size = static_cast<vec2u>(level_size);
+
+        if (l.offset > file_size || l.stored_size > file_size - l.offset)
+            pe_throw std::runtime_error("petx: level is out of the file");
+        if (l.raw_size != level_raw_size(_pixels, _channels, l.size))
+            pe_throw std::runtime_error(format("petx: level {} has invalid raw size {}", l.size, l.raw_size));
+        if (!(l.flags & level_compressed) && l.stored_size != l.raw_size)
+            pe_throw std::runtime_error(
+                format("petx: uncompressed level {} has invalid size {}", l.size, l.stored_size));
+    }
+
+    if (_levels.front().size != _size)
+        pe_throw std::runtime_error("petx: the largest level does not match the image size");
+}
+
+u64 petx_view::level_raw_size(petx_pixels pixels, u32 channels, const vec2u& size) {
+    if (auto block_format = petx_block_format(pixels))
+        return dxt_data_size(*block_format, size);
+
+    auto component_size = pixels == petx_pixels::f32 ? sizeof(float) : sizeof(u8);
+    return u64(size.x()) * size.y() * channels * component_size;
+}
+
+span<const byte> petx_view::stored_data(u32 level_idx) const {
+    auto& l = level(level_idx);
+    return _bytes.subspan(static_cast<ssize_t>(l.offset), static_cast<ssize_t>(l.stored_size));
+}
+
+optional<span<const byte>> petx_view::try_view(u32 level_idx) const {
+    if (level(level_idx).flags & level_compressed)
+        return nullopt;
+
+    return stored_data(level_idx);
+}
+
+void petx_view::read_level(u32 level_idx, span<byte> output) const {
+    auto& l = level(level_idx);
+    if (static_cast<u64>(output.size()) != l.raw_size)
+        pe_throw std::runtime_error(
+            format("petx: level {} has {} bytes but output has {} bytes", level_idx, l.raw_size, output.size()));
+
+    auto stored = stored_data(level_idx);
+    if (l.flags & level_compressed)
+        decompress_frame(stored, output);
+    else
+        std::memcpy(output.data(), stored.data(), static_cast<size_t>(stored.size()));
+}
+
+vector<byte> petx_view::read_level(u32 level_idx) const {
+    vector<byte> result(level(level_idx).raw_size);
+    read_level(level_idx, result);
+    return result;
+}
+
+const petx_level& petx_view::level(u32 level) const {
+    if (level >= _levels.size())
+        pe_throw std::runtime_error(format("petx: invalid level {}, image has {} levels", level, _levels.size()));
+    return _levels[level];
+}
+
+vector<byte> petx_write(petx_pixels pixels, u32 channels, span<const petx_level_data> levels, bool compress,
+                        double min_compression_ratio) {
+    if constexpr (std::endian::native == std::endian::big)
+        pe_throw std::runtime_error("Implement me for big endian");
+
+    if (levels.empty())
+        pe_throw std::runtime_error("petx: image has no levels");
+    if (channels == 0 || channels > 4)
+        pe_throw std::runtime_error(format("petx: invalid channels count {}", channels));
+
+    vector<petx_level>   entries(static_cast<size_t>(levels.size()));
+    vector<vector<byte>> compressed(entries.size());
+
+    auto offset = align_up(petx_view::header_size + entries.size() * petx_view::level_entry_size, petx_view::alignment);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        auto& level = levels[static_cast<ssize_t>(i)];
+        auto& entry = entries[i];
+
+        auto raw_size = static_cast<u64>(level.data.size());
+        if (raw_size != petx_view::level_raw_size(pixels, channels, level.size))
+            pe_throw std::runtime_error(format("petx: level {} has invalid size {}", level.size, raw_size));
+
+        if (compress && raw_size != 0) {
+            compressed[i] = compress_frame(level.data, asset_codec("texture"));
+            if (static_cast<double>(compressed[i].size()) > static_cast<double>(raw_size) * min_compression_ratio)
+                compressed[i] = {};
+        }
+
+        entry.size        = level.size;
+        entry.offset      = offset;
+        entry.stored_size = compressed[i].empty() ? raw_size : static_cast<u64>(compressed[i].size());
+        entry.raw_size    = raw_size;
+        entry.flags       = compressed[i].empty() ? 0 : petx_view::level_compressed;
+        entry.reserved    = 0;
+
+        offset = align_up(offset + entry.stored_size, petx_view::alignment);
+    }
+
+    serializer s;
+    s.write(petx_magic,
+            petx_view::format_version,
+            static_cast<u32>(pixels),
+            channels,
+            static_cast<vec<u32, 2>>(levels[0].size),
+            static_cast<u32>(entries.size()),
+            u32(0));
+
+    for (auto& e : entries)
+        s.write(static_cast<vec<u32, 2>>(e.size), e.offset, e.stored_size, e.raw_size, e.flags, e.reserved);
+
+    auto result = s.detach_data();
+    result.resize(offset);
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        auto stored = compressed[i].empty() ? levels[static_cast<ssize_t>(i)].data : span<const byte>(compressed[i]);
+        std::memcpy(result.data() + entries[i].offset, stored.data(), static_cast<size_t>(stored.size()));
+    }
+
+    return result;
+}
+} // namespace util
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <core/vec.hpp>
+#include "texture_decode.hpp"
+
+namespace util
+{
+/**
+ * @brief Pixels of .petx levels, values are stored in files
+ */
+enum class petx_pixels : core::u32 {
+    u8 = 0,           /* Channels of u8 */
+    f32,              /* Channels of float */
+    dxt1,             /* Blocks of dxt_format::dxt1 */
+    dxt1_onebitalpha, /* Blocks of dxt_format::dxt1_onebitalpha */
+    dxt3,             /* Blocks of dxt_format::dxt3 */
+    dxt5,             /* Blocks of dxt_format::dxt5 */
+    bc7,              /* Blocks of dxt_format::bc7 */
+};
+
+/**
+ * @brief Gets pixels of the block format
+ */
+inline petx_pixels petx_block_pixels(dxt_format format) {
+    return petx_pixels(core::u32(petx_pixels::dxt1) + core::u32(format));
+}
+
+/**
+ * @brief Gets the block format of pixels
+ *
+ * @return the block format or nullopt if pixels are not block compressed
+ */
+inline core::optional<dxt_format> petx_block_format(petx_pixels pixels) {
+    if (pixels < petx_pixels::dxt1)
+        return core::nullopt;
+    return dxt_format(core::u32(pixels) - core::u32(petx_pixels::dxt1));
+}
+
+struct petx_level {
+    core::vec2u size;
+    core::u64   offset;
+    core::u64   stored_size;
+    core::u64   raw_size;
+    core::u32   flags;
+    core::u32   reserved;
+};
+
+/**
+ * @brief Level of the image to be written
+ */
+struct petx_level_data {
+    core::vec2u                  size;
+    core::span<const core::byte> data;
+};
+
+/**
+ * @brief View of the .petx v2 image
+ *
+ * Every level is stored separately, so levels which are not compressed are available as views into the file
+ * without any copying. Payloads are aligned to 64 bytes from the file start: when the file is memory mapped
+ * (directly or from the asset pack) the levels are aligned for SIMD loads and can be uploaded as-is.
+ * Compressed levels are codec frames of the "texture" asset codec
+ *
+ * Layout: "PETV" | u32 format version | u32 pixels | u32 channels | vec<u32, 2> size | u32 levels count |
+ *         u32 reserved | levels table: (vec<u32, 2> size | u64 offset | u64 stored size | u64 raw size |
+ *         u32 flags | u32 reserved) for every level from the largest one | level payloads
+ */
+class petx_view {
+public:
+    static constexpr core::u32 format_version   = 2;
+    static constexpr size_t    alignment        = 64;
+    static constexpr size_t    header_size      = 4 + 4 + 4 + 4 + 8 + 4 + 4;
+    static constexpr size_t    level_entry_size = 8 + 8 + 8 + 8 + 4 + 4;
+    static constexpr core::u32 level_compressed = 1U << 0U;
+
+    /**
+     * @brief Checks the signature and the version
+     */
+    static bool is_petx(core::span<const core::byte> bytes);
+
+    /**
+     * @brief Reads the header and the levels table
+     *
+     * @throw runtime_error if the image is invalid or truncated
+     *
+     * @param bytes - the file data, must outlive the view
+     */
+    explicit petx_view(core::span<const core::byte> bytes);
+
+    /**
+     * @brief Gets the raw size of the level with pixels
+     */
+    static core::u64 level_raw_size(petx_pixels pixels, core::u32 channels, const core::vec2u& size);
+
+    /**
+     * @brief Gets the level as it is stored in the file
+     */
+    [[nodiscard]]
+    core::span<const core::byte> stored_data(core::u32 level) const;
+
+    /**
+     * @brief Gets the view of the level without copying
+     *
+     * @return the view into the file or nullopt if the level is compressed
+     */
+    [[nodiscard]]
+    core::optional<core::span<const core::byte>> try_view(core::u32 level) const;
+
+    /**
+     * @brief Reads the level into the buffer, compressed levels are decompressed straight into it
+     *
+     * @throw runtime_error if the level is corrupted or the output size differs with the raw size
+     *
+     * @param level - the level, 0 - the largest level
+     * @param output - the output buffer
+     */
+    void read_level(core::u32 level, core::span<core::byte> output) const;
+
+    /**
+     * @brief Reads the level
+     *
+     * @return decompressed copy of the level
+     */
+    [[nodiscard]]
+    core::vector<core::byte> read_level(core::u32 level) const;
+
+    [[nodiscard]]
+    const petx_level& level(core::u32 level) const;
+
+    [[nodiscard]]
+    petx_pixels pixels() const {
+        return _pixels;
+    }
+
+    [[nodiscard]]
+    core::u32 channels() const {
+        return _channels;
+    }
+
+    [[nodiscard]]
+    const core::vec2u& size() const {
+        return _size;
+    }
+
+    [[nodiscard]]
+    core::u32 levels_count() const {
+        return static_cast<core::u32>(_levels.size());
+    }
+
+private:
+    core::span<const core::byte> _bytes;
+    petx_pixels                  _pixels   = petx_pixels::u8;
+    core::u32                    _channels = 0;
+    core::vec2u                  _size     = {0, 0};
+    core::vector<petx_level>     _levels;
+};
+
+/**
+ * @brief Serializes levels to the .petx v2 layout
+ *
+ * @throw runtime_error if there are no levels or sizes of levels don't match pixels
+ *
+ * @param pixels - pixels of levels
+ * @param channels - channels count (3 for dxt1 and 4 for other block formats)
+ * @param levels - levels from the largest to the smallest one
+ * @param compress - compress levels with the "texture" asset codec
+ * @param min_compression_ratio - levels that don't shrink to this ratio are stored uncompressed
+ *
+ * @return the file data
+ */
+core::vector<core::byte> petx_write(petx_pixels                       pixels,
+                                    core::u32                         channels,
+                                    core::span<const petx_level_data> levels,
+                                    bool                              compress              = true,
+                                    double                            min_compression_ratio = 0.9); // NOLINT
+} // namespace util
@@ -0,0 +1,410 @@
+#include "pixel_kernels.hpp"
+
+#include <core/fiber_pool.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define PE_PIXEL_KERNELS_X86
+#endif
+
+using namespace core;
+using namespace util;
+
+namespace
+{
+/* Values or pixels per job, small images are processed in the calling thread */
+constexpr size_t min_values_per_job = 65536;
+
+/* Byte width of rotated tiles, a pair of tiles fits in L1 */
+constexpr size_t tile_bytes = 256;
+
+#ifdef PE_PIXEL_KERNELS_X86
+/* Cephes expf and logf polynomials, the relative error is about 1e-7.
+ * Inlined, so dependency chains of neighbouring vectors are interleaved */
+[[gnu::always_inline]] inline __m128 exp_ps(__m128 x) {
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-87.3f)), _mm_set1_ps(88.3f)); // NOLINT
+
+    /* x = n * ln2 + r, floor(x * log2(e) + 0.5) */
+    auto fx    = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(1.44269504088896341f)), _mm_set1_ps(0.5f)); // NOLINT
+    auto trunc = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+    fx         = _mm_sub_ps(trunc, _mm_and_ps(_mm_cmpgt_ps(trunc, fx), _mm_set1_ps(1.f)));
+
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(0.693359375f)));   // NOLINT
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(-2.12194440e-4f))); // NOLINT
+
+    auto y = _mm_set1_ps(1.9875691500e-4f);                                 // NOLINT
+    y      = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.3981999507e-3f));  // NOLINT
+    y      = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(8.3334519073e-3f));  // NOLINT
+    y      = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(4.1665795894e-2f));  // NOLINT
+    y      = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.6666665459e-1f));  // NOLINT
+    y      = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(5.0000001201e-1f));  // NOLINT
+    y      = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, _mm_mul_ps(x, x)), x), _mm_set1_ps(1.f));
+
+    auto pow2n = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(fx), _mm_set1_epi32(0x7f)), 23); // NOLINT
+    return _mm_mul_ps(y, _mm_castsi128_ps(pow2n));
+}
+
+/* Natural logarithm of positive normal values */
+[[gnu::always_inline]] inline __m128 log_ps(__m128 x) {
+    x = _mm_max_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x00800000))); // NOLINT
+
+    /* x = m * 2^e, m in [0.5, 1) */
+    auto e = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(x), 23), _mm_set1_epi32(0x7e)); // NOLINT
+    x      = _mm_or_ps(_mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(~0x7f800000))), _mm_set1_ps(0.5f)); // NOLINT
+    auto fe = _mm_cvtepi32_ps(e);
+
+    /* m < sqrt(0.5) -> 2m - 1, e - 1; otherwise m - 1 */
+    auto mask = _mm_cmplt_ps(x, _mm_set1_ps(0.707106781186547524f)); // NOLINT
+    fe        = _mm_sub_ps(fe, _mm_and_ps(mask, _mm_set1_ps(1.f)));
+    x         = _mm_add_ps(_mm_sub_ps(x, _mm_set1_ps(1.f)), _mm_and_ps(x, mask));
+
+    auto z = _mm_mul_ps(x, x);
+    auto y = _mm_set1_ps(7.0376836292e-2f);                                 // NOLINT
+    y      = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-1.1514610310e-1f)); // NOLINT
+    y      = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.1676998740e-1f));  // NOLINT
+    y      = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-1.2420140846e-1f)); // NOLINT
+    y      = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.4249322787e-1f));  // NOLINT
+    y      = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-1.6668057665e-1f)); // NOLINT
+    y      = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(2.0000714765e-1f));  // NOLINT
+    y      = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-2.4999993993e-1f)); // NOLINT
+    y      = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(3.3333331174e-1f));  // NOLINT
+    y      = _mm_mul_ps(_mm_mul_ps(y, x), z);
+
+    y = _mm_add_ps(y, _mm_mul_ps(fe, _mm_set1_ps(-2.12194440e-4f))); // NOLINT
+    y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));             // NOLINT
+    x = _mm_add_ps(x, y);
+    return _mm_add_ps(x, _mm_mul_ps(fe, _mm_set1_ps(0.693359375f))); // NOLINT
+}
+
+/* 4 values scaled to [0, 255], Gamma is false when the gamma is 1 */
+template <bool Gamma>
+[[gnu::always_inline]] inline __m128 tone_map4(__m128 v, __m128 neg_exposure, float inv_gamma) {
+    auto mapped = _mm_sub_ps(_mm_set1_ps(1.f), exp_ps(_mm_mul_ps(v, neg_exposure)));
+    mapped      = _mm_min_ps(_mm_max_ps(mapped, _mm_setzero_ps()), _mm_set1_ps(1.f));
+
+    if constexpr (Gamma) {
+        auto nonzero = _mm_cmpgt_ps(mapped, _mm_setzero_ps());
+        mapped       = _mm_and_ps(nonzero, exp_ps(_mm_mul_ps(log_ps(mapped), _mm_set1_ps(inv_gamma))));
+        mapped       = _mm_min_ps(mapped, _mm_set1_ps(1.f));
+    }
+
+    return _mm_mul_ps(mapped, _mm_set1_ps(255.f)); // NOLINT
+}
+
+/* 16 values in [0, 255] to bytes, cvt is truncation or rounding */
+template <bool Round>
+__m128i pack16(__m128 a, __m128 b, __m128 c, __m128 d) {
+    auto cvt = [](__m128 v) { return Round ? _mm_cvtps_epi32(v) : _mm_cvttps_epi32(v); };
+    return _mm_packus_epi16(_mm_packs_epi32(cvt(a), cvt(b)), _mm_packs_epi32(cvt(c), cvt(d)));
+}
+
+/* Runs the kernel of 16 values on the tail through zero padded buffers */
+template <typename SrcT, typename DstT, typename F>
+void padded_tail(const SrcT* src, DstT* dst, size_t count, F&& kernel16) {
+    if (!count)
+        return;
+    SrcT src_block[16] = {}; // NOLINT
+    DstT dst_block[16];      // NOLINT
+    std::memcpy(src_block, src, count * sizeof(SrcT));
+    kernel16(src_block, dst_block);
+    std::memcpy(dst, dst_block, count * sizeof(DstT));
+}
+
+template <bool Gamma>
+void tone_map_range_impl(const float* src, u8* dst, size_t count, float gamma, float exposure) {
+    auto neg_exposure = _mm_set1_ps(-exposure);
+    auto inv_gamma    = 1.f / gamma;
+    auto kernel16     = [&](const float* s, u8* d) {
+        auto v = pack16<false>(tone_map4<Gamma>(_mm_loadu_ps(s), neg_exposure, inv_gamma),
+                               tone_map4<Gamma>(_mm_loadu_ps(s + 4), neg_exposure, inv_gamma),   // NOLINT
+                               tone_map4<Gamma>(_mm_loadu_ps(s + 8), neg_exposure, inv_gamma),   // NOLINT
+                               tone_map4<Gamma>(_mm_loadu_ps(s + 12), neg_exposure, inv_gamma)); // NOLINT
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d), v); // NOLINT
+    };
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) // NOLINT
+        kernel16(src + i, dst + i);
+    padded_tail(src + i, dst + i, count - i, kernel16);
+}
+
+void tone_map_range(const float* src, u8* dst, size_t count, float gamma, float exposure) {
+    if (std::fabs(gamma - 1.f) > 1e-6f) // NOLINT
+        tone_map_range_impl<true>(src, dst, count, gamma, exposure);
+    else
+        tone_map_range_impl<false>(src, dst, count, gamma, exposure);
+}
+
+void u8_to_float_range(const u8* src, float* dst, size_t count) {
+    auto scale = _mm_set1_ps(255.f); // NOLINT
+    auto zero  = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) { // NOLINT
+        auto v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)); // NOLINT
+        auto lo = _mm_unpacklo_epi8(v, zero);
+        auto hi = _mm_unpackhi_epi8(v, zero);
+
+        /* Division gives the same values as the scalar v / 255.f */
+        _mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));  // NOLINT
+        _mm_storeu_ps(dst + i + 8, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));  // NOLINT
+        _mm_storeu_ps(dst + i + 12, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale)); // NOLINT
+    }
+    for (; i < count; ++i)
+        dst[i] = float(src[i]) / 255.f; // NOLINT
+}
+
+void float_to_u8_range(const float* src, u8* dst, size_t count) {
+    auto kernel16 = [](const float* s, u8* d) {
+        auto scale = _mm_set1_ps(255.f); // NOLINT
+        auto v     = pack16<true>(_mm_mul_ps(_mm_loadu_ps(s), scale),
+                              _mm_mul_ps(_mm_loadu_ps(s + 4), scale),   // NOLINT
+                              _mm_mul_ps(_mm_loadu_ps(s + 8), scale),   // NOLINT
+                              _mm_mul_ps(_mm_loadu_ps(s + 12), scale)); // NOLINT
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d), v); // NOLINT
+    };
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) // NOLINT
+        kernel16(src + i, dst + i);
+    padded_tail(src + i, dst + i, count - i, kernel16);
+}
+#else
+void tone_map_range(const float* src, u8* dst, size_t count, float gamma, float exposure) {
+    for (size_t i = 0; i < count; ++i) {
+        auto mapped = std::clamp(1.f - std::exp(-src[i] * exposure), 0.f, 1.f);
+        dst[i]      = static_cast<u8>(255.f * std::pow(mapped, 1.f / gamma)); // NOLINT
+    }
+}
+
+void u8_to_float_range(const u8* src, float* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        dst[i] = float(src[i]) / 255.f; // NOLINT
+}
+
+void float_to_u8_range(const float* src, u8* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        dst[i] = static_cast<u8>(std::nearbyint(std::clamp(src[i], 0.f, 1.f) * 255.f)); // NOLINT
+}
+#endif
+
+template <typename F>
+void parallel_values(size_t count, fiber_pool* pool, F&& function) {
+    parallel_for(count, min_values_per_job, [&](size_t begin, size_t end) { function(begin, end - begin); }, pool);
+}
+
+template <size_t S>
+struct pixel {
+    byte bytes[S]; // NOLINT
+};
+
+/* Calls function with std::integral_constant of the pixel size, so pixel copies are compiled as plain moves */
+template <typename F>
+void with_pixel_size(size_t pixel_size, F&& function) {
+    switch (pixel_size) {
+    case 1: function(std::integral_constant<size_t, 1>()); break;
+    case 2: function(std::integral_constant<size_t, 2>()); break;
+    case 3: function(std::integral_constant<size_t, 3>()); break;
+    case 4: function(std::integral_constant<size_t, 4>()); break;   // NOLINT
+    case 8: function(std::integral_constant<size_t, 8>()); break;   // NOLINT
+    case 12: function(std::integral_constant<size_t, 12>()); break; // NOLINT
+    case 16: function(std::integral_constant<size_t, 16>()); break; // NOLINT
+    default: pe_throw std::runtime_error("pixel kernels: unsupported pixel size " + std::to_string(pixel_size));
+    }
+}
+
+size_t rows_per_job(vec2u size) {
+    return std::max<size_t>(1, min_values_per_job / std::max<size_t>(size.x(), 1));
+}
+
+/* Transposes 4x4 blocks of 4-byte pixels, returns the count of columns handled */
+template <size_t S>
+u32 transpose_block4([[maybe_unused]] const pixel<S>* src,
+                     [[maybe_unused]] u32             src_width,
+                     [[maybe_unused]] pixel<S>*       dst,
+                     [[maybe_unused]] u32             dst_width,
+                     [[maybe_unused]] u32             x_begin,
+                     [[maybe_unused]] u32             x_end,
+                     [[maybe_unused]] u32             y,
+                     [[maybe_unused]] u32             src_height,
+                     [[maybe_unused]] bool            left) {
+#ifdef PE_PIXEL_KERNELS_X86
+    if constexpr (S == 4) {
+        auto x = x_begin;
+        for (; x + 4 <= x_end; x += 4) {
+            auto row = [&](u32 i) { return _mm_loadu_ps(reinterpret_cast<const float*>(src + size_t(y + i) * src_width + x)); }; // NOLINT
+            auto r0  = row(0);
+            auto r1  = row(1);
+            auto r2  = row(2);
+            auto r3  = row(3);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3); // NOLINT
+
+            /* Transposed row i is the source column x + i */
+            auto store = [&](u32 i, __m128 v) {
+                if (left) {
+                    auto dst_row = src_width - (x + i) - 1;
+                    _mm_storeu_ps(reinterpret_cast<float*>(dst + size_t(dst_row) * dst_width + y), v); // NOLINT
+                }
+                else {
+                    auto dst_col = src_height - (y + 3) - 1;
+                    _mm_storeu_ps(reinterpret_cast<float*>(dst + size_t(x + i) * dst_width + dst_col), // NOLINT
+                                  _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3)));
+                }
+            };
+            store(0, r0);
+            store(1, r1);
+            store(2, r2);
+            store(3, r3);
+        }
+        return x - x_begin;
+    }
+#endif
+    return 0;
+}
+
+template <size_t S>
+void rotate_90(const pixel<S>* src, vec2u size, pixel<S>* dst, bool left, fiber_pool* pool) {
+    auto tile        = u32(std::clamp<size_t>(tile_bytes / S, 16, 64)); // NOLINT
+    auto tile_rows   = (size.y() + tile - 1) / tile;
+    auto tiles_per_x = (size.x() + tile - 1) / tile;
+    auto dst_width   = size.y();
+
+    auto min_tile_rows = std::max<size_t>(1, min_values_per_job / (size_t(tile) * std::max<u32>(size.x(), 1)));
+
+    parallel_for(
+        tile_rows,
+        min_tile_rows,
+        [&](size_t begin, size_t end) {
+            for (auto ty = u32(begin); ty < u32(end); ++ty) {
+                auto y_begin = ty * tile;
+                auto y_end   = std::min(y_begin + tile, size.y());
+
+                for (u32 tx = 0; tx < tiles_per_x; ++tx) {
+                    auto x_begin = tx * tile;
+                    auto x_end   = std::min(x_begin + tile, size.x());
+
+                    auto y = y_begin;
+                    for (; y + 4 <= y_end; y += 4) {
+                        auto done = transpose_block4(src, size.x(), dst, dst_width, x_begin, x_end, y, size.y(), left);
+                        for (auto x = x_begin + done; x < x_end; ++x)
+                            for (auto i = y; i < y + 4; ++i)
+                                (left ? dst[size_t(size.x() - x - 1) * dst_width + i]
+                                      : dst[size_t(x) * dst_width + size.y() - i - 1]) = src[size_t(i) * size.x() + x];
+                    }
+                    for (; y < y_end; ++y)
+                        for (auto x = x_begin; x < x_end; ++x)
+                            (left ? dst[size_t(size.x() - x - 1) * dst_width + y]
+                                  : dst[size_t(x) * dst_width + size.y() - y - 1]) = src[size_t(y) * size.x() + x];
+                }
+            }
+        },
+        pool);
+}
+
+/* Reverses pixels of the row into dst */
+template <size_t S>
+void reverse_row_copy(const pixel<S>* src, pixel<S>* dst, u32 width) {
+    u32 x = 0;
+#ifdef PE_PIXEL_KERNELS_X86
+    if constexpr (S == 4) {
+        for (; x + 4 <= width; x += 4) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x)); // NOLINT
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + width - x - 4),    // NOLINT
+                             _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)));
+        }
+    }
+#endif
+    for (; x < width; ++x)
+        dst[width - x - 1] = src[x];
+}
+
+template <size_t S>
+void reverse_row(pixel<S>* row, u32 width) {
+    u32 begin = 0;
+    u32 end   = width;
+#ifdef PE_PIXEL_KERNELS_X86
+    if constexpr (S == 4) {
+        for (; end - begin >= 8; begin += 4, end -= 4) { // NOLINT
+            auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + begin));   // NOLINT
+            auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + end - 4)); // NOLINT
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row + begin), _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 1, 2, 3)));   // NOLINT
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row + end - 4), _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 1, 2, 3))); // NOLINT
+        }
+    }
+#endif
+    std::reverse(row + begin, row + end);
+}
+} // namespace
+
+namespace util
+{
+void tone_map(const float* src, u8* dst, size_t count, float gamma, float exposure, fiber_pool* pool) {
+    parallel_values(
+        count, pool, [&](size_t begin, size_t n) { tone_map_range(src + begin, dst + begin, n, gamma, exposure); });
+}
+
+void u8_to_float(const u8* src, float* dst, size_t count, fiber_pool* pool) {
+    parallel_values(count, pool, [&](size_t begin, size_t n) { u8_to_float_range(src + begin, dst + begin, n); });
+}
+
+void float_to_u8(const float* src, u8* dst, size_t count, fiber_pool* pool) {
+    parallel_values(count, pool, [&](size_t begin, size_t n) { float_to_u8_range(src + begin, dst + begin, n); });
+}
+
+void rotate_pixels(const byte* src, vec2u size, size_t pixel_size, byte* dst, pixel_rotation rotation, fiber_pool* pool) {
+    with_pixel_size(pixel_size, [&](auto s) {
+        constexpr size_t S = decltype(s)::value;
+        auto src_pixels    = reinterpret_cast<const pixel<S>*>(src); // NOLINT
+        auto dst_pixels    = reinterpret_cast<pixel<S>*>(dst);       // NOLINT
+
+        if (rotation != pixel_rotation::half) {
+            rotate_90(src_pixels, size, dst_pixels, rotation == pixel_rotation::left, pool);
+            return;
+        }
+
+        parallel_for(
+            size.y(),
+            rows_per_job(size),
+            [&](size_t begin, size_t end) {
+                for (auto y = begin; y < end; ++y)
+                    reverse_row_copy(src_pixels + y * size.x(), dst_pixels + (size.y() - y - 1) * size.x(), size.x());
+            },
+            pool);
+    });
+}
+
+void flip_pixels_horizontal(byte* data, vec2u size, size_t pixel_size, fiber_pool* pool) {
+    with_pixel_size(pixel_size, [&](auto s) {
+        constexpr size_t S = decltype(s)::value;
+        auto pixels        = reinterpret_cast<pixel<S>*>(data); // NOLINT
+
+        parallel_for(
+            size.y(),
+            rows_per_job(size),
+            [&](size_t begin, size_t end) {
+                for (auto y = begin; y < end; ++y)
+                    reverse_row(pixels + y * size.x(), size.x());
+            },
+            pool);
+    });
+}
+
+void flip_pixels_vertical(byte* data, vec2u size, size_t pixel_size, fiber_pool* pool) {
+    auto pitch = size_t(size.x()) * pixel_size;
+    parallel_for(
+        size.y() / 2,
+        rows_per_job(size),
+        [&](size_t begin, size_t end) {
+            for (auto y = begin; y < end; ++y) {
+                auto top    = data + y * pitch;
+                auto bottom = data + (size.y() - y - 1) * pitch;
+                std::swap_ranges(top, top + pitch, bottom);
+            }
+        },
+        pool);
+}
+} // namespace util
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <core/vec.hpp>
+
+namespace core {
+    class fiber_pool;
+}
+
+namespace util
+{
+/**
+ * Pixel transform kernels of color maps
+ *
+ * Images are tightly packed rows of pixels with pixel_size bytes each. Kernels split the work into rows or tiles and
+ * run it in parallel jobs of the fiber pool (nullptr - the global fiber pool)
+ */
+
+enum class pixel_rotation : core::u8 {
+    left = 0, /* Counterclockwise by 90 degrees, the result size is size.yx() */
+    right,    /* Clockwise by 90 degrees, the result size is size.yx() */
+    half,     /* By 180 degrees */
+};
+
+/**
+ * @brief Maps HDR values to 8-bit values: 255 * (1 - exp(-v * exposure)) ^ (1 / gamma), truncated
+ *
+ * exp and log are evaluated with SSE polynomial approximations (Cephes expf and logf, relative error about 1e-7),
+ * so a result differs from the one computed with std::exp and std::pow by at most 1 and only near integer
+ * boundaries. Negative values are mapped to 0
+ *
+ * @param src - HDR values
+ * @param dst - 8-bit values
+ * @param count - the count of values
+ * @param gamma - the gamma
+ * @param exposure - the exposure
+ * @param pool - the fiber pool
+ */
+void tone_map(const float* src, core::u8* dst, size_t count, float gamma, float exposure, core::fiber_pool* pool = nullptr);
+
+/**
+ * @brief Converts 8-bit values to floats in [0, 1]: v / 255
+ */
+void u8_to_float(const core::u8* src, float* dst, size_t count, core::fiber_pool* pool = nullptr);
+
+/**
+ * @brief Converts floats in [0, 1] to 8-bit values: round(v * 255), values out of range are clamped
+ */
+void float_to_u8(const float* src, core::u8* dst, size_t count, core::fiber_pool* pool = nullptr);
+
+/**
+ * @brief Rotates the image
+ *
+ * 90 degree rotations transpose square tiles with rows of up to 256 bytes, so both images are accessed within cache.
+ * src and dst must not overlap
+ *
+ * @param src - the source image
+ * @param size - the size of the source image
+ * @param pixel_size - the size of a pixel in bytes
+ * @param dst - the rotated image
+ * @param rotation - the rotation
+ * @param pool - the fiber pool
+ */
+void rotate_pixels(const core::byte*  src,
+                   core::vec2u        size,
+                   size_t             pixel_size,
+                   core::byte*        dst,
+                   pixel_rotation     rotation,
+                   core::fiber_pool*  pool = nullptr);
+
+/**
+ * @brief Mirrors every row of the image in place
+ */
+void flip_pixels_horizontal(core::byte* data, core::vec2u size, size_t pixel_size, core::fiber_pool* pool = nullptr);
+
+/**
+ * @brief Swaps rows of the image in place
+ */
+void flip_pixels_vertical(core::byte* data, core::vec2u size, size_t pixel_size, core::fiber_pool* pool = nullptr);
+} // namespace util
@@ -0,0 +1,268 @@
+#include "seekable_compression.hpp"
+
+#include <core/fiber_pool.hpp>
+#include <core/serialization.hpp>
+
+using namespace core;
+
+namespace
+{
+constexpr auto seekable_magic      = array{'P', 'E', 'S', 'K'};
+constexpr u64  seekable_max_blocks = u64(1) << 40U;
+
+u64 read_u64(span<const byte> data, size_t index) {
+    u64 v; // NOLINT
+    std::memcpy(&v, data.data() + index * sizeof(u64), sizeof(v));
+    return v;
+}
+} // namespace
+
+namespace util
+{
+seekable_writer::seekable_writer(serialization_sink& output, codec_settings settings, size_t block_size):
+    _output(output), _settings(settings), _block_size(std::max<size_t>(block_size, 1)) {
+    get_codec(_settings.codec); /* Throws for unknown codecs before anything is written */
+
+    byte_vector header;
+    serialize_all(header, seekable_magic, format_version, _settings.codec, static_cast<u64>(_block_size));
+    write_output(header);
+
+    _buffer.reserve(_block_size);
+}
+
+void seekable_writer::write(span<const byte> chunk) {
+    while (!chunk.empty()) {
+        auto count = std::min(static_cast<size_t>(chunk.size()), _block_size - _buffer.size());
+        _buffer.insert(_buffer.end(), chunk.begin(), chunk.begin() + static_cast<ptrdiff_t>(count));
+        chunk = chunk.subspan(static_cast<ptrdiff_t>(count));
+
+        if (_buffer.size() == _block_size)
+            compress_buffer();
+    }
+}
+
+void seekable_writer::finish() {
+    if (!_buffer.empty())
+        compress_buffer();
+
+    byte_vector trailer;
+    trailer.reserve(_block_ends.size() * sizeof(u64) + trailer_size);
+    for (auto end : _block_ends)
+        serialize(end, trailer);
+    serialize_all(trailer, _raw_size, static_cast<u64>(_block_ends.size()), seekable_magic);
+
+    write_output(trailer);
+    _output.finish();
+}
+
+void seekable_writer::write_output(span<const byte> data) {
+    _output.write(data);
+    _written += static_cast<u64>(data.size());
+}
+
+void seekable_writer::compress_buffer() {
+    auto compressed = get_codec(_settings.codec).compress(_buffer, _settings.level);
+    write_output(compressed);
+
+    auto last_end = _block_ends.empty() ? 0 : _block_ends.back();
+    _block_ends.push_back(last_end + compressed.size());
+    _raw_size += _buffer.size();
+    _buffer.clear();
+}
+
+vector<byte> compress_seekable(span<const byte> data, codec_settings settings, size_t block_size, fiber_pool* pool) {
+    if (!pool)
+        pool = &global_fiber_pool();
+
+    block_size = std::max<size_t>(block_size, 1);
+
+    auto& codec        = get_codec(settings.codec);
+    auto  raw_size     = static_cast<size_t>(data.size());
+    auto  blocks_count = (raw_size + block_size - 1) / block_size;
+
+    vector<vector<byte>>       blocks(blocks_count);
+    vector<job_future<void>>   jobs;
+    jobs.reserve(blocks_count);
+
+    for (size_t i = 0; i < blocks_count; ++i) {
+        auto block = data.subspan(static_cast<ptrdiff_t>(i * block_size),
+                                  static_cast<ptrdiff_t>(std::min(block_size, raw_size - i * block_size)));
+        jobs.push_back(pool->submit([&codec, &result = blocks[i], block, level = settings.level] {
+            result = codec.compress(block, level);
+        }));
+    }
+
+    wait_all_rethrow(jobs);
+
+    size_t compressed_size = 0;
+    for (auto& block : blocks)
+        compressed_size += block.size();
+
+    vector<byte> result;
+    result.reserve(seekable_writer::header_size + compressed_size + blocks_count * sizeof(u64) +
+                   seekable_writer::trailer_size);
+    serialize_all(result, seekable_magic, seekable_writer::format_version, settings.codec, static_cast<u64>(block_size));
+
+    for (auto& block : blocks)
+        result.insert(result.end(), block.begin(), block.end());
+
+    u64 end = 0;
+    for (auto& block : blocks) {
+        end += block.size();
+        serialize(end, result);
+    }
+    serialize_all(result, static_cast<u64>(raw_size), static_cast<u64>(blocks_count), seekable_magic);
+
+    return result;
+}
+
+bool is_seekable_compressed(span<const byte> data) {
+    return static_cast<size_t>(data.size()) >= seekable_writer::header_size + seekable_writer::trailer_size &&
+           std::memcmp(data.data(), seekable_magic.data(), seekable_magic.size()) == 0;
+}
+
+seekable_reader::seekable_reader(span<const byte> data) {
+    if (!is_seekable_compressed(data))
+        pe_throw std::runtime_error("seekable compression: invalid header");
+
+    auto header = data;
+    auto trailer = data.subspan(static_cast<ptrdiff_t>(static_cast<size_t>(data.size()) - seekable_writer::trailer_size));
+
+    array<char, 4> magic;        // NOLINT
+    u32            version;      // NOLINT
+    codec_id       id;           // NOLINT
+    u64            block_size;   // NOLINT
+    u64            blocks_count; // NOLINT
+
+    deserialize_all(header, magic, version, id, block_size);
+    if (version != seekable_writer::format_version)
+        pe_throw std::runtime_error("seekable compression: unsupported version " + std::to_string(version));
+
+    deserialize_all(trailer, _raw_size, blocks_count, magic);
+    if (magic != seekable_magic)
+        pe_throw std::runtime_error("seekable compression: invalid trailer");
+
+    _codec = &get_codec(id);
+
+    auto payload_size = static_cast<size_t>(data.size()) - seekable_writer::header_size - seekable_writer::trailer_size;
+    if (block_size == 0 || blocks_count > seekable_max_blocks || blocks_count * sizeof(u64) > payload_size ||
+        blocks_count != _raw_size / block_size + (_raw_size % block_size != 0))
+        pe_throw std::runtime_error("seekable compression: invalid offset table");
+
+    /* blocks_count is bounded by the payload size, so the product is checked without overflow */
+    if (blocks_count != 0 && (block_size > std::numeric_limits<u64>::max() / blocks_count ||
+                              _raw_size > blocks_count * block_size))
+        pe_throw std::runtime_error("seekable compression: raw size exceeds the block table");
+
+    _block_size   = static_cast<size_t>(block_size);
+    _blocks_count = static_cast<size_t>(blocks_count);
+
+    auto blocks_size = payload_size - _blocks_count * sizeof(u64);
+    _blocks          = data.subspan(static_cast<ptrdiff_t>(seekable_writer::header_size),
+                           static_cast<ptrdiff_t>(blocks_size));
+    _block_ends      = data.subspan(static_cast<ptrdiff_t>(seekable_writer::header_size + blocks_size),
+                               static_cast<ptrdiff_t>(_blocks_count * sizeof(u64)));
+
+    /* Raw sizes of blocks are bounded by their compressed sizes before any buffer is allocated */
+    u64 last_end = 0;
+    for (size_t i = 0; i < _blocks_count; ++i) {
+        auto end = read_u64(_block_ends, i);
+        if (end < last_end)
+            pe_throw std::runtime_error("seekable compression: invalid offset table");
+        if (block_raw_size(i) / _codec->max_expansion() > end - last_end)
+            pe_throw std::runtime_error("seekable compression: block raw size exceeds the maximum expansion");
+        last_end = end;
+    }
+
+    if (last_end != blocks_size)
+        pe_throw std::runtime_error("seekable compression: offset table differs with the payload size");
+}
+
+span<const byte> seekable_reader::compressed_block(size_t block_index) const {
+    auto start = block_index == 0 ? 0 : read_u64(_block_ends, block_index - 1);
+    auto end   = read_u64(_block_ends, block_index);
+    return _blocks.subspan(static_cast<ptrdiff_t>(start), static_cast<ptrdiff_t>(end - start));
+}
+
+void seekable_reader::check_range(u64 offset, size_t size) const {
+    if (offset > _raw_size || size > _raw_size - offset)
+        pe_throw std::runtime_error("seekable compression: range is out of the raw size");
+}
+
+void seekable_reader::read_block(size_t block_index, size_t offset, span<byte> output) const {
+    auto block    = compressed_block(block_index);
+    auto raw_size = block_raw_size(block_index);
+
+    if (_codec->id() == codec_id::store) {
+        if (static_cast<size_t>(block.size()) != raw_size)
+            pe_throw std::runtime_error("seekable compression: stored block size differs with the raw size");
+        std::memcpy(output.data(), block.data() + offset, static_cast<size_t>(output.size()));
+    }
+    else if (offset == 0 && static_cast<size_t>(output.size()) == raw_size) {
+        _codec->decompress(block, output);
+    }
+    else {
+        /* Blocks are decompressed whole, the requested part is copied */
+        vector<byte> buffer(raw_size);
+        _codec->decompress(block, buffer);
+        std::memcpy(output.data(), buffer.data() + offset, static_cast<size_t>(output.size()));
+    }
+}
+
+void seekable_reader::read(u64 offset, span<byte> output) const {
+    auto size = static_cast<size_t>(output.size());
+    check_range(offset, size);
+
+    while (size) {
+        auto block_index  = static_cast<size_t>(offset / _block_size);
+        auto block_offset = static_cast<size_t>(offset % _block_size);
+        auto count        = std::min(size, block_raw_size(block_index) - block_offset);
+
+        read_block(block_index, block_offset, output.first(static_cast<ptrdiff_t>(count)));
+
+        output = output.subspan(static_cast<ptrdiff_t>(count));
+        offset += count;
+        size -= count;
+    }
+}
+
+vector<byte> seekable_reader::read(u64 offset, size_t size) const {
+    check_range(offset, size);
+
+    vector<byte> result(size);
+    read(offset, result);
+    return result;
+}
+
+void seekable_reader::read_parallel(u64 offset, span<byte> output, fiber_pool* pool) const {
+    if (!pool)
+        pool = &global_fiber_pool();
+
+    auto size = static_cast<size_t>(output.size());
+    check_range(offset, size);
+
+    vector<job_future<void>> jobs;
+    jobs.reserve(size / _block_size + 2);
+
+    while (size) {
+        auto block_index  = static_cast<size_t>(offset / _block_size);
+        auto block_offset = static_cast<size_t>(offset % _block_size);
+        auto count        = std::min(size, block_raw_size(block_index) - block_offset);
+        auto out          = output.first(static_cast<ptrdiff_t>(count));
+
+        jobs.push_back(pool->submit([this, block_index, block_offset, out] { read_block(block_index, block_offset, out); }));
+
+        output = output.subspan(static_cast<ptrdiff_t>(count));
+        offset += count;
+        size -= count;
+    }
+
+    wait_all_rethrow(jobs);
+}
+
+vector<byte> seekable_reader::read_all(fiber_pool* pool) const {
+    vector<byte> result(static_cast<size_t>(_raw_size));
+    read_parallel(0, result, pool);
+    return result;
+}
+} // namespace util
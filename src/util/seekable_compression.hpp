@@ -0,0 +1,198 @@
+#pragma once
+
+#include "codec.hpp"
+
+namespace core {
+    class fiber_pool;
+}
+
+namespace util
+{
+constexpr size_t SEEKABLE_BLOCK_SIZE = 64 * 1024;
+
+/**
+ * @brief Writes the seekable compressed stream
+ *
+ * The input is split into fixed-size blocks which are compressed independently, so any byte range
+ * can be decompressed without touching the blocks outside of it. Block offsets go into the trailing table,
+ * so the stream is written in one pass with the memory bounded by the block size.
+ *
+ * Layout: "PESK" | u32 version | u8 codec id | u64 block size | compressed blocks |
+ *         u64 end offset of each block (relative to the first block) | u64 raw size | u64 blocks count | "PESK"
+ */
+class seekable_writer : public core::serialization_sink {
+public:
+    static constexpr core::u32 format_version = 1;
+    static constexpr size_t    header_size    = 4 + 4 + 1 + 8;
+    static constexpr size_t    trailer_size   = 8 + 8 + 4;
+
+    /**
+     * @brief Writes the header into the output
+     *
+     * @param output - receives the compressed stream
+     * @param settings - the codec and the compression level of blocks
+     * @param block_size - size of uncompressed block
+     */
+    seekable_writer(core::serialization_sink& output,
+                    codec_settings            settings   = {},
+                    size_t                    block_size = SEEKABLE_BLOCK_SIZE);
+
+    void write(core::span<const core::byte> chunk) override;
+
+    /**
+     * @brief Compresses the last block, writes the offset table and finishes the output
+     */
+    void finish() override;
+
+    /**
+     * @brief Gets the count of bytes passed to the output
+     */
+    [[nodiscard]]
+    core::u64 written() const {
+        return _written;
+    }
+
+private:
+    void write_output(core::span<const core::byte> data);
+    void compress_buffer();
+
+private:
+    core::serialization_sink& _output;
+    codec_settings            _settings;
+    size_t                    _block_size;
+    core::vector<core::byte>  _buffer;
+    core::vector<core::u64>   _block_ends;
+    core::u64                 _raw_size = 0;
+    core::u64                 _written  = 0;
+};
+
+/**
+ * @brief Compresses the input into the seekable stream with blocks compressed in parallel
+ *
+ * The result is the same as written by seekable_writer
+ *
+ * @param data - byte input
+ * @param settings - the codec and the compression level of blocks
+ * @param block_size - size of uncompressed block
+ * @param pool - the fiber pool which runs compression jobs, nullptr - the global fiber pool
+ *
+ * @return the seekable stream
+ */
+core::vector<core::byte> compress_seekable(core::span<const core::byte> data,
+                                           codec_settings               settings   = {},
+                                           size_t                       block_size = SEEKABLE_BLOCK_SIZE,
+                                           core::fiber_pool*            pool       = nullptr);
+
+/**
+ * @brief Checks that the input is written by seekable_writer or compress_seekable
+ */
+bool is_seekable_compressed(core::span<const core::byte> data);
+
+/**
+ * @brief Random-access reader of the seekable stream
+ *
+ * The reader does not own the stream, it is usually a view into the mapped file,
+ * so only the pages of the requested blocks are read from the disk
+ */
+class seekable_reader {
+public:
+    /**
+     * @brief Reads the header and the offset table
+     *
+     * @throw runtime_error if the stream is invalid
+     *
+     * @param data - the seekable stream, must outlive the reader
+     */
+    explicit seekable_reader(core::span<const core::byte> data);
+
+    /**
+     * @brief Decompresses the byte range into the buffer
+     *
+     * Only blocks which overlap the range are decompressed
+     *
+     * @throw runtime_error if the range is out of the raw size or a block is corrupted
+     *
+     * @param offset - offset of the range in uncompressed data
+     * @param output - the output buffer, its size is the size of the range
+     */
+    void read(core::u64 offset, core::span<core::byte> output) const;
+
+    /**
+     * @brief Decompresses the byte range
+     *
+     * @throw runtime_error if the range is out of the raw size or a block is corrupted
+     *
+     * @param offset - offset of the range in uncompressed data
+     * @param size - size of the range
+     *
+     * @return decompressed bytes
+     */
+    [[nodiscard]]
+    core::vector<core::byte> read(core::u64 offset, size_t size) const;
+
+    /**
+     * @brief Decompresses the byte range into the buffer, blocks are decompressed in parallel
+     *
+     * @throw runtime_error if the range is out of the raw size or a block is corrupted
+     *
+     * @param offset - offset of the range in uncompressed data
+     * @param output - the output buffer, its size is the size of the range
+     * @param pool - the fiber pool which runs decompression jobs, nullptr - the global fiber pool
+     */
+    void read_parallel(core::u64 offset, core::span<core::byte> output, core::fiber_pool* pool = nullptr) const;
+
+    /**
+     * @brief Decompresses the whole stream in parallel
+     */
+    [[nodiscard]]
+    core::vector<core::byte> read_all(core::fiber_pool* pool = nullptr) const;
+
+    /**
+     * @brief Gets the compressed bytes of the block
+     */
+    [[nodiscard]]
+    core::span<const core::byte> compressed_block(size_t block_index) const;
+
+    /**
+     * @brief Gets the uncompressed size of the block
+     */
+    [[nodiscard]]
+    size_t block_raw_size(size_t block_index) const {
+        return static_cast<size_t>(std::min<core::u64>(_block_size, _raw_size - block_index * _block_size));
+    }
+
+    [[nodiscard]]
+    core::u64 raw_size() const {
+        return _raw_size;
+    }
+
+    [[nodiscard]]
+    size_t block_size() const {
+        return _block_size;
+    }
+
+    [[nodiscard]]
+    size_t blocks_count() const {
+        return _blocks_count;
+    }
+
+    [[nodiscard]]
+    codec_id codec() const {
+        return _codec->id();
+    }
+
+private:
+    void check_range(core::u64 offset, size_t size) const;
+
+    /* Decompresses the part of the block which starts at the offset inside of the block */
+    void read_block(size_t block_index, size_t offset, core::span<core::byte> output) const;
+
+private:
+    core::span<const core::byte> _blocks;
+    core::span<const core::byte> _block_ends;
+    const util::codec*           _codec;
+    core::u64                    _raw_size;
+    size_t                       _block_size;
+    size_t                       _blocks_count;
+};
+} // namespace util
@@ -0,0 +1,602 @@
+#include "texture_decode.hpp"
+#include "bc7_tables.hpp"
+
+#include <core/fiber_pool.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define PE_TEXTURE_DECODE_X86
+#endif
+
+using namespace core;
+using namespace util;
+
+namespace
+{
+/* Blocks per job, small images are decoded in the calling thread */
+constexpr size_t min_blocks_per_job = 4096;
+constexpr size_t min_pixels_per_job = 65536;
+
+template <typename T>
+T load(const byte* p) {
+    T v; // NOLINT
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/* 5 and 6 bit channels are expanded by replicating high bits, so the maximum value is 255 */
+constexpr u8 expand5(u32 v) {
+    return static_cast<u8>((v << 3U) | (v >> 2U)); // NOLINT
+}
+
+constexpr u8 expand6(u32 v) {
+    return static_cast<u8>((v << 2U) | (v >> 4U)); // NOLINT
+}
+
+/* Color palette of the block as 4 RGBA colors */
+array<u8, 16> dxt_color_palette(const byte* color_block, bool four_colors_only, bool transparent) {
+    auto c0 = load<u16>(color_block);
+    auto c1 = load<u16>(color_block + 2);
+
+    array<u8, 16> p; // NOLINT
+    p[0] = expand5(c0 >> 11U); // NOLINT
+    p[1] = expand6((c0 >> 5U) & 63U); // NOLINT
+    p[2] = expand5(c0 & 31U); // NOLINT
+    p[3] = 255; // NOLINT
+    p[4] = expand5(c1 >> 11U); // NOLINT
+    p[5] = expand6((c1 >> 5U) & 63U); // NOLINT
+    p[6] = expand5(c1 & 31U); // NOLINT
+    p[7] = 255; // NOLINT
+
+    if (four_colors_only || c0 > c1) {
+        for (size_t i = 0; i < 3; ++i) {
+            p[8 + i]  = static_cast<u8>((2 * p[i] + p[4 + i]) / 3); // NOLINT
+            p[12 + i] = static_cast<u8>((p[i] + 2 * p[4 + i]) / 3); // NOLINT
+        }
+        p[11] = 255; // NOLINT
+        p[15] = 255; // NOLINT
+    }
+    else {
+        for (size_t i = 0; i < 3; ++i) {
+            p[8 + i]  = static_cast<u8>((p[i] + p[4 + i]) / 2); // NOLINT
+            p[12 + i] = 0; // NOLINT
+        }
+        p[11] = 255; // NOLINT
+        p[15] = transparent ? 0 : 255; // NOLINT
+    }
+
+    return p;
+}
+
+/* 8 alpha values of the DXT5 block */
+array<u8, 8> dxt5_alpha_palette(const byte* block) {
+    auto a0 = static_cast<u32>(block[0]);
+    auto a1 = static_cast<u32>(block[1]);
+
+    array<u8, 8> p; // NOLINT
+    p[0] = static_cast<u8>(a0);
+    p[1] = static_cast<u8>(a1);
+
+    if (a0 > a1) {
+        for (u32 i = 1; i < 7; ++i) // NOLINT
+            p[i + 1] = static_cast<u8>(((7 - i) * a0 + i * a1) / 7); // NOLINT
+    }
+    else {
+        for (u32 i = 1; i < 5; ++i) // NOLINT
+            p[i + 1] = static_cast<u8>(((5 - i) * a0 + i * a1) / 5); // NOLINT
+        p[6] = 0; // NOLINT
+        p[7] = 255; // NOLINT
+    }
+
+    return p;
+}
+
+/* 48 bits of 3-bit alpha indices */
+u64 dxt5_alpha_indices(const byte* block) {
+    u64 bits = 0;
+    std::memcpy(&bits, block + 2, 6); // NOLINT
+    return bits;
+}
+
+/* Reads fields of the BC7 block starting from the least significant bit */
+class bc7_reader {
+public:
+    bc7_reader(const byte* block): _lo(load<u64>(block)), _hi(load<u64>(block + 8)) {}
+
+    u32 read(u32 count) {
+        if (count == 0)
+            return 0;
+
+        auto bits = _pos >= 64 ? _hi >> (_pos - 64) : (_lo >> _pos) | (_pos ? _hi << (64 - _pos) : 0); // NOLINT
+        _pos += count;
+        return static_cast<u32>(bits & ((u64(1) << count) - 1));
+    }
+
+private:
+    u64 _lo;
+    u64 _hi;
+    u32 _pos = 0;
+};
+
+void decode_bc7_block(const byte* block, u8* rgba) {
+    auto first = static_cast<u32>(block[0]);
+    if (first == 0) {
+        /* Reserved mode is decoded as transparent black */
+        std::memset(rgba, 0, 64); // NOLINT
+        return;
+    }
+
+    auto  mode_index = static_cast<u32>(__builtin_ctz(first));
+    auto& mode       = bc7_details::modes[mode_index];
+
+    bc7_reader bits(block);
+    bits.read(mode_index + 1);
+
+    auto partition       = bits.read(mode.partition_bits);
+    auto rotation        = bits.read(mode.rotation_bits);
+    auto index_selection = bits.read(mode.index_selection_bits);
+
+    /* Components of all endpoints are stored channel by channel */
+    auto                    endpoints_count = mode.subsets * 2U;
+    array<array<u32, 4>, 6> endpoints{}; // NOLINT
+    for (u32 c = 0; c < 3; ++c)
+        for (u32 e = 0; e < endpoints_count; ++e)
+            endpoints[e][c] = bits.read(mode.color_bits);
+    for (u32 e = 0; e < endpoints_count; ++e)
+        endpoints[e][3] = bits.read(mode.alpha_bits);
+
+    auto color_bits = u32(mode.color_bits);
+    auto alpha_bits = u32(mode.alpha_bits);
+    if (mode.endpoint_pbits || mode.shared_pbits) {
+        array<u32, 6> pbits{}; // NOLINT
+        for (u32 e = 0; e < endpoints_count; ++e)
+            pbits[e] = mode.endpoint_pbits || e % 2 == 0 ? bits.read(1) : pbits[e - 1];
+
+        for (u32 e = 0; e < endpoints_count; ++e)
+            for (u32 c = 0; c < (alpha_bits ? 4U : 3U); ++c)
+                endpoints[e][c] = (endpoints[e][c] << 1U) | pbits[e];
+
+        ++color_bits;
+        alpha_bits += alpha_bits ? 1 : 0;
+    }
+
+    for (auto& endpoint : endpoints) {
+        for (u32 c = 0; c < 3; ++c)
+            endpoint[c] = bc7_details::expand(endpoint[c], color_bits);
+        endpoint[3] = alpha_bits ? bc7_details::expand(endpoint[3], alpha_bits) : 255; // NOLINT
+    }
+
+    array<u32, 16> indices{}; // NOLINT
+    array<u32, 16> indices2{}; // NOLINT
+    for (u32 i = 0; i < 16; ++i) // NOLINT
+        indices[i] = bits.read(mode.index_bits - (bc7_details::is_anchor(mode.subsets, partition, i) ? 1U : 0U));
+    if (mode.index2_bits)
+        for (u32 i = 0; i < 16; ++i) // NOLINT
+            indices2[i] = bits.read(mode.index2_bits - (i == 0 ? 1U : 0U));
+
+    auto weights  = bc7_details::weights(mode.index_bits);
+    auto weights2 = bc7_details::weights(mode.index2_bits);
+    for (u32 i = 0; i < 16; ++i) { // NOLINT
+        auto  subset = bc7_details::subset_of(mode.subsets, partition, i);
+        auto& e0     = endpoints[subset * 2];
+        auto& e1     = endpoints[subset * 2 + 1];
+
+        /* Modes 4 and 5 have separate alpha indices, the index selection bit swaps them */
+        auto color_weight = u32(weights[indices[i]]);
+        auto alpha_weight = color_weight;
+        if (mode.index2_bits) {
+            alpha_weight = weights2[indices2[i]];
+            if (index_selection)
+                std::swap(color_weight, alpha_weight);
+        }
+
+        auto out = rgba + i * 4;
+        for (u32 c = 0; c < 3; ++c)
+            out[c] = bc7_details::interpolate(e0[c], e1[c], color_weight);
+        out[3] = bc7_details::interpolate(e0[3], e1[3], alpha_weight);
+
+        if (rotation)
+            std::swap(out[3], out[rotation - 1]);
+    }
+}
+
+void decode_block(dxt_format format, const byte* block, u8* rgba) {
+    if (format == dxt_format::bc7) {
+        decode_bc7_block(block, rgba);
+        return;
+    }
+
+    auto color_block = format == dxt_format::dxt3 || format == dxt_format::dxt5 ? block + 8 : block;
+    auto palette     = dxt_color_palette(color_block,
+                                     format == dxt_format::dxt3 || format == dxt_format::dxt5,
+                                     format == dxt_format::dxt1_onebitalpha);
+    auto indices     = load<u32>(color_block + 4);
+
+    for (u32 i = 0; i < 16; ++i) // NOLINT
+        std::memcpy(rgba + i * 4, palette.data() + ((indices >> (i * 2)) & 3U) * 4, 4);
+
+    if (format == dxt_format::dxt3) {
+        auto alpha = load<u64>(block);
+        for (u32 i = 0; i < 16; ++i) // NOLINT
+            rgba[i * 4 + 3] = static_cast<u8>(((alpha >> (i * 4)) & 15U) * 17); // NOLINT
+    }
+    else if (format == dxt_format::dxt5) {
+        auto alpha   = dxt5_alpha_palette(block);
+        auto indices = dxt5_alpha_indices(block);
+        for (u32 i = 0; i < 16; ++i) // NOLINT
+            rgba[i * 4 + 3] = alpha[(indices >> (i * 3)) & 7U]; // NOLINT
+    }
+}
+
+/* Copies the part of decoded block which lies inside of the image */
+void write_clipped_block(const u8* rgba, u8* output, size_t pitch, size_t channels, vec2u block_size) {
+    for (u32 y = 0; y < block_size.y(); ++y) {
+        auto row = output + y * pitch;
+        for (u32 x = 0; x < block_size.x(); ++x)
+            std::memcpy(row + x * channels, rgba + (y * 4 + x) * 4, channels);
+    }
+}
+
+#ifdef PE_TEXTURE_DECODE_X86
+bool simd_supported() {
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+}
+
+/* Shuffle masks which select 4 colors of the palette by the row of 2-bit indices */
+template <size_t Channels>
+constexpr auto make_color_shuffles() {
+    array<array<u8, 16>, 256> masks{}; // NOLINT
+    for (u32 row = 0; row < 256; ++row) { // NOLINT
+        masks[row].fill(0x80); // NOLINT
+        for (u32 x = 0; x < 4; ++x)
+            for (u32 c = 0; c < Channels; ++c)
+                masks[row][x * Channels + c] = static_cast<u8>(((row >> (x * 2)) & 3U) * 4 + c); // NOLINT
+    }
+    return masks;
+}
+
+/* Four 3-bit alpha indices per 12-bit row */
+constexpr auto make_alpha_indices() {
+    array<u32, 4096> rows{}; // NOLINT
+    for (u32 row = 0; row < 4096; ++row) // NOLINT
+        for (u32 x = 0; x < 4; ++x)
+            rows[row] |= ((row >> (x * 3)) & 7U) << (x * 8); // NOLINT
+    return rows;
+}
+
+/* Moves alpha of the row (bytes 4 * row .. 4 * row + 3) into alpha channels */
+constexpr auto make_alpha_shuffles() {
+    array<array<u8, 16>, 4> masks{}; // NOLINT
+    for (u32 row = 0; row < 4; ++row) {
+        masks[row].fill(0x80); // NOLINT
+        for (u32 x = 0; x < 4; ++x)
+            masks[row][x * 4 + 3] = static_cast<u8>(row * 4 + x); // NOLINT
+    }
+    return masks;
+}
+
+alignas(16) constexpr auto rgba_shuffles  = make_color_shuffles<4>();
+alignas(16) constexpr auto rgb_shuffles   = make_color_shuffles<3>();
+alignas(16) constexpr auto alpha_indices  = make_alpha_indices();
+alignas(16) constexpr auto alpha_shuffles = make_alpha_shuffles();
+
+__attribute__((target("ssse3"))) inline __m128i load128(const void* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); // NOLINT
+}
+
+/* Swaps c0 and c1 of each block */
+__attribute__((target("ssse3"))) inline __m128i swap_pairs(__m128i v) {
+    constexpr int mask = _MM_SHUFFLE(2, 3, 0, 1); // NOLINT
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, mask), mask);
+}
+
+/*
+ * Palettes of four blocks at once
+ *
+ * 16-bit lanes hold c0 and c1 of blocks one after another, so interpolated colors are computed for all
+ * blocks with the same instructions: the lane of c0 gets c2 = (2 * c0 + c1) / 3, the lane of c1 gets
+ * c3 = (c0 + 2 * c1) / 3 (or (c0 + c1) / 2 and black for 3-color blocks)
+ */
+__attribute__((target("ssse3")))
+void color_palettes_ssse3(const byte* blocks, size_t stride, bool four_colors_only, bool transparent,
+                          __m128i* palettes) {
+    auto c = _mm_set_epi32(load<i32>(blocks + stride * 3),
+                           load<i32>(blocks + stride * 2),
+                           load<i32>(blocks + stride),
+                           load<i32>(blocks));
+
+    auto mask5 = _mm_set1_epi16(31); // NOLINT
+    auto r     = _mm_srli_epi16(c, 11); // NOLINT
+    auto g     = _mm_and_si128(_mm_srli_epi16(c, 5), _mm_set1_epi16(63)); // NOLINT
+    auto b     = _mm_and_si128(c, mask5);
+
+    r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2)); // NOLINT
+    g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4)); // NOLINT
+    b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2)); // NOLINT
+
+    /* x / 3 == (x * 0xAAAB) >> 17 for x < 2^16 */
+    auto div3 = _mm_set1_epi16(static_cast<short>(0xAAAB)); // NOLINT
+    auto four = [&](__m128i v) {
+        auto sum = _mm_add_epi16(_mm_add_epi16(v, v), swap_pairs(v));
+        return _mm_srli_epi16(_mm_mulhi_epu16(sum, div3), 1);
+    };
+
+    auto r23 = four(r);
+    auto g23 = four(g);
+    auto b23 = four(b);
+    auto a   = _mm_set1_epi16(255); // NOLINT
+    auto a23 = a;
+
+    if (!four_colors_only) {
+        /* c0 > c1 as unsigned, the result of c0 lane is broadcasted to c1 lane */
+        auto sign        = _mm_set1_epi16(static_cast<short>(0x8000)); // NOLINT
+        auto greater     = _mm_cmpgt_epi16(_mm_xor_si128(c, sign), _mm_xor_si128(swap_pairs(c), sign));
+        constexpr int bc = _MM_SHUFFLE(2, 2, 0, 0); // NOLINT
+        auto four_mask   = _mm_shufflehi_epi16(_mm_shufflelo_epi16(greater, bc), bc);
+        auto c0_lanes    = _mm_set1_epi32(0xFFFF); // NOLINT
+
+        auto three = [&](__m128i v4, __m128i v) {
+            auto half = _mm_and_si128(_mm_srli_epi16(_mm_add_epi16(v, swap_pairs(v)), 1), c0_lanes);
+            return _mm_or_si128(_mm_and_si128(four_mask, v4), _mm_andnot_si128(four_mask, half));
+        };
+
+        r23 = three(r23, r);
+        g23 = three(g23, g);
+        b23 = three(b23, b);
+
+        if (transparent)
+            a23 = _mm_or_si128(_mm_and_si128(a, c0_lanes), _mm_and_si128(a, four_mask));
+    }
+
+    auto rg01 = _mm_or_si128(r, _mm_slli_epi16(g, 8)); // NOLINT
+    auto ba01 = _mm_or_si128(b, _mm_slli_epi16(a, 8)); // NOLINT
+    auto rg23 = _mm_or_si128(r23, _mm_slli_epi16(g23, 8)); // NOLINT
+    auto ba23 = _mm_or_si128(b23, _mm_slli_epi16(a23, 8)); // NOLINT
+
+    auto lo01 = _mm_unpacklo_epi16(rg01, ba01);
+    auto hi01 = _mm_unpackhi_epi16(rg01, ba01);
+    auto lo23 = _mm_unpacklo_epi16(rg23, ba23);
+    auto hi23 = _mm_unpackhi_epi16(rg23, ba23);
+
+    palettes[0] = _mm_unpacklo_epi64(lo01, lo23);
+    palettes[1] = _mm_unpackhi_epi64(lo01, lo23);
+    palettes[2] = _mm_unpacklo_epi64(hi01, hi23);
+    palettes[3] = _mm_unpackhi_epi64(hi01, hi23);
+}
+
+/* 16 alpha values of the block in pixel order */
+__attribute__((target("ssse3"))) __m128i block_alpha_ssse3(dxt_format format, const byte* block) {
+    if (format == dxt_format::dxt3) {
+        auto v  = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(block)); // NOLINT
+        auto lo = _mm_and_si128(v, _mm_set1_epi8(15)); // NOLINT
+        auto hi = _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(15)); // NOLINT
+        auto n  = _mm_unpacklo_epi8(lo, hi);
+        return _mm_or_si128(n, _mm_slli_epi16(n, 4)); // NOLINT
+    }
+
+    auto palette = dxt5_alpha_palette(block);
+    auto bits    = dxt5_alpha_indices(block);
+    auto indices = _mm_set_epi32(static_cast<i32>(alpha_indices[(bits >> 36U) & 0xFFFU]), // NOLINT
+                                 static_cast<i32>(alpha_indices[(bits >> 24U) & 0xFFFU]), // NOLINT
+                                 static_cast<i32>(alpha_indices[(bits >> 12U) & 0xFFFU]), // NOLINT
+                                 static_cast<i32>(alpha_indices[bits & 0xFFFU])); // NOLINT
+    return _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(palette.data())), indices); // NOLINT
+}
+
+/* Decodes four consecutive blocks which lie inside of the image */
+template <size_t Channels>
+__attribute__((target("ssse3")))
+void decode_four_blocks_ssse3(dxt_format format, const byte* blocks, u8* output, size_t pitch) {
+    auto has_alpha   = format == dxt_format::dxt3 || format == dxt_format::dxt5;
+    auto stride      = dxt_block_size(format);
+    auto color_start = has_alpha ? blocks + 8 : blocks;
+
+    __m128i palettes[4]; // NOLINT
+    color_palettes_ssse3(color_start, stride, has_alpha, format == dxt_format::dxt1_onebitalpha, palettes);
+
+    for (size_t i = 0; i < 4; ++i) {
+        auto block   = blocks + i * stride;
+        auto indices = load<u32>(block + (has_alpha ? 12 : 4)); // NOLINT
+        auto out     = output + i * 4 * Channels;
+
+        __m128i alpha = _mm_setzero_si128();
+        if (Channels == 4 && has_alpha)
+            alpha = block_alpha_ssse3(format, block);
+
+        for (u32 y = 0; y < 4; ++y) {
+            auto row = (indices >> (y * 8)) & 0xFFU; // NOLINT
+
+            if constexpr (Channels == 4) {
+                auto pixels = _mm_shuffle_epi8(palettes[i], load128(rgba_shuffles[row].data()));
+                if (has_alpha) {
+                    auto a = _mm_shuffle_epi8(alpha, load128(alpha_shuffles[y].data()));
+                    pixels = _mm_or_si128(_mm_and_si128(pixels, _mm_set1_epi32(0x00FFFFFF)), a); // NOLINT
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + y * pitch), pixels); // NOLINT
+            }
+            else {
+                /* 12 bytes are stored, the rest of the row may be already written by the next block row */
+                auto pixels = _mm_shuffle_epi8(palettes[i], load128(rgb_shuffles[row].data()));
+                auto tail   = _mm_cvtsi128_si32(_mm_srli_si128(pixels, 8)); // NOLINT
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out + y * pitch), pixels); // NOLINT
+                std::memcpy(out + y * pitch + 8, &tail, 4); // NOLINT
+            }
+        }
+    }
+}
+
+/* 8 pixels of 16-bit formats or 4 pixels of BGRX8888 per iteration, returns the count of decoded pixels */
+__attribute__((target("ssse3")))
+size_t decode_packed_ssse3(packed_pixel_format format, const byte* data, size_t count, u8* output) {
+    size_t i = 0;
+
+    switch (format) {
+    case packed_pixel_format::bgra4444: {
+        auto swap_rb = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15); // NOLINT
+        auto low     = _mm_set1_epi8(15); // NOLINT
+        for (; i + 8 <= count; i += 8) { // NOLINT
+            auto v  = load128(data + i * 2);
+            auto l  = _mm_and_si128(v, low);
+            auto h  = _mm_and_si128(_mm_srli_epi16(v, 4), low); // NOLINT
+            auto lo = _mm_shuffle_epi8(_mm_unpacklo_epi8(l, h), swap_rb);
+            auto hi = _mm_shuffle_epi8(_mm_unpackhi_epi8(l, h), swap_rb);
+            lo      = _mm_or_si128(lo, _mm_slli_epi16(lo, 4)); // NOLINT
+            hi      = _mm_or_si128(hi, _mm_slli_epi16(hi, 4)); // NOLINT
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4), lo); // NOLINT
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4 + 16), hi); // NOLINT
+        }
+    } break;
+    case packed_pixel_format::bgra5551:
+    case packed_pixel_format::bgrx5551: {
+        auto mask5  = _mm_set1_epi16(31); // NOLINT
+        auto opaque = _mm_set1_epi16(format == packed_pixel_format::bgrx5551 ? 255 : 0); // NOLINT
+        for (; i + 8 <= count; i += 8) { // NOLINT
+            auto v = load128(data + i * 2);
+            auto b = _mm_and_si128(v, mask5);
+            auto g = _mm_and_si128(_mm_srli_epi16(v, 5), mask5); // NOLINT
+            auto r = _mm_and_si128(_mm_srli_epi16(v, 10), mask5); // NOLINT
+            auto a = _mm_or_si128(_mm_srli_epi16(_mm_srai_epi16(v, 15), 8), opaque); // NOLINT
+            b      = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2)); // NOLINT
+            g      = _mm_or_si128(_mm_slli_epi16(g, 3), _mm_srli_epi16(g, 2)); // NOLINT
+            r      = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2)); // NOLINT
+
+            auto rg = _mm_or_si128(r, _mm_slli_epi16(g, 8)); // NOLINT
+            auto ba = _mm_or_si128(b, _mm_slli_epi16(a, 8)); // NOLINT
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4), _mm_unpacklo_epi16(rg, ba)); // NOLINT
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4 + 16), _mm_unpackhi_epi16(rg, ba)); // NOLINT
+        }
+    } break;
+    case packed_pixel_format::bgrx8888: {
+        auto swap_rb = _mm_setr_epi8(2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12, -1); // NOLINT
+        auto opaque  = _mm_set1_epi32(static_cast<i32>(0xFF000000)); // NOLINT
+        for (; i + 4 <= count; i += 4) {
+            auto v = _mm_or_si128(_mm_shuffle_epi8(load128(data + i * 4), swap_rb), opaque);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4), v); // NOLINT
+        }
+    } break;
+    }
+
+    return i;
+}
+#endif
+
+void decode_packed_scalar(packed_pixel_format format, const byte* data, size_t count, u8* output) {
+    for (size_t i = 0; i < count; ++i) {
+        auto out = output + i * 4;
+
+        switch (format) {
+        case packed_pixel_format::bgra4444: {
+            auto v = load<u16>(data + i * 2);
+            out[0] = static_cast<u8>(((v >> 8U) & 15U) * 17); // NOLINT
+            out[1] = static_cast<u8>(((v >> 4U) & 15U) * 17); // NOLINT
+            out[2] = static_cast<u8>((v & 15U) * 17); // NOLINT
+            out[3] = static_cast<u8>((v >> 12U) * 17); // NOLINT
+        } break;
+        case packed_pixel_format::bgra5551:
+        case packed_pixel_format::bgrx5551: {
+            auto v = load<u16>(data + i * 2);
+            out[0] = expand5((v >> 10U) & 31U); // NOLINT
+            out[1] = expand5((v >> 5U) & 31U); // NOLINT
+            out[2] = expand5(v & 31U); // NOLINT
+            out[3] = format == packed_pixel_format::bgrx5551 || (v >> 15U) ? 255 : 0; // NOLINT
+        } break;
+        case packed_pixel_format::bgrx8888:
+            out[0] = static_cast<u8>(data[i * 4 + 2]);
+            out[1] = static_cast<u8>(data[i * 4 + 1]);
+            out[2] = static_cast<u8>(data[i * 4]);
+            out[3] = 255; // NOLINT
+            break;
+        }
+    }
+}
+
+void dxt_decode_rows(dxt_format format,
+                     const byte* data,
+                     vec2u       size,
+                     u8*         output,
+                     size_t      channels,
+                     size_t      row_begin,
+                     size_t      row_end) {
+    auto blocks     = dxt_blocks_count(size);
+    auto block_size = dxt_block_size(format);
+    auto pitch      = size_t(size.x()) * channels;
+
+    for (size_t by = row_begin; by < row_end; ++by) {
+        auto src       = data + by * blocks.x() * block_size;
+        auto out       = output + by * 4 * pitch;
+        auto full_row  = by * 4 + 4 <= size.y();
+        auto full_cols = full_row ? size.x() / 4 : 0;
+        size_t bx      = 0;
+
+#ifdef PE_TEXTURE_DECODE_X86
+        if (simd_supported() && format != dxt_format::bc7) {
+            for (; bx + 4 <= full_cols; bx += 4) {
+                if (channels == 4)
+                    decode_four_blocks_ssse3<4>(format, src + bx * block_size, out + bx * 4 * channels, pitch);
+                else
+                    decode_four_blocks_ssse3<3>(format, src + bx * block_size, out + bx * 4 * channels, pitch);
+            }
+        }
+#endif
+
+        array<u8, 64> rgba; // NOLINT
+        for (; bx < blocks.x(); ++bx) {
+            decode_block(format, src + bx * block_size, rgba.data());
+            auto clip = vec2u{std::min(4U, size.x() - static_cast<u32>(bx) * 4),
+                              std::min(4U, size.y() - static_cast<u32>(by) * 4)};
+            write_clipped_block(rgba.data(), out + bx * 4 * channels, pitch, channels, clip);
+        }
+    }
+}
+} // namespace
+
+namespace util
+{
+void dxt_decode_block(dxt_format format, const byte* block, u8* rgba) {
+    decode_block(format, block, rgba);
+}
+
+void dxt_decode(dxt_format format, span<const byte> data, vec2u size, u8* output, size_t channels, fiber_pool* pool) {
+    if (channels != 3 && channels != 4)
+        pe_throw std::runtime_error("dxt_decode: output must have 3 or 4 channels");
+
+    if (static_cast<size_t>(data.size()) < dxt_data_size(format, size))
+        pe_throw std::runtime_error("dxt_decode: data size is less than the image requires");
+
+    auto blocks = dxt_blocks_count(size);
+    if (blocks.x() == 0 || blocks.y() == 0)
+        return;
+
+    parallel_for(
+        blocks.y(),
+        std::max<size_t>(min_blocks_per_job / blocks.x(), 1),
+        [&](size_t begin, size_t end) { dxt_decode_rows(format, data.data(), size, output, channels, begin, end); },
+        pool);
+}
+
+void decode_packed_pixels(packed_pixel_format format,
+                          span<const byte>    data,
+                          size_t              count,
+                          u8*                 output,
+                          fiber_pool*         pool) {
+    auto pixel_size = packed_pixel_size(format);
+    if (static_cast<size_t>(data.size()) < count * pixel_size)
+        pe_throw std::runtime_error("decode_packed_pixels: data size is less than the count of pixels requires");
+
+    parallel_for(
+        count,
+        min_pixels_per_job,
+        [&](size_t begin, size_t end) {
+            auto src = data.data() + begin * pixel_size;
+            auto out = output + begin * 4;
+            size_t i = 0;
+#ifdef PE_TEXTURE_DECODE_X86
+            if (simd_supported())
+                i = decode_packed_ssse3(format, src, end - begin, out);
+#endif
+            decode_packed_scalar(format, src + i * pixel_size, end - begin - i, out + i * 4);
+        },
+        pool);
+}
+} // namespace util
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <core/vec.hpp>
+
+namespace core {
+    class fiber_pool;
+}
+
+namespace util
+{
+/**
+ * @brief Block compression formats (DXT1 - BC1, DXT3 - BC2, DXT5 - BC3, BC7 - BPTC)
+ */
+enum class dxt_format : core::u8 {
+    dxt1 = 0,         /* Opaque, the transparent color of 3-color blocks is decoded as black */
+    dxt1_onebitalpha, /* The transparent color of 3-color blocks has zero alpha */
+    dxt3,             /* Explicit 4-bit alpha */
+    dxt5,             /* Interpolated 8-bit alpha */
+    bc7,              /* RGBA with up to three subsets per block and 8 block modes */
+};
+
+/**
+ * @brief Pixel formats with packed channels
+ *
+ * Channels are listed from the least significant bits (BGRA4444 has blue in bits 0-3)
+ */
+enum class packed_pixel_format : core::u8 {
+    bgra4444 = 0,
+    bgra5551,
+    bgrx5551,
+    bgrx8888,
+};
+
+constexpr size_t dxt_block_size(dxt_format format) {
+    return format == dxt_format::dxt1 || format == dxt_format::dxt1_onebitalpha ? 8 : 16; // NOLINT
+}
+
+/**
+ * @brief Gets the count of 4x4 blocks which cover the image, partial blocks are counted
+ */
+inline core::vec2u dxt_blocks_count(core::vec2u size) {
+    return {(size.x() + 3) / 4, (size.y() + 3) / 4};
+}
+
+inline size_t dxt_data_size(dxt_format format, core::vec2u size) {
+    auto blocks = dxt_blocks_count(size);
+    return size_t(blocks.x()) * blocks.y() * dxt_block_size(format);
+}
+
+constexpr size_t packed_pixel_size(packed_pixel_format format) {
+    return format == packed_pixel_format::bgrx8888 ? 4 : 2;
+}
+
+/**
+ * @brief Decodes one block into 16 RGBA pixels
+ *
+ * This is the reference decoder, the block is decoded without SIMD
+ *
+ * @param format - the block format
+ * @param block - the block data (dxt_block_size(format) bytes)
+ * @param rgba - the output, 4 rows of 4 RGBA pixels
+ */
+void dxt_decode_block(dxt_format format, const core::byte* block, core::u8* rgba);
+
+/**
+ * @brief Decodes the block compressed image
+ *
+ * Rows of four DXT blocks are decoded with SSSE3 when the CPU supports it, BC7 blocks are decoded one by one.
+ * Block rows are split between jobs of the fiber pool. Partial blocks on the right and bottom edges are clipped
+ *
+ * @throw runtime_error if the data is smaller than dxt_data_size(format, size)
+ *
+ * @param format - the block format
+ * @param data - blocks in row-major order
+ * @param size - the image size in pixels
+ * @param output - size.x() * size.y() * channels bytes
+ * @param channels - 3 for RGB output (alpha is dropped) or 4 for RGBA output
+ * @param pool - the fiber pool which runs decoding jobs, nullptr - the global fiber pool
+ */
+void dxt_decode(dxt_format                   format,
+                core::span<const core::byte> data,
+                core::vec2u                  size,
+                core::u8*                    output,
+                size_t                       channels = 4,
+                core::fiber_pool*            pool     = nullptr);
+
+/**
+ * @brief Decodes packed pixels into RGBA
+ *
+ * Formats without alpha are decoded with opaque alpha
+ *
+ * @throw runtime_error if the data is smaller than count * packed_pixel_size(format)
+ *
+ * @param format - the pixel format
+ * @param data - pixel data
+ * @param count - the count of pixels
+ * @param output - count * 4 bytes
+ * @param pool - the fiber pool which runs decoding jobs, nullptr - the global fiber pool
+ */
+void decode_packed_pixels(packed_pixel_format          format,
+                          core::span<const core::byte> data,
+                          size_t                       count,
+                          core::u8*                    output,
+                          core::fiber_pool*            pool = nullptr);
+} // namespace util
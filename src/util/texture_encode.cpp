@@ -0,0 +1,1011 @@
+#include "texture_encode.hpp"
+#include "bc7_tables.hpp"
+
+#include <core/fiber_pool.hpp>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define PE_TEXTURE_ENCODE_X86
+#endif
+
+using namespace core;
+using namespace util;
+
+namespace
+{
+/* Blocks per job, encoding is much slower than decoding so jobs are smaller */
+constexpr size_t min_blocks_per_job = 256;
+
+/* Least squares iterations of the high quality mode */
+constexpr size_t refine_iterations = 4;
+
+/* Two-subset partitions of BC7 mode 1 which are fitted completely (the rest are rejected by the estimation) */
+constexpr size_t bc7_partition_candidates = 4;
+
+template <typename T>
+void store(byte* p, T v) {
+    std::memcpy(p, &v, sizeof(v));
+}
+
+constexpr u8 expand5(u32 v) {
+    return static_cast<u8>((v << 3U) | (v >> 2U)); // NOLINT
+}
+
+constexpr u8 expand6(u32 v) {
+    return static_cast<u8>((v << 2U) | (v >> 4U)); // NOLINT
+}
+
+u16 pack565(const array<float, 3>& color) {
+    auto quantize = [](float v, float max) {
+        return static_cast<u32>(std::lround(std::clamp(v, 0.f, 255.f) * max / 255.f));
+    };
+    return static_cast<u16>((quantize(color[0], 31.f) << 11U) | (quantize(color[1], 63.f) << 5U) | // NOLINT
+                            quantize(color[2], 31.f)); // NOLINT
+}
+
+/* The palette as the decoder computes it, 4 RGBA colors with zero alpha */
+array<u8, 16> color_palette(u16 c0, u16 c1, bool four_colors) {
+    array<u8, 16> p = {}; // NOLINT
+    p[0] = expand5(u32(c0) >> 11U); // NOLINT
+    p[1] = expand6((u32(c0) >> 5U) & 63U); // NOLINT
+    p[2] = expand5(u32(c0) & 31U); // NOLINT
+    p[4] = expand5(u32(c1) >> 11U); // NOLINT
+    p[5] = expand6((u32(c1) >> 5U) & 63U); // NOLINT
+    p[6] = expand5(u32(c1) & 31U); // NOLINT
+
+    for (size_t i = 0; i < 3; ++i) {
+        if (four_colors) {
+            p[8 + i]  = static_cast<u8>((2 * p[i] + p[4 + i]) / 3); // NOLINT
+            p[12 + i] = static_cast<u8>((p[i] + 2 * p[4 + i]) / 3); // NOLINT
+        }
+        else {
+            p[8 + i] = static_cast<u8>((p[i] + p[4 + i]) / 2); // NOLINT
+        }
+    }
+    return p;
+}
+
+/* Pixels of the block and which of them are encoded as transparent (DXT1 with one bit alpha only) */
+struct color_block {
+    const u8* rgba;
+    u32       transparent_mask;
+};
+
+struct color_fit {
+    u16 c0      = 0;
+    u16 c1      = 0;
+    u32 indices = 0;
+    u32 error   = numlim<u32>::max();
+};
+
+u32 distance(const u8* a, const u8* b) {
+    u32 result = 0;
+    for (size_t i = 0; i < 3; ++i) {
+        auto d = int(a[i]) - int(b[i]);
+        result += u32(d * d);
+    }
+    return result;
+}
+
+/* Selects indices among colors_count palette colors, transparent pixels get index 3 */
+void fit_indices_scalar(const color_block& block, const array<u8, 16>& palette, u32 colors_count, color_fit& fit) {
+    fit.indices = 0;
+    fit.error   = 0;
+    for (u32 i = 0; i < 16; ++i) {
+        if (block.transparent_mask & (1U << i)) {
+            fit.indices |= 3U << (i * 2);
+            continue;
+        }
+
+        u32 best       = 0;
+        u32 best_error = numlim<u32>::max();
+        for (u32 c = 0; c < colors_count; ++c) {
+            auto error = distance(block.rgba + i * 4, palette.data() + c * 4);
+            if (error < best_error) {
+                best_error = error;
+                best       = c;
+            }
+        }
+        fit.indices |= best << (i * 2);
+        fit.error += best_error;
+    }
+}
+
+#ifdef PE_TEXTURE_ENCODE_X86
+bool simd_supported() {
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+}
+
+/* Moves bit i to bit 2 * i */
+constexpr array<u32, 16> spread_bits = {0, 1, 4, 5, 16, 17, 20, 21, 64, 65, 68, 69, 80, 81, 84, 85};
+
+/* Squared RGB distances of 4 pixels to the color, alpha must be masked out of both */
+__attribute__((target("ssse3"))) inline __m128i distances_ssse3(__m128i pixels, __m128i color) {
+    auto zero = _mm_setzero_si128();
+    auto lo   = _mm_sub_epi16(_mm_unpacklo_epi8(pixels, zero), _mm_unpacklo_epi8(color, zero));
+    auto hi   = _mm_sub_epi16(_mm_unpackhi_epi8(pixels, zero), _mm_unpackhi_epi8(color, zero));
+    return _mm_hadd_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi));
+}
+
+/* Selects indices among 4 palette colors for all 16 opaque pixels */
+__attribute__((target("ssse3"))) void fit_indices_ssse3(const u8* rgba, const array<u8, 16>& palette, color_fit& fit) {
+    auto rgb_mask = _mm_set1_epi32(0x00ffffff); // NOLINT
+    __m128i colors[4]; // NOLINT
+    for (int c = 0; c < 4; ++c) {
+        u32 color; // NOLINT
+        std::memcpy(&color, palette.data() + c * 4, sizeof(color));
+        colors[c] = _mm_and_si128(_mm_set1_epi32(int(color)), rgb_mask);
+    }
+
+    auto errors  = _mm_setzero_si128();
+    u32  indices = 0;
+    for (int row = 0; row < 4; ++row) {
+        auto pixels = _mm_and_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + row * 16)), rgb_mask); // NOLINT
+
+        auto best_error = distances_ssse3(pixels, colors[0]);
+        auto best_index = _mm_setzero_si128();
+        for (int c = 1; c < 4; ++c) {
+            auto error  = distances_ssse3(pixels, colors[c]);
+            auto better = _mm_cmplt_epi32(error, best_error);
+            best_error  = _mm_or_si128(_mm_and_si128(better, error), _mm_andnot_si128(better, best_error));
+            best_index  = _mm_or_si128(_mm_and_si128(better, _mm_set1_epi32(c)), _mm_andnot_si128(better, best_index));
+        }
+
+        /* Low and high bits of 4 indices are gathered with movemask, then interleaved: pixel i goes to bits 2 * i */
+        auto low  = u32(_mm_movemask_ps(_mm_castsi128_ps(_mm_slli_epi32(best_index, 31)))); // NOLINT
+        auto high = u32(_mm_movemask_ps(_mm_castsi128_ps(_mm_slli_epi32(best_index, 30)))); // NOLINT
+        indices |= (spread_bits[low] | (spread_bits[high] << 1U)) << (u32(row) * 8); // NOLINT
+
+        errors = _mm_add_epi32(errors, best_error);
+    }
+
+    errors = _mm_add_epi32(errors, _mm_shuffle_epi32(errors, _MM_SHUFFLE(1, 0, 3, 2))); // NOLINT
+    errors = _mm_add_epi32(errors, _mm_shuffle_epi32(errors, _MM_SHUFFLE(2, 3, 0, 1))); // NOLINT
+
+    fit.indices = indices;
+    fit.error   = u32(_mm_cvtsi128_si32(errors));
+}
+#endif
+
+/* Computes the palette of endpoints and selects indices, the mode is defined by the order of endpoints */
+void evaluate_endpoints(const color_block& block, color_fit& fit) {
+    auto four_colors = fit.c0 > fit.c1;
+    auto palette     = color_palette(fit.c0, fit.c1, four_colors || !block.transparent_mask);
+
+#ifdef PE_TEXTURE_ENCODE_X86
+    if (four_colors && !block.transparent_mask && simd_supported()) {
+        fit_indices_ssse3(block.rgba, palette, fit);
+        return;
+    }
+#endif
+
+    fit_indices_scalar(block, palette, four_colors ? 4 : 3, fit);
+}
+
+/* Orders endpoints for the mode: c0 > c1 selects 4 colors, c0 <= c1 selects 3 colors with transparency */
+color_fit make_fit(const color_block& block, u16 a, u16 b) {
+    color_fit fit;
+    auto      three_colors = block.transparent_mask != 0;
+
+    if (three_colors) {
+        fit.c0 = std::min(a, b);
+        fit.c1 = std::max(a, b);
+    }
+    else if (a == b) {
+        /* Single color: indices are all zero, so both modes decode the same colors */
+        fit.c0 = a;
+        fit.c1 = b;
+        fit.indices = 0;
+        fit.error   = 0;
+        auto palette = color_palette(a, b, true);
+        for (u32 i = 0; i < 16; ++i)
+            fit.error += distance(block.rgba + i * 4, palette.data());
+        return fit;
+    }
+    else {
+        fit.c0 = std::max(a, b);
+        fit.c1 = std::min(a, b);
+    }
+
+    evaluate_endpoints(block, fit);
+    return fit;
+}
+
+/* Endpoints minimizing the squared error for the given indices */
+bool least_squares_endpoints(const color_block& block, const color_fit& fit, array<float, 3>& e0, array<float, 3>& e1) {
+    auto four_colors = fit.c0 > fit.c1 || !block.transparent_mask;
+
+    /* Weights of the first endpoint for indices */
+    constexpr array<float, 4> four_weights  = {1.f, 0.f, 2.f / 3.f, 1.f / 3.f};
+    constexpr array<float, 4> three_weights = {1.f, 0.f, 0.5f, 0.f};
+
+    float aa = 0.f, ab = 0.f, bb = 0.f;
+    array<float, 3> ax = {}, bx = {};
+    for (u32 i = 0; i < 16; ++i) {
+        if (block.transparent_mask & (1U << i))
+            continue;
+
+        auto index = (fit.indices >> (i * 2)) & 3U;
+        auto a     = four_colors ? four_weights[index] : three_weights[index];
+        auto b     = 1.f - a;
+
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (size_t c = 0; c < 3; ++c) {
+            ax[c] += a * float(block.rgba[i * 4 + c]);
+            bx[c] += b * float(block.rgba[i * 4 + c]);
+        }
+    }
+
+    auto det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f) // NOLINT
+        return false;
+
+    for (size_t c = 0; c < 3; ++c) {
+        e0[c] = (ax[c] * bb - bx[c] * ab) / det;
+        e1[c] = (bx[c] * aa - ax[c] * ab) / det;
+    }
+    return true;
+}
+
+color_fit fit_colors(const color_block& block, dxt_encode_quality quality) {
+    /* Mean and covariance of encoded pixels */
+    array<float, 3> mean  = {};
+    u32             count = 0;
+    for (u32 i = 0; i < 16; ++i) {
+        if (block.transparent_mask & (1U << i))
+            continue;
+        for (size_t c = 0; c < 3; ++c)
+            mean[c] += float(block.rgba[i * 4 + c]);
+        ++count;
+    }
+
+    if (count == 0) {
+        color_fit fit;
+        fit.indices = numlim<u32>::max();
+        fit.error   = 0;
+        return fit;
+    }
+
+    for (auto& m : mean)
+        m /= float(count);
+
+    array<float, 6> cov = {}; // NOLINT
+    for (u32 i = 0; i < 16; ++i) {
+        if (block.transparent_mask & (1U << i))
+            continue;
+        auto r = float(block.rgba[i * 4]) - mean[0];
+        auto g = float(block.rgba[i * 4 + 1]) - mean[1];
+        auto b = float(block.rgba[i * 4 + 2]) - mean[2];
+        cov[0] += r * r;
+        cov[1] += r * g;
+        cov[2] += r * b;
+        cov[3] += g * g;
+        cov[4] += g * b;
+        cov[5] += b * b; // NOLINT
+    }
+
+    /* The principal axis with power iterations */
+    array<float, 3> axis = {1.f, 1.f, 1.f};
+    for (size_t it = 0; it < 8; ++it) { // NOLINT
+        array<float, 3> next = {cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+                                cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+                                cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]}; // NOLINT
+        auto norm = std::max({std::fabs(next[0]), std::fabs(next[1]), std::fabs(next[2])});
+        if (norm < 1e-6f) // NOLINT
+            break;
+        for (size_t c = 0; c < 3; ++c)
+            axis[c] = next[c] / norm;
+    }
+
+    /* Extreme pixels along the axis */
+    float min_proj = numlim<float>::max(), max_proj = numlim<float>::lowest();
+    for (u32 i = 0; i < 16; ++i) {
+        if (block.transparent_mask & (1U << i))
+            continue;
+        float proj = 0.f;
+        for (size_t c = 0; c < 3; ++c)
+            proj += (float(block.rgba[i * 4 + c]) - mean[c]) * axis[c];
+        min_proj = std::min(min_proj, proj);
+        max_proj = std::max(max_proj, proj);
+    }
+
+    auto axis_norm = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    array<float, 3> e0 = mean, e1 = mean;
+    if (axis_norm > 1e-6f) { // NOLINT
+        for (size_t c = 0; c < 3; ++c) {
+            e0[c] += axis[c] * max_proj / axis_norm;
+            e1[c] += axis[c] * min_proj / axis_norm;
+        }
+    }
+
+    auto best = make_fit(block, pack565(e0), pack565(e1));
+    if (quality == dxt_encode_quality::fast || best.error == 0)
+        return best;
+
+    /* Refine endpoints while the error decreases */
+    for (size_t it = 0; it < refine_iterations; ++it) {
+        if (!least_squares_endpoints(block, best, e0, e1))
+            break;
+
+        auto fit = make_fit(block, pack565(e0), pack565(e1));
+        if (fit.error >= best.error)
+            break;
+        best = fit;
+    }
+
+    return best;
+}
+
+void encode_color(const color_block& block, byte* output, dxt_encode_quality quality) {
+    auto fit = fit_colors(block, quality);
+    store(output, fit.c0);
+    store(output + 2, fit.c1);
+    store(output + 4, fit.indices);
+}
+
+void encode_dxt3_alpha(const u8* rgba, byte* output) {
+    u64 bits = 0;
+    for (u32 i = 0; i < 16; ++i)
+        bits |= u64((u32(rgba[i * 4 + 3]) * 15 + 127) / 255) << (i * 4); // NOLINT
+    store(output, bits);
+}
+
+/* Returns the squared error, indices are written to bits */
+u32 fit_dxt5_alpha(const u8* rgba, u8 a0, u8 a1, u64& bits) {
+    array<u32, 8> palette = {a0, a1}; // NOLINT
+    if (a0 > a1) {
+        for (u32 i = 2; i < 8; ++i) // NOLINT
+            palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7; // NOLINT
+    }
+    else {
+        for (u32 i = 2; i < 6; ++i) // NOLINT
+            palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5; // NOLINT
+        palette[6] = 0;   // NOLINT
+        palette[7] = 255; // NOLINT
+    }
+
+    bits       = 0;
+    u32 errors = 0;
+    for (u32 i = 0; i < 16; ++i) {
+        auto a          = int(rgba[i * 4 + 3]);
+        u32  best       = 0;
+        u32  best_error = numlim<u32>::max();
+        for (u32 c = 0; c < 8; ++c) { // NOLINT
+            auto d     = a - int(palette[c]);
+            auto error = u32(d * d);
+            if (error < best_error) {
+                best_error = error;
+                best       = c;
+            }
+        }
+        bits |= u64(best) << (i * 3);
+        errors += best_error;
+    }
+    return errors;
+}
+
+void encode_dxt5_alpha(const u8* rgba, byte* output, dxt_encode_quality quality) {
+    u8 min_alpha = 255, max_alpha = 0;             // NOLINT
+    u8 min_inner = 255, max_inner = 0;             // NOLINT
+    for (u32 i = 0; i < 16; ++i) {
+        auto a    = rgba[i * 4 + 3];
+        min_alpha = std::min(min_alpha, a);
+        max_alpha = std::max(max_alpha, a);
+        if (a != 0 && a != 255) { // NOLINT
+            min_inner = std::min(min_inner, a);
+            max_inner = std::max(max_inner, a);
+        }
+    }
+
+    u64 bits = 0;
+    u8  a0   = max_alpha;
+    u8  a1   = min_alpha;
+    if (a0 == a1) {
+        /* All indices select a0 */
+    }
+    else {
+        auto error = fit_dxt5_alpha(rgba, a0, a1, bits);
+
+        /* 6 interpolated values with explicit 0 and 255 fit blocks with a few fully (non)transparent pixels */
+        if (quality == dxt_encode_quality::high && error != 0) {
+            if (min_inner > max_inner) {
+                min_inner = min_alpha;
+                max_inner = min_alpha;
+            }
+
+            u64  six_bits  = 0;
+            auto six_error = fit_dxt5_alpha(rgba, min_inner, max_inner, six_bits);
+            if (six_error < error) {
+                a0   = min_inner;
+                a1   = max_inner;
+                bits = six_bits;
+            }
+        }
+    }
+
+    store(output, a0);
+    store(output + 1, a1);
+    std::memcpy(output + 2, &bits, 6); // NOLINT
+}
+
+/*================ BC7 */
+
+/* Writes fields of the BC7 block starting from the least significant bit */
+class bc7_writer {
+public:
+    void write(u32 value, u32 count) {
+        if (_pos < 64) {
+            _lo |= u64(value) << _pos;
+            if (_pos + count > 64)
+                _hi |= u64(value) >> (64 - _pos); // NOLINT
+        }
+        else {
+            _hi |= u64(value) << (_pos - 64); // NOLINT
+        }
+        _pos += count;
+    }
+
+    void store(byte* output) const {
+        ::store(output, _lo);
+        ::store(output + 8, _hi); // NOLINT
+    }
+
+private:
+    u64 _lo  = 0;
+    u64 _hi  = 0;
+    u32 _pos = 0;
+};
+
+/* Endpoints and indices of one subset */
+struct bc7_subset_fit {
+    array<array<u32, 4>, 2> quantized = {}; /* Components without p-bits */
+    array<u32, 2>           pbits     = {};
+    array<array<u8, 4>, 2>  colors    = {}; /* Endpoints as the decoder expands them */
+    u64                     error     = numlim<u64>::max();
+};
+
+/* Parameters of the encoded mode: 6 - one RGBA subset, 1 - two RGB subsets */
+struct bc7_mode_params {
+    u32  color_bits;
+    u32  index_bits;
+    u32  channels;
+    bool shared_pbit;
+};
+
+constexpr bc7_mode_params bc7_mode6 = {7, 4, 4, false};
+constexpr bc7_mode_params bc7_mode1 = {6, 3, 3, true};
+
+/* The nearest quantized component for the p-bit */
+u32 bc7_quantize(float value, u32 bits, u32 pbit) {
+    auto max   = (1U << bits) - 1;
+    auto guess = std::lround((std::clamp(value, 0.f, 255.f) * float((max << 1U) | 1U) / 255.f - float(pbit)) / 2.f);
+
+    u32  best       = 0;
+    auto best_error = numlim<float>::max();
+    for (auto q = std::max(guess - 1, 0L); q <= std::min(guess + 1, long(max)); ++q) {
+        auto error = std::fabs(float(bc7_details::expand((u32(q) << 1U) | pbit, bits + 1)) - value);
+        if (error < best_error) {
+            best_error = error;
+            best       = u32(q);
+        }
+    }
+    return best;
+}
+
+/* Quantizes endpoints with p-bits which give the smallest error of endpoints */
+void bc7_quantize_endpoints(const bc7_mode_params& params,
+                            const array<array<float, 4>, 2>& endpoints,
+                            bc7_subset_fit& fit) {
+    array<float, 2>                   errors    = {}; /* Errors of the shared p-bit */
+    array<array<array<u32, 4>, 2>, 2> quantized = {}; /* [pbit][endpoint][channel] */
+
+    for (u32 e = 0; e < 2; ++e) {
+        array<float, 2> endpoint_errors = {};
+        for (u32 p = 0; p < 2; ++p) {
+            for (u32 c = 0; c < params.channels; ++c) {
+                auto q = bc7_quantize(endpoints[e][c], params.color_bits, p);
+                auto d = float(bc7_details::expand((q << 1U) | p, params.color_bits + 1)) - endpoints[e][c];
+                quantized[p][e][c] = q;
+                endpoint_errors[p] += d * d;
+            }
+            errors[p] += endpoint_errors[p];
+        }
+
+        if (!params.shared_pbit) {
+            fit.pbits[e]     = endpoint_errors[1] < endpoint_errors[0] ? 1 : 0;
+            fit.quantized[e] = quantized[fit.pbits[e]][e];
+        }
+    }
+
+    if (params.shared_pbit) {
+        auto p        = errors[1] < errors[0] ? 1U : 0U;
+        fit.pbits     = {p, p};
+        fit.quantized = quantized[p];
+    }
+
+    for (u32 e = 0; e < 2; ++e) {
+        for (u32 c = 0; c < 4; ++c) {
+            fit.colors[e][c] = c < params.channels ? bc7_details::expand((fit.quantized[e][c] << 1U) | fit.pbits[e],
+                                                                         params.color_bits + 1)
+                                                   : u8(255); // NOLINT
+        }
+    }
+}
+
+/* Palette of the subset, 4 RGBA colors per row */
+array<u8, 64> bc7_palette(const bc7_subset_fit& fit, u32 index_bits) {
+    array<u8, 64> palette = {}; // NOLINT
+    auto          weights = bc7_details::weights(index_bits);
+    for (u32 i = 0; i < (1U << index_bits); ++i)
+        for (u32 c = 0; c < 4; ++c)
+            palette[i * 4 + c] = bc7_details::interpolate(fit.colors[0][c], fit.colors[1][c], weights[i]);
+    return palette;
+}
+
+u32 distance4(const u8* a, const u8* b) {
+    u32 result = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        auto d = int(a[i]) - int(b[i]);
+        result += u32(d * d);
+    }
+    return result;
+}
+
+#ifdef PE_TEXTURE_ENCODE_X86
+/* Selects indices among 16 palette colors for all 16 pixels (mode 6) */
+__attribute__((target("ssse3")))
+u64 bc7_fit_indices_ssse3(const u8* rgba, const array<u8, 64>& palette, array<u8, 16>& indices) {
+    auto errors = _mm_setzero_si128();
+    for (int row = 0; row < 4; ++row) {
+        auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + row * 16)); // NOLINT
+
+        auto best_error = _mm_set1_epi32(numlim<i32>::max());
+        auto best_index = _mm_setzero_si128();
+        for (int c = 0; c < 16; ++c) { // NOLINT
+            u32 color; // NOLINT
+            std::memcpy(&color, palette.data() + c * 4, sizeof(color));
+
+            auto error  = distances_ssse3(pixels, _mm_set1_epi32(int(color)));
+            auto better = _mm_cmplt_epi32(error, best_error);
+            best_error  = _mm_or_si128(_mm_and_si128(better, error), _mm_andnot_si128(better, best_error));
+            best_index  = _mm_or_si128(_mm_and_si128(better, _mm_set1_epi32(c)), _mm_andnot_si128(better, best_index));
+        }
+
+        alignas(16) array<i32, 4> row_indices; // NOLINT
+        _mm_store_si128(reinterpret_cast<__m128i*>(row_indices.data()), best_index); // NOLINT
+        for (int x = 0; x < 4; ++x)
+            indices[size_t(row * 4 + x)] = u8(row_indices[size_t(x)]);
+
+        errors = _mm_add_epi32(errors, best_error);
+    }
+
+    alignas(16) array<u32, 4> sums; // NOLINT
+    _mm_store_si128(reinterpret_cast<__m128i*>(sums.data()), errors); // NOLINT
+    return u64(sums[0]) + sums[1] + sums[2] + sums[3];
+}
+#endif
+
+/* Selects indices of pixels of the subset (mask), returns the squared error */
+u64 bc7_fit_indices(const u8* rgba, u32 mask, const bc7_subset_fit& fit, u32 index_bits, array<u8, 16>& indices) {
+    auto palette = bc7_palette(fit, index_bits);
+
+#ifdef PE_TEXTURE_ENCODE_X86
+    if (mask == 0xFFFFU && index_bits == 4 && simd_supported()) // NOLINT
+        return bc7_fit_indices_ssse3(rgba, palette, indices);
+#endif
+
+    u64 error = 0;
+    for (u32 i = 0; i < 16; ++i) { // NOLINT
+        if (!(mask & (1U << i)))
+            continue;
+
+        u32 best       = 0;
+        u32 best_error = numlim<u32>::max();
+        for (u32 c = 0; c < (1U << index_bits); ++c) {
+            auto e = distance4(rgba + i * 4, palette.data() + c * 4);
+            if (e < best_error) {
+                best_error = e;
+                best       = c;
+            }
+        }
+        indices[i] = u8(best);
+        error += best_error;
+    }
+    return error;
+}
+
+/* Mean and the principal axis of pixels of the subset */
+void bc7_principal_axis(const u8* rgba, u32 mask, u32 channels, array<float, 4>& mean, array<float, 4>& axis) {
+    mean      = {};
+    u32 count = 0;
+    for (u32 i = 0; i < 16; ++i) { // NOLINT
+        if (!(mask & (1U << i)))
+            continue;
+        for (u32 c = 0; c < channels; ++c)
+            mean[c] += float(rgba[i * 4 + c]);
+        ++count;
+    }
+    for (auto& m : mean)
+        m /= float(std::max(count, 1U));
+
+    array<array<float, 4>, 4> cov = {};
+    for (u32 i = 0; i < 16; ++i) { // NOLINT
+        if (!(mask & (1U << i)))
+            continue;
+        for (u32 a = 0; a < channels; ++a)
+            for (u32 b = 0; b < channels; ++b)
+                cov[a][b] += (float(rgba[i * 4 + a]) - mean[a]) * (float(rgba[i * 4 + b]) - mean[b]);
+    }
+
+    axis = {1.f, 1.f, 1.f, channels == 4 ? 1.f : 0.f};
+    for (size_t it = 0; it < 8; ++it) { // NOLINT
+        array<float, 4> next = {};
+        for (u32 a = 0; a < channels; ++a)
+            for (u32 b = 0; b < channels; ++b)
+                next[a] += cov[a][b] * axis[b];
+
+        auto norm = std::max({std::fabs(next[0]), std::fabs(next[1]), std::fabs(next[2]), std::fabs(next[3])});
+        if (norm < 1e-6f) // NOLINT
+            break;
+        for (u32 c = 0; c < channels; ++c)
+            axis[c] = next[c] / norm;
+    }
+}
+
+/* Sum of squared distances of pixels to the principal axis, estimates the error of the subset */
+float bc7_axis_residual(const u8* rgba, u32 mask, u32 channels) {
+    array<float, 4> mean, axis; // NOLINT
+    bc7_principal_axis(rgba, mask, channels, mean, axis);
+
+    auto axis_norm = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3];
+    auto residual  = 0.f;
+    for (u32 i = 0; i < 16; ++i) { // NOLINT
+        if (!(mask & (1U << i)))
+            continue;
+
+        array<float, 4> d    = {};
+        float           proj = 0.f;
+        for (u32 c = 0; c < channels; ++c) {
+            d[c] = float(rgba[i * 4 + c]) - mean[c];
+            proj += d[c] * axis[c];
+        }
+        auto length2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2] + d[3] * d[3];
+        residual += length2 - (axis_norm > 1e-6f ? proj * proj / axis_norm : 0.f); // NOLINT
+    }
+    return residual;
+}
+
+/* Endpoints minimizing the squared error for the given indices */
+bool bc7_least_squares(const u8*                  rgba,
+                       u32                        mask,
+                       u32                        channels,
+                       u32                        index_bits,
+                       const array<u8, 16>&       indices,
+                       array<array<float, 4>, 2>& endpoints) {
+    auto weights = bc7_details::weights(index_bits);
+
+    float           aa = 0.f, ab = 0.f, bb = 0.f;
+    array<float, 4> ax = {}, bx = {};
+    for (u32 i = 0; i < 16; ++i) { // NOLINT
+        if (!(mask & (1U << i)))
+            continue;
+
+        auto b = float(weights[indices[i]]) / 64.f; // NOLINT
+        auto a = 1.f - b;
+
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (u32 c = 0; c < channels; ++c) {
+            ax[c] += a * float(rgba[i * 4 + c]);
+            bx[c] += b * float(rgba[i * 4 + c]);
+        }
+    }
+
+    auto det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f) // NOLINT
+        return false;
+
+    for (u32 c = 0; c < channels; ++c) {
+        endpoints[0][c] = (ax[c] * bb - bx[c] * ab) / det;
+        endpoints[1][c] = (bx[c] * aa - ax[c] * ab) / det;
+    }
+    return true;
+}
+
+/* Fits endpoints and indices of the subset */
+bc7_subset_fit bc7_fit_subset(const u8*              rgba,
+                              u32                    mask,
+                              const bc7_mode_params& params,
+                              dxt_encode_quality     quality,
+                              array<u8, 16>&         indices) {
+    array<float, 4> mean, axis; // NOLINT
+    bc7_principal_axis(rgba, mask, params.channels, mean, axis);
+
+    /* Extreme pixels along the axis */
+    float min_proj = numlim<float>::max(), max_proj = numlim<float>::lowest();
+    for (u32 i = 0; i < 16; ++i) { // NOLINT
+        if (!(mask & (1U << i)))
+            continue;
+        float proj = 0.f;
+        for (u32 c = 0; c < params.channels; ++c)
+            proj += (float(rgba[i * 4 + c]) - mean[c]) * axis[c];
+        min_proj = std::min(min_proj, proj);
+        max_proj = std::max(max_proj, proj);
+    }
+
+    auto axis_norm = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3];
+    array<array<float, 4>, 2> endpoints = {mean, mean};
+    if (axis_norm > 1e-6f) { // NOLINT
+        for (u32 c = 0; c < params.channels; ++c) {
+            endpoints[0][c] += axis[c] * min_proj / axis_norm;
+            endpoints[1][c] += axis[c] * max_proj / axis_norm;
+        }
+    }
+
+    bc7_subset_fit best;
+    bc7_quantize_endpoints(params, endpoints, best);
+    best.error = bc7_fit_indices(rgba, mask, best, params.index_bits, indices);
+    if (quality == dxt_encode_quality::fast || best.error == 0)
+        return best;
+
+    /* Refine endpoints while the error decreases */
+    auto best_indices = indices;
+    for (size_t it = 0; it < refine_iterations; ++it) {
+        if (!bc7_least_squares(rgba, mask, params.channels, params.index_bits, best_indices, endpoints))
+            break;
+
+        bc7_subset_fit fit;
+        bc7_quantize_endpoints(params, endpoints, fit);
+        fit.error = bc7_fit_indices(rgba, mask, fit, params.index_bits, indices);
+        if (fit.error >= best.error)
+            break;
+
+        best         = fit;
+        best_indices = indices;
+    }
+
+    indices = best_indices;
+    return best;
+}
+
+/* The highest bit of the index of the anchor pixel is not stored, so it must be zero */
+void bc7_fix_anchor(bc7_subset_fit& fit, u32 mask, u32 anchor, u32 index_bits, array<u8, 16>& indices) {
+    auto max = (1U << index_bits) - 1;
+    if (indices[anchor] <= max / 2)
+        return;
+
+    std::swap(fit.quantized[0], fit.quantized[1]);
+    std::swap(fit.pbits[0], fit.pbits[1]);
+    std::swap(fit.colors[0], fit.colors[1]);
+    for (u32 i = 0; i < 16; ++i) // NOLINT
+        if (mask & (1U << i))
+            indices[i] = u8(max - indices[i]);
+}
+
+u64 bc7_encode_mode6(const u8* rgba, dxt_encode_quality quality, bc7_writer& output) {
+    array<u8, 16> indices = {}; // NOLINT
+    auto          fit     = bc7_fit_subset(rgba, 0xFFFFU, bc7_mode6, quality, indices); // NOLINT
+    bc7_fix_anchor(fit, 0xFFFFU, 0, bc7_mode6.index_bits, indices); // NOLINT
+
+    output.write(1U << 6U, 7); // NOLINT
+    for (u32 c = 0; c < 4; ++c)
+        for (u32 e = 0; e < 2; ++e)
+            output.write(fit.quantized[e][c], bc7_mode6.color_bits);
+    output.write(fit.pbits[0], 1);
+    output.write(fit.pbits[1], 1);
+
+    for (u32 i = 0; i < 16; ++i) // NOLINT
+        output.write(indices[i], bc7_mode6.index_bits - (i == 0 ? 1U : 0U));
+
+    return fit.error;
+}
+
+/* Opaque blocks only: alpha of mode 1 is always 255 */
+u64 bc7_encode_mode1(const u8* rgba, dxt_encode_quality quality, bc7_writer& output) {
+    /* Partitions with the smallest residuals of both subsets are fitted */
+    array<std::pair<float, u32>, 64> estimations; // NOLINT
+    for (u32 p = 0; p < 64; ++p) { // NOLINT
+        auto mask     = u32(bc7_details::partitions2[p]);
+        auto residual = bc7_axis_residual(rgba, ~mask & 0xFFFFU, 3) + bc7_axis_residual(rgba, mask, 3); // NOLINT
+        estimations[p] = {residual, p};
+    }
+    std::partial_sort(estimations.begin(),
+                      estimations.begin() + bc7_partition_candidates,
+                      estimations.end(),
+                      [](auto& a, auto& b) { return a.first < b.first; });
+
+    u32                      best_partition = 0;
+    u64                      best_error     = numlim<u64>::max();
+    array<bc7_subset_fit, 2> best_fits;
+    array<u8, 16>            best_indices = {}; // NOLINT
+
+    for (size_t candidate = 0; candidate < bc7_partition_candidates; ++candidate) {
+        auto partition = estimations[candidate].second;
+        auto masks     = array<u32, 2>{~u32(bc7_details::partitions2[partition]) & 0xFFFFU, // NOLINT
+                                   u32(bc7_details::partitions2[partition])};
+
+        array<u8, 16>            indices = {}; // NOLINT
+        array<bc7_subset_fit, 2> fits;
+        u64                      error = 0;
+        for (u32 s = 0; s < 2; ++s) {
+            array<u8, 16> subset_indices = {}; // NOLINT
+            fits[s] = bc7_fit_subset(rgba, masks[s], bc7_mode1, quality, subset_indices);
+            bc7_fix_anchor(fits[s],
+                           masks[s],
+                           bc7_details::anchor_of(2, partition, s),
+                           bc7_mode1.index_bits,
+                           subset_indices);
+            for (u32 i = 0; i < 16; ++i) // NOLINT
+                if (masks[s] & (1U << i))
+                    indices[i] = subset_indices[i];
+            error += fits[s].error;
+        }
+
+        if (error < best_error) {
+            best_error     = error;
+            best_partition = partition;
+            best_fits      = fits;
+            best_indices   = indices;
+        }
+    }
+
+    output.write(1U << 1U, 2);
+    output.write(best_partition, 6); // NOLINT
+    for (u32 c = 0; c < 3; ++c)
+        for (u32 s = 0; s < 2; ++s)
+            for (u32 e = 0; e < 2; ++e)
+                output.write(best_fits[s].quantized[e][c], bc7_mode1.color_bits);
+    output.write(best_fits[0].pbits[0], 1);
+    output.write(best_fits[1].pbits[0], 1);
+
+    for (u32 i = 0; i < 16; ++i) // NOLINT
+        output.write(best_indices[i],
+                     bc7_mode1.index_bits - (bc7_details::is_anchor(2, best_partition, i) ? 1U : 0U));
+
+    return best_error;
+}
+
+/*
+ * Mode 6 (one subset, RGBA, 4-bit indices) encodes every block. The high quality mode also tries mode 1
+ * (two subsets, RGB, 3-bit indices) for opaque blocks, which fits blocks with sharp edges between two colors
+ */
+void encode_bc7(const u8* rgba, byte* output, dxt_encode_quality quality) {
+    bc7_writer mode6;
+    auto       error = bc7_encode_mode6(rgba, quality, mode6);
+
+    auto opaque = true;
+    for (u32 i = 0; i < 16 && opaque; ++i) // NOLINT
+        opaque = rgba[i * 4 + 3] == 255; // NOLINT
+
+    if (quality == dxt_encode_quality::high && opaque && error != 0) {
+        bc7_writer mode1;
+        if (bc7_encode_mode1(rgba, quality, mode1) < error) {
+            mode1.store(output);
+            return;
+        }
+    }
+
+    mode6.store(output);
+}
+
+void encode_block(dxt_format format, const u8* rgba, byte* output, dxt_encode_quality quality) {
+    color_block block = {rgba, 0};
+
+    switch (format) {
+    case dxt_format::dxt1:
+        encode_color(block, output, quality);
+        break;
+    case dxt_format::dxt1_onebitalpha:
+        for (u32 i = 0; i < 16; ++i)
+            if (rgba[i * 4 + 3] < 128) // NOLINT
+                block.transparent_mask |= 1U << i;
+        encode_color(block, output, quality);
+        break;
+    case dxt_format::dxt3:
+        encode_dxt3_alpha(rgba, output);
+        encode_color(block, output + 8, quality); // NOLINT
+        break;
+    case dxt_format::dxt5:
+        encode_dxt5_alpha(rgba, output, quality);
+        encode_color(block, output + 8, quality); // NOLINT
+        break;
+    case dxt_format::bc7:
+        encode_bc7(rgba, output, quality);
+        break;
+    }
+}
+
+/* Reads the block with edge pixels replicated into partial blocks */
+void read_block(const u8* input, vec2u size, size_t channels, u32 bx, u32 by, u8* rgba) {
+    for (u32 y = 0; y < 4; ++y) {
+        auto sy  = std::min(by * 4 + y, size.y() - 1);
+        auto row = input + size_t(sy) * size.x() * channels;
+        for (u32 x = 0; x < 4; ++x) {
+            auto sx  = std::min(bx * 4 + x, size.x() - 1);
+            auto src = row + size_t(sx) * channels;
+            auto dst = rgba + (y * 4 + x) * 4;
+            dst[0]   = src[0];
+            dst[1]   = src[1];
+            dst[2]   = src[2];
+            dst[3]   = channels == 4 ? src[3] : 255; // NOLINT
+        }
+    }
+}
+
+void dxt_encode_rows(dxt_format         format,
+                     const u8*          input,
+                     vec2u              size,
+                     size_t             channels,
+                     byte*              output,
+                     dxt_encode_quality quality,
+                     size_t             row_begin,
+                     size_t             row_end) {
+    auto blocks     = dxt_blocks_count(size);
+    auto block_size = dxt_block_size(format);
+
+    alignas(16) array<u8, 64> rgba; // NOLINT
+    for (auto by = u32(row_begin); by < row_end; ++by) {
+        auto out = output + size_t(by) * blocks.x() * block_size;
+        for (u32 bx = 0; bx < blocks.x(); ++bx) {
+            read_block(input, size, channels, bx, by, rgba.data());
+            encode_block(format, rgba.data(), out + bx * block_size, quality);
+        }
+    }
+}
+} // namespace
+
+namespace util
+{
+void dxt_encode_block(dxt_format format, const u8* rgba, byte* block, dxt_encode_quality quality) {
+    encode_block(format, rgba, block, quality);
+}
+
+void dxt_encode(dxt_format         format,
+                const u8*          input,
+                vec2u              size,
+                size_t             channels,
+                span<byte>         output,
+                dxt_encode_quality quality,
+                fiber_pool*        pool) {
+    if (channels != 3 && channels != 4)
+        pe_throw std::runtime_error("dxt_encode: input must have 3 or 4 channels");
+
+    if (static_cast<size_t>(output.size()) < dxt_data_size(format, size))
+        pe_throw std::runtime_error("dxt_encode: output size is less than the image requires");
+
+    auto blocks = dxt_blocks_count(size);
+    if (blocks.x() == 0 || blocks.y() == 0)
+        return;
+
+    parallel_for(
+        blocks.y(),
+        std::max<size_t>(min_blocks_per_job / blocks.x(), 1),
+        [&](size_t begin, size_t end) {
+            dxt_encode_rows(format, input, size, channels, output.data(), quality, begin, end);
+        },
+        pool);
+}
+
+double image_psnr(span<const u8> reference, span<const u8> image) {
+    if (reference.size() != image.size())
+        pe_throw std::runtime_error("image_psnr: images have different sizes");
+
+    u64 squared_error = 0;
+    for (ssize_t i = 0; i < reference.size(); ++i) {
+        auto d = int(reference[i]) - int(image[i]);
+        squared_error += u64(d * d);
+    }
+
+    if (squared_error == 0)
+        return std::numeric_limits<double>::infinity();
+
+    auto mse = double(squared_error) / double(reference.size());
+    return 10.0 * std::log10(255.0 * 255.0 / mse); // NOLINT
+}
+} // namespace util
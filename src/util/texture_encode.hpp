@@ -0,0 +1,67 @@
+#pragma once
+
+#include "texture_decode.hpp"
+
+namespace util
+{
+/**
+ * @brief Quality modes of the block encoder
+ */
+enum class dxt_encode_quality : core::u8 {
+    fast = 0, /* Endpoints are the extreme colors along the principal axis */
+    high,     /* Endpoints are refined with least squares, DXT5 alpha tries both interpolation modes, BC7 tries
+                 two subset partitions for opaque blocks */
+};
+
+/**
+ * @brief Encodes 16 RGBA pixels into one block
+ *
+ * DXT1 ignores alpha, DXT1 with one bit alpha encodes pixels with alpha < 128 as transparent.
+ * BC7 blocks are encoded with mode 6 (one RGBA subset) or mode 1 (two RGB subsets)
+ *
+ * @param format - the block format
+ * @param rgba - 4 rows of 4 RGBA pixels
+ * @param block - the output (dxt_block_size(format) bytes)
+ * @param quality - the quality mode
+ */
+void dxt_encode_block(dxt_format         format,
+                      const core::u8*    rgba,
+                      core::byte*        block,
+                      dxt_encode_quality quality = dxt_encode_quality::fast);
+
+/**
+ * @brief Encodes the image with block compression
+ *
+ * Palette indices are selected with SSSE3 when the CPU supports it, block rows are split between
+ * jobs of the fiber pool. Partial blocks on the right and bottom edges are padded with edge pixels
+ *
+ * @throw runtime_error if the output is smaller than dxt_data_size(format, size)
+ *
+ * @param format - the block format
+ * @param input - size.x() * size.y() * channels bytes
+ * @param size - the image size in pixels
+ * @param channels - 3 for RGB input (opaque) or 4 for RGBA input
+ * @param output - blocks in row-major order
+ * @param quality - the quality mode
+ * @param pool - the fiber pool which runs encoding jobs, nullptr - the global fiber pool
+ */
+void dxt_encode(dxt_format             format,
+                const core::u8*        input,
+                core::vec2u            size,
+                size_t                 channels,
+                core::span<core::byte> output,
+                dxt_encode_quality     quality = dxt_encode_quality::fast,
+                core::fiber_pool*      pool    = nullptr);
+
+/**
+ * @brief Computes the peak signal-to-noise ratio of 8-bit images
+ *
+ * @throw runtime_error if images have different sizes
+ *
+ * @param reference - the reference image
+ * @param image - the distorted image
+ *
+ * @return PSNR in decibels, infinity for identical images
+ */
+double image_psnr(core::span<const core::u8> reference, core::span<const core::u8> image);
+} // namespace util
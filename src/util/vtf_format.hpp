@@ -4,6 +4,7 @@
 #include <core/types.hpp>
 #include <core/serialization.hpp>
 #include <core/flags.hpp>
+#include "texture_decode.hpp"
 
 namespace util {
 
@@ -145,45 +146,17 @@ struct vtf_resource_entry_info {
 };
 
 inline core::vec<core::u8, 3> vtf_unpack_rgb565(core::u16 color) {
+    /* High bits are replicated into low bits, so 0x1f and 0x3f become 255 */
+    auto r = core::u32(color >> 11);
+    auto g = core::u32((color >> 5) & 0x3f);
+    auto b = core::u32(color & 0x1f);
     return {
-        core::u8((color >> 11) * 8),
-        core::u8(((color >> 5) & 0x3f) * 4),
-        core::u8((color & 0x1f) * 8)
+        core::u8((r << 3) | (r >> 2)),
+        core::u8((g << 2) | (g >> 4)),
+        core::u8((b << 3) | (b >> 2))
     };
 }
 
-using vtf_dxt1_unpacked_pixel_t = core::array<core::array<core::vec<core::u8, 3>, 4>, 4>;
-inline vtf_dxt1_unpacked_pixel_t vtf_dxt1_unpack_pixel(core::u64 comp_pixel) {
-    using rgb_t = core::vec<core::u8, 3>;
-
-    struct comp_data {
-        core::u16 palette[2];
-        core::u8  color_row[4];
-    } cd;
-
-    vtf_dxt1_unpacked_pixel_t unpacked;
-    core::array<rgb_t, 4> palette;
-
-    std::memcpy(&cd, &comp_pixel, sizeof(cd));
-    palette[0] = vtf_unpack_rgb565(cd.palette[0]);
-    palette[1] = vtf_unpack_rgb565(cd.palette[1]);
-    palette[2] = static_cast<rgb_t>((palette[0] * 2) / 3 + (palette[1] / 3));
-    palette[3] = static_cast<rgb_t>((palette[0] / 3) + (palette[1] * 2) / 3);
-
-    for (size_t i = 0; i < 4; ++i) {
-        core::u8 d = cd.color_row[i] >> 6;
-        core::u8 c = (cd.color_row[i] >> 4) & 3;
-        core::u8 b = (cd.color_row[i] >> 2) & 3;
-        core::u8 a = (cd.color_row[i]) & 3;
-        unpacked[i][0] = palette[a];
-        unpacked[i][1] = palette[b];
-        unpacked[i][2] = palette[c];
-        unpacked[i][3] = palette[d];
-    }
-
-    return unpacked;
-}
-
 class vtf_view {
 public:
     class resource_info_iterator {
@@ -358,27 +331,23 @@ public:
     }
 
     void read_low_res(core::u8* output) const {
-        auto comp_size = static_cast<core::vec2<core::u32>>(low_res_size()) / 4U;
-        auto size = comp_size * 4U;
-        core::u64 comp_data[16U * 16U];
-        core::println("LOW RES OFFSET: {}", low_res_offset());
-        std::memcpy(comp_data,
-                    data.data() + low_res_offset(),
-                    comp_size.x() * comp_size.y() * sizeof(core::u64));
-
-        for (auto [x, y] : core::dimensional_seq(comp_size)) {
-            auto output_offset = ((y * 4U * size.x()) + x * 4U) * 3U;
-            auto comp_offset = y * comp_size.x() + x;
-            auto unpacked = vtf_dxt1_unpack_pixel(comp_data[comp_offset]);
-            constexpr auto unps = sizeof(unpacked[0]);
-            std::memcpy(output + output_offset + size.x() * 0U, unpacked[0].data(), unps);
-            std::memcpy(output + output_offset + size.x() * 3U, unpacked[1].data(), unps);
-            std::memcpy(output + output_offset + size.x() * 6U, unpacked[2].data(), unps);
-            std::memcpy(output + output_offset + size.x() * 9U, unpacked[3].data(), unps);
-        }
+        auto size = static_cast<core::vec2u>(low_res_size());
+        dxt_decode(dxt_format::dxt1,
+                   data.subspan(low_res_offset(), ssize_t(dxt_data_size(dxt_format::dxt1, size))),
+                   size,
+                   output,
+                   3);
     }
 
-    void read_high_res(core::u8* output) const {
+    /**
+     * @brief Decodes the largest mipmap of the high resolution image
+     *
+     * Block compressed and packed formats are decoded in parallel on the fiber pool
+     *
+     * @param output - size.x() * size.y() * high_res_channels_count() bytes
+     * @param pool - the fiber pool which runs decoding jobs, nullptr - the global fiber pool
+     */
+    void read_high_res(core::u8* output, core::fiber_pool* pool = nullptr) const {
         auto format      = high_res_format();
         auto channels    = format_to_channels_count(format);
         auto size        = static_cast<core::vec2<core::u32>>(high_res_size());
@@ -386,11 +355,14 @@ public:
         auto last_mipmap = skip_mipmaps_pixels(mipmap_count(), size);
         auto end_largest = last_mipmap + size.x() * size.y();
         auto start       = data.subspan(offset);
+        auto largest     = start.subspan(ssize_t(skip_mipmaps_bytes(format, mipmap_count(), size)),
+                                     ssize_t(image_data_size(format, size)));
 
         switch (format) {
             case vtf_image_format::A8: case vtf_image_format::I8: case vtf_image_format::P8: case vtf_image_format::IA88:
             case vtf_image_format::UV88: case vtf_image_format::RGB888_BLUESCREEN: case vtf_image_format::RGB888: case vtf_image_format::RGBA8888:
-                std::memcpy(output, start.data(), size.x() * size.y() * channels);
+            case vtf_image_format::UVWQ8888: case vtf_image_format::UVLX8888:
+                std::memcpy(output, largest.data(), size.x() * size.y() * channels);
                 break;
             case vtf_image_format::BGR565:
                 for (core::u32 i = last_mipmap; i < end_largest; ++i) {
@@ -432,32 +404,30 @@ public:
                     std::memcpy(output + (i - last_mipmap) * channels, &color, sizeof(color));
                 }
                 break;
-            case vtf_image_format::DXT1: {
-                auto comp_size = size / 4U;
-                auto cdata = start.subspan(skip_mipmaps_pixels(mipmap_count(), comp_size) * sizeof(core::u64));
-                for (auto [x, y] : core::dimensional_seq(comp_size)) {
-                    auto           output_offset = ((y * 4U * size.x()) + x * 4U) * 3U;
-                    auto           comp_offset   = y * comp_size.x() + x;
-                    core::u64      comp_quad; // NOLINT
-                    std::memcpy(&comp_quad, cdata.data() + comp_offset * sizeof(core::u64), sizeof(core::u64));
-                    auto           unpacked      = vtf_dxt1_unpack_pixel(comp_quad);
-                    constexpr auto unps          = sizeof(unpacked[0]);
-                    std::memcpy(output + output_offset + size.x() * 0U, unpacked[0].data(), unps);
-                    std::memcpy(output + output_offset + size.x() * 3U, unpacked[1].data(), unps);
-                    std::memcpy(output + output_offset + size.x() * 6U, unpacked[2].data(), unps);
-                    std::memcpy(output + output_offset + size.x() * 9U, unpacked[3].data(), unps);
-                }
-            } break;
+            case vtf_image_format::DXT1:
+                dxt_decode(dxt_format::dxt1, largest, size, output, channels, pool);
+                break;
             case vtf_image_format::DXT1_ONEBITALPHA:
+                dxt_decode(dxt_format::dxt1_onebitalpha, largest, size, output, channels, pool);
+                break;
             case vtf_image_format::DXT3:
+                dxt_decode(dxt_format::dxt3, largest, size, output, channels, pool);
+                break;
             case vtf_image_format::DXT5:
+                dxt_decode(dxt_format::dxt5, largest, size, output, channels, pool);
+                break;
             case vtf_image_format::BGRA4444:
+                decode_packed_pixels(packed_pixel_format::bgra4444, largest, size.x() * size.y(), output, pool);
+                break;
             case vtf_image_format::BGRA5551:
+                decode_packed_pixels(packed_pixel_format::bgra5551, largest, size.x() * size.y(), output, pool);
+                break;
             case vtf_image_format::BGRX5551:
+                decode_packed_pixels(packed_pixel_format::bgrx5551, largest, size.x() * size.y(), output, pool);
+                break;
             case vtf_image_format::BGRX8888:
-            case vtf_image_format::UVWQ8888:
-            case vtf_image_format::UVLX8888:
-                pe_throw std::runtime_error("Not implemented format " + core::string(magic_enum::enum_name(format)));
+                decode_packed_pixels(packed_pixel_format::bgrx8888, largest, size.x() * size.y(), output, pool);
+                break;
             case vtf_image_format::BGRA8888: case vtf_image_format::RGBA16161616: case vtf_image_format::RGBA16161616F:
                 pe_throw std::runtime_error("Invalid image format: trying to read HDR texture as non-HDR");
             case vtf_image_format::NONE:
@@ -465,6 +435,53 @@ public:
         }
     }
 
+    /**
+     * @brief Gets the block compression format of the high resolution image
+     *
+     * @return the format or nullopt if the image is not block compressed
+     */
+    [[nodiscard]] core::optional<dxt_format> high_res_dxt_format() const {
+        switch (high_res_format()) {
+            case vtf_image_format::DXT1: return dxt_format::dxt1;
+            case vtf_image_format::DXT1_ONEBITALPHA: return dxt_format::dxt1_onebitalpha;
+            case vtf_image_format::DXT3: return dxt_format::dxt3;
+            case vtf_image_format::DXT5: return dxt_format::dxt5;
+            default: return core::nullopt;
+        }
+    }
+
+    /**
+     * @brief Gets raw data of the high resolution mipmap
+     *
+     * Mipmaps are stored from the smallest to the largest one, the level is counted from the largest
+     *
+     * @throw runtime_error if the level does not exist or the data is truncated
+     *
+     * @param level - the mipmap level, 0 - the largest mipmap
+     *
+     * @return the mipmap data
+     */
+    [[nodiscard]] core::span<const core::byte> high_res_mipmap_data(core::u32 level) const {
+        auto count = std::max(mipmap_count(), 1U);
+        if (level >= count)
+            pe_throw std::runtime_error(core::format("Invalid mipmap level {}: vtf has {} mipmaps", level, count));
+
+        auto format = high_res_format();
+        auto size   = static_cast<core::vec2u>(high_res_size());
+        for (core::u32 i = 0; i < level; ++i) {
+            size     = size / 2u;
+            size.x() = std::max(size.x(), 1u);
+            size.y() = std::max(size.y(), 1u);
+        }
+
+        auto start  = high_res_offset() + skip_mipmaps_bytes(format, count - level, size);
+        auto length = image_data_size(format, size);
+        if (start + length > size_t(data.size()))
+            pe_throw std::runtime_error("Truncated vtf mipmap data");
+
+        return data.subspan(ssize_t(start), ssize_t(length));
+    }
+
     void read_high_res(float* output) const {
         auto format      = high_res_format();
         auto channels    = format_to_channels_count(format);
@@ -528,6 +545,54 @@ public:
         return skip;
     }
 
+    /**
+     * @brief Gets the size of the image data in bytes
+     *
+     * @throw runtime_error if the format is unknown
+     */
+    static size_t image_data_size(vtf_image_format fmt, core::vec2u size) {
+        auto pixels = size_t(size.x()) * size.y();
+
+        switch (fmt) {
+            case vtf_image_format::DXT1: case vtf_image_format::DXT1_ONEBITALPHA:
+                return dxt_data_size(dxt_format::dxt1, size);
+            case vtf_image_format::DXT3: case vtf_image_format::DXT5:
+                return dxt_data_size(dxt_format::dxt5, size);
+            case vtf_image_format::A8: case vtf_image_format::I8: case vtf_image_format::P8:
+                return pixels;
+            case vtf_image_format::IA88: case vtf_image_format::UV88: case vtf_image_format::RGB565:
+            case vtf_image_format::BGR565: case vtf_image_format::BGRX5551: case vtf_image_format::BGRA4444:
+            case vtf_image_format::BGRA5551:
+                return pixels * 2;
+            case vtf_image_format::RGB888: case vtf_image_format::BGR888: case vtf_image_format::RGB888_BLUESCREEN:
+            case vtf_image_format::BGR888_BLUESCREEN:
+                return pixels * 3;
+            case vtf_image_format::RGBA8888: case vtf_image_format::ABGR8888: case vtf_image_format::ARGB8888:
+            case vtf_image_format::BGRA8888: case vtf_image_format::BGRX8888: case vtf_image_format::UVWQ8888:
+            case vtf_image_format::UVLX8888:
+                return pixels * 4;
+            case vtf_image_format::RGBA16161616F: case vtf_image_format::RGBA16161616:
+                return pixels * 8;
+            case vtf_image_format::NONE:
+                break;
+        }
+        pe_throw std::runtime_error("Invalid image format");
+    }
+
+    /**
+     * @brief Gets the size of mipmaps which are stored before the largest one
+     */
+    static size_t skip_mipmaps_bytes(vtf_image_format fmt, size_t mipmap_count, core::vec2u size) {
+        size_t skip = 0;
+        for (size_t i = 1; i < mipmap_count; ++i) {
+            size     = size / 2u;
+            size.x() = std::max(size.x(), 1u);
+            size.y() = std::max(size.y(), 1u);
+            skip += image_data_size(fmt, size);
+        }
+        return skip;
+    }
+
     static size_t format_to_channels_count(vtf_image_format fmt) {
         switch (fmt) {
             case vtf_image_format::A8: case vtf_image_format::I8: case vtf_image_format::P8: